@@ -45,6 +45,7 @@
   #define ROXLU_USE_AUDIO            - to use AudioPlayer for simple 44100,2-channel audio playback (need libcubeb)
   #define ROXLU_USE_CURL             - enable some curl helpers
   #define ROXLU_USE_LOG              - use the logging features
+  #define ROXLU_USE_THREADS          - run rx_parallel_for() on multiple threads (needs C++11), defined automatically for C++11 compilers
 
 
   MACROS
@@ -99,9 +100,54 @@
 
   OBJ                                                                       - class to load OBJ files
   OBJ.load(filepath)                                                        - load the .obj file, returns boolean
+  OBJ.load(data, nbytes)                                                    - parse .obj data from memory, returns boolean
+  OBJ.num_threads                                                           - number of threads used to parse big (> 4MB) files, 0 = one per core (default)
   OBJ.hasNormals()                                                          - returns true if the loaded obj has normals
   OBJ.hasTexCoords()                                                        - returns true if the loaded obj had texcoords
   OBJ.copy(std::vector<VertexPT>&)                                          - copy the loaded vertices
+  OBJ.copy(std::vector<VertexPT>&, std::vector<uint32_t>&)                 - copy the unique vertices and indices (also works with std::vector<uint16_t>)
+  VertexLayout<T>                                                           - compile time offsets of the attributes of a vertex type; specialize it to use your own vertex type with OBJ.copy()
+  rx_vertex_attrib_pointers<VertexPTN>()                                    - enable and set the vertex attributes of the given vertex type for the bound VAO/VBO
+  VertexPackedPTN, VertexPackedPTTN                                         - 16/20 byte vertices: half positions, unorm16 texcoords, octahedral snorm16 normals, snorm8 tangents
+  VertexPackedPC                                                            - 12 byte vertex: 2D float position and RGBA8 color, used by the Painter
+  VertexQuantizedPTN, VertexQuantizedPTTN                                   - same, but with unorm16 positions relative to the bounds of the mesh
+  VertexPacker.pack(std::vector<VertexPTTN>&, std::vector<VertexPackedPTTN>&) - pack float vertices (SSE2/F16C when available), fills bounds_min/bounds_size for the quantized types
+  VertexPacker.copy(obj, std::vector<VertexQuantizedPTTN>&, indices)        - copy the unique vertices + indices of an OBJ into packed vertices
+  VERTEX_PACKED_GLSL                                                        - string literal with the GLSL rx_decode_octahedral() and rx_decode_position() for the packed vertices
+  rx_float_to_half(), rx_half_to_float(), rx_oct_encode(), rx_oct_decode()  - conversion helpers used by the packed vertices
+  OBJ.createIndices()                                                       - deduplicate the face corners, fills OBJ.indices and OBJ.unique_tris
+  OBJ.getReuseRatio()                                                       - number of face corners per unique vertex, after createIndices()
+  OBJ.calculateNormals(creaseAngle, weighting)                              - create smooth normals (e.g. when the file has none), OBJ_NORMALS_WEIGHT_{AREA, ANGLE}
+  OBJ.calculateFlatNormals()                                                - create one normal per face
+  OBJ::parseLine(p, eol, line, nparsed)                                     - parse one .obj line into an OBJ::LINE, returns OBJ_LINE_{NONE, VERTEX, NORMAL, TEXCOORD, FACE}; used by OBJ and OBJReader
+
+  OBJReader                                                                 - streams an .obj through callbacks in bounded memory, for meshes that don't fit in memory
+  OBJReader.on_vertex, on_normal, on_texcoord, on_face, user                - the callbacks, called for each `v`, `vn`, `vt` and triangle
+  OBJReader.read(filepath), read(FILE*)                                     - read the file or stream, see OBJReader.buffer_size
+
+  MeshOptimizer                                                             - reorders indexed triangles for the vertex cache (Tipsify), overdraw and vertex fetch
+  MeshOptimizer.optimize(vertices, indices)                                 - run all passes, see acmr_before/after, atvr_before/after or print()
+  MeshOptimizer.getACMR(indices, nverts), getATVR(indices, nverts)          - average cache miss ratio and average transformed to vertex ratio for a FIFO of `cache_size`
+
+  OBJCache                                                                  - binary cache of the indexed OBJ data, memory mapped; no parsing, no copies
+  OBJCache.load(filepath, layout)                                           - map the cache for the given .obj file, rebuilds it when missing or stale. OBJ_CACHE_LAYOUT_{PLANAR, INTERLEAVED}
+  OBJCache.positions, normals, tex_coords, tangents, vertices, indices      - pointers into the mapped cache (vertices is used for the interleaved layout)
+  OBJCache.load(filepath, layout, numLods)                                  - same as above but with a LOD chain created by MeshSimplifier, see OBJCache.lods
+
+  MeshSimplifier                                                            - quadric error mesh simplification that keeps UV/normal seams; the result reuses the vertices
+  MeshSimplifier.simplify(vertices, indices, result, targetTris, targetErr) - simplify until `targetTris` triangles or the relative error `targetErr` is reached; returns the error
+  MeshSimplifier.createLODs(vertices, indices, lods, numLods, ratio)        - creates a chain of MeshLOD, each with about `ratio` times the triangles of the previous one
+  MeshSimplifier.print()                                                    - prints the number of triangles and the time per million triangles
+  MeshSimplifier.weld_seams                                                 - set to true to also simplify meshes where every triangle has its own vertices (flat shading)
+
+  Meshlets                                                                  - splits an indexed mesh into clusters of max 64 vertices / 124 triangles with a bounding sphere and normal cone
+  Meshlets.build(vertices, indices)                                         - creates the meshlets, Meshlets.indices has the triangles ordered per meshlet
+  Meshlets.cull(mvp, eye, draws)                                            - frustum and back face (normal cone) culling, fills a compacted std::vector<MeshletDraw>
+  Meshlets.print()                                                          - prints the number of meshlets and the culling stats
+
+  Tube                                                                      - generates an indexed tube or ribbon (VertexPTN) along a Spline<vec3>
+  Tube.create(spline)                                                       - generate all vertices + indices, see Tube.vertices and Tube.indices
+  Tube.update(spline, first, last)                                          - regenerate only the rings influenced by the changed points [first, last], see dirty_start/dirty_end
 
   Painter                                                                   - simple helper to draw lines, circles, rectangles, textures with GL 3.x
   Painter.init()                                                            - must be called to ininitialize the GL-objects.
@@ -112,9 +158,34 @@
   Painter.resolution(6)                                                     - sets the circle resolution
   Painter.line(x0, y0, x1, y1)                                              - draw one line
   Painter.texture(texid, x, y, w, h)                                        - draw a texture
+  Painter.texture(region, x, y, w, h)                                       - draw an image of a TextureAtlas or TextureArray
+  Painter.sortTextures(true)                                                - group all textures per texture/atlas page: one draw call per page, textures don't keep their order
   Painter.color(r,g,b,a)                                                    - set the draw color
   Painter.fill()                                                            - draw filled shapes
   Painter.nofill()                                                          - draw only outlines
+  Painter.instanced()                                                       - draw rects and circles with instancing: 20 bytes per shape, one draw call per shape kind
+  Painter.noinstanced()                                                     - draw rects and circles as vertices again (default)
+  Painter.sdf(), nosdf()                                                    - draw rects and circles as one antialiased quad per shape using a signed distance field
+  Painter.roundedRect(x, y, w, h, radius)                                   - draw a rounded rectangle (always uses the SDF path)
+  Painter.lineWidth(w)                                                      - width of the outlines of SDF shapes (rings) and of polylines, default 1
+  Painter.polyline(), nopolyline()                                          - draw line() and begin(GL_LINE_STRIP/GL_LINE_LOOP/GL_LINES) as thick antialiased lines, expanded on the GPU
+  Painter.lineJoin(PAINTER_JOIN_MITER)                                      - join of polylines: PAINTER_JOIN_MITER (default, butt caps) or PAINTER_JOIN_ROUND (round caps)
+  Painter.polyline(points, n, closed)                                       - add a polyline of vec2 points in one call, using the current color and width
+  Painter.print()                                                           - print the number of added commands and the number of draw calls after merging
+  Painter.layer("name")                                                     - draw into a retained layer (created when needed); it's only uploaded again when it changed
+  Painter.nolayer()                                                         - draw without layer again; these shapes are removed by clear()
+  Painter.clearLayer("name"), layerOrder("name", order)                     - remove the shapes of a layer, set the draw order (< 0 is drawn below the shapes without layer)
+  Painter.showLayer("name"), hideLayer("name")                              - toggle drawing of a layer
+  Painter.recorder()                                                        - get a PainterRecorder that can be filled on another thread; stitched in the order they were handed out
+  Painter.cull(), nocull()                                                  - skip shapes outside the viewport/cull rect or smaller than the cull size when they're added, see print() for the stats
+  Painter.cullRect(x, y, w, h), cullSize(1.0)                               - extra rect to cull against (shapes are not clipped), size under which shapes are rejected (0, off by default)
+  PainterRasterizer.init(w, h), draw(painter)                              - rasterize what a Painter recorded on the CPU (tiled, multithreaded) into RGBA8 pixels, no GL context needed
+  PainterRasterizer.benchmark(painter, numRuns)                             - draw the painter numRuns times and print the fastest and average timings and shapes per second
+
+  StreamBuffer                                                              - triple buffered persistent mapped buffer (orphaning when not supported) used by Painter and Font to stream vertices
+  StreamBuffer.begin(nbytes), alloc(nbytes, align, offset), end(), fence()  - start a frame, get mapped memory, unmap before drawing, fence after drawing
+  TextureAtlas.init(w, h), add(w, h, pixels, region)                       - skyline packer that packs RGBA8 images into shared GL_TEXTURE_2D pages
+  TextureArray.init(w, h, layers), add(pixels, region)                      - same size RGBA8 images as layers of a GL_TEXTURE_2D_ARRAY
   -
   Painter.resize(w,h)                                                       - call this when the viewport size changes
   Painter.width()                                                           - return the last set or queried viewport width
@@ -163,9 +234,11 @@
                                                                            
   rx_get_exe_path();                                                       - returns the path to the exe 
   rx_read_file("filepath.txt");                                            - returns the contents of the filepath.
+  rx_map_file("filepath.txt", &data, nbytes);                              - memory maps the file (read only), returns false on error. use rx_unmap_file(data, nbytes) when ready.
   rx_set_data_path("/path/to/data/")                                       - used to set a custom data path. 
   rx_to_data_path("filename.txt")                                          - convert the given filename to the data dir
   rx_get_data_path()                                                       - get the currently set/used data path                            
+  rx_get_file_size("path")                                                 - returns the size of the file in bytes, 0 when not found
   rx_is_dir("path")                                                        - returns true when the path is a dir
   rx_strip_filename("/path/filename")                                      - removes the filename from the given path
   rx_strip_file_ext("/path/filename")                                      - removes the extension from the given filename, including the dot. e.g. image.jpg becomes "image"
@@ -191,6 +264,9 @@
   rx_get_day()                                                             - get the day of the month [00-31]
   rx_get_hour()                                                            - get the hour of day [00-23]
   rx_get_minute()                                                          - get the minuts of the hours, [00-59]
+
+  rx_get_num_cores()                                                       - returns the number of hardware threads, 1 without ROXLU_USE_THREADS
+  rx_parallel_for(njobs, job, user, nthreads = 0)                          - calls job(dx, user) for dx in [0, njobs) on `nthreads` threads (0 = one per core), serially without ROXLU_USE_THREADS
                                                                            
   rx_rgb_to_hsv(r,g,b,h,s,v)                                               - convert rgb in range 0-1 to hsv in the same range. h,s,v are references
   rx_rgb_to_hsv(rgb, hsv)                                                  - convert given vector, hsv will be set (reference)
@@ -243,6 +319,12 @@
   -----------------------------------------------------------------------------------
   vec3 perpendicular(a)                                                    - get a perpendicular vector from the given vec, this vector doesn't have to be normalized!, based on http://lolengine.net/blog/2013/09/21/picking-orthogonal-vector-combing-coconuts 
   bool intersect(a,b,c,d, &result)                                         - checks if two lines intersect line (b-a) and (d-c). resturns true when they intersect and it will set result to the intersection point
+
+  SegmentIntersector
+  -----------------------------------------------------------------------------------
+  SegmentIntersector.add(x0, y0, x1, y1)                                   - add a 2D line segment
+  SegmentIntersector.intersect(std::vector<SegmentIntersection>& result)   - finds all crossings between the added segments using a uniform grid; each result has the point and the two segment indices
+  SegmentIntersector.clear()                                               - remove all segments
   
   mat4
   -----------------------------------------------------------------------------------
@@ -352,6 +434,10 @@
 #  define ROXLU_USE_AUDIO
 #endif
 
+#if !defined(ROXLU_USE_THREADS) && (__cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700))
+#  define ROXLU_USE_THREADS
+#endif
+
 // ------------------------------------------------------------------------------------
 //                              T  I  N  Y  L  I  B 
 // ------------------------------------------------------------------------------------
@@ -360,6 +446,7 @@
 #include <setjmp.h>                               /* for jpeg error handling. */
 #include <iostream>
 #include <cmath>
+#include <climits>
 #include <iterator>
 #include <algorithm>
 #include <string>
@@ -367,6 +454,22 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <stddef.h>                                /* offsetof() */
+
+#if defined(ROXLU_USE_THREADS)
+#  include <thread>
+#  include <atomic>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>                           /* SSE2, used by VertexPacker */
+#  define ROXLU_SSE2
+#endif
+
+#if defined(__F16C__)
+#  include <immintrin.h>                           /* _mm_cvtps_ph(), used by VertexPacker */
+#  define ROXLU_F16C
+#endif
 
 
 #if defined(_WIN32)
@@ -398,6 +501,8 @@
 #  include <sys/resource.h>
 #  include <sys/sysctl.h>
 #  include <sys/stat.h>                             /* stat() */
+#  include <sys/mman.h>                             /* mmap() */
+#  include <fcntl.h>                                /* open() */
 #  include <unistd.h>                               /* sysconf */
 #  include <dirent.h>                               /* DIR */
 #  include <errno.h>                                /* errno */
@@ -411,6 +516,8 @@
 #  include <libgen.h>                               /* dirname() */
 #  include <stdint.h>                               /* uint*_t types */
 #  include <sys/stat.h>
+#  include <sys/mman.h>                             /* mmap() */
+#  include <fcntl.h>                                /* open() */
 #  include <stdarg.h>
 #  define MAX_PATH 4096
 #endif
@@ -492,6 +599,7 @@ extern std::string rx_get_data_path();
 extern std::string rx_get_exe_path();
 extern std::string rx_to_data_path(const std::string filename);
 extern uint64_t rx_get_file_mtime(std::string filepath);
+extern uint64_t rx_get_file_size(std::string filepath);
 extern bool rx_is_dir(std::string filepath);
 extern bool rx_file_exists(std::string filepath);
 extern std::string rx_strip_filename(std::string path);
@@ -503,6 +611,8 @@ extern std::string rx_get_file_ext(std::string filename);
 extern std::vector<std::string> rx_get_files(std::string path, std::string ext = "");
 extern std::string rx_norm_path(std::string path);
 extern std::string rx_read_file(std::string filepath);
+extern bool rx_map_file(std::string filepath, const char** data, size_t& nbytes);
+extern void rx_unmap_file(const char* data, size_t nbytes);
 
 /* string and conversion utils */
 extern std::string rx_string_replace(std::string, char from, char to);
@@ -527,6 +637,10 @@ extern int rx_get_day();
 extern int rx_get_hour();
 extern int rx_get_minute();
 
+/* thread utils */
+extern int rx_get_num_cores();
+extern void rx_parallel_for(int njobs, void (*job)(int dx, void* user), void* user, int nthreads = 0);
+
 #endif // ROXLU_TINYLIB_H
 
 // ------------------------------------------------------------------------------------
@@ -1695,6 +1809,60 @@ extern void rx_hsv_to_rgb(vec3 hsv, float* rgb);
 extern void rx_hsv_to_rgb(vec3 hsv, float* rgb);
 extern void rx_hsv_to_rgb(float* hsv, float* rgb);
 
+/*
+  SegmentIntersector
+  ------------------
+
+  Finds all crossings between a (large) set of 2D line segments. Testing 
+  every pair with intersect() is O(n^2); instead we bin all segments into 
+  a uniform grid (only the cells a segment actually passes through) and 
+  only test the pairs that share a cell. Pairs that share multiple cells
+  are reported once. The grid buffers are reused between calls so you 
+  can call intersect() every frame without reallocating.
+
+  ````c++
+  SegmentIntersector si;
+  si.add(0, 0, 100, 100);
+  si.add(0, 100, 100, 0);
+
+  std::vector<SegmentIntersection> hits;
+  si.intersect(hits);   // hits[0].point = 50,50, hits[0].a = 0, hits[0].b = 1
+  ````
+ */
+
+struct SegmentIntersection {
+  vec3 point;                                                               /* the intersection point (xy-plane) */
+  int a;                                                                    /* index of the first segment */
+  int b;                                                                    /* index of the second segment, b > a */
+};
+
+class SegmentIntersector {
+ public:
+  SegmentIntersector();
+  void clear();                                                             /* removes all segments */
+  void add(const vec3& p0, const vec3& p1);                                 /* add a segment, only x and y are used */
+  void add(float x0, float y0, float x1, float y1);                         /* add a segment */
+  size_t size();                                                            /* returns the number of added segments */
+  size_t intersect(std::vector<SegmentIntersection>& result);               /* finds all intersections; result is cleared first. returns the number of intersections */
+
+ private:
+  void rasterize(int segment, bool fill);                                   /* counts (fill = false) or stores (fill = true) the segment in all the cells it touches */
+
+ public:
+  std::vector<vec3> segments;                                               /* two points per segment */
+  bool skip_connected;                                                      /* when true, segments that share an end point (e.g. line strips) are not reported */
+  size_t num_tests;                                                         /* number of pair tests done by the last call to intersect() */
+
+ private:
+  float min_x;                                                              /* bounds of the grid */
+  float min_y;                                                              /* bounds of the grid */
+  float inv_cell_size;                                                      /* 1.0 / size of a grid cell */
+  int grid_w;                                                               /* number of cells horizontally */
+  int grid_h;                                                               /* number of cells vertically */
+  std::vector<int> cell_offsets;                                            /* offset into cell_items per cell (prefix summed counts) */
+  std::vector<int> cell_items;                                              /* segment indices per cell */
+}; // SegmentIntersector
+
 #define PERLIN_SIZE 1024
 
 class Perlin {
@@ -2104,6 +2272,236 @@ class Program {
   int id;
 }; // Program
 
+/*
+  VertexLayout
+  ------------
+
+  Compile time description of a vertex type: the byte offset (or -1 when 
+  the type doesn't have it), the number of components, the GL type and 
+  whether fixed point values are normalized of every attribute. The 
+  defaults are float attributes. Specialize VertexLayout for your own 
+  vertex types, e.g.:
+
+  ````c++
+  template<> struct VertexLayout<MyVertex> : public VertexLayoutBase {
+    enum { 
+      position = offsetof(MyVertex, pos), 
+      texcoord = offsetof(MyVertex, uv) 
+    };
+  };
+  ````
+
+  OBJ::copy() uses the layout to write the float attributes directly into 
+  the vertices and rx_vertex_attrib_pointers<T>() calls glVertexAttribPointer()
+  for each attribute; the attribute locations follow the order in which 
+  the attributes are stored in the vertex (the first one gets location 0).
+ */
+
+struct VertexLayoutBase {
+  enum {
+    position = -1, position_size = 3, position_type = GL_FLOAT, position_normalized = GL_FALSE,
+    texcoord = -1, texcoord_size = 2, texcoord_type = GL_FLOAT, texcoord_normalized = GL_FALSE,
+    normal = -1, normal_size = 3, normal_type = GL_FLOAT, normal_normalized = GL_FALSE,
+    tangent = -1, tangent_size = 4, tangent_type = GL_FLOAT, tangent_normalized = GL_FALSE,
+    color = -1, color_size = 4, color_type = GL_FLOAT, color_normalized = GL_FALSE
+  };
+};
+
+template<class T> struct VertexLayout;                                                                       /* specialized for every vertex type, see VertexLayoutBase */
+
+template<class T> 
+inline int rx_vertex_attrib_pointers(GLuint firstIndex = 0) {                                                /* enables and sets the attributes of T for the bound VAO/VBO; returns the number of attributes */
+
+  typedef VertexLayout<T> L;
+  int attribs[5][4] = {                                                                                      /* offset, number of components, type, normalized */
+    { L::position, L::position_size, L::position_type, L::position_normalized },
+    { L::texcoord, L::texcoord_size, L::texcoord_type, L::texcoord_normalized },
+    { L::normal, L::normal_size, L::normal_type, L::normal_normalized },
+    { L::tangent, L::tangent_size, L::tangent_type, L::tangent_normalized },
+    { L::color, L::color_size, L::color_type, L::color_normalized }
+  };
+
+  /* Sort on offset so the locations follow the order of the members. */
+  for (int i = 1; i < 5; ++i) {
+    for (int j = i; j > 0 && attribs[j][0] < attribs[j - 1][0]; --j) {
+      for (int k = 0; k < 4; ++k) {
+        std::swap(attribs[j][k], attribs[j - 1][k]);
+      }
+    }
+  }
+
+  GLuint dx = firstIndex;
+  for (int i = 0; i < 5; ++i) {
+    if (attribs[i][0] < 0) {
+      continue;
+    }
+    glEnableVertexAttribArray(dx);
+    glVertexAttribPointer(dx, attribs[i][1], attribs[i][2], attribs[i][3], sizeof(T), (GLvoid*)(size_t)attribs[i][0]);
+    dx++;
+  }
+
+  return dx - firstIndex;
+}
+
+/*
+  StreamBuffer
+  ------------
+
+  Streams the vertex, index or instance data of a frame to the GPU without 
+  stalling on a buffer that the GPU is still reading from. When persistent 
+  mapping is available (GL 4.4 or GL_ARB_buffer_storage) we create one 
+  buffer that stays mapped and is split into `num_regions` regions; every 
+  frame writes into the next region and a fence makes sure the GPU is done 
+  with a region before we write into it again. Otherwise the buffer is 
+  orphaned every frame (mapped with GL_MAP_INVALIDATE_BUFFER_BIT) so the 
+  driver hands out new memory while the GPU still uses the old one.
+
+  The size of a frame must be known in begin(), which grows the buffer 
+  when needed. Because growing creates a new buffer, bind `id` and set the
+  attribute pointers after begin(). alloc() aligns the absolute offset, so
+  with the size of a vertex as alignment `offset / sizeof(vertex)` can be 
+  used as first or base vertex. Reserve `alignment` extra bytes per alloc().
+
+  ````c++
+  size_t offset = 0;
+  stream.begin(nverts * sizeof(VertexPC) + sizeof(VertexPC));
+  VertexPC* v = (VertexPC*)stream.alloc(nverts * sizeof(VertexPC), sizeof(VertexPC), offset);
+  // write the vertices into v
+  stream.end();
+
+  glBindBuffer(GL_ARRAY_BUFFER, stream.id);
+  rx_vertex_attrib_pointers<VertexPC>();
+  glDrawArrays(GL_TRIANGLES, offset / sizeof(VertexPC), nverts);
+
+  stream.fence();
+  ````
+ */
+class StreamBuffer {
+ public:
+  StreamBuffer();
+  bool init(size_t nbytes = 1024 * 1024, int numRegions = 3, bool usePersistent = true);  /* nbytes is the initial size of a region; pass usePersistent = false to always use orphaning */
+  void shutdown();
+  bool begin(size_t nbytes);                                                 /* starts a frame that uses at most nbytes; waits until the GPU is done with the next region */
+  void* alloc(size_t nbytes, size_t alignment, size_t& offset);             /* returns a pointer to nbytes of mapped memory and the offset into the buffer, NULL when it doesn't fit */
+  void end();                                                               /* call when all data is written and before drawing */
+  void fence();                                                             /* call after the draw calls that use the data of this frame */
+
+ private:
+  bool create(size_t regionSize);
+
+ public:
+  GLuint id;                                                                /* the buffer; changes when the buffer grows */
+  size_t region_size;                                                       /* size of one region in bytes */
+  int num_regions;                                                          /* number of regions; 1 when orphaning */
+  int region;                                                               /* the region we write into */
+  size_t used;                                                              /* bytes used in the current region */
+  bool is_persistent;                                                       /* true when we use a persistent mapped buffer */
+  char* ptr;                                                                /* persistent: the whole buffer, orphaning: the mapping of the current frame */
+  std::vector<GLsync> fences;                                               /* one per region */
+  size_t num_waits;                                                         /* number of times begin() had to wait for the GPU */
+};
+
+/*
+  TextureAtlas
+  ------------
+
+  Packs many small RGBA8 images into a couple of shared GL_TEXTURE_2D pages
+  so they can be drawn with one texture bind. Images are placed with the 
+  skyline bottom-left heuristic: we keep the top outline of every page and 
+  put a new image at the position where its top ends lowest. When an image
+  doesn't fit on any page a new page is created. Every image gets a border
+  of `padding` pixels that repeats its edge pixels, so linear filtering 
+  doesn't bleed in the neighbouring images.
+
+  add() returns a TextureRegion with the page texture and the texture 
+  coordinates of the image; pass it to Painter::texture() which uses these
+  texture coordinates instead of [0, 1].
+
+  ````c++
+  TextureAtlas atlas;
+  TextureRegion icon;
+  atlas.init(1024, 1024);
+  atlas.add(32, 32, pixels, icon);
+
+  painter.texture(icon, 10, 10, 32, 32);
+  ````
+
+  TextureArray
+  ------------
+
+  When all images have the same size, a GL_TEXTURE_2D_ARRAY is simpler: 
+  every image is a layer and all of them are drawn with the same texture, 
+  so the Painter never has to switch textures or sort.
+
+  ````c++
+  TextureArray sprites;
+  TextureRegion frames[16];
+  sprites.init(64, 64, 16);
+  for (int i = 0; i < 16; ++i) {
+    sprites.add(pixels[i], frames[i]);
+  }
+  ````
+ */
+struct TextureRegion {
+  TextureRegion();
+  GLenum target;                                                            /* GL_TEXTURE_2D (atlas page) or GL_TEXTURE_2D_ARRAY */
+  GLuint tex;                                                               /* the page or the texture array */
+  int page;                                                                 /* index of the atlas page */
+  int layer;                                                                /* layer in the texture array, 0 for atlas pages */
+  int x;                                                                    /* position of the image in pixels */
+  int y; 
+  int width;                                                                /* size of the image in pixels */
+  int height;
+  float u0;                                                                 /* texture coordinates of the top left corner */
+  float v0;
+  float u1;                                                                 /* texture coordinates of the bottom right corner */
+  float v1;
+};
+
+struct TextureAtlasNode {                                                   /* a horizontal segment of the skyline */
+  int x;
+  int y;
+  int width;
+};
+
+class TextureAtlas {
+ public:
+  TextureAtlas();
+  bool init(int pageWidth = 1024, int pageHeight = 1024, int padding = 1);  /* size of a page and the border around every image */
+  void shutdown();                                                          /* deletes all pages */
+  bool add(int w, int h, unsigned char* pixels, TextureRegion& region);     /* packs and uploads a w x h RGBA8 image, returns false when it's larger than a page */
+  void print();                                                             /* prints the number of pages and how much of them is used */
+
+ private:
+  int findPosition(int page, int w, int h, int& x, int& y);                 /* returns the skyline node where a w x h rect fits best and the position, -1 when it doesn't fit */
+  void addNode(int page, int node, int x, int y, int w, int h);             /* updates the skyline after placing a rect */
+  bool addPage();                                                           /* creates a new page */
+
+ public:
+  int page_width;
+  int page_height;
+  int padding;
+  std::vector<GLuint> pages;                                                /* GL_TEXTURE_2D per page */
+  std::vector<std::vector<TextureAtlasNode> > skylines;                     /* the skyline per page */
+  std::vector<size_t> used;                                                 /* number of used pixels per page (including padding) */
+  std::vector<unsigned char> padded;                                        /* scratch buffer for the image with its border */
+};
+
+class TextureArray {
+ public:
+  TextureArray();
+  bool init(int w, int h, int numLayers);                                   /* allocates a GL_TEXTURE_2D_ARRAY with numLayers RGBA8 layers of w x h */
+  void shutdown();
+  bool add(unsigned char* pixels, TextureRegion& region);                   /* uploads the next layer, returns false when all layers are used */
+
+ public:
+  GLuint tex;
+  int width;
+  int height;
+  int num_layers;                                                           /* number of allocated layers */
+  int layer;                                                                /* the next free layer */
+};
+
 #  endif // ROXLU_USE_OPENGL_H
 #endif // defined(ROXLU_USE_OPENGL)
 
@@ -2286,12 +2684,12 @@ namespace roxlu {
   protected:
     bool setupGraphics();
     void setupTexture(int w, int h, unsigned char* pix);
-    void updateVertices();
+    bool updateVertices();                                                                /* writes the vertices into the stream buffer */
 
   public:
 
     /* state */
-    bool needs_update;
+    bool needs_update;                                                                    /* true when the vertices changed since they were written into the stream buffer */
     int win_w;
     int win_h;
     float col[4];
@@ -2313,15 +2711,23 @@ namespace roxlu {
     static GLuint frag;
     static bool is_initialized;                                                           /* indicates if the prog, vert, frag and vao are initialized */
     GLuint vao;
-    GLuint vbo;
+    StreamBuffer stream;                                                                  /* the vertices are copied into this buffer when they changed */
+    size_t vertex_offset;                                                                 /* byte offset of the vertices in the stream buffer */
 
     GLuint tex;
-    size_t bytes_allocated;
     std::vector<CharacterVertex> vertices;
   };
 
 } // namespace roxlu
 
+template<> struct VertexLayout<roxlu::CharacterVertex> : public VertexLayoutBase {
+  enum {
+    position = offsetof(roxlu::CharacterVertex, x), position_size = 2,
+    texcoord = offsetof(roxlu::CharacterVertex, s),
+    color = offsetof(roxlu::CharacterVertex, fg_color)
+  };
+};
+
 static uint64_t freepixel_pixel_data[] = {0x0,0x0,0x0,0x0,0x0,0x0,0xff0000ff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000ff000000,0x0,0x0,0x0,0x0,0x0,0x0,0xffff0000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffffffff0000,0x0,0x0,0x0,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000000000,0xff00,0x0,0x0,0x0,0xff0000ff000000,0xff00,0xff00000000000000,0xffff000000ffffff,0x0,0xffffffffff000000,0xffffff00ff,0xff00000000ff00,0xffffffffffff,0x0,0xffff000000000000,0xff000000ffffff,0xff000000ff,0xffffffffffff0000,0xff000000,0x0,0xff0000ff000000,0xff000000ffff,0xff000000ffff00,0xff00ff00ff0000ff,0x0,0xff0000000000,0xff00000000,0xff00000000ff00,0xff0000,0x0,0xff00ff000000ffff,0xff00ff0000000000,0xff00000000,0xff00000000,0xff00ff0000,0x0,0xff00ff000000,0xff0000ff00,0xff0000ff0000ff,0xff00ff00000000ff,0xff0000,0xff0000000000,0xff000000ff000000,0xffff0000ffff00,0xff0000,0xff00000000000000,0xff00ff0000ff0000,0x0,0xffff00000000,0xff00000000,0xff000000ff00,0x0,0xffffff00,0xff000000ff00ff00,0xff00ff00ffff00,0xffff0000000000ff,0xffffffff0000ff00,0xff00000000ff,0xff00ff00000000,0xffff0000ffff00,0xff0000,0xff0000ffffffff,0xff00ff00ff00ffff,0xffffff0000000000,0xffff00000000,0xff00000000,0xff000000ff00,0x0,0xff0000ff,0xff00000000ffff00,0xff0000ff0000ff00,0xffffff,0xff00ff000000ff,0xff000000ff00,0xffffffff0000,0xff00ffff00ff00,0xff00000000ff0000,0xff00ff0000ff00,0xff00ff00ff00ffff,0xff00ffffff,0xff000000ff,0xff00000000,0xff000000ff00,0x0,0xff0000ff,0xff00ffffffffff00,0xff00ffff00,0xff000000ff0000ff,0xff00ff00000000,0xff000000ff00,0xffff00ff00000000,0xff00ffff00ff00,0xff00000000ff0000,0xff00ffffffff00,0xff00ff00ff00ffff,0xff00000000,0xffff0000ff,0xff00000000,0xff000000ff00,0x0,0xff0000ff,0xffffff0000ff,0xff0000ff,0xff0000ff0000ff,0xff00ff0000ffff,0xff000000ff00,0xff00ff00ff000000,0xff0000ff00ff00,0xff00000000ff0000,0xff0000000000ff00,0xff00ff0000ff0000,0xff00000000,0xff000000ff,0xff00000000,0xff000000ff00,0x0,0xff0000ff,0xff000000,0xff000000ffff00,0xff00ff00ff0000ff,0xff00ff00ff0000,0xff000000ff00,0xffffff0000ff0000,0xff00000000ff00,0xff00000000ff0000,0xff00,0xff00ff000000ffff,0xff00000000,0xff000000ff,0xff00000000,0xff00ff0000,0xffffffffffffff,0xffffff00,0xffffff000000,0xff00000000000000,0xff00000000ffffff,0xff00ff00ff0000,0xff000000ff00,0xff00000000000000,0xff00000000ff00,0xff0000,0xffffffff,0xffff000000000000,0xffffff0000ffffff,0xffffffff00000000,0xff000000ff,0xff000000,0x0,0x0,0x0,0x0,0xff,0xffff,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000ff00,0x0,0xff00000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffffffff,0x0,0xff000000000000,0xff0000ff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffffffffff0000,0xff0000,0x0,0x0,0x0,0x0,0x0,0xff0000ff000000,0x0,0xff000000000000,0xff00ff00000000ff,0xff00000000,0xff0000000000,0xff0000,0xffffff000000ff,0x0,0xff00ffffff00,0xff000000ffff0000,0xff000000ff000000,0x0,0xff00000000,0xff00ff00,0xffff000000ff,0xff00ff000000,0xffffff00,0xff0000ffffff00,0xff00ff00000000ff,0xff00000000,0xff0000000000,0xffff000000ff0000,0xff0000ff0000ffff,0x0,0xff00ffffff00,0xff0000ff0000ff00,0xffff0000ff000000,0x0,0xff00000000,0xff00ff00,0xff0000ff0000ff,0xff00ff0000,0xff0000ff00,0xff00ff0000ff00,0xff00ff00000000ff,0xff00000000,0xff000000000000,0xff00,0xff000000ff,0xff,0xff00ffffff00,0xff00ff00000000ff,0xff000000ff000000,0xff000000,0xff0000000000,0xff0000ff000000ff,0xff000000ff000000,0x0,0xff000000ff00,0xff0000000000ff,0xff0000ff0000ff00,0xff00ff00000000,0xff0000ff000000,0xffffff000000ff00,0xff000000ff,0xff000000ff00ff,0xff00ffffff00,0xff00000000000000,0xff000000ff000000,0xffff000000ff0000,0xff000000ffff,0xff0000ff000000ff,0xff00ff0000ff0000,0xff000000ff00,0xff000000ff00,0xff,0xff0000ff0000ff00,0xff00ff0000ff00,0xff000000ff000000,0xff000000ff,0xffffff0000ff,0xff000000ff00ff,0xff00ffff0000,0xff00000000000000,0xff000000ff000000,0xff0000000000ff00,0xffff000000ff0000,0xffff0000000000,0xff00ffff00ff0000,0xff000000ff00,0xff00ff0000ffffff,0xffffffff,0xff0000ffffffff00,0xff00ff00ffff00,0xff000000ff0000ff,0xff00000000,0xff000000ff,0xff000000ff00ff,0xff00ff000000,0xff00000000000000,0xff000000,0xffff0000ffff00ff,0xff000000ffffff,0xff0000000000,0xff00ffff00ff0000,0xff000000ff00,0xff000000ff00,0xff,0xff000000ffff0000,0xff00ff00ffff00,0xff000000ff00ffff,0xff00000000,0xff000000ff,0xff000000ff00ff,0xff00ff000000,0xff00000000000000,0xff000000ff000000,0xff00ff00ff00ff00,0xff000000000000,0xff0000000000,0xff000000ff0000,0xff000000ff00,0xff000000ff00,0xff,0xffff0000,0xff000000ff0000ff,0xff00000000ff0000,0xff0000ff00000000,0xff0000ff000000ff,0xffff00ffff0000,0xff00ff000000,0xff00000000000000,0xff0000ff000000,0xff00ff00ffffff00,0xff000000000000,0xff0000000000,0xff000000,0xffff0000ff00,0xff0000ff00,0xff,0xff0000,0xff000000ff0000ff,0xff00000000ff0000,0xffff0000000000,0xffffff000000ff,0xff0000ff00ff0000,0xff00ff000000,0x0,0xffffff,0xffff0000ff000000,0xff000000ffffff,0xff0000000000,0xff0000ff000000,0xff00ffff0000,0xff000000ffffff00,0xffffffffff,0x0,0x0,0x0,0x0,0x0,0xff0000,0xff00ff000000,0x0,0x0,0x0,0x0,0x0,0xffff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000ff0000,0x0,0xff00,0x0,0x0,0x0,0x0,0xff0000ff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffff000000,0x0,0xff,0x0,0x0,0x0,0x0,0xffff0000,0x0,0x0,0x0,0x0,0x0,0xffff00ffff0000,0x0,0x0,0x0,0xff0000ff00,0xff00000000000000,0x0,0x0,0x0,0xff,0x0,0x0,0x0,0xff00ffffffff0000,0xffff00ff00000000,0xffffffff0000ffff,0xffff00ffff0000,0xff00ff00,0xff,0xffffffff0000,0xff000000ffff0000,0xff00000000ffff,0xffffff000000,0x0,0x0,0xffffff0000ff,0xff000000ffffff00,0xffffff000000ffff,0xffff00000000,0xff000000ffff0000,0xff00ff00000000,0xff00ff0000,0xffff00ffff00ff,0xff000000ff00ff00,0xff00,0xff000000ff0000,0xff000000ff0000,0xff000000ff0000,0xff000000ff0000,0x0,0xff00000000000000,0xff000000ff0000,0xff00ff000000ff,0xff00ff0000,0xffff000000ff,0xffff0000,0xff0000ff0000ff,0xff00ff0000,0xffff00ffff00ff,0xff0000ffffffffff,0xff00,0xff000000ff0000,0xff000000000000,0x0,0xff0000,0x0,0xff00000000000000,0xff000000ff0000,0xff0000000000ff,0xff0000,0xffff000000ff,0xff00ff00,0xff0000ff0000ff,0xff00ff0000,0xff,0xff00ff00,0xffff00ff000000ff,0xff000000ff0000,0xff0000ffff00ff,0xffffff0000000000,0xff0000,0xff00000000000000,0xff00000000ffff,0xffff0000ff0000,0xff,0xff00000000ff0000,0xff00ff000000,0xffffff00ff00,0xffff000000ffff00,0xff0000ffff,0xff,0xff000000ff00ff00,0xffff000000ff,0xff000000ff00ff,0xff0000ff0000ffff,0xff0000ffff,0xffffff0000ff,0xff000000000000,0xff000000ff0000,0xff00ff00ff0000,0xffffff00,0xff00000000ff00,0xff00ff000000,0xffffffff,0xff0000ffffffff,0xffffffff00ff0000,0x0,0xff0000ff00ff00,0xff00ff00ff,0xffffffff0000,0xff,0xffffffff00ff0000,0xff000000000000,0xffff00ffffffffff,0xffff,0xff0000ffff0000,0xff00000000,0xff000000000000ff,0xffffffffff00ff,0xff0000ff,0xff00000000ff00,0xff0000ff00ff0000,0x0,0xff00ffffffffff,0xff0000ff00,0xff0000ff0000,0xff,0xff0000,0xff0000000000ff,0x0,0xff0000ff0000,0xff000000ff0000,0xff0000ff00000000,0x0,0xff00000000ff,0xff0000ff,0xff0000ffffffff,0xff0000ff00ff0000,0x0,0xff0000ff00ff00,0xff0000ff00,0xff0000ff0000,0xff0000000000ff,0xff00ff0000,0xff000000ff00ff,0xff000000000000,0xff0000ff0000,0xff000000ff0000,0xff00ff000000ff,0xff0000ff00000000,0xff0000000000,0xffffff0000ff,0xffff00000000ff00,0xff0000ffff,0xff,0xff000000ff00ff00,0xff00ff00ff,0xff000000ff0000,0xff000000000000ff,0xffffff000000ffff,0xffffff000000,0xff00000000000000,0xff0000ffff,0xffffff000000,0xffff0000ffffff00,0xffff0000ffffff,0xff0000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0x0,0xff000000ff,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0x0,0xff000000000000,0x0,0x0,0x0,0xff00000000,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0x0,0xff000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000000000,0xffff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000000000,0xff00,0xff000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffffffffff,0xffffffff0000ffff,0xffffff0000ff,0xff000000ffffff00,0xff0000000000ff,0xff00ff00000000,0xff000000000000,0xffffff0000ff0000,0xffffff000000,0xff00000000,0xffffff0000ffff,0xffffffffff0000,0xffffffffff,0xff0000ffff,0xffffff0000ff,0xffffff0000,0xff000000000000ff,0xff00000000,0xff000000ff00ff,0xff000000ff,0xff0000000000ff,0xff00000000,0xff000000000000,0xff00ff0000,0xff000000ff00ff,0xff0000ff00000000,0xff0000ff00ff0000,0xff0000,0xff000000000000ff,0xff00ff0000,0xff,0xff00000000,0xff0000000000ff,0x0,0xff000000ff00ff,0xff000000ff,0xff000000000000,0xff00000000,0xff000000000000,0xff00ff0000,0xff000000ff00ff,0xff00ff00000000,0xff00000000,0xff00ff,0xff0000000000ff,0xff00000000,0xff,0xff00000000,0xff0000000000ff,0xff00000000000000,0xff00ff000000,0xff0000ff000000ff,0xffffffff0000ffff,0xffffffffff00ff,0xff000000000000,0xff0000,0xff000000ff00ff,0xff00ffffffff00,0xff00000000,0xff00ff,0xff0000000000ff,0xff00000000,0xff000000ff00ff,0xff00ff00000000,0xff0000ffffffff,0xff0000000000ffff,0xff00000000,0xff00ffff0000ff,0xff000000ff0000,0xff00000000,0xff00ffffffffff,0xff00000000ff0000,0xff000000ff0000,0xff00ff000000ff,0xff00000000,0xffffffff00ff,0xff0000ffffffff,0xffffffff00000000,0xff000000ff00ff,0xff00ff00000000,0xffff00ff00000000,0xff000000ff0000,0xffff00ffff0000,0xffff00ff00000000,0xff00000000ffff,0xff00000000,0xff00ffffffffff,0xff000000ff0000,0xffffffffff0000,0xff00ff000000ff,0xff00000000,0xff00ff,0xff0000000000ff,0xff00000000,0xff000000ff00ff,0xff00000000,0xff00ff00000000,0xff000000ff0000,0xff000000ff0000,0xff00000000,0xff000000ff0000,0xff00000000,0xff000000000000,0xff000000ff0000,0xff000000ff0000,0xff00ff000000ff,0xff00000000,0xff00ff,0xff0000000000ff,0xff00ff0000,0xff000000ff00ff,0xff00000000,0xff00ff000000ff,0xff000000ff0000,0xff000000ff0000,0xff0000ff000000,0xff000000ff0000,0xff00000000,0xff000000000000,0xff0000,0xff000000ff0000,0xff0000ffff0000ff,0xff0000ff00ff0000,0xff0000,0xff000000000000ff,0xff00ff0000,0xffff0000ff00ff,0xff0000ff0000ff,0xff000000ffffff00,0xff00000000ffff,0xffffff000000,0xff00000000ffff00,0xffff00000000ffff,0xffffff000000ff,0xff00000000000000,0xff00000000ffff,0xff000000ff0000,0xff00ffff00,0xffffff0000ffff,0xffffffffff0000,0xff,0xff00ffffff,0xff00ffff0000ff,0xff000000ffff00,0x0,0x0,0x0,0x0,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffffff000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff,0xff,0x0,0x0,0x0,0x0,0x0,0xff00ff000000ff,0xff00000000,0xff000000ff,0xffffffff,0xffffffff000000ff,0xffffff000000,0xff00ff000000ff,0xffffffff00ff0000,0xff000000ff00ff,0xff000000000000ff,0xff0000ff00,0xff,0xff,0x0,0x0,0xffffff0000,0xff0000ff0000ff,0xff00000000,0xff00ff0000ff,0xff0000ff000000ff,0xff0000ff00,0xff000000ff00ff,0xff00ff000000ff,0xff0000,0xff000000ff00ff,0xff00,0xff000000ff,0xff,0xff,0x0,0x0,0xff0000,0xff000000ff00ff,0xffff00000000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff00ff,0xff0000ff000000ff,0xff00,0xff000000ff00ff,0xff00,0xff00000000,0xff,0xff,0x0,0x0,0xff0000,0xff000000ff00ff,0xff00ff00000000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff00ff,0xff0000ff000000ff,0xff0000000000ff00,0xff000000ff0000,0xff000000ff0000,0xff00ff0000,0xffff000000ff,0xff000000ffff00ff,0xff0000ffff,0xffffff0000ff,0xffffffff,0xff00000000ffff,0xff00ff00000000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xffffff0000ff,0xff000000ff,0xff0000000000ff,0xff000000ff0000,0xff000000ff0000,0xff00ff0000,0xff0000ff0000ff,0xff00ff0000ffff,0xff00ff0000,0xff000000ff00ff,0xff0000,0xff000000ffffff,0xff00ff00000000,0xff000000ff00ff,0xff0000ffffffff,0xffffffff00ff0000,0xff000000000000,0xff0000ff000000ff,0xffff000000ffff,0xff000000ff0000,0xff000000ff0000,0xff00ff0000,0xffffffff0000ff,0xff00ff000000ff,0xff00000000,0xffffffffff00ff,0xff0000,0xff000000ff00ff,0xff0000ff00000000,0xff000000ff00ff,0xff0000000000ff,0xff0000ff00ff00ff,0xff000000000000,0xff0000ff000000ff,0xff0000ff00,0xff000000ff0000,0xff0000ff000000,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00000000,0xff00ff,0xff0000,0xff0000ff0000ff,0xff00000000,0xff00ff0000ff,0xff000000000000ff,0xff0000ff0000ff00,0xff000000ff0000,0xff00ff000000ff,0xff00ff0000,0xff000000ff0000,0xff0000ff000000,0xff00ffff00,0xffff0000ff00ff,0xff00ff000000ff,0xff0000ff00ff0000,0xff00ff,0xff000000ff0000,0xffff00ff000000ff,0xff00ffffff,0xff000000ff,0xff,0xff00ff00ff,0xffffff0000ff,0xff0000ffffff00,0xffffffff00ff0000,0xffffff0000ff,0xff0000ff00000000,0xffffff0000ff00ff,0xff00ffff000000,0xff000000ffffffff,0xffff000000ffff,0xffffff0000ff,0xff000000ff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0xff00000000000000,0x0,0x0,0xff00000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000000000,0x0,0x0,0xff00000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff,0x0,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000ff000000,0x0,0x0,0xff000000000000,0x0,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffff00000000,0xff000000000000,0x0,0x0,0xff0000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00ff0000ff00,0xff000000000000,0xffffffff00000000,0xff000000ff,0xffff0000000000ff,0xffffff,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0xff000000000000,0xffffffffff0000,0xff0000ff000000,0xff000000000000,0x0,0xff000000ff,0xff,0xff00,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0xff000000000000,0xff000000000000,0xff000000ff0000,0xff000000000000,0x0,0xff,0xff,0xff00,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0xff00ff00ffff00,0xff0000000000ffff,0xffffffffff0000,0xff000000ff,0xffff00ff000000ff,0xffffff000000,0xff000000ffff00ff,0xffff00ff00ffffff,0xffffff000000,0xff00ffffffffff,0xff00ff0000,0xff000000ff00ff,0xffff00ff000000ff,0xffffffff00ffffff,0xff00000000ff,0xffffffffff,0xffff00ffff0000ff,0xff000000ff0000,0xff000000000000,0xff0000ff,0xffff000000ff,0xff000000ff00ff,0xff00ff0000ffff,0xffff00ff0000,0xff000000ff00ff,0xff000000ff0000,0xff00ff0000,0xff000000ff00ff,0xff000000ff,0xff0000,0xff000000ff,0xff00000000,0xff00ff000000ff,0xffff0000ff0000,0xffff00000000,0xffffff,0xff000000ff,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xffffffff0000,0xff000000ff0000,0xff00ffff00ff0000,0xffffff0000ff,0xffff00ff00,0xffff00000000ffff,0xffff000000,0xffff0000,0xff00ff000000ff,0xff00ff0000,0xff00000000,0xff00000000ff00ff,0xff00000000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff000000000000,0xff000000ff0000,0xff00ff0000ff0000,0xff00ff000000,0xffff0000,0xff0000000000ff,0xff0000,0xff0000,0xff00ffff0000ff,0xff00ff0000,0xff000000,0xff000000ff0000ff,0xff00000000,0xff000000ff00ff,0xff00ff000000ff,0xff00ffff00,0xff000000ff0000,0xff000000ff0000,0xff00ff0000ffff00,0xff000000ff0000,0xff000000ffff0000,0xff0000000000,0xff0000,0xff00,0xff00ff00ffff00,0xffffffff00ff0000,0xffffffffff00ff,0xffff00ff000000ff,0xff00ffffff,0xffffff0000ff,0xff000000ffffffff,0xff00ff00ff,0xffffff000000,0xff0000ffffff0000,0xff000000ff00ff,0xff000000ff0000,0xffff000000ff0000,0xffffffff00ffffff,0xffffffffff00ff,0xffffffffff,0xff00000000,0x0,0x0,0x0,0x0,0x0,0xff,0xff0000,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0xff000000ff,0x0,0x0,0x0,0x0,0x0,0xff,0xff0000,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0xffffff00,0x0,0x0,0x0,0x0,0x0,0xff,0xff0000,0x0,0x0,0x0,0x0,0xffff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00,0xff00000000ff00,0x0,0x0,0xff,0xff000000,0xff000000,0xff,0x0,0xff00,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000,0xffffff00000000ff,0xffffff000000,0xff000000ff00ff00,0xffff,0xff00000000,0xff00000000ff0000,0xff00ff000000ffff,0xffffff000000,0xff000000ff0000,0x0,0x0,0x0,0xffff00ffff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0xff00000000,0xffffff0000ff,0xffff00ffff,0x0,0x0,0xff000000ffffff00,0xffffff000000ffff,0xffffff000000,0xff000000ffffff00,0xffff00000000ffff,0xffffffffff0000,0xffff00ffffffffff,0xffffffff00ffffff,0xff000000ff00ff,0xff000000ff0000,0xff00000000000000,0xffffff000000ffff,0xff000000ff0000,0x0,0x0,0x0,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff0000ff0000,0xff00ff,0xff0000000000ff,0xff00000000,0xff000000ff0000,0xff0000ff00ff00,0xff000000000000,0xff00ff0000ff0000,0xff0000,0x0,0x0,0x0,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff0000,0xff0000000000ff,0xff00000000,0xff0000ffff0000,0xff00ff000000ff,0xff000000000000,0xff00000000,0xffff0000ff,0x0,0x0,0xff00000000,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff0000,0xff0000000000ff,0xff00000000,0xff00ff00ff0000,0xff00ff000000ff,0xff00ff00ffff00,0xff00000000,0xffff00ff00ff,0x0,0xff00ff00ff00ff,0x0,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xffffffff0000,0xffff0000ffffffff,0xffffffff0000ffff,0xff00ff00ff0000,0xff00ff000000ff,0xff0000ffff00ff,0xffffff0000ff0000,0xff00ffffff0000,0xffff000000000000,0xffffff000000ffff,0xff000000ff,0xffff00ffffffffff,0xffffffff00ffffff,0xffffffffff00ff,0xffff00ffffffffff,0xff00ffffff,0xff0000,0xff0000000000ff,0xff00000000,0xff00ff00ff0000,0xff00ff000000ff,0xff00000000000000,0xff0000ffff,0xffff000000ff,0xff00000000000000,0xff00ff000000ff00,0xff00000000,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff0000,0xff0000000000ff,0xff00000000,0xffff0000ff0000,0xff00ff000000ff,0x0,0x0,0xff000000000000,0x0,0xff00ff00ff00ff,0xff000000,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff0000ff0000,0xff00ff,0xff0000000000ff,0xff00000000,0xff000000ff0000,0xff0000ff00ff00,0x0,0x0,0xff000000ff0000,0x0,0x0,0xff0000,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xffff000000ff0000,0xffffffffff0000,0xffff00ffffffffff,0xffffffff00ffffff,0xff000000ff00ff,0xff000000ff0000,0x0,0x0,0xffffff000000,0x0,0x0,0xff000000ff0000,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0x0,0x0,0x0,0x0,0xff000000ff0000,0x0,0x0,0x0,0x0,0xffff0000000000,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0x0,0x0,0x0,0x0,0xffffff000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000,0xff,0x0,0xff00000000000000,0xff00000000000000,0xff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000ff0000,0xffffff000000ffff,0xff00ff000000,0x0,0xff0000000000ff,0xffffff000000,0xff00ff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000000000,0x0,0x0,0x0,0xff00000000,0x0,0x0,0x0,0x0,0xff000000,0xff000000,0xff,0x0,0xff0000,0xff0000000000,0xff0000000000,0xff000000ff0000,0xff0000,0xff0000000000ff,0xff00000000,0xff00ff00ff0000,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xffffff0000000000,0x0,0xff0000,0xffffff00000000ff,0xff00ff000000,0xff00ff00,0xff000000000000,0xff00000000,0xff000000ff0000,0xff000000ff00ff00,0xff00ff000000ff00,0xff00ff000000,0xff0000ff00ff00,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00000000,0xff000000ff,0xff00000000000000,0xffffff000000ff00,0xff00ff000000,0xff0000,0xff000000000000,0xff00000000,0xff0000ff00ff00,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ffff0000ff,0xff00ff0000,0xff000000ff00ff,0xffff00ff000000ff,0xff000000ff,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000000000,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff00ff00ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff0000ff0000ff00,0xffff00000000,0xffff0000,0xffff00000000ffff,0xffff00000000,0xff000000ffff0000,0xffffff000000ffff,0xffffff000000,0xffffff00,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff00ff00ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff00ff0000,0xff0000ff000000,0xff0000ff0000ff00,0xff0000ff0000,0xff0000ff0000ff,0xff00ff0000ff00,0xff00ff0000,0xff000000ff00ff,0xff000000ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff00ff00ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xffff00ff00ffff00,0xffffffff000000,0xff0000ffffffff00,0xffffff0000ffffff,0xffffffff0000ff,0xff00ffffffff00,0xffffffff00000000,0xffffffffff00ff,0xffffffffff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff0000ffff,0xff00ff0000,0xff000000ff00ff,0xffff00ff000000ff,0xff000000ff,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00000000,0xff0000,0xff0000000000ff,0xff000000ff00ff00,0xff00ff000000ff00,0xff00ff000000,0xff0000ff00ff00,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00000000,0xffff0000ff00ff,0xff00ffff0000ff,0xff0000ff00ffff00,0xffff0000ff00ff,0xff00ffff0000ff,0xff00ff0000,0xff0000,0xff0000000000ff,0xff0000,0xff0000000000ff,0xff00000000,0xff00000000ff00ff,0xffffff000000ffff,0xffffff000000,0xff0000ffffff00,0xffff00ff00000000,0xff00ffff000000,0xff0000ff00ffff00,0xffff0000ff00ff,0xff00ffff0000ff,0xff0000ff00ffff00,0xffffff000000ffff,0xffffff000000,0xff0000ffffff00,0x0,0x0,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff,0x0,0xff000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000000000,0xff,0x0,0xff000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffffff00,0xffffff0000000000,0xff,0x0,0xff00000000000000,0x0,0xff000000,0xff000000,0xff,0x0,0xff00000000000000,0xff00000000000000,0xff00000000,0x0,0xff00,0x0,0x0,0x0,0x0,0x0,0xff00ff00,0xffffff000000ffff,0xff00000000,0xff0000,0xffffff00000000ff,0xff00ff000000,0x0,0xff0000000000ff,0xff00000000,0xff00ff00,0xff000000ff,0xff00ff000000,0xff000000ffffff00,0xffffff000000ffff,0xff0000ff000000,0xffffff00,0xffff0000ff00ff00,0xffffff00000000ff,0xff00000000,0xff00000000ff0000,0xffffff000000ff00,0xff00ff000000,0x0,0xff0000000000ff,0xff00ff000000,0xff00ff00,0xff000000ff,0xff00ff000000,0xff000000ff,0xff00000000,0xffff000000ff,0xff000000ff,0x0,0xff,0x0,0x0,0x0,0x0,0xff00000000,0x0,0x0,0x0,0xff00000000,0x0,0xff000000ff,0xff00000000,0xff,0xff000000ff,0xff000000ffffff00,0xffff00ff0000ffff,0xffffff000000,0xff000000ffffff00,0xffffff000000ffff,0xffffff000000,0xff0000ffffff00,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xffff00ff00ff0000,0xff000000ff0000,0xff000000ff,0xff0000ffff,0xffff000000ff,0xff00ff000000ff,0xff00ff000000ff,0xffff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ffff0000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xffff00ff0000,0xff000000ff00ff,0xff0000ff000000ff,0xff00ff0000,0xff0000ff0000ff,0xff00ff000000ff,0xff00ffffffffff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff00ff00ff,0xff00ff0000,0xff000000ff00ff,0xff0000ff000000ff,0xff00ffff00,0xffff00ff0000ff,0xff0000ffffffffff,0xffffffff00ffffff,0xffffffff0000ff,0xff00ffffffffff,0xff0000000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff00ff00ff,0xff00ff0000,0xff000000ff00ff,0xff000000ff,0xff0000ffff,0xffff000000ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff0000000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff0000ffff,0xff0000ff00ffff00,0xffff0000ff00ff,0xffff0000ff,0xff0000ffff,0xffff000000ff,0xff00ff000000ff,0xff00ffff00,0xffff0000ff00ff,0xff00ff000000ff,0xff000000ffffff00,0xff0000ffff,0xffffff0000ff,0xff000000ffffff00,0xffffff000000ffff,0xffffff000000,0xff000000ffffff00,0xffff0000ff00ff,0xff00ffff0000ff,0xff00ffff00,0xffffffff000000ff,0xff00000000,0xff0000ff000000ff,0xff00ff00ff,0xff00ffff0000ff,0xff00ff000000ff,0x0,0x0,0x0,0x0,0x0,0x0,0xff,0x0,0x0,0x0,0xff000000ff,0xff00000000,0x0,0x0,0x0,0xff0000ff000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff000000ff,0xff00000000,0x0,0x0,0x0,0xff0000ff000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000000000,0xff000000ff,0xffff000000,0x0,0x0,0x0,0xff00ff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00,0xff0000ff000000,0xff000000000000,0xff00,0x0,0x0,0x0,0xff0000ff000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff,0xffff00000000,0xff00000000000000,0xffffff00000000ff,0x0,0x0,0x0,0xffff00000000,0xff00000000000000,0xffffff,0x0,0x0,0x0,0xff00000000,0x0,0x0,0xff00000000000000,0x0,0xff0000ff00,0x0,0x0,0x0,0x0,0x0,0xff0000ff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000ffff,0xffff00000000,0xffff0000ffff0000,0xffffffff000000ff,0xffffff0000ff,0xffff000000ff0000,0xffffff,0xffffffffff0000,0xffff0000,0xffffff000000ffff,0xffff00000000,0xff000000ff0000,0xff00ff0000,0xff0000,0xff0000000000ff,0xff00000000000000,0xff000000ff0000,0xff0000ff000000,0xff000000ff0000,0xff0000ff00,0x0,0xff000000ff0000,0x0,0xff0000,0xff00000000ff0000,0xffffff0000ff0000,0xff0000ff000000,0xff000000ff0000,0xff0000ff00,0xff0000,0xff0000000000ff,0xff000000000000,0x0,0xff0000,0xff000000000000,0xff00ff0000,0x0,0xff000000000000,0x0,0xff0000,0xff000000000000,0x0,0xff0000,0xff000000000000,0xff000000ff,0xff0000,0xff0000000000ff,0xff0000ffff0000,0xffffff0000000000,0xff0000,0xff0000ffffff00,0xff00ff0000,0xffffff000000,0xff0000ffffff00,0xffffff0000000000,0xff0000,0xff0000ffffff00,0xffff0000000000,0xff00ff,0xff00ff00ffff00,0xff000000ff,0xff00ff,0xff0000000000ff,0xff00ff0000ff00,0xff00000000,0xff00ff,0xff00ff000000ff,0xffffffff00ff0000,0xff000000ff0000,0xffff00ff000000ff,0xff0000ffff,0xffffffff00ff,0xff00ff000000ff,0xff0000ff00000000,0xff00ff,0xffff00ffff0000ff,0xff0000ff00000000,0xff0000,0xff0000000000ff,0xff00ffffffff00,0xff00000000,0xff0000,0xff0000000000ff,0xff00ff0000,0xffffffffff0000,0xff00ffffffffff,0xffffffff00000000,0xff00ff,0xff00ffffffffff,0xff00000000,0xff00ff,0xffff00ff000000ff,0xffffff000000ff,0xff0000,0xff0000000000ff,0xff00ff000000ff,0xff00000000,0xff0000,0xff0000000000ff,0xff00ff0000,0xff0000,0xff0000000000ff,0xff00000000,0xff0000,0xff0000000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff000000ff,0xff0000,0xff,0xff0000ffff0000ff,0xff00ff0000,0xff0000ff0000ff,0xff00ff000000ff,0xff0000ff00,0xff0000,0xff0000000000ff,0xff00000000,0xff0000,0xff000000000000ff,0xff0000ff00ff0000,0xff0000ff0000ff,0xff00ffff0000ff,0xff0000ff0000ff00,0xff0000,0xff0000000000ff,0xff00ffff00,0xffffff000000ffff,0xffff00000000,0xffff0000ffffff00,0xffffffff000000ff,0xffffff0000ff,0xffff0000ffffff00,0xffffff0000ffffff,0xffffffffff00ff,0xffffff00,0xffff0000ffffff,0xffffff000000ff,0xff00ff00ffff00,0xff00ff0000,0xffffffffff00ff,0xff00ffffffffff,0xff000000,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000ff00,0x0,0x0,0x0,0xff,0xff00000000,0x0,0x0,0x0,0xff000000,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000ff00,0x0,0x0,0xff00000000,0xff000000ff,0xff000000ff,0xff0000000000ff,0x0,0xff0000,0xff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000,0xff,0x0,0xffffff0000000000,0xff00000000,0xffffff00,0xff0000000000ff,0x0,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00,0x0,0xff00000000000000,0xff0000,0x0,0x0,0xff00000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0x0,0xff,0x0,0x0,0xffff,0xffffff000000,0x0,0xff0000000000ff,0x0,0xffff00,0x0,0x0,0xff00000000000000,0x0,0x0,0xff000000,0xff000000,0xff00000000000000,0x0,0x0,0xff0000000000,0xff,0x0,0x0,0xff0000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000ff0000ff,0xff000000ff0000,0xff000000ff0000,0xff000000000000,0xffff000000ff0000,0xff00000000,0xffff0000ffffff00,0xffffffff00ffffff,0xff00000000,0xffff0000ffffffff,0xffffffff0000,0x0,0xffff000000000000,0xffff,0xff00ff000000ff00,0xffff0000,0xff000000ff00ff,0xff000000ff0000,0xff000000ff0000,0xff000000000000,0xff000000ff0000,0xff00ff000000,0xff000000000000,0xff00000000,0xff000000ff,0xff00,0xff000000,0xff00000000ff,0xff00000000000000,0x0,0xff00ff000000ff00,0xff000000,0xffff0000000000ff,0xff0000,0xff0000ffff0000,0xffff000000000000,0xff0000,0xff000000ff0000,0xff000000000000,0xff00000000,0xff,0xff00,0xff000000,0xff00ffff00000000,0xff0000000000ff00,0x0,0xffff,0xff000000,0xff0000000000ff,0xffff00ff00ff00ff,0xff00ff00ff0000,0xff0000ffff00ff,0xffff00ff00ff00ff,0xff000000ff0000,0xff0000ffffff00,0xff00000000,0xffff00ff00ff,0xffff000000ff00,0xff000000ff000000,0xffff00000000ff,0xff0000000000ff00,0xffff000000,0xffff000000ff00,0xff000000,0xff0000000000ff,0xffff00ff00ff,0xff00ff00ff00ff,0xff00ff0000ffff,0xffff00ff00ff,0xff000000ff00ff,0xffff00ff000000ff,0xff0000ffff,0xff0000ffff00ff,0xff00000000ff00,0xff000000,0xff00ffff000000ff,0xff0000000000ff00,0xff00000000,0xff00000000ff00,0xff000000,0xff0000000000ff,0xff00ff00ff,0xff00ff00ff00ff,0xff00ff000000ff,0xff00ff00ff,0xff000000ff00ff,0xff00ff000000ff,0xffffffff00000000,0xff0000,0xff00000000ff00,0xff000000,0xff00000000ff,0xff0000ffffffff00,0xff00000000,0xff00000000ff00,0xff000000,0xff0000000000ff,0xff00ffff00,0xffff0000ff00ff,0xff00ff000000ff,0xff00ffff00,0xff000000ff00ff,0xff00ff000000ff,0xff0000ff00000000,0xff0000,0xff00000000ff00,0xff000000,0xff,0xff0000000000ff00,0xff00000000,0xff00000000ff00,0xff000000,0xff0000000000ff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff00ff0000ff,0xff00ff000000ff,0xff0000ff00000000,0xff0000,0xff00000000ff00,0xff000000,0xff,0xff0000000000ff00,0xff00000000,0xff00000000ff00,0xff000000,0xff00ffffffffff,0xff00ff0000,0xff000000ff00ff,0xff00ff000000ff,0xff00ff0000,0xff000000ff,0xffff0000ffffff00,0xff00ffffff,0xff00ff,0xffffff00ffffffff,0xff00ffffffff00ff,0xffffff,0xffff000000000000,0xffffffff00ffff,0xffffff00ffffffff,0xffffff0000ff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0xff00,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0xff00,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff,0x0,0x0,0xff,0xff00000000000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000000000,0x0,0x0,0xff00000000000000,0xffff,0xff00000000000000,0xffff000000ff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000,0x0,0x0,0x0,0xffff00000000,0xff000000000000,0x0,0x0,0x0,0xff0000,0xff0000000000,0xffffff00,0xffffff0000000000,0xff000000000000,0xffff0000ffff00,0xff00ffffffff0000,0xff00ff,0xffff000000ffff00,0xffff,0xffff0000000000,0xff0000ff00000000,0xff0000ffffff,0xffff000000000000,0xffffffff00ffff,0xffff00,0xff000000,0xff0000000000,0xff00,0xff00000000000000,0xff0000000000,0xff0000ff000000,0xff000000,0xffff,0xff00000000ff0000,0xff00000000,0xff0000ff000000,0xff00000000,0xff00000000ff,0xff00000000000000,0xff00000000,0xff0000ff,0xff000000,0xff00ff00000000,0xff00,0xff00000000000000,0xff0000000000,0xff0000ffffff00,0xff000000,0xff00000000ff,0xff000000ffff0000,0x0,0xff000000000000,0xff00000000,0xff,0xff00000000000000,0xff00000000,0xff0000ff,0x0,0x0,0xff0000000000ff00,0xff0000000000ff00,0xff0000000000,0xff0000ff0000ff,0xff000000,0xff00000000ff,0xff00000000ff0000,0xffff000000,0xff0000ffffff00,0xff00000000,0xffff000000ff,0xff000000ff000000,0xff00000000,0xff0000ff,0xff000000ffff0000,0xffff00ff0000,0xff00000000ff00,0xff00000000ff0000,0xff0000000000,0xff0000ffffff00,0xff000000,0xffffffff000000ff,0xff00000000ff0000,0xff00000000,0xff0000ff000000,0xff00000000,0xff00000000ff,0xff00000000000000,0xff00000000,0xffff00,0xff000000,0xff000000ffff,0xff00000000ff00,0xff00000000ff0000,0xff0000000000,0xff0000ffffffff,0xff000000,0xff00000000ff,0xff00000000ffff00,0xff00000000,0xff0000ff000000,0xffffff0000,0xff00000000ff,0xff0000ffffffff00,0xff00000000,0xffffff00ffffffff,0xff0000ff,0xff000000ffff,0xffff000000ff00,0xff000000ffff0000,0xff0000000000,0xff000000000000,0xff000000,0xff,0xff00000000ff0000,0xff00000000,0xff0000ff000000,0xff00000000,0xff00000000ff,0xff000000ff000000,0xff00000000,0x0,0xff000000ff000000,0xff0000ff0000,0xff00000000ff00,0xff00000000ff0000,0xff0000000000,0xff000000000000,0xff000000,0xffffffff000000ff,0xff00000000ff0000,0xff00000000,0xff0000ff000000,0xff00000000,0xff00000000ff,0xff00000000000000,0xff00000000,0x0,0xff000000,0xff0000000000,0xff0000000000ff00,0xff0000000000ff00,0xff0000000000,0xffff000000000000,0xffffffff00ff,0xffffff,0xffff00ffffff0000,0xffffffff00ffff,0xffff0000ff000000,0xff0000ff000000ff,0xffffffff00ffffff,0xffff000000000000,0xffffffff00ffff,0x0,0xffffffff0000,0xffffffff00000000,0xff00,0xff00000000000000,0xff0000000000,0x0,0x0,0x0,0x0,0x0,0xff000000,0xff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0xff00,0xff00000000000000,0xff0000000000,0xff00000000000000,0x0,0x0,0x0,0x0,0xff0000ff,0xffff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0xffffff00,0xffffff0000000000,0xff000000000000,0xff000000000000,0x0,0x0,0x0,0x0,0xffff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00,0xff00000000,0xffff0000000000,0xffff00000000ff00,0xff00ffff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xffffff00ff00ff,0xff0000000000,0xff000000000000,0xff0000000000ffff,0xff00ff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00ff,0xff0000000000,0xff000000000000,0xff0000000000ff00,0xff00ff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff00,0xff0000000000,0xff000000000000,0xff00000000ff00,0xff0000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff0000ff000000,0xffff00000000ffff,0xffff00,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff0000ff000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff000000000000,0x0,0xff000000000000,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff000000000000,0x0,0x0,0xff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff0000ff0000ff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff0000ff0000ff,0xff00000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000000000,0xff0000ff0000ff,0xffff000000,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0xff0000ff00000000,0xffff00ffff00ff,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0};
 static int freepixel_char_data[] = {32,121,187,3,16,-1,0,7,33,126,153,1,16,3,0,7,34,26,34,5,16,1,0,7,35,32,34,5,16,1,0,7,36,30,0,6,16,1,0,7,37,37,0,6,16,1,0,7,38,38,34,5,16,1,0,7,39,126,17,1,16,3,0,7,40,125,187,2,16,3,0,7,41,12,204,2,16,2,0,7,42,92,170,4,16,2,0,7,43,97,170,4,16,3,0,7,44,15,204,2,16,2,0,7,45,80,34,5,16,1,0,7,46,126,68,1,16,3,0,7,47,92,34,5,16,1,0,7,48,98,34,5,16,1,0,7,49,112,170,4,16,2,0,7,50,110,34,5,16,1,0,7,51,116,34,5,16,1,0,7,52,122,34,5,16,1,0,7,53,0,51,5,16,1,0,7,54,6,51,5,16,1,0,7,55,12,51,5,16,1,0,7,56,18,51,5,16,1,0,7,57,24,51,5,16,1,0,7,58,126,51,1,16,3,0,7,59,18,204,2,16,2,0,7,60,109,187,3,16,2,0,7,61,48,51,5,16,1,0,7,62,113,187,3,16,2,0,7,63,60,51,5,16,1,0,7,64,98,17,6,16,1,0,7,65,66,51,5,16,1,0,7,66,14,34,5,16,1,0,7,67,78,51,5,16,1,0,7,68,84,51,5,16,1,0,7,69,90,51,5,16,1,0,7,70,96,51,5,16,1,0,7,71,102,51,5,16,1,0,7,72,108,51,5,16,1,0,7,73,10,187,4,16,2,0,7,74,120,51,5,16,1,0,7,75,0,68,5,16,1,0,7,76,6,68,5,16,1,0,7,77,65,0,6,16,1,0,7,78,12,68,5,16,1,0,7,79,18,68,5,16,1,0,7,80,24,68,5,16,1,0,7,81,30,68,5,16,1,0,7,82,36,68,5,16,1,0,7,83,42,68,5,16,1,0,7,84,114,0,6,16,1,0,7,85,48,68,5,16,1,0,7,86,0,17,6,16,1,0,7,87,7,17,6,16,1,0,7,88,54,68,5,16,1,0,7,89,21,17,6,16,1,0,7,90,60,68,5,16,1,0,7,91,105,187,3,16,2,0,7,92,72,68,5,16,1,0,7,93,117,187,3,16,2,0,7,94,56,17,6,16,1,0,7,95,0,0,7,16,0,0,7,96,126,85,1,16,3,0,7,97,90,68,5,16,1,0,7,98,96,68,5,16,1,0,7,99,102,68,5,16,1,0,7,100,72,51,5,16,1,0,7,101,114,68,5,16,1,0,7,102,120,68,5,16,1,0,7,103,0,85,5,16,1,0,7,104,6,85,5,16,1,0,7,105,35,187,4,16,2,0,7,106,40,187,4,16,1,0,7,107,24,85,5,16,1,0,7,108,45,187,4,16,2,0,7,109,44,0,6,16,1,0,7,110,36,85,5,16,1,0,7,111,42,85,5,16,1,0,7,112,48,85,5,16,1,0,7,113,54,85,5,16,1,0,7,114,60,85,5,16,1,0,7,115,66,85,5,16,1,0,7,116,72,85,5,16,1,0,7,117,78,85,5,16,1,0,7,118,84,85,5,16,1,0,7,119,14,17,6,16,1,0,7,120,90,85,5,16,1,0,7,121,96,85,5,16,1,0,7,122,102,85,5,16,1,0,7,123,50,187,4,16,1,0,7,124,126,102,1,16,3,0,7,125,21,204,2,16,2,0,7,126,0,102,5,16,1,0,7,160,8,204,3,16,-1,0,7,161,126,136,1,16,3,0,7,162,6,102,5,16,1,0,7,163,119,17,6,16,1,0,7,164,12,102,5,16,1,0,7,165,7,34,6,16,1,0,7,166,126,119,1,16,3,0,7,167,18,102,5,16,1,0,7,168,24,102,5,16,1,0,7,169,23,0,6,16,1,0,7,170,0,187,4,16,2,0,7,171,30,102,5,16,1,0,7,172,40,204,1,16,5,0,7,173,85,187,4,16,1,0,7,174,86,0,6,16,1,0,7,175,4,204,3,16,2,0,7,176,0,204,3,16,2,0,7,177,20,187,4,16,2,0,7,178,30,204,2,16,2,0,7,179,33,204,2,16,2,0,7,180,36,204,1,16,3,0,7,181,42,17,6,16,1,0,7,182,49,17,6,16,1,0,7,183,38,204,1,16,3,0,7,184,27,204,2,16,2,0,7,185,24,204,2,16,2,0,7,186,80,187,4,16,2,0,7,187,36,102,5,16,1,0,7,188,70,17,6,16,1,0,7,189,16,0,6,16,1,0,7,190,58,0,6,16,1,0,7,191,42,102,5,16,1,0,7,192,48,102,5,16,1,0,7,193,54,102,5,16,1,0,7,194,60,102,5,16,1,0,7,195,66,102,5,16,1,0,7,196,72,102,5,16,1,0,7,197,78,102,5,16,1,0,7,198,0,34,6,16,1,0,7,199,84,102,5,16,1,0,7,200,90,102,5,16,1,0,7,201,96,102,5,16,1,0,7,202,102,102,5,16,1,0,7,203,108,102,5,16,1,0,7,204,70,187,4,16,2,0,7,205,30,187,4,16,2,0,7,206,55,187,4,16,2,0,7,207,75,187,4,16,2,0,7,208,112,17,6,16,1,0,7,209,114,102,5,16,1,0,7,210,120,102,5,16,1,0,7,211,0,119,5,16,1,0,7,212,6,119,5,16,1,0,7,213,12,119,5,16,1,0,7,214,18,119,5,16,1,0,7,215,95,187,4,16,2,0,7,216,24,119,5,16,1,0,7,217,30,119,5,16,1,0,7,218,36,119,5,16,1,0,7,219,42,119,5,16,1,0,7,220,48,119,5,16,1,0,7,221,84,17,6,16,1,0,7,222,54,119,5,16,1,0,7,223,60,119,5,16,1,0,7,224,66,119,5,16,1,0,7,225,72,119,5,16,1,0,7,226,78,119,5,16,1,0,7,227,84,119,5,16,1,0,7,228,90,119,5,16,1,0,7,229,96,119,5,16,1,0,7,230,77,17,6,16,1,0,7,231,102,119,5,16,1,0,7,232,108,119,5,16,1,0,7,233,114,119,5,16,1,0,7,234,120,119,5,16,1,0,7,235,0,136,5,16,1,0,7,236,90,187,4,16,2,0,7,237,60,187,4,16,2,0,7,238,100,187,4,16,2,0,7,239,117,170,4,16,2,0,7,240,6,136,5,16,1,0,7,241,12,136,5,16,1,0,7,242,18,136,5,16,1,0,7,243,24,136,5,16,1,0,7,244,30,136,5,16,1,0,7,245,36,136,5,16,1,0,7,246,42,136,5,16,1,0,7,247,65,187,4,16,1,0,7,248,48,136,5,16,1,0,7,249,54,136,5,16,1,0,7,250,60,136,5,16,1,0,7,251,66,136,5,16,1,0,7,252,72,136,5,16,1,0,7,253,78,136,5,16,1,0,7,254,84,136,5,16,1,0,7,255,90,136,5,16,1,0,7,256,96,136,5,16,1,0,7,257,102,136,5,16,1,0,7,258,108,136,5,16,1,0,7,259,114,136,5,16,1,0,7,260,120,136,5,16,1,0,7,261,0,153,5,16,1,0,7,262,6,153,5,16,1,0,7,263,12,153,5,16,1,0,7,268,18,153,5,16,1,0,7,269,24,153,5,16,1,0,7,270,30,153,5,16,1,0,7,271,8,0,7,16,0,0,7,272,35,17,6,16,1,0,7,273,28,17,6,16,1,0,7,274,36,153,5,16,1,0,7,275,42,153,5,16,1,0,7,278,54,170,5,16,1,0,7,279,48,153,5,16,1,0,7,280,54,153,5,16,1,0,7,281,60,153,5,16,1,0,7,282,66,153,5,16,1,0,7,283,72,153,5,16,1,0,7,286,78,153,5,16,1,0,7,287,84,153,5,16,1,0,7,290,90,153,5,16,1,0,7,291,96,153,5,16,1,0,7,298,72,170,4,16,2,0,7,299,77,170,4,16,2,0,7,302,82,170,4,16,2,0,7,303,87,170,4,16,2,0,7,304,102,170,4,16,2,0,7,305,107,170,4,16,2,0,7,310,102,153,5,16,1,0,7,311,108,153,5,16,1,0,7,313,114,153,5,16,1,0,7,314,122,170,4,16,2,0,7,315,120,153,5,16,1,0,7,316,5,187,4,16,2,0,7,317,0,170,5,16,1,0,7,318,15,187,4,16,2,0,7,321,107,0,6,16,1,0,7,322,25,187,4,16,2,0,7,323,6,170,5,16,1,0,7,324,12,170,5,16,1,0,7,325,18,170,5,16,1,0,7,326,24,170,5,16,1,0,7,327,30,170,5,16,1,0,7,328,36,170,5,16,1,0,7,332,42,170,5,16,1,0,7,333,48,170,5,16,1,0,7,336,121,0,6,16,1,0,7,337,100,0,6,16,1,0,7,338,93,0,6,16,1,0,7,339,79,0,6,16,1,0,7,340,60,170,5,16,1,0,7,341,66,170,5,16,1,0,7,342,20,34,5,16,1,0,7,343,44,34,5,16,1,0,7,344,50,34,5,16,1,0,7,345,56,34,5,16,1,0,7,346,62,34,5,16,1,0,7,347,68,34,5,16,1,0,7,350,74,34,5,16,1,0,7,351,86,34,5,16,1,0,7,352,104,34,5,16,1,0,7,353,30,51,5,16,1,0,7,354,72,0,6,16,1,0,7,355,36,51,5,16,1,0,7,356,51,0,6,16,1,0,7,357,42,51,5,16,1,0,7,362,54,51,5,16,1,0,7,363,114,51,5,16,1,0,7,366,66,68,5,16,1,0,7,367,78,68,5,16,1,0,7,368,63,17,6,16,1,0,7,369,105,17,6,16,1,0,7,370,84,68,5,16,1,0,7,371,108,68,5,16,1,0,7,376,91,17,6,16,1,0,7,377,12,85,5,16,1,0,7,378,18,85,5,16,1,0,7,379,30,85,5,16,1,0,7,380,108,85,5,16,1,0,7,381,114,85,5,16,1,0,7,382,120,85,5,16,1,0,7};
 
@@ -2443,30 +2849,354 @@ struct VertexPTTN {
   vec3 norm;
 };
 
+/* 
+   Packed vertices, see VertexPacker. Positions are half floats (VertexPacked*) 
+   or unorm16 relative to the bounds of the mesh (VertexQuantized*), texcoords 
+   are unorm16, normals are octahedral encoded snorm16 and tangents snorm8 with 
+   the handedness in w. Use VERTEX_PACKED_GLSL to decode them in a shader. 
+   `Unpacked` is the float vertex type that VertexPacker::copy() gets from an OBJ.
+*/
+struct VertexPackedPTN {                                    /* 16 bytes, VertexPTN is 32 */
+  typedef VertexPTN Unpacked;
+  uint16_t pos[4];                                          /* half floats, pos[3] is padding */
+  uint16_t tex[2];
+  int16_t norm[2];
+};
+
+struct VertexPackedPTTN {                                   /* 20 bytes, VertexPTTN is 48 */
+  typedef VertexPTTN Unpacked;
+  uint16_t pos[4];
+  uint16_t tex[2];
+  int16_t norm[2];
+  int8_t tan[4];
+};
+
+struct VertexQuantizedPTN {                                 /* 16 bytes, position = VertexPacker::bounds_min + pos * VertexPacker::bounds_size */
+  typedef VertexPTN Unpacked;
+  uint16_t pos[4];
+  uint16_t tex[2];
+  int16_t norm[2];
+};
+
+struct VertexQuantizedPTTN {                                /* 20 bytes */
+  typedef VertexPTTN Unpacked;
+  uint16_t pos[4];
+  uint16_t tex[2];
+  int16_t norm[2];
+  int8_t tan[4];
+};
+
+/* 2D position with a RGBA8 color (r in the lowest byte), 12 bytes, VertexPC is 28. */
+struct VertexPackedPC {
+  VertexPackedPC(){}
+  VertexPackedPC(float x, float y, uint32_t c) { pos[0] = x; pos[1] = y; col = c; } 
+  float* ptr() { return pos; } 
+  float pos[2];
+  uint32_t col;
+};
+
+template<> struct VertexLayout<VertexP> : public VertexLayoutBase {
+  enum { position = offsetof(VertexP, pos) };
+};
+
+template<> struct VertexLayout<VertexPC> : public VertexLayoutBase {
+  enum { position = offsetof(VertexPC, pos), color = offsetof(VertexPC, col) };
+};
+
+template<> struct VertexLayout<VertexPT> : public VertexLayoutBase {
+  enum { position = offsetof(VertexPT, pos), texcoord = offsetof(VertexPT, tex) };
+};
+
+template<> struct VertexLayout<VertexPT3> : public VertexLayoutBase {
+  enum { position = offsetof(VertexPT3, pos), texcoord = offsetof(VertexPT3, tex), texcoord_size = 3 };
+};
+
+template<> struct VertexLayout<VertexPTN> : public VertexLayoutBase {
+  enum { position = offsetof(VertexPTN, pos), texcoord = offsetof(VertexPTN, tex), normal = offsetof(VertexPTN, norm) };
+};
+
+template<> struct VertexLayout<VertexPN> : public VertexLayoutBase {
+  enum { position = offsetof(VertexPN, pos), normal = offsetof(VertexPN, norm) };
+};
+
+template<> struct VertexLayout<VertexPTTN> : public VertexLayoutBase {
+  enum { position = offsetof(VertexPTTN, pos), texcoord = offsetof(VertexPTTN, tex), tangent = offsetof(VertexPTTN, tan), normal = offsetof(VertexPTTN, norm) };
+};
+
+template<> struct VertexLayout<VertexPackedPC> : public VertexLayoutBase {
+  enum { 
+    position = offsetof(VertexPackedPC, pos), position_size = 2, 
+    color = offsetof(VertexPackedPC, col), color_type = GL_UNSIGNED_BYTE, color_normalized = GL_TRUE 
+  };
+};
+
+template<> struct VertexLayout<VertexPackedPTN> : public VertexLayoutBase {
+  enum { 
+    position = offsetof(VertexPackedPTN, pos), position_type = GL_HALF_FLOAT,
+    texcoord = offsetof(VertexPackedPTN, tex), texcoord_type = GL_UNSIGNED_SHORT, texcoord_normalized = GL_TRUE,
+    normal = offsetof(VertexPackedPTN, norm), normal_size = 2, normal_type = GL_SHORT, normal_normalized = GL_TRUE
+  };
+};
+
+template<> struct VertexLayout<VertexPackedPTTN> : public VertexLayoutBase {
+  enum { 
+    position = offsetof(VertexPackedPTTN, pos), position_type = GL_HALF_FLOAT,
+    texcoord = offsetof(VertexPackedPTTN, tex), texcoord_type = GL_UNSIGNED_SHORT, texcoord_normalized = GL_TRUE,
+    normal = offsetof(VertexPackedPTTN, norm), normal_size = 2, normal_type = GL_SHORT, normal_normalized = GL_TRUE,
+    tangent = offsetof(VertexPackedPTTN, tan), tangent_type = GL_BYTE, tangent_normalized = GL_TRUE
+  };
+};
+
+template<> struct VertexLayout<VertexQuantizedPTN> : public VertexLayoutBase {
+  enum { 
+    position = offsetof(VertexQuantizedPTN, pos), position_type = GL_UNSIGNED_SHORT, position_normalized = GL_TRUE,
+    texcoord = offsetof(VertexQuantizedPTN, tex), texcoord_type = GL_UNSIGNED_SHORT, texcoord_normalized = GL_TRUE,
+    normal = offsetof(VertexQuantizedPTN, norm), normal_size = 2, normal_type = GL_SHORT, normal_normalized = GL_TRUE
+  };
+};
+
+template<> struct VertexLayout<VertexQuantizedPTTN> : public VertexLayoutBase {
+  enum { 
+    position = offsetof(VertexQuantizedPTTN, pos), position_type = GL_UNSIGNED_SHORT, position_normalized = GL_TRUE,
+    texcoord = offsetof(VertexQuantizedPTTN, tex), texcoord_type = GL_UNSIGNED_SHORT, texcoord_normalized = GL_TRUE,
+    normal = offsetof(VertexQuantizedPTTN, norm), normal_size = 2, normal_type = GL_SHORT, normal_normalized = GL_TRUE,
+    tangent = offsetof(VertexQuantizedPTTN, tan), tangent_type = GL_BYTE, tangent_normalized = GL_TRUE
+  };
+};
+
+/* Writes the float attributes that T has, see VertexLayout; the conditions are compile time constants. Packed vertices are written by VertexPacker. */
+template<class T>
+inline void rx_set_vertex(T& v, const vec3& pos, const vec2& tex, const vec3& norm, const vec4& tan) {
+  typedef VertexLayout<T> L;
+  char* dst = (char*)&v;
+  if (L::position >= 0 && L::position_type == GL_FLOAT) { memcpy(dst + L::position, &pos.x, sizeof(float) * LOWEST(int(L::position_size), 3)); } 
+  if (L::texcoord >= 0 && L::texcoord_type == GL_FLOAT) { memcpy(dst + L::texcoord, &tex.x, sizeof(float) * LOWEST(int(L::texcoord_size), 2)); } 
+  if (L::normal >= 0 && L::normal_type == GL_FLOAT) { memcpy(dst + L::normal, &norm.x, sizeof(float) * LOWEST(int(L::normal_size), 3)); } 
+  if (L::tangent >= 0 && L::tangent_type == GL_FLOAT) { memcpy(dst + L::tangent, &tan.x, sizeof(float) * LOWEST(int(L::tangent_size), 4)); } 
+}
+
+/* 
+   OBJ parse helpers
+   -----------------
+   Allocation free number parsing on [p, end) ranges, used by the OBJ parser. 
+   rx_parse_float() gives the same results as strtof() (which is what 
+   std::stringstream uses): short numbers are converted with one exact double 
+   operation, everything else (and the rare case where rounding the double to 
+   a float could differ) falls back to strtof().
+*/
+
+inline bool rx_is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline const char* rx_skip_space(const char* p, const char* end) {
+  while (p < end && rx_is_space(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/* Returns the position after the parsed number or NULL when no number was found. */
+inline const char* rx_parse_float(const char* p, const char* end, float& result) {
+
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char* start = p;
+  bool neg = false;
+  uint64_t mant = 0;
+  int ndigits = 0;
+  int exp10 = 0;
+  bool has_digits = false;
+
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    ++p;
+  }
+
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (ndigits < 19) {
+      mant = mant * 10 + (*p - '0');
+      ndigits += (mant != 0);
+    }
+    else {
+      exp10++;
+    }
+    has_digits = true;
+    ++p;
+  }
+
+  if (p < end && *p == '.') {
+    ++p;
+    while (p < end && *p >= '0' && *p <= '9') {
+      if (ndigits < 19) {
+        mant = mant * 10 + (*p - '0');
+        ndigits += (mant != 0);
+        exp10--;
+      }
+      has_digits = true;
+      ++p;
+    }
+  }
+
+  bool fast = has_digits;
+
+  if (fast && p < end && (*p == 'e' || *p == 'E')) {
+    const char* e = p + 1;
+    bool eneg = false;
+    int eval = 0;
+    if (e < end && (*e == '-' || *e == '+')) {
+      eneg = (*e == '-');
+      ++e;
+    }
+    if (e < end && *e >= '0' && *e <= '9') {
+      while (e < end && *e >= '0' && *e <= '9') {
+        eval = (eval < 10000) ? eval * 10 + (*e - '0') : eval;
+        ++e;
+      }
+      exp10 += eneg ? -eval : eval;
+      p = e;
+    }
+  }
+
+  if (fast && ndigits <= 15 && exp10 >= -22 && exp10 <= 22) {
+
+    double d = (double)mant;
+    d = (exp10 < 0) ? d / pow10[-exp10] : d * pow10[exp10];
+
+    /* 
+       The double is correctly rounded; rounding it again to a float only goes 
+       wrong when it's (nearly) halfway between two floats, or a subnormal.
+    */
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    uint32_t low = (uint32_t)(bits & 0x1FFFFFFF);
+    if ((d == 0.0 || d >= 2.0e-38)
+        && low != 0x0FFFFFFF
+        && low != 0x10000000
+        && low != 0x10000001)
+      {
+        result = neg ? -(float)d : (float)d;
+        return p;
+      }
+  }
+
+  /* Slow path, e.g. very long numbers, inf/nan, hex floats. */
+  char buf[128];
+  size_t len = 0;
+  while (start + len < end && len < sizeof(buf) - 1 && !rx_is_space(start[len]) && start[len] != '\n') {
+    buf[len] = start[len];
+    ++len;
+  }
+  buf[len] = '\0';
+
+  char* stop = NULL;
+  float f = strtof(buf, &stop);
+  if (stop == buf) {
+    return NULL;
+  }
+
+  result = f;
+  return start + (stop - buf);
+}
+
+/* Parses up to `n` whitespace separated floats; once one fails, the rest is set to 0 (like std::stringstream). */
+inline const char* rx_parse_floats(const char* p, const char* end, float* result, int n) {
+  for (int i = 0; i < n; ++i) {
+    p = (NULL == p) ? NULL : rx_parse_float(rx_skip_space(p, end), end, result[i]);
+    if (NULL == p) {
+      result[i] = 0.0f;
+    }
+  }
+  return p;
+}
+
+/* Parses an integer like atoi(); returns the position after the digits. */
+inline const char* rx_parse_int(const char* p, const char* end, int& result) {
+
+  bool neg = false;
+  int value = 0;
+
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    ++p;
+  }
+
+  while (p < end && *p >= '0' && *p <= '9') {
+    value = value * 10 + (*p - '0');
+    ++p;
+  }
+
+  result = neg ? -value : value;
+  return p;
+}
+
+#define OBJ_NORMALS_WEIGHT_AREA 1                                                /* calculateNormals(): weigh the face normals by the area of the face */
+#define OBJ_NORMALS_WEIGHT_ANGLE 2                                               /* calculateNormals(): weigh the face normals by the angle of the face corner */
+#define OBJ_LINE_NONE 0                                                          /* parseLine(): empty line, comment, a type we don't use or an invalid face */
+#define OBJ_LINE_VERTEX 1                                                        /* parseLine(): `v` line, LINE.value holds the position */
+#define OBJ_LINE_NORMAL 2                                                        /* parseLine(): `vn` line, LINE.value holds the normal */
+#define OBJ_LINE_TEXCOORD 3                                                      /* parseLine(): `vt` line, LINE.value.x/y hold the (flipped) texcoord */
+#define OBJ_LINE_FACE 4                                                          /* parseLine(): `f` line with 3 corners, LINE.face holds the zero based indices */
+
 class OBJ {
  public:
   struct TRI { int v, t, n, tan; }; /* v = vertex index, t = texcoord index, n = normal index, tan = tangent index */
   struct FACE { TRI a, b, c; };
   struct XYZ {  float x, y, z; };
   struct TEXCOORD { float s, t; };
+  struct LINE { vec3 value; FACE face; };                                       /* the result of parseLine() */
+  struct CHUNK;
 
-  bool load(std::string filepath);
+  OBJ();
+  bool load(std::string filepath);                                              /* memory maps and parses the given file */
+  bool load(const char* data, size_t nbytes);                                   /* parses the given obj data; big files are split into chunks that are parsed in parallel */
 
   bool hasNormals();
   bool hasTexCoords();
   bool hasTangents();
 
   template<class T>
-    bool copy(T& result);
+    bool copy(std::vector<T>& result);                                          /* copy all face corners (3 vertices per face), T must have a VertexLayout */
+
+  template<class T>
+    bool copy(T& result);                                                       /* same as above, for containers derived from std::vector */
 
-  void push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexP>& verts);
+  void push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexP>& verts);    /* appends one vertex, see rx_set_vertex() */
   void push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPTN>& verts);
   void push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPT>& verts);
   void push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPN>& verts);
   void push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPTTN>& verts);
 
+  template<class T, class I>
+    bool copy(std::vector<T>& verts, std::vector<I>& result);                   /* append the unique vertices to verts and set result to their indices into verts, I is uint32_t or uint16_t; calls createIndices() when necessary and fails when I can't index all vertices */
+
+  size_t createIndices();                                                       /* deduplicates the (v, t, n) face corners into `unique_tris` and fills `indices`, returns the number of unique vertices */
+  float getReuseRatio();                                                        /* returns the number of face corners per unique vertex; e.g. 6.0 for a typical closed mesh */
+  bool calculateNormals(float creaseAngle = 180.0f, int weighting = OBJ_NORMALS_WEIGHT_ANGLE); /* creates smooth normals; faces that make a bigger angle than creaseAngle (degrees) get separate normals. recalculates the tangents when we have texcoords */
+  bool calculateFlatNormals();                                                  /* creates one normal per face, stored after a normal per vertex (for the tangents); recalculates the tangents when we have texcoords */
+
+  static int getLineType(const char* p, const char* eol, const char*& data);    /* returns the OBJ_LINE_* type of the line [p, eol); data is set to the first character after the type */
+  static int parseLine(const char* p, const char* eol, LINE& line, size_t* nparsed); /* parses the line [p, eol), returns the OBJ_LINE_* type; nparsed holds the number of v, vn, vt before this line (for relative indices) */
+
  private:
   void calculateTangents();
+  void calculateFaceTangent(const FACE& face, vec3& sdir, vec3& tdir);          /* calculates the (unnormalized) tangent and bitangent of the given face */
+  void createAdjacency();                                                        /* fills `adj_offsets` and `adj_corners` with the face corners that use each vertex */
+  void count(CHUNK& chunk);                                                     /* counts the v, vn, vt and f lines in the given chunk */
+  void parse(CHUNK& chunk);                                                     /* parses all lines of the chunk; writes vertices, normals, texcoords at the chunk offsets */
+  static const char* parseCorner(const char* p, const char* end, TRI& tri, size_t* nparsed); /* parses a v/t/n face corner, see parseLine() */
+  static void countJob(int dx, void* user);                                     /* rx_parallel_for() job, user is a CHUNK* array */
+  static void parseJob(int dx, void* user);                                     /* rx_parallel_for() job, user is a CHUNK* array */
+  static void mergeJob(int dx, void* user);                                     /* rx_parallel_for() job, copies the chunk faces into `faces` */
+  static void faceTangentsJob(int dx, void* user);                              /* rx_parallel_for() job, user is the OBJ; calculates the tangents of a range of faces */
+  static void vertexTangentsJob(int dx, void* user);                            /* rx_parallel_for() job, user is the OBJ; sums and orthogonalizes the tangents of a range of vertices */
+  static void faceNormalsJob(int dx, void* user);                               /* rx_parallel_for() job, user is the OBJ; calculates the normal and corner weights of a range of faces */
+  static void cornerNormalsJob(int dx, void* user);                             /* rx_parallel_for() job, user is the OBJ; calculates the normals at the corners of a range of vertices */
+  static void vertexNormalsJob(int dx, void* user);                             /* rx_parallel_for() job, user is the OBJ; stores the unique normals of a range of vertices */
+  static void flatNormalsJob(int dx, void* user);                               /* rx_parallel_for() job, user is the OBJ; stores the normals of a range of faces */
 
  public:
   std::vector<vec3> vertices;
@@ -2474,41 +3204,184 @@ class OBJ {
   std::vector<vec2> tex_coords;
   std::vector<vec4> tangents;
   std::vector<OBJ::FACE> faces;
-  std::vector<int> indices;
+  std::vector<int> indices;                                                     /* index into `unique_tris` for each face corner, see createIndices() */
+  std::vector<OBJ::TRI> unique_tris;                                            /* the unique (v, t, n) face corners, see createIndices() */
   bool has_texcoords;
   bool has_normals;
   bool has_tangents;
+  int num_threads;                                                              /* number of threads used to parse big files and calculate tangents; 0 = one per core */
+
+ private:
+  int num_jobs;                                                                 /* number of jobs used by calculateTangents() and calculateNormals() */
+  std::vector<uint32_t> adj_offsets;                                            /* face corners of vertex i: adj_corners[adj_offsets[i]] ... adj_corners[adj_offsets[i + 1]], see createAdjacency() */
+  std::vector<uint32_t> adj_corners;                                            /* face corners (face * 3 + corner) per vertex, in face order */
+  std::vector<vec3> face_tangents;                                              /* tangent and bitangent per face, scratch for calculateTangents() */
+  std::vector<vec3> vertex_tangents;                                            /* summed tangent and bitangent per vertex when calculateTangents() uses one job */
+  std::vector<vec3> face_normals;                                               /* scratch for calculateNormals(): unit normal per face */
+  std::vector<float> corner_weights;                                            /* scratch for calculateNormals(): area or angle per face corner */
+  std::vector<vec3> corner_normals;                                             /* scratch for calculateNormals(): normal per adj_corners entry */
+  std::vector<uint32_t> corner_ids;                                             /* scratch for calculateNormals(): which normal of its vertex, per adj_corners entry */
+  std::vector<uint32_t> extra_offsets;                                          /* scratch for calculateNormals(): where the extra (creased) normals of a vertex are stored */
+  float normals_crease;                                                         /* cosine of the crease angle, used by the normal jobs */
+  int normals_weighting;                                                        /* OBJ_NORMALS_WEIGHT_{AREA, ANGLE} */
 }; // OBJ
 
+struct OBJ::CHUNK {                                                             /* part of the file, split on a line boundary, that is parsed by one job */
+  OBJ* obj;
+  const char* begin;
+  const char* end;
+  size_t counts[4];                                                             /* number of v, vn, vt lines and (an upper bound of) f lines in this chunk */
+  size_t offsets[3];                                                            /* number of v, vn, vt lines in the file before this chunk */
+  size_t first[3];                                                              /* where we write the first v, vn, vt of this chunk in the OBJ arrays */
+  size_t first_face;                                                            /* where the faces of this chunk are copied to, see mergeJob() */
+  std::vector<FACE> faces;                                                      /* the faces of this chunk */
+};
+
+inline OBJ::OBJ()
+  :has_texcoords(false)
+  ,has_normals(false)
+  ,has_tangents(false)
+  ,num_threads(0)
+  ,num_jobs(1)
+  ,normals_crease(-1.0f)
+  ,normals_weighting(0)
+{
+}
+
 template<class T>
-inline bool OBJ::copy(T& result) {
+inline bool OBJ::copy(std::vector<T>& result) {
+
+  size_t first = result.size();
+  result.resize(first + faces.size() * 3);
+
+  T* out = result.size() ? &result[first] : NULL;
   for(std::vector<FACE>::iterator it = faces.begin(); it != faces.end(); ++it) {
     FACE& f = *it;
-    push_back(vertices[f.a.v], normals[f.a.n], tex_coords[f.a.t], tangents[f.a.tan], result) ;
-    push_back(vertices[f.b.v], normals[f.b.n], tex_coords[f.b.t], tangents[f.b.tan], result) ;
-    push_back(vertices[f.c.v], normals[f.c.n], tex_coords[f.c.t], tangents[f.c.tan], result) ;
+    rx_set_vertex(*out++, vertices[f.a.v], tex_coords[f.a.t], normals[f.a.n], tangents[f.a.tan]);
+    rx_set_vertex(*out++, vertices[f.b.v], tex_coords[f.b.t], normals[f.b.n], tangents[f.b.tan]);
+    rx_set_vertex(*out++, vertices[f.c.v], tex_coords[f.c.t], normals[f.c.n], tangents[f.c.tan]);
   }
   return true;
 }
 
+template<class T>
+inline bool OBJ::copy(T& result) {
+  std::vector<typename T::value_type>& verts = result;
+  return copy(verts);
+}
+
 inline void OBJ::push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexP>& verts) {
-  verts.push_back(VertexP(vert));
+  verts.resize(verts.size() + 1);
+  rx_set_vertex(verts.back(), vert, tc, norm, tan);
 }
 
 inline void OBJ::push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPTN>& verts) {
-  verts.push_back(VertexPTN(vert, tc, norm));
+  verts.resize(verts.size() + 1);
+  rx_set_vertex(verts.back(), vert, tc, norm, tan);
 }
 
 inline void OBJ::push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPT>& verts) {
-  verts.push_back(VertexPT(vert, tc));
+  verts.resize(verts.size() + 1);
+  rx_set_vertex(verts.back(), vert, tc, norm, tan);
 }
 
 inline void OBJ::push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPN>& verts) {
-  verts.push_back(VertexPN(vert, norm));
+  verts.resize(verts.size() + 1);
+  rx_set_vertex(verts.back(), vert, tc, norm, tan);
 }
 
 inline void OBJ::push_back(vec3 vert, vec3 norm, vec2 tc, vec4 tan, std::vector<VertexPTTN>& verts) {
-  verts.push_back(VertexPTTN(vert, tc, tan, norm));
+  verts.resize(verts.size() + 1);
+  rx_set_vertex(verts.back(), vert, tc, norm, tan);
+}
+
+template<class T, class I>
+inline bool OBJ::copy(std::vector<T>& verts, std::vector<I>& result) {
+
+  if (indices.size() != faces.size() * 3) {
+    createIndices();
+  }
+
+  /* The unique vertices are appended, so the indices start after the vertices that are already in verts. */
+  size_t first = verts.size();
+  if (unique_tris.size() && first + unique_tris.size() - 1 > size_t(I(~I(0)))) {
+    printf("Error: cannot copy into %d-bit indices, we have %d unique vertices after %d existing ones.\n", int(sizeof(I) * 8), int(unique_tris.size()), int(first));
+    return false;
+  }
+
+  /* Texcoord and normal indices are -1 when the file didn't have them. Tangents are stored per position. */
+  verts.resize(first + unique_tris.size());
+  for (size_t i = 0; i < unique_tris.size(); ++i) {
+    TRI& tri = unique_tris[i];
+    rx_set_vertex(verts[first + i], vertices[tri.v], tex_coords[HEIGHEST(tri.t, 0)], normals[HEIGHEST(tri.n, 0)], tangents[tri.v]);
+  }
+
+  result.resize(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    result[i] = I(first + indices[i]);
+  }
+
+  return true;
+}
+
+/* Open addressing (linear probing) on the (v, t, n) triple; the table stores an index into unique_tris. */
+inline size_t OBJ::createIndices() {
+
+  size_t ncorners = faces.size() * 3;
+  size_t capacity = 16;
+  while (capacity < ncorners * 2) {
+    capacity <<= 1;
+  }
+
+  std::vector<int> table(capacity, -1);
+  size_t mask = capacity - 1;
+
+  indices.resize(ncorners);
+  unique_tris.clear();
+  unique_tris.reserve(ncorners / 4 + 16);
+
+  for (size_t i = 0; i < ncorners; ++i) {
+
+    const FACE& face = faces[i / 3];
+    const TRI& tri = (i % 3 == 0) ? face.a : ((i % 3 == 1) ? face.b : face.c);
+    uint32_t h = (uint32_t)tri.v * 0x9E3779B1u;
+    h ^= (uint32_t)tri.t * 0x85EBCA77u;
+    h ^= (uint32_t)tri.n * 0xC2B2AE3Du;
+    h ^= h >> 15;
+
+    size_t slot = h & mask;
+    while (true) {
+
+      int dx = table[slot];
+
+      if (-1 == dx) {
+        dx = unique_tris.size();
+        table[slot] = dx;
+        unique_tris.push_back(tri);
+        indices[i] = dx;
+        break;
+      }
+
+      const TRI& other = unique_tris[dx];
+      if (other.v == tri.v && other.t == tri.t && other.n == tri.n) {
+        indices[i] = dx;
+        break;
+      }
+
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  return unique_tris.size();
+}
+
+inline float OBJ::getReuseRatio() {
+
+  if (0 == unique_tris.size()) {
+    return 0.0f;
+  }
+
+  return float(indices.size()) / float(unique_tris.size());
 }
 
 inline bool OBJ::hasNormals() {
@@ -2521,75 +3394,92 @@ inline bool OBJ::hasTexCoords() {
 
 inline bool OBJ::load(std::string filepath) {
 
-  // are unset below
-  has_normals = true;
-  has_texcoords = true;
-  has_tangents = true;
+  const char* data = NULL;
+  size_t nbytes = 0;
 
-  std::ifstream ifs;
-  ifs.open(filepath.c_str());
-  if(!ifs.is_open()) {
+  if (false == rx_map_file(filepath, &data, nbytes)) {
     printf("Error: Cannot find .obj file: %s\n", filepath.c_str());
     return false;
   }
 
-  char c;
-  std::string line;
-  while(std::getline(ifs, line)) {
-    std::stringstream ss(line);
-    ss >> c;
-    if(c == 'v') {
-      if(line[1] == ' ') {
-        vec3 p;
-        ss >> p.x >> p.y >> p.z;
-        vertices.push_back(p);
-      }
-      else if(line[1] == 'n') {
-        vec3 p;
-        ss >> c;
-        ss >> p.x >> p.y >> p.z;
-        normals.push_back(p);
-      }
-      else if (line[1] == 't') {
-        vec2 t;
-        ss >> c;
-        ss >> t.x >> t.y;
-        t.y = 1.0f - t.y;
-        tex_coords.push_back(t);
-      }
+  bool result = load(data, nbytes);
+
+  rx_unmap_file(data, nbytes);
+
+  return result;
+}
+
+inline bool OBJ::load(const char* data, size_t nbytes) {
+
+  // are unset below
+  has_normals = true;
+  has_texcoords = true;
+  has_tangents = true;
+
+  /* Split big files into chunks on line boundaries; a couple per thread to balance the work. */
+  int nthreads = (num_threads > 0) ? num_threads : rx_get_num_cores();
+  size_t min_chunk_size = 1024 * 1024;
+  size_t nchunks = 1;
+
+  if (nthreads > 1 && nbytes > min_chunk_size * 4) {
+    nchunks = LOWEST(size_t(nthreads) * 4, nbytes / min_chunk_size);
+  }
+
+  std::vector<CHUNK> chunks(nchunks);
+  const char* end = data + nbytes;
+  const char* p = data;
+
+  for (size_t i = 0; i < nchunks; ++i) {
+
+    const char* chunk_end = (i + 1 == nchunks) ? end : data + (nbytes / nchunks) * (i + 1);
+    if (chunk_end < p) {
+      chunk_end = p;
     }
-    else if(c == 'f') {
-      std::string part;
-      std::vector<OBJ::TRI> tris;
-      while(ss >> part) {
-        std::stringstream fss;
-        std::string indices[3];
-        int dx = 0;
-        for(int i = 0; i < part.size(); ++i) {
-          if(part[i] == '/') {
-            dx++;
-            continue;
-          }
-          indices[dx].push_back(part[i]);
-        }
-        TRI tri;
-        tri.v = atoi(indices[0].c_str()) - 1;
-        tri.t = atoi(indices[1].c_str()) - 1;
-        tri.n = atoi(indices[2].c_str()) - 1;
-        tri.tan = 0;
-        tris.push_back(tri);
-      }
-      if(tris.size() == 3) {
-        OBJ::FACE face;
-        face.a = tris[0];
-        face.b = tris[1];
-        face.c = tris[2];
-        faces.push_back(face);
-      }
-      else {
-        printf("Error: wrong face indices.\n");
-      }
+
+    if (chunk_end < end) {
+      const char* eol = (const char*)memchr(chunk_end, '\n', end - chunk_end);
+      chunk_end = (NULL == eol) ? end : eol + 1;
     }
+
+    CHUNK& chunk = chunks[i];
+    chunk.obj = this;
+    chunk.begin = p;
+    chunk.end = chunk_end;
+    p = chunk_end;
+  }
+
+  /* Count, so we can calculate where each chunk writes its vertices and never reallocate. */
+  rx_parallel_for(nchunks, OBJ::countJob, &chunks[0], nthreads);
+
+  size_t totals[3] = { 0, 0, 0 };
+  size_t sizes[3] = { vertices.size(), normals.size(), tex_coords.size() };
+
+  for (size_t i = 0; i < nchunks; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      chunks[i].offsets[k] = totals[k];
+      chunks[i].first[k] = sizes[k] + totals[k];
+      totals[k] += chunks[i].counts[k];
+    }
+  }
+
+  vertices.resize(sizes[0] + totals[0]);
+  normals.resize(sizes[1] + totals[1]);
+  tex_coords.resize(sizes[2] + totals[2]);
+
+  rx_parallel_for(nchunks, OBJ::parseJob, &chunks[0], nthreads);
+
+  /* Merge the faces. */
+  if (1 == nchunks && 0 == faces.size()) {
+    faces.swap(chunks[0].faces);
+  }
+  else {
+    size_t nfaces = faces.size();
+    for (size_t i = 0; i < nchunks; ++i) {
+      chunks[i].first_face = nfaces;
+      nfaces += chunks[i].faces.size();
+    }
+    faces.resize(nfaces);
+    rx_parallel_for(nchunks, OBJ::mergeJob, &chunks[0], nthreads);
   }
   
   // we need to have a reserved tangents in either case ...
@@ -2616,2688 +3506,9562 @@ inline bool OBJ::load(std::string filepath) {
   return true;
 } // OBJ::load
 
+inline void OBJ::countJob(int dx, void* user) {
+  CHUNK& chunk = ((CHUNK*)user)[dx];
+  chunk.obj->count(chunk);
+}
 
-/* from: Mathematics for 3D Game Programming and Computer Graphics, 3rd edition, Eric Lengyel */
-inline void OBJ::calculateTangents() {
+inline void OBJ::parseJob(int dx, void* user) {
+  CHUNK& chunk = ((CHUNK*)user)[dx];
+  chunk.obj->parse(chunk);
+}
 
-  if(!normals.size() || !tex_coords.size()) {
-    printf("Error: cannot calculate tangents because we have no normals and/or texcoords.\n");
-    return;
+inline void OBJ::mergeJob(int dx, void* user) {
+  CHUNK& chunk = ((CHUNK*)user)[dx];
+  if (chunk.faces.size()) {
+    memcpy(&chunk.obj->faces[chunk.first_face], &chunk.faces[0], sizeof(FACE) * chunk.faces.size());
   }
-  
-  vec3* tan1 = new vec3[vertices.size() * 2];
-  vec3* tan2 = tan1 + vertices.size();
-  memset(tan1, 0x00, sizeof(vec3) * vertices.size() * 2);
+}
 
-  for(size_t i = 0; i < faces.size(); ++i) {
-    OBJ::FACE& face = faces[i];
+/* Counts the v, vn and vt lines with the same getLineType() as parse(); the face count is an upper bound. */
+inline void OBJ::count(CHUNK& chunk) {
 
-    int i1 = face.a.v;
-    int i2 = face.b.v;
-    int i3 = face.c.v;
+  const char* p = chunk.begin;
+  const char* end = chunk.end;
+  const char* data = NULL;
 
-    vec3& v1 = vertices[face.a.v];
-    vec3& v2 = vertices[face.b.v];
-    vec3& v3 = vertices[face.c.v];
+  chunk.counts[0] = chunk.counts[1] = chunk.counts[2] = chunk.counts[3] = 0;
 
-    vec2& c1 = tex_coords[face.a.t];
-    vec2& c2 = tex_coords[face.b.t];
-    vec2& c3 = tex_coords[face.c.t];
+  while (p < end) {
 
-    float x1 = v2.x - v1.x;
-    float x2 = v3.x - v1.x;
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    if (NULL == eol) {
+      eol = end;
+    }
 
-    float y1 = v2.y - v1.y;
-    float y2 = v3.y - v1.y;
+    switch (getLineType(p, eol, data)) {
+      case OBJ_LINE_VERTEX:   chunk.counts[0]++; break;
+      case OBJ_LINE_NORMAL:   chunk.counts[1]++; break;
+      case OBJ_LINE_TEXCOORD: chunk.counts[2]++; break;
+      case OBJ_LINE_FACE:     chunk.counts[3]++; break;
+      default:                break;
+    }
 
-    float z1 = v2.z - v1.z;
-    float z2 = v3.z - v1.z;
+    p = eol + 1;
+  }
+}
 
-    float s1 = c2.x - c1.x;
-    float s2 = c3.x - c1.x;
+/* Parses the lines of the chunk, see parseLine(). */
+inline void OBJ::parse(CHUNK& chunk) {
 
-    float t1 = c2.y - c1.y;
-    float t2 = c3.y - c1.y;
+  const char* p = chunk.begin;
+  const char* end = chunk.end;
+  vec3* out_vertices = vertices.size() ? &vertices[chunk.first[0]] : NULL;
+  vec3* out_normals = normals.size() ? &normals[chunk.first[1]] : NULL;
+  vec2* out_texcoords = tex_coords.size() ? &tex_coords[chunk.first[2]] : NULL;
+  size_t nparsed[3] = { chunk.offsets[0], chunk.offsets[1], chunk.offsets[2] };
+  LINE line;
 
-    float r = 1.0f / (s1 * t2 - s2 * t1);
+  chunk.faces.clear();
+  chunk.faces.reserve(chunk.counts[3]);
 
-    vec3 sdir((t2 * x1 - t1 * x2) * r, 
-              (t2 * y1 - t1 * y2) * r,
-              (t2 * z1 - t1 * z2) * r);
+  while (p < end) {
 
-    vec3 tdir((s1 * x2 - s2 * x1) * r, 
-              (s1 * y2 - s2 * y1) * r,
-              (s1 * z2 - s2 * z1) * r);
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    if (NULL == eol) {
+      eol = end;
+    }
 
-    tan1[i1] += sdir;
-    tan1[i2] += sdir;
-    tan1[i3] += sdir;
+    switch (parseLine(p, eol, line, nparsed)) {
+      case OBJ_LINE_VERTEX: {
+        *out_vertices++ = line.value;
+        nparsed[0]++;
+        break;
+      }
+      case OBJ_LINE_NORMAL: {
+        *out_normals++ = line.value;
+        nparsed[1]++;
+        break;
+      }
+      case OBJ_LINE_TEXCOORD: {
+        out_texcoords->set(line.value.x, line.value.y);
+        out_texcoords++;
+        nparsed[2]++;
+        break;
+      }
+      case OBJ_LINE_FACE: {
+        chunk.faces.push_back(line.face);
+        break;
+      }
+      default: {
+        break;
+      }
+    }
 
-    tan2[i1] += tdir;
-    tan2[i2] += tdir;
-    tan2[i3] += tdir;
+    p = eol + 1;
   }
+} // OBJ::parse
 
-  for(size_t i = 0; i < vertices.size(); ++i) {
-    const vec3& n = normalized(normals[i]);
-    const vec3& t = tan1[i];
-    vec3 tangent = normalized(t - n * dot(n, t));
-    float w = (dot(cross(n, t), tan2[i]) < 0.0f) ? -1.0f : 1.0f;
-    tangents[i].set(tangent.x, tangent.y, tangent.z, w);
+/*
+   Selects the type of a line the same way as reading it with std::stringstream:
+   the first non-space character selects the type and `v` lines are selected 
+   on the second character of the line.
+*/
+inline int OBJ::getLineType(const char* p, const char* eol, const char*& data) {
+
+  const char* line = p;
+  p = rx_skip_space(p, eol);
+
+  if (p == eol) {
+    return OBJ_LINE_NONE;
   }
 
-  delete[] tan1;
-  tan1 = NULL;
-  tan2 = NULL;
+  char c = *p++;
 
-} // OBJ::calculateTangents
+  if (c == 'v' && line + 1 < eol) {
+    if (line[1] == ' ') {
+      data = p;
+      return OBJ_LINE_VERTEX;
+    }
+    if (line[1] == 'n' || line[1] == 't') {
+      p = rx_skip_space(p, eol);
+      data = p + (p < eol);
+      return (line[1] == 'n') ? OBJ_LINE_NORMAL : OBJ_LINE_TEXCOORD;
+    }
+  }
+  else if (c == 'f') {
+    data = p;
+    return OBJ_LINE_FACE;
+  }
 
-/*
-  Painter
-  --------
-  
-  The Painter class is a simple wrapper that mimics intermediate 
-  mode of openGL draw calls. This Painter class is not meant to be
-  used in super optimized applications as using this approach is 
-  is just not the correct one for optimized draw calls. Though this
-  class is probably quite fast as we will use vbo's. Goal of is class
-  is to provide a simple way to draw lines, rects, circles etc.. when 
-  you just want to quickly draw something.
+  return OBJ_LINE_NONE;
+}
 
-  Contexts
-  --------
-  The painter is build around the concept of contexts, where a 
-  context takes care of drawing particular vertex data. At this time
-  we only have a VertexPC renderer, which can draw vertices with color.
-  When ready, we will also have a VertexPT context that can render 
-  textures.
+/* 
+   Parses one line; this gives the same results as reading the lines with 
+   std::stringstream. Faces must have exactly 3 corners, for other faces we 
+   log an error and return OBJ_LINE_NONE. Texcoords are flipped vertically.
+   Used by OBJ::load() and OBJReader, the caller counts the lines.
+*/
+inline int OBJ::parseLine(const char* p, const char* eol, LINE& line, size_t* nparsed) {
 
-  TODO
-  ----
-  At this point the API might change...
+  int type = getLineType(p, eol, p);
 
- */
+  switch (type) {
+    case OBJ_LINE_VERTEX:
+    case OBJ_LINE_NORMAL: {
+      rx_parse_floats(p, eol, &line.value.x, 3);
+      break;
+    }
+    case OBJ_LINE_TEXCOORD: {
+      rx_parse_floats(p, eol, &line.value.x, 2);
+      line.value.y = 1.0f - line.value.y;
+      line.value.z = 0.0f;
+      break;
+    }
+    case OBJ_LINE_FACE: {
+      TRI* tris[3] = { &line.face.a, &line.face.b, &line.face.c };
+      TRI tri;
+      int ntris = 0;
+      while (true) {
+        p = rx_skip_space(p, eol);
+        if (p >= eol) {
+          break;
+        }
+        p = parseCorner(p, eol, (ntris < 3) ? *tris[ntris] : tri, nparsed);
+        ntris++;
+      }
+      if (ntris != 3) {
+        printf("Error: wrong face indices.\n");
+        return OBJ_LINE_NONE;
+      }
+      break;
+    }
+    default: {
+      break;
+    }
+  }
 
-#define PAINTER_CONTEXT_TYPE_PC 1   /* a context that can draw position + colors */
-#define PAINTER_CONTEXT_TYPE_PT 2   /* a context that can draw position + texcoords (not yet implemented) */
+  return type;
+}
 
-#define PAINTER_STATE_NONE 0x0000   /* default state; no-fill */
-#define PAINTER_STATE_FILL 0x0001   /* draw everything filled */
+/* 
+   A corner is `v`, `v/t`, `v//n` or `v/t/n`; missing parts become -1, anything
+   after the third part is ignored. Negative (relative) indices refer to the
+   last lines before this face, e.g. -1 is the last vertex.
+*/
+inline const char* OBJ::parseCorner(const char* p, const char* end, TRI& tri, size_t* nparsed) {
 
-// -----------------------------------------------------
+  int values[3] = { 0, 0, 0 };
+  int part = 0;
 
-static const char* PAINTER_VERTEX_PC_VS  = ""
-  "#version 330\n"
-  ""
-  "layout( std140 ) uniform Shared { "
-  "  mat4 u_pm; " 
-  "};"
-  ""
-  "layout( location = 0 ) in vec4 a_pos; " 
-  "layout( location = 1 ) in vec4 a_col; "
-  "out vec4 v_col;"
-  ""
-  "void main() {"
-  "  gl_Position = u_pm * a_pos; " 
-  "  v_col = a_col; "
-  "}"
-  "";
+  while (p < end && !rx_is_space(*p)) {
+    if (part < 3) {
+      p = rx_parse_int(p, end, values[part]);
+    }
+    while (p < end && *p != '/' && !rx_is_space(*p)) {
+      ++p;
+    }
+    if (p < end && *p == '/') {
+      ++part;
+      ++p;
+    }
+  }
 
-static const char* PAINTER_VERTEX_PC_FS = ""
-  "#version 330\n"
-  "in vec4 v_col; " 
-  "layout (location = 0) out vec4 fragcolor; " 
-  ""
-  "void main() {"
-  " fragcolor = v_col; " 
-  "}"
-  "";
+  tri.v = (values[0] < 0) ? int(nparsed[0]) + values[0] : values[0] - 1;
+  tri.t = (values[1] < 0) ? int(nparsed[2]) + values[1] : values[1] - 1;
+  tri.n = (values[2] < 0) ? int(nparsed[1]) + values[2] : values[2] - 1;
+  tri.tan = tri.v; /* tangents are stored per position */
 
-// -----------------------------------------------------
+  return p;
+}
 
-static const char* PAINTER_VERTEX_PT_VS = ""
-  "#version 330\n"
-  ""
-  "layout( std140 ) uniform Shared { "
-  "  mat4 u_pm; "
-  "};"
-  ""
-  "layout( location = 0 ) in vec4 a_pos; " 
-  "layout( location = 1 ) in vec2 a_tex; "
-  "out vec2 v_tex;"
-  ""
-  "void main() {"
-  "   gl_Position = u_pm * a_pos; "
-  "   v_tex = a_tex; " 
-  "}"
-  "";
+/*
+  OBJReader
+  ---------
 
-static const char* PAINTER_VERTEX_PT_SAMPLER2D_FS = ""
-  "#version 330\n"
-  "uniform sampler2D u_tex; "
-  "in vec2 v_tex; " 
-  "layout( location = 0 ) out vec4 fragcolor; " 
-  ""
-  "void main() {"
-  "  fragcolor = texture(u_tex, v_tex);"
-  "}"
-  "";
+  Streams an .obj file through callbacks instead of storing it; only one 
+  buffer of `buffer_size` bytes is used (it only grows when a single line is 
+  bigger than the buffer). Use this for meshes that don't fit in memory, e.g. 
+  to calculate the bounds, to decimate or to convert a file to another 
+  format on the fly. Set the callbacks you need, the others may be NULL.
 
-// -----------------------------------------------------
+  The face indices are zero based and relative indices are resolved, just 
+  like OBJ::faces; missing texcoord/normal indices are -1. Texcoords are 
+  flipped vertically, the same as OBJ::load() does.
 
-class PainterCommand {
+  ````c++
+  static void on_vertex(const vec3& v, void* user) {
+    Bounds* b = (Bounds*)user;
+    ...
+  }
+
+  OBJReader reader;
+  reader.on_vertex = on_vertex;
+  reader.user = &bounds;
+  reader.read(rx_to_data_path("scan.obj"));
+  ````
+ */
+class OBJReader {
  public:
-  GLenum type;
-  int offset;
-  int count;
-  GLuint tex; /* the texture, in case we need to draw a texture */
-};
+  OBJReader();
+  bool read(std::string filepath);                                              /* opens the file and calls read(FILE*) */
+  bool read(FILE* fp);                                                          /* reads until the end of the stream; can be a pipe */
 
-// -----------------------------------------------------
+ private:
+  void parse(const char* p, const char* end);                                   /* parses the complete lines in [p, end) */
 
-class Painter;
+ public:
+  void (*on_vertex)(const vec3& position, void* user);                          /* called for every `v` line */
+  void (*on_normal)(const vec3& normal, void* user);                            /* called for every `vn` line */
+  void (*on_texcoord)(const vec2& texcoord, void* user);                        /* called for every `vt` line */
+  void (*on_face)(const OBJ::FACE& face, void* user);                           /* called for every triangle */
+  void* user;                                                                   /* passed into the callbacks */
+  size_t buffer_size;                                                           /* number of bytes we read at once; 1MB by default */
+  size_t num_vertices;                                                          /* number of `v` lines read so far */
+  size_t num_normals;                                                           /* number of `vn` lines read so far */
+  size_t num_tex_coords;                                                        /* number of `vt` lines read so far */
+  size_t num_faces;                                                             /* number of triangles read so far */
 
-class PainterContextPC {
+ private:
+  std::vector<char> buffer;
+}; // OBJReader
+
+inline OBJReader::OBJReader()
+  :on_vertex(NULL)
+  ,on_normal(NULL)
+  ,on_texcoord(NULL)
+  ,on_face(NULL)
+  ,user(NULL)
+  ,buffer_size(1024 * 1024)
+  ,num_vertices(0)
+  ,num_normals(0)
+  ,num_tex_coords(0)
+  ,num_faces(0)
+{
+}
 
-public:
-  PainterContextPC(Painter& painter);                             /* a PainterContext is used to render specific vertex data. This context renders only colors */
-  void init();                                                    /* must be called to initialize this context. */
-  void shutdown();                                                /* must be called to cleanup. */
-  void clear();                                                   /* clear all vertices */
-  void update();                                                  /* updates the vbo if necessary */
-  void draw();                                                    /* draws the buffers and commands to screen */
-  void rect(float x, float y, float w, float h);                  /* create a rectangular shape */
-  void circle(float x, float y, float radius);                    /* create a circle */
-  void line(float x0, float y0, float x1, float y1);              /* create a line */
-  void command(GLenum cmd, std::vector<VertexPC>& vertices);      /* adds a command (Painter calls this when using begin()/end() */
+inline bool OBJReader::read(std::string filepath) {
 
-public:
-  Painter& painter;                                               /* reference to the main Painter object */
-  std::vector<PainterCommand> commands;                           /* the command that we render */
-  std::vector<VertexPC> vertices;                                 /* the vertices... also stored in vbo */
-  size_t allocated;                                               /* number of bytes allocated in our vbo */
-  bool needs_update;                                              /* is set to true whenever our vbo needs to be updated */
-  GLuint vao;                                                     /* the vao */
-  GLuint vbo;                                                     /* vbo that holds our data on the gpu */
-  GLuint vert;                                                    /* our vertex shader, see PAINTER_VERTEX_PC_VS */
-  GLuint frag;                                                    /* our fragment shader, see PAINTER_VERTEX_PC_FS */
-  GLuint prog;                                                    /* the shader program, used to render our vbo */
-};
+  FILE* fp = fopen(filepath.c_str(), "rb");
+  if (NULL == fp) {
+    printf("Error: cannot open the obj file: %s\n", filepath.c_str());
+    return false;
+  }
 
-// -----------------------------------------------------
+  bool result = read(fp);
+  fclose(fp);
 
-class PainterContextPT {
+  return result;
+}
 
- public:
-  PainterContextPT(Painter& painter);                             /* a PainterContextPT is used to render textures */
-  void init();                                                    /* must be called to initialize this context. */
-  void shutdown();                                                /* must be called to cleanup. */
-  void clear();                                                   /* clear all vertices */
-  void update();                                                  /* updates the vbo with VertexPT data */
-  void draw();                                                    /* draws the texture */
-  void texture(GLuint tex, float x, float y, float w, float h);   /* add anther texture that should be drawn */
+inline bool OBJReader::read(FILE* fp) {
 
- public:
-  Painter& painter;                                               /* reference to the main Painter object */
-  std::vector<PainterCommand> commands;                           /* the commands/texture draw calls. the type field contains the texture type; at this moment of writing only GL_TEXTURE_2D is supported */
-  std::vector<VertexPT> vertices;                                 /* the vertices we draw */
-  size_t allocated;                                               /* number of bytes we've allocated in the vbo */
-  bool needs_update;                                              /* is set to true whenever we need to udpate the vbo; is set in texture() */
-  GLuint vao;                                                     /* our vao, that contains the vertex info */
-  GLuint vbo;                                                     /* reference to our gpu vbo */
-  GLuint vert;                                                    /* vertex shader for vertexpt data */  
-  GLuint frag;                                                    /* fragment shader for the vertexpt data */
-  GLuint prog;                                                    /* the shader program that draws the texture */
-};
+  if (NULL == fp) {
+    printf("Error: cannot read the obj, invalid file pointer.\n");
+    return false;
+  }
 
-// -----------------------------------------------------
+  num_vertices = 0;
+  num_normals = 0;
+  num_tex_coords = 0;
+  num_faces = 0;
+  buffer.resize(HEIGHEST(buffer_size, size_t(1024)));
 
-// Shared GL data
-struct PainterShared {
-  mat4 pm;
-};
+  /* `used` is the number of bytes at the start of the buffer with an incomplete line from the previous read. */
+  size_t used = 0;
 
-// -----------------------------------------------------
+  while (true) {
 
-class Painter {
+    if (used == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
 
- public:
-  Painter();
-  void init();                                                                      /* must be called to initialize some GL objects we need. */
-  void shutdown();                                                                  /* must be called to cleanup the Painter .*/
-  void clear();                                                                     /* clear all vertices */
-  void draw();                                                                      /* draw all the added lines, circles, textures etc.. */
-  void rect(float x, float y, float w, float h);                                    /* draw a rectangle */
-  void circle(float x, float y, float radius);                                      /* draw a circle, see resolution() to change the resolution of the circle */
-  void line(float x0, float y0, float x1, float y1);                                /* draw a single line, see begin()/end() if you want to draw line strips */
-  void texture(GLuint tex, float x, float y, float w, float h);                     /* draw a texture, at the time of writing only GL_TEXTURE_2D is supported */
+    size_t nread = fread(&buffer[used], 1, buffer.size() - used, fp);
+    size_t nbytes = used + nread;
+    const char* begin = &buffer[0];
 
-  void begin(GLenum type);                                                          /* begin a batch of vertices, just like the old days  */
-  void vertex(float x, float y);                                                    /* add a vertex to the current batch */
-  void end();                                                                       /* end the current batch; this will flush the added vertices into the correct context */
+    if (0 == nread) {
+      if (ferror(fp)) {
+        printf("Error: failed to read the obj.\n");
+        return false;
+      }
+      parse(begin, begin + nbytes);
+      break;
+    }
 
-  void color(float r = 1.0, float g = 1.0, float b = 1.0, float a = 1.0);           /* set the color of lines, circles, rectangles */
-  void rgba(int r = 255, int g = 255, int b = 255, int a = 255);                    /* set the color of lines, circles, rectangles, etc.. using RGB values in range [0,255] */
-  void hex(std::string hexstr);                                                     /* set the color of lines, circles, rectangles, etc.. using a HEX string, e.g. `484A47` for rgb, or 484A47FF for rgba. */
-  void fill();                                                                      /* enable fill mode */
-  void nofill();                                                                    /* disable fill mode */
-  void resize(int w, int h);                                                        /* whenever your viewport changes, call this so we can recalculate the projection matrix */
-  void resolution(int n);                                                           /* set the circle resolution */
+    size_t last = nbytes;
+    while (last > 0 && begin[last - 1] != '\n') {
+      --last;
+    }
 
-  int width();                                                                      /* returns the last set/calculated viewport width */
-  int height();                                                                     /* returns the last set/calculated viewport height */
+    if (0 == last) {
+      used = nbytes;
+      continue;
+    }
 
- public:
-  PainterContextPC context_pc;                                                      /* context used to draw VertexPC vertices (color) */
-  PainterContextPT context_pt;                                                      /* context used to draw VertexPT vertices (textures) */
-  int circle_resolution;                                                            /* the last set circle resolution */
-  vec4 col;                                                                         /* the color we use to draw with */
-  int state;                                                                        /* keeps state of the painter; e.g. fill/nofill */
-  GLuint ubo;                                                                       /* shared uniform buffer object with matrice(s) */
-  PainterShared ubo_data;                                                           /* the actual data for our ubo */
-  std::vector<vec2> circle_data;                                                    /* pre-calculated sin/cos values for our circle; just a tiny bit of optimization */
-  int win_w;                                                                        /* the last calculated or set viewport width */
-  int win_h;                                                                        /* the last calculated or set viewport height */
+    parse(begin, begin + last);
 
-  /* begin() - end() handling */
-  GLenum command_type;                                                              /* when begin() is called we store the command type. the next call to vertex defines what PainterContext we will use; for now only default is used */
-  int context_type;                                                                 /* when begin()/end() is used, a call to one of the overloaded vertex() function will define what context will be used. in end() we add the added vertices to the correct context */
-  std::vector<VertexPC> vertices_pc;                                                /* VertexPC vertices for our PC context */ 
-};
+    used = nbytes - last;
+    if (used) {
+      memmove(&buffer[0], &buffer[last], used);
+    }
+  }
 
-#  endif // ROXLU_USE_OPENGL_MATH_H
-#endif // defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_MATH)
+  return true;
+}
 
-// ------------------------------------------------------------------------------------
-//                              R O X L U _ U S E _ O P E N G L 
-//                              R O X L U _ U S E _ P N G 
-// ------------------------------------------------------------------------------------
+/* Parses the lines with OBJ::parseLine(), the same way as OBJ::load(). */
+inline void OBJReader::parse(const char* p, const char* end) {
 
-#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_PNG)
-#  ifndef ROXLU_USE_OPENGL_PNG_H
-#  define ROXLU_USE_OPENGL_PNG_H
+  OBJ::LINE line;
 
-extern GLuint rx_create_texture(std::string filepath, int internalFormat = -1, int format = -1, int type = -1);
-extern bool rx_create_png_screenshot(std::string filepath); 
+  while (p < end) {
 
-#  endif // ROXLU_USE_OPENGL_PNG_H
-#endif // defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_PNG)
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    if (NULL == eol) {
+      eol = end;
+    }
 
+    size_t nparsed[3] = { num_vertices, num_normals, num_tex_coords };
 
-// ------------------------------------------------------------------------------------
-//                              R O X L U _ U S E _ O P E N G L 
-//                              R O X L U _ U S E _ J P G
-// ------------------------------------------------------------------------------------
+    switch (OBJ::parseLine(p, eol, line, nparsed)) {
+      case OBJ_LINE_VERTEX: {
+        num_vertices++;
+        if (on_vertex) {
+          on_vertex(line.value, user);
+        }
+        break;
+      }
+      case OBJ_LINE_NORMAL: {
+        num_normals++;
+        if (on_normal) {
+          on_normal(line.value, user);
+        }
+        break;
+      }
+      case OBJ_LINE_TEXCOORD: {
+        num_tex_coords++;
+        if (on_texcoord) {
+          on_texcoord(vec2(line.value.x, line.value.y), user);
+        }
+        break;
+      }
+      case OBJ_LINE_FACE: {
+        num_faces++;
+        if (on_face) {
+          on_face(line.face, user);
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+    }
 
-#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_JPG)
-#  ifndef ROXLU_USE_OPENGL_JPG_H
-#  define ROXLU_USE_OPENGL_JPG_H
+    p = eol + 1;
+  }
+} // OBJReader::parse
 
-extern bool rx_create_jpg_screenshot(std::string filepath, int quality = 80); 
 
-#  endif // ROXLU_USE_OPENGL_JPG_H
-#endif // defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_JPG)
+/* from: Mathematics for 3D Game Programming and Computer Graphics, 3rd edition, Eric Lengyel */
+/* 
+   Calculates the tangents per face and then sums them per vertex, in face 
+   order. With one job the face tangents are added directly to the vertices;
+   for big meshes we create the vertex -> face adjacency (see createAdjacency())
+   so each job can sum a range of vertices without locking. 
+   Both give the same result for every thread count. The scratch buffers 
+   are members so they're reused by the next call.
+ */
+inline void OBJ::calculateTangents() {
 
+  if(!normals.size() || !tex_coords.size()) {
+    printf("Error: cannot calculate tangents because we have no normals and/or texcoords.\n");
+    return;
+  }
 
-// ------------------------------------------------------------------------------------
-//                              R O X L U _ U S E _ A U D I O 
-// ------------------------------------------------------------------------------------
+  size_t nfaces = faces.size();
+  size_t nverts = vertices.size();
+  int nthreads = (num_threads > 0) ? num_threads : rx_get_num_cores();
+
+  num_jobs = 1;
+  if (nthreads > 1 && nfaces > 64 * 1024) {
+    num_jobs = nthreads * 4;
+  }
+
+  if (1 == num_jobs) {
+    vec3 sdir, tdir;
+    vertex_tangents.assign(nverts * 2, vec3(0.0f, 0.0f, 0.0f));
+    for (size_t i = 0; i < nfaces; ++i) {
+      calculateFaceTangent(faces[i], sdir, tdir);
+      vec3* a = &vertex_tangents[faces[i].a.v * 2];
+      vec3* b = &vertex_tangents[faces[i].b.v * 2];
+      vec3* c = &vertex_tangents[faces[i].c.v * 2];
+      a[0] += sdir;
+      b[0] += sdir;
+      c[0] += sdir;
+      a[1] += tdir;
+      b[1] += tdir;
+      c[1] += tdir;
+    }
+    vertexTangentsJob(0, this);
+    return;
+  }
 
-#if defined(ROXLU_USE_AUDIO)
-#  ifndef ROXLU_USE_AUDIO_H
-#  define ROXLU_USE_AUDIO_H
-#  include <sndfile.h>
-#  include <cubeb/cubeb.h>
-#  if defined(__APPLE__) or defined(__linux)
-#    include <pthread.h>
-#  endif
+  /* Tangent and bitangent per face. */
+  face_tangents.resize(nfaces * 2);
+  rx_parallel_for(num_jobs, OBJ::faceTangentsJob, this, nthreads);
 
-/*
+  createAdjacency();
 
-  AudioPlayer
-  -----------
-  
-  The audio player uses libsndfile and libcubeb (Firefox' audio output layer) to 
-  load and playback audio files. At this moment we only support audio files with 
-  a samplerate of 44100, 2 channels. 
+  /* Sum and orthogonalize per vertex. */
+  rx_parallel_for(num_jobs, OBJ::vertexTangentsJob, this, nthreads);
 
-  On Mac you must link with:
-  --------------------------
-  - cubeb (https://github.com/kinetiknz/cubeb)
-  - pthreads
-  - AudioUnit framework
-  - CoreAudio framework
-  - AudioToolbox framework
+} // OBJ::calculateTangents
 
-  On Linux you must link with (depending how you compiled libsndfile):
-  -------------------------------------------------------------------
-  -lz
-  -lpthread
-  -logg
-  -lvorbis
-  -lvorbisenc
-  -lFLAC
-  -ldl
-  -lasound
+inline void OBJ::faceTangentsJob(int dx, void* user) {
 
+  OBJ* obj = (OBJ*)user;
+  size_t nfaces = obj->faces.size();
+  size_t start = (nfaces * dx) / obj->num_jobs;
+  size_t end = (nfaces * (dx + 1)) / obj->num_jobs;
 
-  High level description:
-  -----------------------
-  AudioPlayer:         interface that is supposed to use to add audio files and play them
-  AudioFile:           holds a buffer (data) with float (2-channel) audio
-  AudioPlaybackState:  a user can play the same audio file multiple times; this object keeps 
-                       track of the current read position in the AudioFile.data member
+  for(size_t i = start; i < end; ++i) {
+    obj->calculateFaceTangent(obj->faces[i], obj->face_tangents[i * 2 + 0], obj->face_tangents[i * 2 + 1]);
+  }
+}
 
-  ````c++
-  AudioPlayer player;
+inline void OBJ::calculateFaceTangent(const FACE& face, vec3& sdir, vec3& tdir) {
 
-  player.add(0, "boing.wav");
-  player.add(1, "bleep.wav");
-  player.add(2, "zweeep.wav");
+  const vec3& v1 = vertices[face.a.v];
+  const vec3& v2 = vertices[face.b.v];
+  const vec3& v3 = vertices[face.c.v];
 
-  AudioPlaybackState* state = player.play(0);
-  if(state) {
-     state->volume(0.5);
-  }
-  ````                       
+  const vec2& c1 = tex_coords[face.a.t];
+  const vec2& c2 = tex_coords[face.b.t];
+  const vec2& c3 = tex_coords[face.c.t];
 
-*/
+  float x1 = v2.x - v1.x;
+  float x2 = v3.x - v1.x;
 
-class AudioPlayer;
+  float y1 = v2.y - v1.y;
+  float y2 = v3.y - v1.y;
 
-long audioplayer_data_cb(cubeb_stream* stm, void* user, void* buffer, long nframes);      /* The callback that gets called by cubeb that whenever it wants some more audio data */
-void audioplayer_state_cb(cubeb_stream* stm, void* user, cubeb_state state);              /* Is called whenever a stream starts or stops */
+  float z1 = v2.z - v1.z;
+  float z2 = v3.z - v1.z;
 
-/* ----------------------------------- */
+  float s1 = c2.x - c1.x;
+  float s2 = c3.x - c1.x;
 
-class AudioFile {                                                                         /* An AudioFile will hold the raw loaded audio data */
- public:
-  AudioFile();
-  bool load(std::string filepath);                                                        /* Loads the given audio filepath usign libsnd file */
+  float t1 = c2.y - c1.y;
+  float t2 = c3.y - c1.y;
 
- public:
-  SNDFILE* sf;                                                                            /* Handle to the sound file */
-  SF_INFO info;                                                                           /* Contains information about the loaded sound file. See libsndfile documentation for more info */
-  std::vector<float> data;                                                                /* The raw audio data */
-};
+  float r = 1.0f / (s1 * t2 - s2 * t1);
 
-/* ----------------------------------- */
+  sdir.set((t2 * x1 - t1 * x2) * r, 
+           (t2 * y1 - t1 * y2) * r,
+           (t2 * z1 - t1 * z2) * r);
 
-class AudioPlaybackState {                                                                /* Everytime you call AudioPlayer::play() we create a new AudioPlaybackState instance that keeps track of the read position for this sample */
- public: 
-  AudioPlaybackState(int name, AudioFile* file);                                          /* C'tor; pass the name of the audio file and a pointer to the actual AudioFile itself that contains the audio data */
-  ~AudioPlaybackState();
-  void volume(float level) ;                                                              /* Set the volume: 0 - off, 1.0 full */
+  tdir.set((s1 * x2 - s2 * x1) * r, 
+           (s1 * y2 - s2 * y1) * r,
+           (s1 * z2 - s2 * z1) * r);
+}
 
- public:
-  AudioFile* file;                                                                        /* Pointer to the audio file */
-  size_t read_pos;                                                                        /* The current read position in the file->data member. */
-  float volume_level;                                                                     /* Each playstate keeps track of it's own volume */
-  int name;                                                                               /* The name of the audio file that we play (a redundant, easy helper) */
-};
+inline void OBJ::vertexTangentsJob(int dx, void* user) {
 
-/* ----------------------------------- */
+  OBJ* obj = (OBJ*)user;
+  size_t nverts = obj->vertices.size();
+  size_t start = (nverts * dx) / obj->num_jobs;
+  size_t end = (nverts * (dx + 1)) / obj->num_jobs;
+  bool summed = (1 == obj->num_jobs);
+  const vec3* face_tangents = obj->face_tangents.size() ? &obj->face_tangents[0] : NULL;
+  const uint32_t* offsets = summed ? NULL : &obj->adj_offsets[0];
+  const uint32_t* corners = obj->adj_corners.size() ? &obj->adj_corners[0] : NULL;
 
-class AudioPlayer {                                                                       /* The AudioPlayer manages all the audio files and states. */
- public:
-  AudioPlayer();                                                                          /* C'tor, creates the necessary cubeb context and stream. */
-  ~AudioPlayer();                                                                         /* D'tor, cleans up all allocated members. */
-  bool add(int name, std::string filepath);                                               /* Add a new audio file for the given name and filepath. Note that we use libsndfile to load the audio files. */
-  AudioPlaybackState* play(int name, float volume = 1.0);                                 /* Playback the given audio name. We return the state object on which you can set the volume. On error we return NULL. */
-  void lock();                                                                            /* Locks a mutex; used to sync access to the play_states member. */
-  void unlock();                                                                          /* Unlocks a mutex; "" "" "" */
+  for(size_t i = start; i < end; ++i) {
 
- public:
-  cubeb* cube_ctx;                                                                        /* The cubeb state */
-  cubeb_stream* cube_stream;                                                              /* The cubeb_stream to playback the audio samples. We only have one stream. */
-  std::map<int, AudioFile*> files;                                                        /* The added files */
-  std::vector<AudioPlaybackState*> play_states;                                           /* The playback states; each state keeps track of what frames to play and the volume */
+    vec3 t(0.0f, 0.0f, 0.0f);
+    vec3 t2(0.0f, 0.0f, 0.0f);
 
-#if defined(__APPLE__) or defined(__linux) 
-  pthread_mutex_t mutex;                                                                  /* Used to lock the mutex to protect the play_states member. */
-#endif  
-};
+    if (summed) {
+      t = obj->vertex_tangents[i * 2 + 0];
+      t2 = obj->vertex_tangents[i * 2 + 1];
+    }
+    else {
+      for (uint32_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+        const vec3* ft = face_tangents + (corners[j] / 3) * 2;
+        t += ft[0];
+        t2 += ft[1];
+      }
+    }
 
-#  endif // ROXLU_USE_AUDIO_H
-#endif // defined(ROXLU_USE_AUDIO)
+    const vec3& n = normalized(obj->normals[i]);
+    vec3 tangent = normalized(t - n * dot(n, t));
+    float w = (dot(cross(n, t), t2) < 0.0f) ? -1.0f : 1.0f;
+    obj->tangents[i].set(tangent.x, tangent.y, tangent.z, w);
+  }
+}
 
+/* Counting sort of the face corners on vertex; the corners of a vertex are stored in face order. */
+inline void OBJ::createAdjacency() {
 
-// ------------------------------------------------------------------------------------
-//                              R O X L U _ U S E _ L O G
-// ------------------------------------------------------------------------------------
-#if defined(ROXLU_USE_LOG)
-#  ifndef ROXLU_USE_LOG_H
-#  define ROXLU_USE_LOG_H
+  size_t nfaces = faces.size();
+  size_t nverts = vertices.size();
 
-#define RX_LOG_LEVEL_ALL 4
-#define RX_LOG_LEVEL_ERROR  1
-#define RX_LOG_LEVEL_WARNING 2
-#define RX_LOG_LEVEL_VERBOSE 3
+  adj_offsets.assign(nverts + 1, 0);
+  for (size_t i = 0; i < nfaces; ++i) {
+    adj_offsets[faces[i].a.v + 1]++;
+    adj_offsets[faces[i].b.v + 1]++;
+    adj_offsets[faces[i].c.v + 1]++;
+  }
+  
+  for (size_t i = 0; i < nverts; ++i) {
+    adj_offsets[i + 1] += adj_offsets[i];
+  }
 
-#if defined(_MSC_VER)
-#  define RX_VERBOSE(fmt, ...) { rx_verbose(__LINE__, __FUNCSIG__, fmt, ##__VA_ARGS__); } 
-#  define RX_WARNING(fmt, ...) { rx_warning(__LINE__, __FUNCSIG__, fmt, ##__VA_ARGS__); } 
-#  define RX_ERROR(fmt, ...) { rx_error(__LINE__, __FUNCSIG__, fmt, ##__VA_ARGS__); } 
-#else                                                                             
-#  define RX_VERBOSE(fmt, ...) { rx_verbose(__LINE__, __PRETTY_FUNCTION__, fmt, ##__VA_ARGS__); } 
-#  define RX_WARNING(fmt, ...) { rx_warning(__LINE__, __PRETTY_FUNCTION__, fmt, ##__VA_ARGS__); } 
-#  define RX_ERROR(fmt, ...) { rx_error(__LINE__, __PRETTY_FUNCTION__, fmt, ##__VA_ARGS__); } 
-#endif
+  adj_corners.resize(nfaces * 3);
+  for (size_t i = 0; i < nfaces; ++i) {
+    adj_corners[adj_offsets[faces[i].a.v]++] = i * 3 + 0;
+    adj_corners[adj_offsets[faces[i].b.v]++] = i * 3 + 1;
+    adj_corners[adj_offsets[faces[i].c.v]++] = i * 3 + 2;
+  }
 
-/* --------------------------------------------------------------------------------- */
+  /* Filling moved every offset to the start of the next vertex; shift them back. */
+  for (size_t i = nverts; i > 0; --i) {
+    adj_offsets[i] = adj_offsets[i - 1];
+  }
+  adj_offsets[0] = 0;
+}
 
-int rx_log_init(std::string path = "");
-void rx_log_disable_stdout();
-void rx_log_enable_stdout();
-void rx_log_set_level(int level);
-void rx_verbose(int line, const char* function, const char* fmt, ...);
-void rx_warning(int line, const char* function, const char* fmt, ...);
-void rx_error(int line, const char* function, const char* fmt, ...);
+/*
+   Smooth normals: every face corner gets the weighted sum of the normals
+   of the faces around its vertex that make an angle smaller than the 
+   crease angle with its own face. Corners of a vertex that end up with the
+   same normal share it. The first normal of vertex `i` is stored at 
+   `normals[i]` (so calculateTangents() can use it), the others are 
+   appended after the last vertex. 
+ */
+inline bool OBJ::calculateNormals(float creaseAngle, int weighting) {
 
-/* --------------------------------------------------------------------------------- */
+  if (0 == faces.size()) {
+    printf("Error: cannot calculate normals, we have no faces.\n");
+    return false;
+  }
 
-class Log {
- public:
-  Log();
-  ~Log();
-  int open(std::string filepath);
-  void log(int level, int line, const char* function, const char* fmt, va_list args);
+  if (weighting != OBJ_NORMALS_WEIGHT_AREA && weighting != OBJ_NORMALS_WEIGHT_ANGLE) {
+    printf("Error: invalid normal weighting: %d\n", weighting);
+    return false;
+  }
 
- public:
-  bool write_to_stdout;
-  int level;                   /* what level we should log. */
+  size_t nfaces = faces.size();
+  size_t nverts = vertices.size();
+  int nthreads = (num_threads > 0) ? num_threads : rx_get_num_cores();
 
- private:
-  std::string filepath;        /* filepath where we save the log file. */
-  std::ofstream ofs;           /* the output file stream */
-};
+  num_jobs = 1;
+  if (nthreads > 1 && nfaces > 64 * 1024) {
+    num_jobs = nthreads * 4;
+  }
 
-/* --------------------------------------------------------------------------------- */
+  normals_crease = (creaseAngle >= 180.0f) ? -2.0f : cos(creaseAngle * DEG_TO_RAD);
+  normals_weighting = weighting;
 
-extern Log rx_log;
+  face_normals.resize(nfaces);
+  corner_weights.resize(nfaces * 3);
+  rx_parallel_for(num_jobs, OBJ::faceNormalsJob, this, nthreads);
 
-#  endif // ROXLU_USE_LOG_H
-#endif // defined(ROXLU_USE_LOG) 
+  createAdjacency();
 
+  corner_normals.resize(nfaces * 3);
+  corner_ids.resize(nfaces * 3);
+  extra_offsets.resize(nverts + 1);
+  rx_parallel_for(num_jobs, OBJ::cornerNormalsJob, this, nthreads);
 
-// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-//                          I M P L E M E N T A T I O N
-// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  /* cornerNormalsJob() stored the number of extra normals per vertex, turn them into offsets. */
+  uint32_t nextra = 0;
+  for (size_t i = 0; i < nverts; ++i) {
+    uint32_t n = extra_offsets[i];
+    extra_offsets[i] = nextra;
+    nextra += n;
+  }
+  extra_offsets[nverts] = nextra;
 
-// ====================================================================================
-//                              T I N Y L I B 
-// ====================================================================================
+  normals.resize(nverts + nextra);
+  rx_parallel_for(num_jobs, OBJ::vertexNormalsJob, this, nthreads);
 
-#if defined(ROXLU_IMPLEMENTATION)
+  has_normals = true;
+  indices.clear();
+  unique_tris.clear();
 
-#if defined(_WIN32) 
-extern std::string rx_get_exe_path() {
-  char buffer[MAX_PATH];
+  if (has_texcoords) {
+    tangents.assign(vertices.size(), vec4());
+    calculateTangents();
+    has_tangents = true;
+  }
 
-  // Try to get the executable path with a buffer of MAX_PATH characters.
-  DWORD result = ::GetModuleFileNameA(nullptr, buffer, static_cast<DWORD>(MAX_PATH));
-  if(result == 0) {
-    return "";
-  }
-
-  std::string::size_type pos = std::string(buffer).find_last_of( "\\/" );
-
-  return std::string(buffer).substr(0, pos) +"\\";
+  return true;
 }
-#elif defined(__APPLE__) 
-extern std::string rx_get_exe_path() {
-  char buffer[1024];
-  uint32_t usize = sizeof(buffer);;
 
-  int result;
-  char* path;
-  char* fullpath;
+inline bool OBJ::calculateFlatNormals() {
 
-  result = _NSGetExecutablePath(buffer, &usize);
-  if (result) {
-    return "";
+  if (0 == faces.size()) {
+    printf("Error: cannot calculate normals, we have no faces.\n");
+    return false;
   }
 
-  path = (char*)malloc(2 * PATH_MAX);
-  fullpath = realpath(buffer, path);
+  int nthreads = (num_threads > 0) ? num_threads : rx_get_num_cores();
 
-  if (fullpath == NULL) {
-    free(path);
-    return "";
+  num_jobs = 1;
+  if (nthreads > 1 && faces.size() > 64 * 1024) {
+    num_jobs = nthreads * 4;
   }
-  strncpy(buffer, fullpath, usize);
 
-  const char* dn = dirname(buffer);
-  usize = strlen(dn);
-  std::string ret(dn, usize) ;
-  ret.push_back('/');
+  /* Like calculateNormals(), normals[i] is a normal of vertex i for calculateTangents(); the face normals come after them. */
+  size_t nverts = vertices.size();
+  normals.resize(nverts + faces.size());
+  rx_parallel_for(num_jobs, OBJ::flatNormalsJob, this, nthreads);
 
-  free(path);
-  return ret;
-}
-#elif defined(__linux) 
-extern std::string rx_get_exe_path() {
-  char buffer[MAX_PATH];
-  size_t size = MAX_PATH;
-  ssize_t n = readlink("/proc/self/exe", buffer, size - 1);
-  if (n <= 0) {
-    return "";
+  std::fill(normals.begin(), normals.begin() + nverts, vec3(0.0f, 0.0f, 0.0f));
+  for (size_t i = 0; i < faces.size(); ++i) {
+    const vec3& n = normals[nverts + i];
+    normals[faces[i].a.v] += n;
+    normals[faces[i].b.v] += n;
+    normals[faces[i].c.v] += n;
   }
-  buffer[n] = '\0';
-
-
-  const char* dn = dirname(buffer);
-  size = strlen(dn);
-  std::string ret(dn, size) ;
-  ret.push_back('/');
-  return ret;
-}
-#endif // rx_get_exe_path() / win32
 
-extern bool rx_file_exists(std::string filepath) {
+  for (size_t i = 0; i < nverts; ++i) {
+    if (dot(normals[i], normals[i]) > 0.0f) {
+      normals[i] = normalized(normals[i]);
+    }
+  }
 
-#if defined(_WIN32)
-  char* lptr = (char*)filepath.c_str();
-  DWORD dwattrib = GetFileAttributes(lptr);
-  return (dwattrib != INVALID_FILE_ATTRIBUTES && !(dwattrib & FILE_ATTRIBUTE_DIRECTORY));
+  has_normals = true;
+  indices.clear();
+  unique_tris.clear();
 
-#elif defined(__APPLE__)
-  int res = access(filepath.c_str(), R_OK);
-  if(res < 0) {
-    return false;
+  /* The tangents were orthogonalized against the old normals. */
+  if (has_texcoords) {
+    tangents.assign(vertices.size(), vec4());
+    calculateTangents();
+    has_tangents = true;
+  }
+  else {
+    has_tangents = false;
   }
-#else
-  struct stat buffer;   
-  return (stat(filepath.c_str(), &buffer) == 0);
-#endif
 
   return true;
 }
 
-#if defined(WIN32) 
-extern bool rx_is_dir(std::string filepath) {
-  DWORD type = GetFileAttributesA(filepath.c_str());
-  if (type & FILE_ATTRIBUTE_DIRECTORY) {
-    return true; 
-  }
-  if (type & INVALID_FILE_ATTRIBUTES) {
-    return false; 
-  }
-  return false;
-}
-#else
-extern bool rx_is_dir(std::string filepath) {
-  struct stat st;
-  int result = stat(filepath.c_str(), &st);
+inline void OBJ::faceNormalsJob(int dx, void* user) {
 
-  if(result < 0) {
-    if(errno == EACCES) {
-      printf("EACCESS: no permission for: %s", filepath.c_str());
-    }
-    else if(errno == EFAULT) {
-      printf("EFAULT: bad address, for: %s", filepath.c_str());
-    }
-    else if(errno == ELOOP) {
-      printf("ELOOP: too many links, for: %s", filepath.c_str());
-    }
-    else if(errno == ENAMETOOLONG) {
-      printf("ENAMETOOLONG: for: %s", filepath.c_str());
-    }
-    else if(errno == ENOENT) {
-      // we expect this when the dir doesn't exist
-      return false;
+  OBJ* obj = (OBJ*)user;
+  size_t nfaces = obj->faces.size();
+  size_t start = (nfaces * dx) / obj->num_jobs;
+  size_t end = (nfaces * (dx + 1)) / obj->num_jobs;
+
+  for (size_t i = start; i < end; ++i) {
+
+    OBJ::FACE& face = obj->faces[i];
+    const vec3& v1 = obj->vertices[face.a.v];
+    const vec3& v2 = obj->vertices[face.b.v];
+    const vec3& v3 = obj->vertices[face.c.v];
+    vec3 e1 = v2 - v1;
+    vec3 e2 = v3 - v1;
+    vec3 e3 = v3 - v2;
+    vec3 n = cross(e1, e2);
+    float len = length(n);
+    float* w = &obj->corner_weights[i * 3];
+
+    if (len <= 0.0f) {
+      obj->face_normals[i].set(0.0f, 0.0f, 0.0f);
+      w[0] = w[1] = w[2] = 0.0f;
+      continue;
     }
-    else if(errno == ENOMEM) {
-      printf("ENOMEM: for: %s", filepath.c_str());
+
+    obj->face_normals[i] = n / len;
+
+    if (obj->normals_weighting == OBJ_NORMALS_WEIGHT_AREA) {
+      w[0] = w[1] = w[2] = len * 0.5f;
     }
-    else if(errno == ENOTDIR) {
-      printf("ENOTDIR: for: %s", filepath.c_str());
+    else {
+      float l1 = length(e1);
+      float l2 = length(e2);
+      float l3 = length(e3);
+      w[0] = (l1 > 0.0f && l2 > 0.0f) ? acos(CLAMP(dot(e1, e2) / (l1 * l2), -1.0f, 1.0f)) : 0.0f;
+      w[1] = (l1 > 0.0f && l3 > 0.0f) ? acos(CLAMP(dot(-e1, e3) / (l1 * l3), -1.0f, 1.0f)) : 0.0f;
+      w[2] = PI - w[0] - w[1];
     }
-    else if(errno == EOVERFLOW) {
-      printf("EOVERFLOW: for: %s", filepath.c_str());
+  }
+}
+
+inline void OBJ::cornerNormalsJob(int dx, void* user) {
+
+  OBJ* obj = (OBJ*)user;
+  size_t nverts = obj->vertices.size();
+  size_t start = (nverts * dx) / obj->num_jobs;
+  size_t end = (nverts * (dx + 1)) / obj->num_jobs;
+  const uint32_t* offsets = &obj->adj_offsets[0];
+  const uint32_t* corners = obj->adj_corners.size() ? &obj->adj_corners[0] : NULL;
+  const vec3* face_normals = &obj->face_normals[0];
+  const float* weights = &obj->corner_weights[0];
+  float crease = obj->normals_crease;
+
+  for (size_t i = start; i < end; ++i) {
+
+    uint32_t first = offsets[i];
+    uint32_t last = offsets[i + 1];
+    uint32_t nunique = 0;
+
+    for (uint32_t j = first; j < last; ++j) {
+
+      const vec3& fn = face_normals[corners[j] / 3];
+      vec3 n(0.0f, 0.0f, 0.0f);
+
+      for (uint32_t k = first; k < last; ++k) {
+        const vec3& other = face_normals[corners[k] / 3];
+        if (k == j || dot(fn, other) >= crease) {
+          n += other * weights[corners[k]];
+        }
+      }
+
+      float len = length(n);
+      obj->corner_normals[j] = (len > 0.0f) ? n / len : fn;
+
+      /* Share the normal with an earlier corner of this vertex when it's the same. */
+      uint32_t id = nunique;
+      for (uint32_t k = first; k < j; ++k) {
+        if (obj->corner_normals[k] == obj->corner_normals[j]) {
+          id = obj->corner_ids[k];
+          break;
+        }
+      }
+
+      if (id == nunique) {
+        nunique++;
+      }
+
+      obj->corner_ids[j] = id;
     }
 
-    return false;
+    obj->extra_offsets[i] = (nunique > 1) ? nunique - 1 : 0;
   }
-
-#if defined(__APPLE__) or defined(__linux__)
-  return S_ISDIR(st.st_mode);
-#else 
-  return result == 0;
-#endif  
 }
-#endif // !defined(WIN32) for rx_is_dir()
 
-extern std::string rx_to_data_path(const std::string filename) {
+inline void OBJ::vertexNormalsJob(int dx, void* user) {
 
-  std::string data_path = rx_get_data_path();
-  if (0 != data_path.size()) {
-    return data_path + filename;
+  OBJ* obj = (OBJ*)user;
+  size_t nverts = obj->vertices.size();
+  size_t start = (nverts * dx) / obj->num_jobs;
+  size_t end = (nverts * (dx + 1)) / obj->num_jobs;
+  const uint32_t* offsets = &obj->adj_offsets[0];
+
+  for (size_t i = start; i < end; ++i) {
+
+    obj->normals[i].set(0.0f, 0.0f, 0.0f);
+
+    for (uint32_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+
+      uint32_t id = obj->corner_ids[j];
+      uint32_t dst = (0 == id) ? i : nverts + obj->extra_offsets[i] + id - 1;
+      uint32_t corner = obj->adj_corners[j];
+      OBJ::FACE& face = obj->faces[corner / 3];
+      OBJ::TRI& tri = (corner % 3 == 0) ? face.a : ((corner % 3 == 1) ? face.b : face.c);
+
+      obj->normals[dst] = obj->corner_normals[j];
+      tri.n = dst;
+    }
   }
+}
 
-  data_path = rx_get_exe_path();
+inline void OBJ::flatNormalsJob(int dx, void* user) {
 
-#if defined(__APPLE__)
-  if(rx_is_dir(data_path +"data")) {
-    data_path += "data/" +filename;
+  OBJ* obj = (OBJ*)user;
+  size_t nfaces = obj->faces.size();
+  size_t start = (nfaces * dx) / obj->num_jobs;
+  size_t end = (nfaces * (dx + 1)) / obj->num_jobs;
+
+  size_t nverts = obj->vertices.size();
+
+  for (size_t i = start; i < end; ++i) {
+    OBJ::FACE& face = obj->faces[i];
+    vec3 n = cross(obj->vertices[face.b.v] - obj->vertices[face.a.v], obj->vertices[face.c.v] - obj->vertices[face.a.v]);
+    obj->normals[nverts + i] = (dot(n, n) > 0.0f) ? normalized(n) : n;
+    face.a.n = face.b.n = face.c.n = nverts + i;
   }
-  else if(rx_is_dir(data_path +"../MacOS")) {
-    /* When we're part of an .app bundle, the Resources dir is our data dir. */
-    data_path += "../Resources/" +filename;
+}
+
+/*
+  VertexPacker
+  ------------
+
+  Converts float vertices into the packed vertex types to reduce the memory 
+  bandwidth of the vertex fetch: a VertexPTTN of 48 bytes becomes a 
+  VertexPackedPTTN or VertexQuantizedPTTN of 20 bytes. 
+
+  - VertexPacked*:    half float positions, precise to ~3 digits so use 
+                      them for meshes around the origin. 
+  - VertexQuantized*: unorm16 positions relative to the bounds of the mesh; 
+                      the precision is bounds_size / 65535 on every axis. Pass 
+                      bounds_min and bounds_size to the shader.
+  - texcoords are clamped to [0, 1] and stored as unorm16, normals are 
+    octahedral encoded into two snorm16 values and tangents are stored 
+    as snorm8 with the handedness in w.
+
+  The conversion uses SSE2 when available (and F16C for the half floats). 
+  rx_vertex_attrib_pointers<T>() sets up the attributes and VERTEX_PACKED_GLSL 
+  contains the functions to decode the normal and the position:
+
+  ````c++
+  std::vector<VertexQuantizedPTTN> vertices;
+  std::vector<uint32_t> indices;
+
+  VertexPacker packer;
+  packer.copy(obj, vertices, indices);
+
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexQuantizedPTTN), &vertices[0], GL_STATIC_DRAW);
+  rx_vertex_attrib_pointers<VertexQuantizedPTTN>();
+
+  glUniform3fv(u_bounds_min, 1, packer.bounds_min.ptr());
+  glUniform3fv(u_bounds_size, 1, packer.bounds_size.ptr());
+  ````
+
+  VERTEX_PACKED_GLSL is a string literal so it can be pasted into the 
+  source of a vertex shader, after the #version line and the attributes:
+
+  ````c++
+  static const char* MESH_VS = ""
+    "#version 330\n"
+    "layout( location = 0 ) in vec4 a_pos;\n"
+    "layout( location = 2 ) in vec2 a_norm;\n"
+    "uniform vec3 u_bounds_min;\n"
+    "uniform vec3 u_bounds_size;\n"
+    VERTEX_PACKED_GLSL
+    "void main() {\n"
+    "  vec3 pos = rx_decode_position(a_pos.xyz, u_bounds_min, u_bounds_size);\n"
+    "  vec3 norm = rx_decode_octahedral(a_norm);\n"
+    "  ...\n"
+    "}\n";
+  ````
+ */
+
+#define VERTEX_PACKED_GLSL                                                 \
+  "vec3 rx_decode_octahedral(vec2 e) {\n"                                  \
+  "  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));\n"                    \
+  "  float t = max(-n.z, 0.0);\n"                                          \
+  "  n.x += (n.x >= 0.0) ? -t : t;\n"                                      \
+  "  n.y += (n.y >= 0.0) ? -t : t;\n"                                      \
+  "  return normalize(n);\n"                                               \
+  "}\n"                                                                    \
+  "vec3 rx_decode_position(vec3 q, vec3 boundsMin, vec3 boundsSize) {\n"   \
+  "  return boundsMin + q * boundsSize;\n"                                 \
+  "}\n"
+
+/* IEEE half float conversion, rounds to nearest even like the F16C instructions. */
+inline uint16_t rx_float_to_half(float f) {
+
+  uint32_t u;
+  memcpy(&u, &f, 4);
+
+  uint32_t sign = u & 0x80000000u;
+  uint32_t result;
+  u ^= sign;
+
+  if (u >= ((127 + 16) << 23)) {                                  /* inf or nan */
+    result = (u > (255u << 23)) ? 0x7E00 : 0x7C00;
+  }
+  else if (u < (113 << 23)) {                                     /* subnormal half or zero; the float add does the rounding */
+    uint32_t magic = ((127 - 15) + (23 - 10) + 1) << 23;
+    float mf, af;
+    memcpy(&mf, &magic, 4);
+    memcpy(&af, &u, 4);
+    af += mf;
+    memcpy(&result, &af, 4);
+    result -= magic;
   }
   else {
-    data_path += filename;
+    uint32_t odd = (u >> 13) & 1;
+    u -= 112u << 23;                                              /* rebias the exponent from 127 to 15 */
+    u += 0xFFFu + odd;
+    result = u >> 13;
   }
-#elif defined(__linux)
-  data_path += "data/" +filename;
-#else 
-  data_path += "data\\" +filename;
-#endif  
 
-  return data_path;
+  return (uint16_t)(result | (sign >> 16));
 }
 
-std::string rx_data_path = "";
-
-extern void rx_set_data_path(const std::string path) {
-  rx_data_path = path;
-}
+inline float rx_half_to_float(uint16_t h) {
 
-extern std::string rx_get_data_path() {
-  
-  return rx_data_path;
-}
+  uint32_t u = (uint32_t)(h & 0x7FFF) << 13;
+  uint32_t exp = u & (0x7C00 << 13);
+  float f;
 
-/* See http://stackoverflow.com/questions/4021479/getting-file-modification-time-on-unix-using-utime-in-c */
-/* returns the unix epoc time stamp in nano seconds */
-extern uint64_t rx_get_file_mtime(std::string filepath) {
-#if defined(_WIN32)
-  struct _stat statbuf;
-  if (_stat(filepath.c_str(), &statbuf) == -1) {
-    return 0;
+  u += (127 - 15) << 23;
+  if (exp == (0x7C00 << 13)) {                                    /* inf or nan */
+    u += (128 - 16) << 23;
+    memcpy(&f, &u, 4);
   }
-  return statbuf.st_mtime * 1e6;
-#else  
-  struct stat statbuf;
-  if (stat(filepath.c_str(), &statbuf) == -1) {
-    return 0;
+  else if (exp == 0) {                                            /* subnormal or zero */
+    uint32_t magic = 113 << 23;
+    float mf;
+    u += 1 << 23;
+    memcpy(&f, &u, 4);
+    memcpy(&mf, &magic, 4);
+    f -= mf;
   }
-  return statbuf.st_mtime * 1e6;
-#endif
-}
-
-extern std::string rx_string_replace(std::string str, std::string from, std::string to) {
-  size_t start_pos = str.find(from);
-  if(start_pos == std::string::npos) {
-    return str;
+  else {
+    memcpy(&f, &u, 4);
   }
-  str.replace(start_pos, from.length(), to);
-  return str;
-}
 
-extern std::string rx_string_replace(std::string str, char from, char to) {
-  std::replace(str.begin(), str.end(), from, to);
-  return str;
+  return (h & 0x8000) ? -f : f;
 }
 
-extern std::string rx_strip_filename(std::string path) {
-  std::string directory;
-  path = rx_string_replace(path, '\\', '/');
-  path = rx_string_replace(path, "//", "/");
-  const size_t last_slash_idx = path.rfind('/');
+/* Maps a unit vector onto the octahedron and unfolds it into [-1, 1]^2. */
+inline void rx_oct_encode(const vec3& n, float& x, float& y) {
 
-  if(std::string::npos != last_slash_idx) {
-    directory = path.substr(0, last_slash_idx + 1);
+  float len = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+  if (len <= 0.0f) {
+    x = y = 0.0f;
+    return;
   }
 
-#if defined(_WIN32)
-  directory = rx_string_replace(directory, '/', '\\');
-#endif
+  x = n.x / len;
+  y = n.y / len;
 
-  return directory;
+  if (n.z < 0.0f) {
+    float ox = x;
+    x = (1.0f - fabsf(y)) * ((ox >= 0.0f) ? 1.0f : -1.0f);
+    y = (1.0f - fabsf(ox)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+  }
 }
 
-extern std::string rx_strip_file_ext(std::string path) {
-  std::string ext = "." +rx_get_file_ext(path);
-  std::string result = rx_string_replace(path, ext, "");
-  return result;
+inline vec3 rx_oct_decode(float x, float y) {
+
+  vec3 n(x, y, 1.0f - fabsf(x) - fabsf(y));
+  float t = HEIGHEST(-n.z, 0.0f);
+
+  n.x += (n.x >= 0.0f) ? -t : t;
+  n.y += (n.y >= 0.0f) ? -t : t;
+
+  return normalized(n);
 }
 
-extern std::string rx_strip_dir(std::string path) {
-  std::string filename;;
-  path = rx_string_replace(path, '\\', '/');
-  path = rx_string_replace(path, "//", "/");
+#if defined(ROXLU_SSE2) && !defined(ROXLU_F16C)
+/* SSE2 version of rx_float_to_half(); returns the halfs sign extended in the 4 int32 lanes. */
+inline __m128i rx_float_to_half_sse2(__m128 f) {
 
-  const size_t last_slash_idx = path.rfind('/');
-  if(last_slash_idx == std::string::npos) {
-    return path;
-  }
+  const __m128i f16max = _mm_set1_epi32((127 + 16) << 23);
+  const __m128i min_normal = _mm_set1_epi32(113 << 23);
+  const __m128i subnorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+  const __m128i normal_bias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
 
-  if(std::string::npos != last_slash_idx) {
-    filename = path.substr(last_slash_idx + 1, path.size());
-  }
+  __m128 sign = _mm_and_ps(f, _mm_set1_ps(-0.0f));
+  __m128 absf = _mm_xor_ps(f, sign);
+  __m128i absi = _mm_castps_si128(absf);
 
-  return filename;
+  __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+  __m128i is_regular = _mm_cmpgt_epi32(f16max, absi);
+  __m128i is_subnormal = _mm_cmpgt_epi32(min_normal, absi);
+  __m128i inf_or_nan = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+  __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subnorm_magic))), subnorm_magic);
+  __m128i odd = _mm_srai_epi32(_mm_slli_epi32(absi, 31 - 13), 31);                  /* -1 when the mantissa is odd */
+  __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absi, normal_bias), odd), 13);
+
+  __m128i result = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+  result = _mm_or_si128(_mm_and_si128(is_regular, result), _mm_andnot_si128(is_regular, inf_or_nan));
+
+  return _mm_or_si128(result, _mm_srai_epi32(_mm_castps_si128(sign), 16));
 }
+#endif
 
-extern bool rx_create_dir(std::string path) {
-#ifdef _WIN32
-  if(_mkdir(path.c_str()) != 0) {
-    if(errno == ENOENT) { 
-      printf("Cannot create directory: %s (ENOENT)\n", path.c_str());
-      return false;
-    }
-    else if(errno == EEXIST) {
-      printf("Cannot create directory: %s (EEXIST)\n", path.c_str());
-    }
-  }
-  return true;
+class VertexPacker {
+ public:
+  VertexPacker();
+  void pack(const std::vector<VertexPTN>& in, std::vector<VertexPackedPTN>& out);            /* half float positions */
+  void pack(const std::vector<VertexPTTN>& in, std::vector<VertexPackedPTTN>& out);
+  void pack(const std::vector<VertexPTN>& in, std::vector<VertexQuantizedPTN>& out);         /* calculates bounds_min, bounds_size and stores the positions relative to them */
+  void pack(const std::vector<VertexPTTN>& in, std::vector<VertexQuantizedPTTN>& out);
+  template<class T, class I> bool copy(OBJ& obj, std::vector<T>& out, std::vector<I>& indices); /* copies the unique vertices + indices of the obj and packs them, T is one of the packed vertex types */
 
-#else
-  if(mkdir(path.c_str(), 0777) != 0) {
+ private:
+  template<class S, class T> void encode(const std::vector<S>& in, std::vector<T>& out, bool quantize);
+
+ public:
+  vec3 bounds_min;                                                                             /* minimum position of the last quantized mesh */
+  vec3 bounds_size;                                                                            /* size of the bounding box of the last quantized mesh */
+};
+
+inline VertexPacker::VertexPacker()
+  :bounds_min(0.0f, 0.0f, 0.0f)
+  ,bounds_size(0.0f, 0.0f, 0.0f)
+{
+}
+
+inline void VertexPacker::pack(const std::vector<VertexPTN>& in, std::vector<VertexPackedPTN>& out) {
+  encode(in, out, false);
+}
+
+inline void VertexPacker::pack(const std::vector<VertexPTTN>& in, std::vector<VertexPackedPTTN>& out) {
+  encode(in, out, false);
+}
+
+inline void VertexPacker::pack(const std::vector<VertexPTN>& in, std::vector<VertexQuantizedPTN>& out) {
+  encode(in, out, true);
+}
+
+inline void VertexPacker::pack(const std::vector<VertexPTTN>& in, std::vector<VertexQuantizedPTTN>& out) {
+  encode(in, out, true);
+}
+
+template<class T, class I>
+inline bool VertexPacker::copy(OBJ& obj, std::vector<T>& out, std::vector<I>& indices) {
+
+  std::vector<typename T::Unpacked> vertices;
+  if (false == obj.copy(vertices, indices)) {
     return false;
   }
+
+  pack(vertices, out);
+
   return true;
-#endif
 }
 
-extern std::string rx_get_file_ext(std::string filepath) {
-  size_t pos = filepath.rfind(".");
-  std::string result = "";
+/* 
+   Writes the attributes at the offsets of VertexLayout<T>, see the 
+   VertexPacked* types. The SSE2 path and the scalar path give the same 
+   results as both round to nearest even.
+*/
+template<class S, class T>
+inline void VertexPacker::encode(const std::vector<S>& in, std::vector<T>& out, bool quantize) {
 
-  if(pos == std::string::npos) {
-    return result;
-  }
+  typedef VertexLayout<S> LS;
+  typedef VertexLayout<T> LT;
 
-  std::string ext = filepath.substr(pos + 1, (filepath.size() - pos));
-  return ext;
-} // rx_get_file_ext()
+  out.resize(in.size());
+  if (0 == in.size()) {
+    return;
+  }
 
-extern bool rx_create_path(std::string path) {
+  float scale[3] = { 0.0f, 0.0f, 0.0f };
 
-#ifdef _WIN32
-  std::string drive;
-  for(int i = 0; i < path.size()-1; ++i) {
-    if(path[i] == ':' && path[i + 1] == '\\') {
-      break;
+  if (quantize) {
+    vec3 bmin = in[0].pos;
+    vec3 bmax = in[0].pos;
+    for (size_t i = 1; i < in.size(); ++i) {
+      const vec3& p = in[i].pos;
+      bmin.x = LOWEST(bmin.x, p.x);  bmax.x = HEIGHEST(bmax.x, p.x);
+      bmin.y = LOWEST(bmin.y, p.y);  bmax.y = HEIGHEST(bmax.y, p.y);
+      bmin.z = LOWEST(bmin.z, p.z);  bmax.z = HEIGHEST(bmax.z, p.z);
+    }
+    bounds_min = bmin;
+    bounds_size = bmax - bmin;
+    const float* size = bounds_size.ptr();
+    for (int k = 0; k < 3; ++k) {
+      scale[k] = (size[k] > 0.0f) ? (65535.0f / size[k]) : 0.0f;
     }
-    drive.push_back(path[i]);
   }
-  path = path.substr(drive.size() + 2);
-  drive = drive + ":";
+
+#if defined(ROXLU_SSE2)
+  const __m128 qmin = _mm_setr_ps(bounds_min.x, bounds_min.y, bounds_min.z, 0.0f);
+  const __m128 qscale = _mm_setr_ps(scale[0], scale[1], scale[2], 0.0f);
+  const __m128 tn_lo = _mm_setr_ps(0.0f, 0.0f, -1.0f, -1.0f);                       /* texcoord (unorm16), normal (snorm16) */
+  const __m128 tn_scale = _mm_setr_ps(65535.0f, 65535.0f, 32767.0f, 32767.0f);
+  const __m128i tn_bias = _mm_setr_epi32(32768, 32768, 0, 0);                        /* unorm16 through the signed pack: -32768 before, flip the sign bit after */
+  const __m128i tn_flip = _mm_setr_epi16((short)0x8000, (short)0x8000, 0, 0, (short)0x8000, (short)0x8000, 0, 0);
+  const __m128i q_bias = _mm_set1_epi32(32768);
+  const __m128i q_flip = _mm_set1_epi16((short)0x8000);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
 #endif
 
-  std::vector<std::string> dirs;
-  while(path.length() > 0) {
+  for (size_t i = 0; i < in.size(); ++i) {
 
-     
-#ifdef _WIN32
-    int index = path.find('\\'); // win 
-#else
-    int index = path.find('/'); // posix
-#endif
-    std::string dir = (index == -1 ) ? path : path.substr(0, index);
+    const char* src = (const char*)&in[i];
+    char* dst = (char*)&out[i];
+    const float* pos = (const float*)(src + LS::position);
+    const float* tex = (const float*)(src + LS::texcoord);
+    float oct[2];
+    uint16_t qpos[4];
+    uint16_t qtex[2];
+    int16_t qnorm[2];
 
-    if(dir.length() > 0) {
-      dirs.push_back(dir);
+    rx_oct_encode(*(const vec3*)(src + LS::normal), oct[0], oct[1]);
+
+#if defined(ROXLU_SSE2)
+
+    __m128 p = _mm_setr_ps(pos[0], pos[1], pos[2], 0.0f);
+    __m128i pi;
+    if (quantize) {
+      __m128 q = _mm_mul_ps(_mm_sub_ps(p, qmin), qscale);
+      q = _mm_min_ps(_mm_max_ps(q, zero), _mm_set1_ps(65535.0f));
+      pi = _mm_sub_epi32(_mm_cvtps_epi32(q), q_bias);
+      pi = _mm_xor_si128(_mm_packs_epi32(pi, pi), q_flip);
     }
-    if(index + 1 >= path.length() || index == -1) {
-      break;
+    else {
+#  if defined(ROXLU_F16C)
+      pi = _mm_cvtps_ph(p, 0);
+#  else
+      pi = rx_float_to_half_sse2(p);
+      pi = _mm_packs_epi32(pi, pi);
+#  endif
+    }
+    _mm_storel_epi64((__m128i*)qpos, pi);
+
+    __m128 tn = _mm_setr_ps(tex[0], tex[1], oct[0], oct[1]);
+    tn = _mm_mul_ps(_mm_min_ps(_mm_max_ps(tn, tn_lo), one), tn_scale);
+    __m128i tni = _mm_sub_epi32(_mm_cvtps_epi32(tn), tn_bias);
+    tni = _mm_xor_si128(_mm_packs_epi32(tni, tni), tn_flip);
+    uint32_t tn_bits[2];
+    _mm_storel_epi64((__m128i*)tn_bits, tni);
+    memcpy(qtex, &tn_bits[0], 4);
+    memcpy(qnorm, &tn_bits[1], 4);
+
+    if (LT::tangent >= 0) {
+      __m128 t = _mm_loadu_ps((const float*)(src + LS::tangent));
+      t = _mm_mul_ps(_mm_min_ps(_mm_max_ps(t, _mm_set1_ps(-1.0f)), one), _mm_set1_ps(127.0f));
+      __m128i ti = _mm_cvtps_epi32(t);
+      ti = _mm_packs_epi16(_mm_packs_epi32(ti, ti), ti);
+      int32_t tan_bits = _mm_cvtsi128_si32(ti);
+      memcpy(dst + LT::tangent, &tan_bits, 4);
     }
-    path = path.substr(index + 1);
-  }
-    
-  struct stat s;
-  std::string dir_path;
 
-#ifdef _WIN32
-  dir_path = drive;
-#endif
+#else
 
-  for(unsigned int i = 0; i < dirs.size(); i++) {
+    for (int k = 0; k < 3; ++k) {
+      if (quantize) {
+        qpos[k] = (uint16_t)lrintf(CLAMP((pos[k] - bounds_min.ptr()[k]) * scale[k], 0.0f, 65535.0f));
+      }
+      else {
+        qpos[k] = rx_float_to_half(pos[k]);
+      }
+    }
+    qpos[3] = 0;
 
-#ifdef _WIN32
-    dir_path += "\\";
-#else
-    dir_path += "/";
-#endif
+    for (int k = 0; k < 2; ++k) {
+      qtex[k] = (uint16_t)lrintf(CLAMP(tex[k], 0.0f, 1.0f) * 65535.0f);
+      qnorm[k] = (int16_t)lrintf(CLAMP(oct[k], -1.0f, 1.0f) * 32767.0f);
+    }
 
-#if !defined(_WIN32)
-    dir_path += dirs[i];
-    if(stat(dir_path.c_str(), &s) != 0) {
-      if(!rx_create_dir(dir_path.c_str())) {
-        printf("ERROR: cannot create directory: %s\n", dir_path.c_str());
-        return false;
+    if (LT::tangent >= 0) {
+      const float* tan = (const float*)(src + LS::tangent);
+      int8_t qtan[4];
+      for (int k = 0; k < 4; ++k) {
+        qtan[k] = (int8_t)lrintf(CLAMP(tan[k], -1.0f, 1.0f) * 127.0f);
       }
+      memcpy(dst + LT::tangent, qtan, 4);
     }
+
 #endif
+
+    memcpy(dst + LT::position, qpos, 8);
+    memcpy(dst + LT::texcoord, qtex, 4);
+    memcpy(dst + LT::normal, qnorm, 4);
   }
+}
 
-#if defined(_WIN32)
-   printf("WARNING: We have not yet implemented rx_create_path() on windows.\n");
-#endif
+/*
+  MeshOptimizer
+  -------------
+
+  Reorders indexed triangle lists so they render faster. The faces of an 
+  .obj file are stored in an arbitrary order which means that the GPU has to 
+  transform the same vertex several times. MeshOptimizer implements:
+
+  - optimizeVertexCache(): Tipsify, "Fast Triangle Reordering for Vertex 
+    Locality and Reduced Overdraw", Sander, Nehab, Barczak, 2007. Reorders 
+    the triangles so that vertices are reused while they're still in the 
+    post transform cache.
+  - optimizeOverdraw(): splits the result of optimizeVertexCache() into 
+    clusters and sorts them so that triangles on the outside of the mesh, 
+    which are likely to occlude others, are drawn first. `overdraw_threshold` 
+    is the factor by which the ACMR of a cluster may grow; bigger values 
+    give more clusters and less overdraw.
+  - optimizeVertexFetch(): reorders the vertices in the order they're first 
+    used by the indices so fetching vertices is cache friendly. Vertices that
+    aren't used are removed.
+
+  optimize() runs all passes and stores the average cache miss ratio (ACMR, 
+  transformed vertices per triangle) and the average transformed to vertex 
+  ratio (ATVR, transformed vertices per unique vertex, 1.0 is optimal) for 
+  a FIFO cache with `cache_size` entries, before and after optimizing. 
 
-  return true;
-} // rx_create_path()
+  ````c++
+  std::vector<VertexPTN> vertices;
+  std::vector<uint32_t> indices;
+  obj.copy(vertices, indices);
 
-/* using * for ext will return all images */
-extern std::vector<std::string> rx_get_files(std::string path, std::string ext) { 
-  std::vector<std::string> result;
-#if !defined(_WIN32)
-  DIR* dir;
-  struct dirent* ent;
-  if((dir = opendir(path.c_str())) != NULL) {
-    while((ent = readdir(dir)) != NULL) {
-      if(ent->d_type == DT_REG) {
-        std::string file_path = path +"/" +ent->d_name;
+  MeshOptimizer opt;
+  opt.optimize(vertices, indices);
+  opt.print();
+  ````
+ */
+class MeshOptimizer {
+ public:
+  MeshOptimizer();
+  template<class T> void optimize(std::vector<T>& vertices, std::vector<uint32_t>& indices);            /* runs all passes (optimizeOverdraw() only when `overdraw` is true) and fills the acmr/atvr members */
+  void optimizeVertexCache(std::vector<uint32_t>& indices, size_t num_vertices);                        /* reorders the triangles for the post transform vertex cache */
+  template<class T> void optimizeOverdraw(std::vector<uint32_t>& indices, std::vector<T>& vertices);    /* reorders the clusters found by the last call to optimizeVertexCache() */
+  template<class T> void optimizeVertexFetch(std::vector<T>& vertices, std::vector<uint32_t>& indices); /* reorders the vertices in the order they're used, removes unused vertices */
+  float getACMR(std::vector<uint32_t>& indices, size_t num_vertices);                                   /* average cache miss ratio: transformed vertices per triangle; between 0.5 and 3.0 */
+  float getATVR(std::vector<uint32_t>& indices, size_t num_vertices);                                   /* average transformed to vertex ratio: transformed vertices per used vertex; 1.0 is optimal */
+  void print();                                                                                         /* prints the ACMR/ATVR of the last call to optimize() */
 
-        if(ext != "*" && ext.size()) {
-          std::string file_ext = rx_get_file_ext(file_path);
-          if(file_ext != ext) {
-            continue;
-          }
-        }
+ private:
+  size_t simulateCache(std::vector<uint32_t>& indices, size_t num_vertices, size_t* num_used);          /* returns the number of cache misses for a FIFO with `cache_size` entries */
 
-        result.push_back(file_path);
-      }
-    }
-    closedir(dir);
-  }
-#else
+ public:
+  int cache_size;                                                               /* size of the simulated FIFO cache, 16 by default */
+  bool overdraw;                                                                /* when true optimize() runs optimizeOverdraw() too, false by default */
+  float overdraw_threshold;                                                     /* factor by which the ACMR of a cluster may grow when splitting clusters for optimizeOverdraw() */
+  float acmr_before;                                                            /* ACMR before optimize() */
+  float acmr_after;                                                             /* ACMR after optimize() */
+  float atvr_before;                                                            /* ATVR before optimize() */
+  float atvr_after;                                                             /* ATVR after optimize() */
 
-  char search_path[MAX_PATH] = { 0 };
-  WIN32_FIND_DATA ffd;
-  DWORD err;
-  HANDLE handle;
+ private:
+  std::vector<uint32_t> clusters;                                               /* first triangle of every cluster, found by optimizeVertexCache() */
+  std::vector<uint32_t> adj_offsets;                                            /* the triangles that use a vertex: adj_tris[adj_offsets[v]] ... adj_tris[adj_offsets[v + 1]] */
+  std::vector<uint32_t> adj_tris;
+  std::vector<int> live;                                                        /* number of triangles per vertex that are not emitted yet */
+  std::vector<int> cache_time;                                                  /* time stamp of when a vertex entered the cache */
+  std::vector<uint32_t> dead_end;                                               /* stack with recently used vertices */
+  std::vector<uint32_t> candidates;
+  std::vector<uint8_t> emitted;
+  std::vector<uint32_t> remap;
+  std::vector<uint32_t> tmp_indices;
+  std::vector<uint32_t> splits;                                                 /* optimizeOverdraw(): first triangle of every split cluster */
+  std::vector<vec3> cluster_centers;                                            /* optimizeOverdraw(): area weighted center per split cluster */
+  std::vector<vec3> cluster_normals;                                            /* optimizeOverdraw(): average normal per split cluster */
+  std::vector<std::pair<float, uint32_t> > cluster_order;                       /* optimizeOverdraw(): sort key and index per split cluster */
+}; // MeshOptimizer
+
+inline MeshOptimizer::MeshOptimizer()
+  :cache_size(16)
+  ,overdraw(false)
+  ,overdraw_threshold(1.05f)
+  ,acmr_before(0.0f)
+  ,acmr_after(0.0f)
+  ,atvr_before(0.0f)
+  ,atvr_after(0.0f)
+{
+}
 
-  if (ext.size()) {
-    sprintf(search_path, "%s\\*", path.c_str());
-  }
-  else {
-    sprintf(search_path, "%s\\*.%s", path.c_str(), ext.c_str());
-  }
+template<class T>
+inline void MeshOptimizer::optimize(std::vector<T>& vertices, std::vector<uint32_t>& indices) {
 
-  handle = FindFirstFile(search_path, &ffd);
-  if (INVALID_HANDLE_VALUE == handle) {
-    err = GetLastError();
-    printf("error: cannot get directory listing, error code: %u\n", err);
-  }
-  else {
-    do {
-      if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-        continue;
-      }
-      std::string file_path = path +"/" +ffd.cFileName;
-      result.push_back(file_path);
-    } while (FindNextFile(handle, &ffd) != 0);
-  }
-  CloseHandle(handle);
+  acmr_before = getACMR(indices, vertices.size());
+  atvr_before = getATVR(indices, vertices.size());
 
-#endif
-  return result;
-} // rx_get_files()
+  optimizeVertexCache(indices, vertices.size());
 
-extern std::string rx_norm_path(std::string path) {
-#if defined(_WIN32)
-  std::string from = "/";
-  std::string to = "\\";
-  size_t start_pos = 0;
-  while((start_pos = path.find(from, start_pos)) != std::string::npos) {
-    path.replace(start_pos, from.length(), to);
-    start_pos += to.length();
+  if (overdraw) {
+    optimizeOverdraw(indices, vertices);
   }
-  return path;
-#else
-  return path;
-#endif
-} // rx_norm_path()
 
+  optimizeVertexFetch(vertices, indices);
 
-extern int rx_to_int(const std::string& v) {
-  int r = 0;
-  std::stringstream ss(v);
-  ss >> r;
-  return r;
+  acmr_after = getACMR(indices, vertices.size());
+  atvr_after = getATVR(indices, vertices.size());
 }
 
-extern float rx_to_float(const std::string& v) {
-  float r = 0.0f;
-  std::stringstream ss(v);
-  ss >> r;
-  return r;
-}
+inline size_t MeshOptimizer::simulateCache(std::vector<uint32_t>& indices, size_t num_vertices, size_t* num_used) {
 
-extern std::string rx_int_to_string(const int& v) {
-  std::stringstream ss;
-  ss << v;
-  return ss.str();
+  size_t misses = 0;
+  size_t used = 0;
+  int time = cache_size + 1;
+
+  cache_time.assign(num_vertices, 0);
+
+  for (size_t i = 0; i < indices.size(); ++i) {
+    uint32_t v = indices[i];
+    if (0 == cache_time[v]) {
+      used++;
+    }
+    if (time - cache_time[v] > cache_size) {
+      cache_time[v] = time++;
+      misses++;
+    }
+  }
+
+  if (num_used) {
+    *num_used = used;
+  }
+
+  return misses;
 }
 
-extern std::string rx_float_to_string(const float& v) {
-  std::stringstream ss;
-  ss << v;
-  return ss.str();
+inline float MeshOptimizer::getACMR(std::vector<uint32_t>& indices, size_t num_vertices) {
+  if (indices.size() < 3) {
+    return 0.0f;
+  }
+  return float(simulateCache(indices, num_vertices, NULL)) / float(indices.size() / 3);
 }
 
-extern std::vector<std::string> rx_split(std::string str, char delim) {
-  std::string line;
-  std::stringstream ss(str);
-  std::vector<std::string> result;
-  while(std::getline(ss, line, delim)) {
-    result.push_back(line);
+inline float MeshOptimizer::getATVR(std::vector<uint32_t>& indices, size_t num_vertices) {
+  size_t used = 0;
+  size_t misses = simulateCache(indices, num_vertices, &used);
+  if (0 == used) {
+    return 0.0f;
   }
-  return result;
+  return float(misses) / float(used);
 }
 
-extern std::string rx_to_lower(std::string str) {
-  std::string result;
-  result.resize(str.size());
-  std::transform(str.begin(), str.end(), result.begin(), ::tolower);
-  return result;
+inline void MeshOptimizer::print() {
+  printf("mesh_optimizer.cache_size: %d\n", cache_size);
+  printf("mesh_optimizer.acmr_before: %f\n", acmr_before);
+  printf("mesh_optimizer.acmr_after: %f\n", acmr_after);
+  printf("mesh_optimizer.atvr_before: %f\n", atvr_before);
+  printf("mesh_optimizer.atvr_after: %f\n", atvr_after);
+  printf("mesh_optimizer.clusters: %d\n", (int)clusters.size());
 }
 
-extern uint64_t rx_hrtime() {
-#if defined(__APPLE__) 
-  mach_timebase_info_data_t info;
-  if(mach_timebase_info(&info) != KERN_SUCCESS) {
-    abort();
+inline void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t num_vertices) {
+
+  size_t num_tris = indices.size() / 3;
+  
+  clusters.clear();
+
+  if (0 == num_tris || 0 == num_vertices) {
+    return;
   }
-  return mach_absolute_time() * info.numer / info.denom;
 
-#elif defined(__linux)
-  static clock_t fast_clock_id = -1;
-  struct timespec t;
-  clock_t clock_id;
+  /* Triangle adjacency per vertex. */
+  adj_offsets.assign(num_vertices + 1, 0);
+  for (size_t i = 0; i < num_tris * 3; ++i) {
+    adj_offsets[indices[i] + 1]++;
+  }
+  for (size_t i = 0; i < num_vertices; ++i) {
+    adj_offsets[i + 1] += adj_offsets[i];
+  }
 
-  if(fast_clock_id == -1) {
-    if(clock_getres(CLOCK_MONOTONIC_COARSE, &t) == 0 && t.tv_nsec <= 1 * 1000 * 1000LLU) {
-      fast_clock_id = CLOCK_MONOTONIC_COARSE;
-    }
-    else {
-      fast_clock_id = CLOCK_MONOTONIC;
-    }
+  adj_tris.resize(num_tris * 3);
+  live.assign(num_vertices, 0);
+  for (size_t i = 0; i < num_tris * 3; ++i) {
+    uint32_t v = indices[i];
+    adj_tris[adj_offsets[v] + live[v]] = i / 3;
+    live[v]++;
   }
 
-  clock_id =  CLOCK_MONOTONIC;
-  if(clock_gettime(clock_id, &t)) {
-    return 0; 
+  cache_time.assign(num_vertices, 0);
+  emitted.assign(num_tris, 0);
+  dead_end.clear();
+  tmp_indices.clear();
+  tmp_indices.reserve(num_tris * 3);
+
+  int time = cache_size + 1;
+  size_t cursor = 0;
+  int f = 0;
+
+  /* Find the first used vertex. */
+  while (cursor < num_vertices && 0 == live[cursor]) {
+    cursor++;
   }
+  f = cursor;
+  clusters.push_back(0);
 
-  return t.tv_sec * (uint64_t)1e9 +t.tv_nsec;
+  while (f >= 0) {
 
-#elif defined(_WIN32)
-  LARGE_INTEGER timer_freq;
-  LARGE_INTEGER timer_time;
-  QueryPerformanceCounter(&timer_time);
-  QueryPerformanceFrequency(&timer_freq);
-  static double freq = (double)timer_freq.QuadPart/(double)1000000000;
-  return (uint64_t)((double)timer_time.QuadPart / freq);
-#endif
-};
+    candidates.clear();
 
-extern float rx_millis() {
-  static uint64_t start = rx_hrtime();
-  int64_t d = (rx_hrtime() - start);
-  return d / 1000000000.0;
-}
+    /* Emit all the triangles of the fanning vertex. */
+    for (uint32_t j = adj_offsets[f]; j < adj_offsets[f + 1]; ++j) {
 
-extern std::string rx_read_file(std::string filepath) {
-  std::ifstream ifs(filepath.c_str(), std::ios::in);
-  if(!ifs.is_open()) {
-    return "";
-  }
-  std::string str((std::istreambuf_iterator<char>(ifs)) , std::istreambuf_iterator<char>());
-  return str;
-}
+      uint32_t t = adj_tris[j];
+      if (emitted[t]) {
+        continue;
+      }
 
-extern std::string rx_strftime(const std::string fmt) {
-  time_t t;
-  struct tm* info;
-  char buf[4096]; // must be enough..
-  time(&t);
-  info = localtime(&t);
-  strftime(buf, 4096, fmt.c_str(), info);
-  std::string result(buf);
-  return result;
-}
+      for (int k = 0; k < 3; ++k) {
+        uint32_t v = indices[t * 3 + k];
+        tmp_indices.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        live[v]--;
+        if (time - cache_time[v] > cache_size) {
+          cache_time[v] = time++;
+        }
+      }
 
-extern std::string rx_get_time_string() {
-  double millis = double(rx_hrtime()) / 1000000000.0;
-  uint64_t intpart = (millis - (int)millis) * 1000;
-  std::string millis_str;
-  std::stringstream ss; 
-  ss << intpart;
-  ss >> millis_str;
-  return rx_strftime("%Y.%m.%d_%H.%M.%S_") +millis_str;
-}
+      emitted[t] = 1;
+    }
 
-extern std::string rx_get_date_string() {
-  return rx_strftime("%Y.%m.%d");
-}
+    /* Select the candidate which is still in the cache after emitting all its triangles, prefer the oldest one. */
+    int best = -1;
+    int best_priority = -1;
+    for (size_t j = 0; j < candidates.size(); ++j) {
+      uint32_t v = candidates[j];
+      if (live[v] <= 0) {
+        continue;
+      }
+      int priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+        priority = time - cache_time[v];
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        best = v;
+      }
+    }
 
-extern int rx_get_year() {
-  return rx_to_int(rx_strftime("%Y"));
-}
+    if (best >= 0) {
+      f = best;
+      continue;
+    }
 
-extern int rx_get_month() {
-  return rx_to_int(rx_strftime("%m"));
-}
+    /* Dead end: use a recently used vertex or the next vertex in input order; this starts a new cluster. */
+    f = -1;
+    while (dead_end.size()) {
+      uint32_t v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v] > 0) {
+        f = v;
+        break;
+      }
+    }
 
-extern int rx_get_day() {
-  return rx_to_int(rx_strftime("%d"));
-}
+    if (f < 0) {
+      while (cursor < num_vertices && live[cursor] <= 0) {
+        cursor++;
+      }
+      if (cursor < num_vertices) {
+        f = cursor;
+      }
+    }
 
-extern int rx_get_hour() {
-  return rx_to_int(rx_strftime("%H"));
-}
+    if (f >= 0) {
+      clusters.push_back(tmp_indices.size() / 3);
+    }
+  }
 
-extern int rx_get_minute() {
-  return rx_to_int(rx_strftime("%M"));
+  indices.swap(tmp_indices);
 }
 
-#undef get16bits
-#if (defined(__GNUC__) && defined(__i386__)) || defined(__WATCOMC__) \
-|| defined(_MSC_VER) || defined (__BORLANDC__) || defined (__TURBOC__)
-#define get16bits(d) (*((const uint16_t *) (d)))
-#endif
-
-#if !defined (get16bits)
-#define get16bits(d) ((((uint32_t)(((const uint8_t *)(d))[1])) << 8)\
-+(uint32_t)(((const uint8_t *)(d))[0]) )
-#endif
+template<class T>
+inline void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, std::vector<T>& vertices) {
 
-extern uint32_t rx_string_id(const std::string& v) {
-  const char* data = v.c_str();
-  int len = v.size();
-  uint32_t hash = len, tmp;
-  int rem;
-  
-  if (len <= 0 || data == NULL) {
-    return 0;
-  }
-  
-  rem = len & 3;
-  len >>= 2;
-  
-  /* Main loop */
-  for (;len > 0; len--) {
-    hash  += get16bits (data);
-    tmp    = (get16bits (data+2) << 11) ^ hash;
-    hash   = (hash << 16) ^ tmp;
-    data  += 2*sizeof (uint16_t);
-    hash  += hash >> 11;
-  }
-  
-  /* Handle end cases */
-  switch (rem) {
-    case 3: hash += get16bits (data);
-      hash ^= hash << 16;
-      hash ^= data[sizeof (uint16_t)] << 18;
-      hash += hash >> 11;
-      break;
-    case 2: hash += get16bits (data);
-      hash ^= hash << 11;
-      hash += hash >> 17;
-      break;
-    case 1: hash += *data;
-      hash ^= hash << 10;
-      hash += hash >> 1;
+  size_t num_tris = indices.size() / 3;
+  if (0 == num_tris || 0 == clusters.size()) {
+    return;
   }
-  
-  /* Force "avalanching" of final 127 bits */
-  hash ^= hash << 3;
-  hash += hash >> 5;
-  hash ^= hash << 4;
-  hash += hash >> 17;
-  hash ^= hash << 25;
-  hash += hash >> 6;
-  
-  return hash;
-}
 
-#endif // defined(ROXLU_IMPLEMENTATION)
+  /* Split the clusters where the ACMR of the first part is close to the ACMR of the whole cluster. */
+  splits.clear();
+  cache_time.assign(vertices.size(), 0);
+  int time = cache_size + 1;
 
-// ====================================================================================
-//                              R O X L U _ U S E _ M A T H
-// ====================================================================================
-#if defined(ROXLU_USE_CURL) && defined(ROXLU_IMPLEMENTATION) 
+  for (size_t i = 0; i < clusters.size(); ++i) {
 
-size_t rx_curl_write_string_data(void* ptr, size_t size, size_t nmemb, void* str) {
-  std::string* s = static_cast<std::string*>(str);
-  std::copy((char*)ptr, (char*)ptr + (size * nmemb), std::back_inserter(*s));
-  return size * nmemb;
-}
+    size_t start = clusters[i];
+    size_t end = (i + 1 < clusters.size()) ? clusters[i + 1] : num_tris;
+    size_t misses = 0;
 
-size_t rx_curl_write_file_data(void* ptr, size_t size, size_t nmemb, void* fpptr) {
-  FILE* fp = static_cast<FILE*>(fpptr);
-  size_t written = fwrite(ptr, size, nmemb, fp);
-  return written;
-}
+    time += cache_size + 1;
+    for (size_t t = start * 3; t < end * 3; ++t) {
+      uint32_t v = indices[t];
+      if (time - cache_time[v] > cache_size) {
+        cache_time[v] = time++;
+        misses++;
+      }
+    }
 
-bool rx_fetch_url(std::string url, std::string& result) {
-  
-  CURL* curl = NULL;
-  CURLcode res;
+    float threshold = overdraw_threshold * float(misses) / float(end - start);
+    size_t last = start;
+    misses = 0;
+    time += cache_size + 1;
+    splits.push_back(start);
+
+    for (size_t t = start; t < end; ++t) {
+      for (int k = 0; k < 3; ++k) {
+        uint32_t v = indices[t * 3 + k];
+        if (time - cache_time[v] > cache_size) {
+          cache_time[v] = time++;
+          misses++;
+        }
+      }
+      if (t + 1 < end && float(misses) <= threshold * float(t + 1 - last)) {
+        splits.push_back(t + 1);
+        last = t + 1;
+        misses = 0;
+        time += cache_size + 1;
+      }
+    }
+  }
 
-  curl = curl_easy_init();
-  if(!curl) {
-    printf("Error: cannot intialize curl.\n");
-    return false;
+  /* Sort the clusters on how much they face away from the center of the mesh. */
+  vec3 center(0.0f, 0.0f, 0.0f);
+  float total_area = 0.0f;
+  cluster_centers.resize(splits.size());
+  cluster_normals.resize(splits.size());
+
+  for (size_t i = 0; i < splits.size(); ++i) {
+
+    size_t start = splits[i];
+    size_t end = (i + 1 < splits.size()) ? splits[i + 1] : num_tris;
+    vec3 c(0.0f, 0.0f, 0.0f);
+    vec3 n(0.0f, 0.0f, 0.0f);
+    float area = 0.0f;
+
+    for (size_t t = start; t < end; ++t) {
+      const vec3& a = vertices[indices[t * 3 + 0]].pos;
+      const vec3& b = vertices[indices[t * 3 + 1]].pos;
+      const vec3& d = vertices[indices[t * 3 + 2]].pos;
+      vec3 cr = cross(b - a, d - a);
+      float w = length(cr) * 0.5f;
+      c += (a + b + d) * (w / 3.0f);
+      n += cr;
+      area += w;
+    }
+
+    center += c;
+    total_area += area;
+    cluster_centers[i] = (area > 0.0f) ? c / area : vertices[indices[start * 3]].pos;
+    cluster_normals[i] = (dot(n, n) > 0.0f) ? normalized(n) : n;
   }
 
-  res = curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  RX_CHECK_CURLCODE(res, "Cannot set url");
+  if (total_area > 0.0f) {
+    center /= total_area;
+  }
 
-  res = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-  RX_CHECK_CURLCODE(res, "Cannot set follow location");
+  cluster_order.resize(splits.size());
+  for (size_t i = 0; i < splits.size(); ++i) {
+    cluster_order[i].first = -dot(cluster_centers[i] - center, cluster_normals[i]);
+    cluster_order[i].second = i;
+  }
+  std::stable_sort(cluster_order.begin(), cluster_order.end());
 
-  res = curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result);
-  RX_CHECK_CURLCODE(res, "Cannot set write data");
-  
-  res = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, rx_curl_write_string_data);
-  RX_CHECK_CURLCODE(res, "Cannot set write function");
+  tmp_indices.clear();
+  tmp_indices.reserve(indices.size());
+  clusters.clear();
 
-  res = curl_easy_perform(curl);
-  RX_CHECK_CURLCODE(res, "Cannot easy perform");
+  for (size_t i = 0; i < cluster_order.size(); ++i) {
+    size_t dx = cluster_order[i].second;
+    size_t start = splits[dx];
+    size_t end = (dx + 1 < splits.size()) ? splits[dx + 1] : num_tris;
+    clusters.push_back(tmp_indices.size() / 3);
+    tmp_indices.insert(tmp_indices.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+  }
 
-  curl_easy_cleanup(curl);
-  curl = NULL;
-  
-  return true;
+  indices.swap(tmp_indices);
 }
 
-bool rx_download_file(std::string url, std::string filepath) {
+template<class T>
+inline void MeshOptimizer::optimizeVertexFetch(std::vector<T>& vertices, std::vector<uint32_t>& indices) {
 
-  FILE* fp = NULL;
-  CURL* curl = NULL;
-  CURLcode res;
+  const uint32_t unused = 0xFFFFFFFF;
+  uint32_t num_used = 0;
 
-  fp = fopen(filepath.c_str(), "wb");
-  if(!fp) {
-    printf("Error: cannot open file: %s\n", filepath.c_str());
-    return false;
+  remap.assign(vertices.size(), unused);
+
+  for (size_t i = 0; i < indices.size(); ++i) {
+    uint32_t v = indices[i];
+    if (remap[v] == unused) {
+      remap[v] = num_used++;
+    }
+    indices[i] = remap[v];
   }
-  
-  curl = curl_easy_init();
-  if(!curl) {
-    printf("Error: cannot initialize cur.\n");
-    return false;
+
+  /* The unused vertices go to the end, so `remap` is a permutation that we apply in place, one cycle at a time. */
+  uint32_t num_referenced = num_used;
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    if (remap[i] == unused) {
+      remap[i] = num_used++;
+    }
   }
 
-#if !defined(NDEBUG)  
-  res = curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
-  RX_CHECK_CURLCODE(res, "Cannot set verbose");
-#endif
+  emitted.assign(vertices.size(), 0);
 
-  res = curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-  RX_CHECK_CURLCODE(res, "Cannot disable SSL_VERIFYPEER");
+  for (size_t i = 0; i < vertices.size(); ++i) {
 
-  res = curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-  RX_CHECK_CURLCODE(res, "Cannot disable SSL_VERIFYPEER");
+    if (emitted[i]) {
+      continue;
+    }
 
-  res = curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  RX_CHECK_CURLCODE(res, "Cannot set url");
+    T carry = vertices[i];
+    size_t j = i;
+    do {
+      size_t k = remap[j];
+      std::swap(carry, vertices[k]);
+      emitted[k] = 1;
+      j = k;
+    } while (j != i);
+  }
 
-  res = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-  RX_CHECK_CURLCODE(res, "Cannot set follow location");
+  vertices.resize(num_referenced);
+}
 
-  res = curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-  RX_CHECK_CURLCODE(res, "Cannot set write data");
-  
-  res = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, rx_curl_write_file_data);
-  RX_CHECK_CURLCODE(res, "Cannot set write function");
+/*
+  MeshSimplifier
+  --------------
+
+  Reduces the number of triangles of an indexed mesh using the quadric 
+  error metric from "Surface Simplification Using Quadric Error Metrics", 
+  Garland, Heckbert, 1997. Vertices are collapsed into one of their 
+  neighbours (half edge collapse) so the result uses the same vertex array;
+  only the indices change. That means that one vertex buffer can be shared
+  by all the levels of detail.
+
+  Vertices that share their position (UV and normal seams, e.g. after
+  OBJ::createIndices()) are welded: they share one quadric and move
+  together. A seam vertex may only collapse along the seam so every side 
+  keeps its own attributes. When every triangle has its own vertices (flat 
+  shading) no vertex can do that; set `weld_seams` to move those vertices 
+  anyway, they get the attributes of the target. Vertices on an open border
+  and vertices on non-manifold edges never move.
+
+  The error is the distance to the original surface relative to the size 
+  of the mesh; 0.01 means 1% of the biggest side of the bounding box.
+  Collapses are done in passes: every pass sorts the candidates on error 
+  and collapses as many vertices as possible that weren't touched yet.
 
-  res = curl_easy_perform(curl);
-  RX_CHECK_CURLCODE(res, "Cannot easy perform");
+  ````c++
+  MeshSimplifier simp;
+  std::vector<uint32_t> lod;
+  float err = simp.simplify(vertices, indices, lod, indices.size() / 6, 0.01f);  // half the triangles
+  simp.print();
+  ````
+ */
 
-  curl_easy_cleanup(curl);
-  curl = NULL;
+struct MeshLOD {
+  std::vector<uint32_t> indices;                                                /* triangle indices into the vertices that were simplified */
+  float error;                                                                  /* relative error of this level */
+};
 
-  fclose(fp);
-  fp = NULL;
+class MeshSimplifier {
+ public:
+  struct QUADRIC { double a00, a01, a02, a11, a12, a22, b0, b1, b2, c, w; };    /* symmetric 3x3 matrix, vector, constant and the summed area */
 
-  return true;
-}
+  MeshSimplifier();
+  template<class T> float simplify(std::vector<T>& vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& result, size_t targetTriangles, float targetError); /* returns the reached error */
+  template<class T> bool createLODs(std::vector<T>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLOD>& lods, int numLods, float ratio = 0.5f, float maxError = 0.05f); /* lods[0] is a copy of indices, every next level has about `ratio` times the triangles of the previous one */
+  float simplify(std::vector<vec3>& positions, std::vector<uint32_t>& indices, std::vector<uint32_t>& result, size_t targetTriangles, float targetError);
+  void print();                                                                 /* prints the timing of the last calls */
 
-#endif
+ private:
+  void weld();                                                                  /* finds the vertices with the same position */
+  void createQuadrics(std::vector<uint32_t>& tris);                             /* creates the quadric for each position from the given triangles */
+  void createAdjacency(std::vector<uint32_t>& tris);                            /* triangles per position */
+  bool canCollapse(std::vector<uint32_t>& tris, uint32_t v, uint32_t target);   /* checks the link condition, the seams and that no triangle flips; fills `remap` */
+  double getError(const QUADRIC& q, const vec3& p);
+  void addQuadric(QUADRIC& a, const QUADRIC& b);
 
-// ====================================================================================
-//                              R O X L U _ U S E _ M A T H
-// ====================================================================================
-#if defined(ROXLU_USE_MATH) && defined(ROXLU_IMPLEMENTATION) 
+ public:
+  size_t num_input_triangles;                                                   /* sum of the input triangles of the simplify() calls since the last print() */
+  size_t num_output_triangles;                                                  /* sum of the output triangles of the simplify() calls since the last print() */
+  uint64_t time_ns;                                                             /* time spent in simplify() since the last print() */
+  bool weld_seams;                                                              /* when true, vertices at the same position may also collapse across a seam (e.g. flat shaded meshes); default false */
 
-extern float rx_random(float max) {
-  return max * rand() / (RAND_MAX + 1.0f);
+ private:
+  std::vector<vec3> positions;                                                  /* positions of the vertices that we simplify */
+  std::vector<uint32_t> canonical;                                              /* the first vertex with the same position */
+  std::vector<uint8_t> locked;                                                  /* 1 when the vertex is on a border or non-manifold edge */
+  std::vector<QUADRIC> quadrics;                                                /* per canonical vertex */
+  std::vector<uint32_t> adj_offsets;                                            /* triangles per canonical vertex: adj_tris[adj_offsets[v]] ... adj_tris[adj_offsets[v + 1]] */
+  std::vector<uint32_t> adj_tris;
+  std::vector<uint8_t> touched;                                                 /* 1 when a vertex changed in the current pass */
+  std::vector<uint8_t> removed;                                                 /* 1 when a triangle collapsed */
+  std::vector<uint32_t> link;                                                   /* scratch for canCollapse(): the neighbours of the vertex we collapse */
+  std::vector<uint32_t> opposite;                                               /* scratch for canCollapse(): the neighbours opposite the collapsed edge */
+  std::vector<std::pair<uint32_t, uint32_t> > remap;                            /* set by canCollapse(): the vertex each vertex at the position of v moves to */
+  std::vector<std::pair<double, uint64_t> > candidates;                         /* error and (vertex, target) */
+  float extent;                                                                 /* biggest side of the bounding box, errors are relative to this */
+}; // MeshSimplifier
+
+inline MeshSimplifier::MeshSimplifier()
+  :num_input_triangles(0)
+  ,num_output_triangles(0)
+  ,time_ns(0)
+  ,weld_seams(false)
+  ,extent(1.0f)
+{
 }
 
-extern float rx_random(float x, float y) {
-  float high = 0;
-  float low = 0;
-  float result = 0;
-        
-  high = std::max<float>(x,y);
-  low = std::min<float>(x,y);
-  result = low + ((high-low) * rand()/(RAND_MAX + 1.0));
-  return result;
+template<class T>
+inline float MeshSimplifier::simplify(std::vector<T>& vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& result, size_t targetTriangles, float targetError) {
+  std::vector<vec3> pos(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    pos[i] = vertices[i].pos;
+  }
+  return simplify(pos, indices, result, targetTriangles, targetError);
 }
 
-extern bool rx_is_power_of_two(int n) {
-  if (0 == n) {
+template<class T>
+inline bool MeshSimplifier::createLODs(std::vector<T>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLOD>& lods, int numLods, float ratio, float maxError) {
+
+  if (numLods < 1 || ratio <= 0.0f || ratio >= 1.0f) {
+    printf("Error: invalid number of lods or ratio: %d, %f\n", numLods, ratio);
     return false;
   }
-  return (n & (n - 1)) == 0;
-}
 
-extern float rx_map(float val, float inmin, float inmax, float outmin, float outmax, bool clamp) {
+  std::vector<vec3> pos(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    pos[i] = vertices[i].pos;
+  }
 
-  float out = (val - inmin) / (inmax - inmin) * (outmax - outmin) + outmin;
-  
-  if (true == clamp) {
-    if (outmin < outmax) {
-      if (out > outmax) {
-        out = outmax;
-      }
-      else if (out < outmin) {
-        out = outmin;
-      }
-    }
-    else {
-      if (out < outmax) {
-        out = outmax;
-      }
-      else if (out > outmin) {
-        out = outmin;
-      }
+  lods.clear();
+  lods.resize(1);
+  lods[0].indices = indices;
+  lods[0].error = 0.0f;
+
+  /* Every level is simplified from the previous one; we stop when we can't get below maxError anymore. */
+  for (int i = 1; i < numLods; ++i) {
+    MeshLOD lod;
+    size_t target = size_t((lods.back().indices.size() / 3) * ratio);
+    float err = simplify(pos, lods.back().indices, lod.indices, target, maxError);
+    if (lod.indices.size() >= lods.back().indices.size()) {
+      break;
     }
+    lod.error = LOWEST(HEIGHEST(err, lods.back().error), maxError);
+    lods.push_back(lod);
   }
 
-  return out;
+  return true;
 }
 
-// all in range 0 - 1 
-extern void rx_rgb_to_hsv(float r, float g, float b, float& h, float& s, float& v) {
-  float K = 0.f;
+inline void MeshSimplifier::print() {
+  double ms = double(time_ns) / 1e6;
+  double mtris = double(num_input_triangles) / 1e6;
+  printf("mesh_simplifier.input_triangles: %d\n", (int)num_input_triangles);
+  printf("mesh_simplifier.output_triangles: %d\n", (int)num_output_triangles);
+  printf("mesh_simplifier.time: %.2f ms\n", ms);
+  printf("mesh_simplifier.time_per_million_triangles: %.2f ms\n", (mtris > 0.0) ? ms / mtris : 0.0);
+  num_input_triangles = 0;
+  num_output_triangles = 0;
+  time_ns = 0;
+}
 
-  if(g < b) {
-    std::swap(g, b);
-    K = -1.f;
+inline double MeshSimplifier::getError(const QUADRIC& q, const vec3& p) {
+  double x = p.x, y = p.y, z = p.z;
+  double e = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z
+    + q.a11 * y * y + 2.0 * q.a12 * y * z + q.a22 * z * z
+    + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+  return (q.w > 0.0) ? fabs(e) / q.w : 0.0;
+}
+
+inline float MeshSimplifier::simplify(std::vector<vec3>& pos, std::vector<uint32_t>& indices, std::vector<uint32_t>& result, size_t targetTriangles, float targetError) {
+
+  uint64_t start_time = rx_hrtime();
+  size_t num_tris = indices.size() / 3;
+  
+  result.assign(indices.begin(), indices.begin() + num_tris * 3);
+  num_input_triangles += num_tris;
+
+  if (num_tris <= targetTriangles || 0 == pos.size()) {
+    num_output_triangles += num_tris;
+    time_ns += rx_hrtime() - start_time;
+    return 0.0f;
   }
 
-  if(r < g) {
-    std::swap(r, g);
-    K = -2.f / 6.f - K;
+  if (&pos != &positions) {
+    positions = pos;
   }
 
-  float chroma = r - std::min<float>(g, b);
-  h = fabs(K + (g - b) / (6.f * chroma + 1e-20f));
-  s = chroma / (r + 1e-20f);
-  v = r;
-}
+  weld();
 
-extern void rx_rgb_to_hsv(vec3 rgb, vec3& hsv) {
-  rx_rgb_to_hsv(rgb.x, rgb.y, rgb.z, hsv.x, hsv.y, hsv.z);
-}
+  /* Lock the vertices on borders and non-manifold edges: every edge v -> w must be used exactly once by a triangle and once as w -> v. */
+  createAdjacency(result);
 
-extern void rx_rgb_to_hsv(vec3 rgb, float* hsv) {
-  rx_rgb_to_hsv(rgb.x, rgb.y, rgb.z, hsv[0], hsv[1], hsv[2]);
-}
+  for (size_t v = 0; v < positions.size(); ++v) {
 
-extern void rx_rgb_to_hsv(float* rgb, float* hsv) {
-  rx_rgb_to_hsv(rgb[0], rgb[1], rgb[2], hsv[0], hsv[1], hsv[2]);
-}
+    if (locked[v] || canonical[v] != v) {
+      continue;
+    }
 
-extern void rx_hsv_to_rgb(float h, float s, float v, float& r, float& g, float& b) {
-  float tmp_r = CLAMP((-1.0f + fabs(6.0f * h - 3.0f)), 0,1);
-  float tmp_g = CLAMP(( 2.0f - fabs(6.0f * h - 2.0f)), 0,1);      
-  float tmp_b = CLAMP(( 2.0f - fabs(6.0f * h - 4.0f)), 0,1);  
-  float p = 1.0f - s;  
-  r = v * (p + tmp_r * s);  
-  g = v * (p + tmp_g * s);    
-  b = v * (p + tmp_b * s);        
-}
+    link.clear();
+    opposite.clear();
 
-extern void rx_hsv_to_rgb(vec3 hsv, vec3& rgb) {
-  rx_hsv_to_rgb(hsv.x, hsv.y, hsv.z, rgb.x, rgb.y, rgb.z);
-}
+    for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+      uint32_t* tri = &result[adj_tris[j] * 3];
+      for (int k = 0; k < 3; ++k) {
+        if (canonical[tri[k]] == v) {
+          link.push_back(canonical[tri[(k + 1) % 3]]);
+          opposite.push_back(canonical[tri[(k + 2) % 3]]);
+        }
+      }
+    }
 
-extern void rx_hsv_to_rgb(vec3 hsv, float* rgb) {
-  rx_hsv_to_rgb(hsv.x, hsv.y, hsv.z, rgb[0], rgb[1], rgb[2]);
-}
+    std::sort(link.begin(), link.end());
+    std::sort(opposite.begin(), opposite.end());
 
-extern void rx_hsv_to_rgb(float* hsv, float* rgb) {
-  rx_hsv_to_rgb(hsv[0], hsv[1], hsv[2], rgb[0], rgb[1], rgb[2]);
-}
+    if (link != opposite || std::adjacent_find(link.begin(), link.end()) != link.end()) {
+      locked[v] = 1;
+    }
+  }
 
+  createQuadrics(result);
+  removed.assign(num_tris, 0);
 
-#endif // defined(ROXLU_USE_MATH) && defined(ROXLU_IMPLEMENTATON) 
+  double max_error = double(targetError) * extent;
+  max_error *= max_error;
+  double reached_error = 0.0;
+  size_t live_tris = num_tris;
 
-// ====================================================================================
-//                              R O X L U _ U S E _ J P G
-// ====================================================================================
+  for (int pass = 0; live_tris > targetTriangles; ++pass) {
 
-#if defined(ROXLU_USE_JPG) && defined(ROXLU_IMPLEMENTATION)
+    if (pass > 0) {
+      createAdjacency(result);
+    }
 
-static void rx_load_jpg_error_handler(j_common_ptr cinfo) {
-  printf("Error occured while loading the jpeg (rx_load_jpg). This error is triggered by libjpeg. \n");
-  struct rx_jpeg_error_mgr* jerr = (struct rx_jpeg_error_mgr*)cinfo->err;
-  longjmp(jerr->setjmp_buffer, 1);
-}
+    /* Find the cheapest collapse for every vertex that may move. */
+    candidates.clear();
+    for (size_t v = 0; v < positions.size(); ++v) {
 
-/*
+      if (locked[v] || canonical[v] != v || adj_offsets[v] == adj_offsets[v + 1]) {
+        continue;
+      }
 
-  @param std::string filepath      - The file to laod
-  @param unsigned char** pix       - A reference to the buffer that will be set to the 
-                                     memory we allocate OR that we will reallocate (if needed).
-                                     We will only reallocate when the *allocated parameter is
-                                     passed. 
-  @param int& width                - Will be set to the width of the image.
-  @param int& height               - Will be set to the height of the image
-  @param int& nchannels            - Will be set to the number of color channels in the image
-  @param int* allocated (NULL)     - Can be NULL, if not it must be set to the number of bytes in *pix.
-                                     When the number of allocated bytes is less then what we need, we will
-                                     reallocate the buffer.   
-  @return int                      - The number of bytes of the image buffer (doesn't have to be the same 
-                                     as the number of bytes that was previously allocated!).
-                                   - on error we return a negative value.
+      double best_error = max_error;
+      uint32_t best_target = 0xFFFFFFFF;
 
- */
-int rx_load_jpg(std::string filepath, unsigned char** pix, int& width, int& height, int& nchannels, int* allocated) {
-  
-  struct rx_jpeg_error_mgr jerr;
-  struct jpeg_decompress_struct cinfo;
-  FILE* fp = NULL;
-  JSAMPARRAY buffer;
-  int stride = 0;
-  int num_bytes = 0;
-  unsigned char* pixels = NULL;
-  unsigned char* tmp = NULL;
-  
-  if( (fp = fopen(filepath.c_str(), "rb")) == NULL ) {
-    printf("Error: cannot load %s (rx_load_jpg)\n", filepath.c_str());
-    return -1;
-  }
+      for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+        uint32_t* tri = &result[adj_tris[j] * 3];
+        for (int k = 0; k < 3; ++k) {
+          if (canonical[tri[k]] == v) {
+            continue;
+          }
+          QUADRIC q = quadrics[v];
+          addQuadric(q, quadrics[canonical[tri[k]]]);
+          double err = getError(q, positions[tri[k]]);
+          if (err <= best_error) {
+            best_error = err;
+            best_target = tri[k];
+          }
+        }
+      }
 
-  memset(&jerr, 0x00, sizeof(jerr));
-  cinfo.err = jpeg_std_error(&jerr.pub);
+      if (best_target != 0xFFFFFFFF) {
+        candidates.push_back(std::pair<double, uint64_t>(best_error, (uint64_t(v) << 32) | best_target));
+      }
+    }
 
-  /* Set the error handler, otherwise libjpg calls exit(). */
-  jerr.pub.error_exit = rx_load_jpg_error_handler;
-  if (setjmp(jerr.setjmp_buffer)) { /* When an error occurs we jump to this part. */
-    if (NULL != fp) {
-      fclose(fp);
-      fp = NULL;
+    if (0 == candidates.size()) {
+      break;
     }
-    
-    jpeg_destroy_decompress(&cinfo);
-    return -1;
-  }
 
-  jpeg_create_decompress(&cinfo);
-  jpeg_stdio_src(&cinfo, fp);
-  jpeg_read_header(&cinfo, TRUE);
-  jpeg_start_decompress(&cinfo);
+    std::sort(candidates.begin(), candidates.end());
+    touched.assign(positions.size(), 0);
 
-  stride = cinfo.output_width * cinfo.output_components;
-  nchannels = cinfo.output_components;
-  width = cinfo.output_width;
-  height = cinfo.output_height;
-  num_bytes = width * height * nchannels;
+    size_t num_collapsed = 0;
+    for (size_t i = 0; i < candidates.size() && live_tris > targetTriangles; ++i) {
 
-  /* Reallocate when a buffer size is given */
-  if (NULL != allocated) {
-    if (0 == *allocated) {
-      /* not allocated yet */
-      pixels = (unsigned char*)malloc(num_bytes);
-      if (pixels) {
-        *allocated = num_bytes;
+      uint32_t v = candidates[i].second >> 32;
+      uint32_t target = candidates[i].second & 0xFFFFFFFF;
+      uint32_t ct = canonical[target];
+
+      if (touched[v] || touched[ct] || false == canCollapse(result, v, target)) {
+        continue;
       }
-      else {
-        printf("Error: cannot allocate a buffer for the jpg. (rx_load_jpg)\n");
+
+      for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+        uint32_t t = adj_tris[j];
+        if (removed[t]) {
+          continue;
+        }
+        uint32_t* tri = &result[t * 3];
+        if (canonical[tri[0]] == ct || canonical[tri[1]] == ct || canonical[tri[2]] == ct) {
+          removed[t] = 1;
+          live_tris--;
+          continue;
+        }
+        for (int k = 0; k < 3; ++k) {
+          if (canonical[tri[k]] != v) {
+            continue;
+          }
+          for (size_t r = 0; r < remap.size(); ++r) {
+            if (remap[r].first == tri[k]) {
+              tri[k] = remap[r].second;
+              break;
+            }
+          }
+        }
       }
+
+      addQuadric(quadrics[ct], quadrics[v]);
+
+      touched[v] = 1;
+      touched[ct] = 1;
+      reached_error = HEIGHEST(reached_error, candidates[i].first);
+      num_collapsed++;
     }
-    else if (num_bytes > *allocated) {
-      /* already allocated, try to reallocate if necessary */
-      tmp = (unsigned char*)realloc(*pix, num_bytes);
-      if (NULL == tmp) {
-        printf("Error: cannot reallocate the pixel buffer for the jpg. (rx_load_jpg)\n");
-        pixels = NULL;
-      }
-      else {
-        pixels = tmp;
-        *allocated = num_bytes;
+
+    /* Remove the collapsed triangles. */
+    size_t dx = 0;
+    for (size_t t = 0; t < removed.size(); ++t) {
+      if (removed[t]) {
+        continue;
       }
+      result[dx * 3 + 0] = result[t * 3 + 0];
+      result[dx * 3 + 1] = result[t * 3 + 1];
+      result[dx * 3 + 2] = result[t * 3 + 2];
+      dx++;
     }
-    else {
-      pixels = *pix;
-    }
-  }
-  else {
-    pixels = (unsigned char*)malloc(num_bytes);
-  }
+    result.resize(dx * 3);
+    removed.assign(dx, 0);
 
-  if(!pixels) {
-    printf("Error: cannot allocate pixel buffer for jpg.(rx_load_jpg) \n");
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
-    fclose(fp);
-    return -1;
+    if (0 == num_collapsed) {
+      break;
+    }
   }
 
-  size_t dest_row = 0;
-  buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr) &cinfo, JPOOL_IMAGE, stride, 1);
-  while(cinfo.output_scanline < cinfo.output_height) {
-    jpeg_read_scanlines(&cinfo, buffer, 1);
-    memcpy(pixels + (dest_row * stride), buffer[0], stride);
-    dest_row++;
-  }
+  num_output_triangles += result.size() / 3;
+  time_ns += rx_hrtime() - start_time;
 
-  jpeg_finish_decompress(&cinfo);
-  jpeg_destroy_decompress(&cinfo);
-  fclose(fp);
-  *pix = pixels;
-  return num_bytes;
+  return float(sqrt(reached_error) / extent);
 }
 
-bool rx_save_jpg(std::string filepath, unsigned char* pix, int width, int height, int nchannels, int quality, bool flip, J_COLOR_SPACE colorSpace, J_DCT_METHOD dctMethod) {
-
-  if(!pix) {
-    printf("Error: cannot save jpg, invalid pixels.\n");
-    return false;
+/* Orders vertex indices on position, then index; at namespace scope because C++98 can't sort with local types. */
+struct MeshSimplifierPositionSort {
+  const vec3* p;
+  bool operator()(uint32_t a, uint32_t b) const {
+    if (p[a].x != p[b].x) return p[a].x < p[b].x;
+    if (p[a].y != p[b].y) return p[a].y < p[b].y;
+    if (p[a].z != p[b].z) return p[a].z < p[b].z;
+    return a < b;
   }
+};
 
-  if(width <= 0 || height <= 0) {
-    printf("Error: cannot save jpg, invalid size: %d x %d\n", width, height);
-    return false;
-  }
+/* Sorts the vertices on position so vertices at the same position get the same canonical vertex. */
+inline void MeshSimplifier::weld() {
 
-  if(quality < 0) {
-    quality = 0;
-  }
-  else if(quality > 100) {
-    quality = 100;
-  }
+  size_t nverts = positions.size();
+  std::vector<uint32_t> order(nverts);
+  vec3 bmin = positions[0];
+  vec3 bmax = positions[0];
 
-  FILE* fp = fopen(filepath.c_str(), "wb");
-  if(!fp) {
-    printf("Cannot open the file: `%s`", filepath.c_str());
-    fp = NULL;
-    return false;
+  for (size_t i = 0; i < nverts; ++i) {
+    order[i] = i;
+    bmin.set(LOWEST(bmin.x, positions[i].x), LOWEST(bmin.y, positions[i].y), LOWEST(bmin.z, positions[i].z));
+    bmax.set(HEIGHEST(bmax.x, positions[i].x), HEIGHEST(bmax.y, positions[i].y), HEIGHEST(bmax.z, positions[i].z));
   }
 
-  struct jpeg_compress_struct cinfo;
-  struct jpeg_error_mgr jerr;
-  JSAMPROW row_pointer[1];
+  vec3 size = bmax - bmin;
+  extent = HEIGHEST(size.x, HEIGHEST(size.y, size.z));
+  extent = (extent > 0.0f) ? extent : 1.0f;
 
-  cinfo.err = jpeg_std_error(&jerr);
-  jpeg_create_compress(&cinfo);
-  
-  jpeg_stdio_dest(&cinfo, fp);
+  MeshSimplifierPositionSort sorter;
+  sorter.p = &positions[0];
+  std::sort(order.begin(), order.end(), sorter);
 
-  // compression parameters
-  cinfo.image_width = width;
-  cinfo.image_height = height;
-  cinfo.input_components = nchannels;
-  cinfo.in_color_space = colorSpace;
+  canonical.resize(nverts);
+  locked.assign(nverts, 0);
 
-  jpeg_set_defaults(&cinfo); // after setting the default we can set our custom settings
+  for (size_t i = 0; i < nverts; ) {
+    size_t j = i + 1;
+    while (j < nverts && positions[order[j]] == positions[order[i]]) {
+      ++j;
+    }
+    for (size_t k = i; k < j; ++k) {
+      canonical[order[k]] = order[i];
+    }
+    i = j;
+  }
+}
 
-  cinfo.dct_method = dctMethod;
+inline void MeshSimplifier::createQuadrics(std::vector<uint32_t>& tris) {
 
-  jpeg_set_quality(&cinfo, quality, TRUE /* limit to jpeg baseline values */);
+  QUADRIC zero = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  quadrics.assign(positions.size(), zero);
 
-  jpeg_start_compress(&cinfo, TRUE /* write complete data stream */); 
+  for (size_t i = 0; i + 2 < tris.size(); i += 3) {
 
-  int stride = width * nchannels;
+    const vec3& p0 = positions[tris[i + 0]];
+    const vec3& p1 = positions[tris[i + 1]];
+    const vec3& p2 = positions[tris[i + 2]];
+    vec3 n = cross(p1 - p0, p2 - p0);
+    float len = length(n);
+    if (len <= 0.0f) {
+      continue;
+    }
 
-  if(flip) {
-    while(cinfo.next_scanline < cinfo.image_height) {
-      row_pointer[0] = &pix[ (cinfo.image_height - 1 - cinfo.next_scanline) * stride];
-      jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    n /= len;
+    double area = len * 0.5;
+    double a = n.x, b = n.y, c = n.z, d = -dot(n, p0);
+
+    for (int k = 0; k < 3; ++k) {
+      QUADRIC& q = quadrics[canonical[tris[i + k]]];
+      q.a00 += area * a * a; q.a01 += area * a * b; q.a02 += area * a * c;
+      q.a11 += area * b * b; q.a12 += area * b * c; q.a22 += area * c * c;
+      q.b0 += area * a * d; q.b1 += area * b * d; q.b2 += area * c * d;
+      q.c += area * d * d;
+      q.w += area;
     }
   }
-  else {
-    while(cinfo.next_scanline < cinfo.image_height) {
-      row_pointer[0] = &pix[cinfo.next_scanline * stride];
-      jpeg_write_scanlines(&cinfo, row_pointer, 1);
+}
+
+inline void MeshSimplifier::createAdjacency(std::vector<uint32_t>& tris) {
+
+  size_t nverts = positions.size();
+  adj_offsets.assign(nverts + 1, 0);
+
+  for (size_t i = 0; i < tris.size(); ++i) {
+    adj_offsets[canonical[tris[i]] + 1]++;
+  }
+  for (size_t i = 0; i < nverts; ++i) {
+    adj_offsets[i + 1] += adj_offsets[i];
+  }
+
+  adj_tris.resize(tris.size());
+  for (size_t i = 0; i < tris.size(); ++i) {
+    adj_tris[adj_offsets[canonical[tris[i]]]++] = i / 3;
+  }
+  for (size_t i = nverts; i > 0; --i) {
+    adj_offsets[i] = adj_offsets[i - 1];
+  }
+  adj_offsets[0] = 0;
+}
+
+inline void MeshSimplifier::addQuadric(QUADRIC& a, const QUADRIC& b) {
+  a.a00 += b.a00; a.a01 += b.a01; a.a02 += b.a02;
+  a.a11 += b.a11; a.a12 += b.a12; a.a22 += b.a22;
+  a.b0 += b.b0; a.b1 += b.b1; a.b2 += b.b2;
+  a.c += b.c; a.w += b.w;
+}
+
+inline bool MeshSimplifier::canCollapse(std::vector<uint32_t>& tris, uint32_t v, uint32_t target) {
+
+  uint32_t ct = canonical[target];
+  const vec3& p = positions[target];
+
+  /* 
+     Every vertex at the position of v moves to the vertex at the position of 
+     the target with which it shares a collapsed triangle, so each side of a
+     seam keeps its own attributes. A vertex without such a triangle would 
+     get the attributes of the other side: then the collapse crosses the 
+     seam and we don't do it, unless `weld_seams` is set.
+  */
+  remap.clear();
+  for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+    if (removed[adj_tris[j]]) {
+      continue;
+    }
+    uint32_t* tri = &tris[adj_tris[j] * 3];
+    for (int k = 0; k < 3; ++k) {
+      if (canonical[tri[k]] != ct) {
+        continue;
+      }
+      for (int m = 0; m < 3; ++m) {
+        if (canonical[tri[m]] != v) {
+          continue;
+        }
+        size_t r = 0;
+        while (r < remap.size() && remap[r].first != tri[m]) {
+          ++r;
+        }
+        if (r == remap.size()) {
+          remap.push_back(std::pair<uint32_t, uint32_t>(tri[m], tri[k]));
+        }
+        else if (remap[r].second != tri[k]) {
+          return false;
+        }
+      }
     }
   }
 
-  jpeg_finish_compress(&cinfo);
+  for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+    if (removed[adj_tris[j]]) {
+      continue;
+    }
+    uint32_t* tri = &tris[adj_tris[j] * 3];
+    for (int k = 0; k < 3; ++k) {
+      if (canonical[tri[k]] != v) {
+        continue;
+      }
+      size_t r = 0;
+      while (r < remap.size() && remap[r].first != tri[k]) {
+        ++r;
+      }
+      if (r < remap.size()) {
+        continue;
+      }
+      if (false == weld_seams) {
+        return false;
+      }
+      remap.push_back(std::pair<uint32_t, uint32_t>(tri[k], target));
+    }
+  }
 
-  fclose(fp);
-  fp = NULL;
+  /* Link condition: v and the target may only share the neighbours opposite their edge, otherwise we create non-manifold edges. */
+  link.clear();
+  opposite.clear();
+  for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+    if (removed[adj_tris[j]]) {
+      continue;
+    }
+    uint32_t* tri = &tris[adj_tris[j] * 3];
+    bool has_target = canonical[tri[0]] == ct || canonical[tri[1]] == ct || canonical[tri[2]] == ct;
+    for (int k = 0; k < 3; ++k) {
+      uint32_t c = canonical[tri[k]];
+      if (c == v || c == ct) {
+        continue;
+      }
+      if (has_target) {
+        opposite.push_back(c);
+      }
+      else {
+        link.push_back(c);
+      }
+    }
+  }
+
+  std::sort(link.begin(), link.end());
+
+  for (uint32_t j = adj_offsets[ct]; j < adj_offsets[ct + 1]; ++j) {
+    if (removed[adj_tris[j]]) {
+      continue;
+    }
+    uint32_t* tri = &tris[adj_tris[j] * 3];
+    for (int k = 0; k < 3; ++k) {
+      uint32_t c = canonical[tri[k]];
+      if (c == ct || c == v) {
+        continue;
+      }
+      if (std::find(opposite.begin(), opposite.end(), c) != opposite.end()) {
+        continue;
+      }
+      if (std::binary_search(link.begin(), link.end(), c)) {
+        return false;
+      }
+    }
+  }
+
+  /* The triangles that stay may not flip. */
+  for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+
+    if (removed[adj_tris[j]]) {
+      continue;
+    }
+
+    uint32_t* tri = &tris[adj_tris[j] * 3];
+    if (canonical[tri[0]] == ct || canonical[tri[1]] == ct || canonical[tri[2]] == ct) {
+      continue;
+    }
+
+    vec3 p0 = positions[tri[0]];
+    vec3 p1 = positions[tri[1]];
+    vec3 p2 = positions[tri[2]];
+    vec3 before = cross(p1 - p0, p2 - p0);
+    if (canonical[tri[0]] == v) p0 = p;
+    if (canonical[tri[1]] == v) p1 = p;
+    if (canonical[tri[2]] == v) p2 = p;
+    vec3 after = cross(p1 - p0, p2 - p0);
+
+    if (dot(before, after) <= 0.0f) {
+      return false;
+    }
+  }
 
-  jpeg_destroy_compress(&cinfo);
   return true;
 }
 
-#endif // defined(ROXLU_USE_JPG) && defined(ROXLU_IMPLEMENTATON) 
+/*
+  Meshlets
+  --------
 
+  Splits an indexed triangle mesh into small clusters (meshlets) of at most
+  64 vertices and 124 triangles so we can cull parts of a dense mesh instead
+  of the whole object. Meshlets are grown over the triangle adjacency; when 
+  a cluster has no free neighbouring triangles left we continue with the 
+  next free triangle in index order, so run MeshOptimizer first to keep the 
+  clusters compact.
+
+  Every meshlet gets a bounding sphere and a normal cone. cull() tests the
+  spheres against the frustum of a model-view-projection matrix and uses the
+  cones to remove clusters that only contain back facing triangles. The 
+  visible meshlets are written as a compacted draw list: `indices` stores the 
+  triangles meshlet after meshlet, so neighbouring visible meshlets are 
+  merged into one draw. MeshletDraw has the layout of the 
+  DrawElementsIndirectCommand, so the list can be used with 
+  glMultiDrawElementsIndirect() as well.
 
-// ====================================================================================
-//                              R O X L U _ U S E _ P N G
-// ====================================================================================
+  ````c++
+  Meshlets meshlets;
+  meshlets.build(vertices, indices);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshlets.indices.size() * sizeof(uint32_t), &meshlets.indices[0], GL_STATIC_DRAW);
 
-#if defined(ROXLU_USE_PNG) && defined(ROXLU_IMPLEMENTATION)
+  // every frame, eye is the camera position in model space
+  std::vector<MeshletDraw> draws;
+  meshlets.cull(pm * vm * mm, eye, draws);
+  for (size_t i = 0; i < draws.size(); ++i) {
+    glDrawElements(GL_TRIANGLES, draws[i].count, GL_UNSIGNED_INT, (GLvoid*)(draws[i].first_index * sizeof(uint32_t)));
+  }
+  ````
+ */
 
-extern bool rx_save_png(std::string filepath, 
-                        unsigned char* pixels, 
-                        int w, 
-                        int h, 
-                        int channels = 3, 
-                        bool flip = false) 
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+struct Meshlet {
+  uint32_t first_index;                                                         /* first index into Meshlets::indices */
+  uint32_t num_triangles;
+  uint32_t first_vertex;                                                        /* first index into Meshlets::vertices, the unique vertices of this meshlet */
+  uint32_t num_vertices;
+  vec3 center;                                                                  /* bounding sphere */
+  float radius;
+  vec3 cone_apex;                                                               /* normal cone */
+  vec3 cone_axis;
+  float cone_cutoff;                                                            /* back facing when dot(normalized(cone_apex - eye), cone_axis) >= cone_cutoff; 1.0 when the triangles face too many directions */
+};
+
+struct MeshletDraw {                                                            /* same layout as DrawElementsIndirectCommand */
+  GLuint count;                                                                 /* number of indices */
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+
+class Meshlets {
+ public:
+  Meshlets();
+  template<class T> bool build(std::vector<T>& vertices, std::vector<uint32_t>& indices, int maxVertices = MESHLET_MAX_VERTICES, int maxTriangles = MESHLET_MAX_TRIANGLES);
+  bool build(std::vector<vec3>& positions, std::vector<uint32_t>& indices, int maxVertices = MESHLET_MAX_VERTICES, int maxTriangles = MESHLET_MAX_TRIANGLES);
+  size_t cull(const mat4& mvp, const vec3& eye, std::vector<MeshletDraw>& draws);  /* fills draws with the visible meshlets (eye in model space), returns the number of draws */
+  void print();                                                                 /* prints the stats of the last build() and cull() */
+
+ private:
+  void addMeshlet(std::vector<vec3>& positions, Meshlet& m);                    /* calculates the bounds and resets the local indices of the vertices */
+
+ public:
+  std::vector<Meshlet> meshlets;
+  std::vector<uint32_t> indices;                                                /* the triangles, meshlet after meshlet */
+  std::vector<uint32_t> vertices;                                               /* the vertices per meshlet, see Meshlet::first_vertex */
+  size_t num_visible;                                                           /* meshlets that passed the last cull() */
+  size_t num_frustum_culled;                                                    /* meshlets outside the frustum in the last cull() */
+  size_t num_backface_culled;                                                   /* meshlets rejected by their normal cone in the last cull() */
+  uint64_t build_time_ns;
+  uint64_t cull_time_ns;
+
+ private:
+  std::vector<uint32_t> adj_offsets;                                            /* triangles per vertex: adj_tris[adj_offsets[v]] ... adj_tris[adj_offsets[v + 1]] */
+  std::vector<uint32_t> adj_tris;
+  std::vector<uint32_t> live;                                                   /* number of triangles per vertex that are not in a meshlet yet */
+  std::vector<uint8_t> local;                                                   /* index of the vertex in the current meshlet, 0xFF when it's not in it */
+}; // Meshlets
+
+inline Meshlets::Meshlets()
+  :num_visible(0)
+  ,num_frustum_culled(0)
+  ,num_backface_culled(0)
+  ,build_time_ns(0)
+  ,cull_time_ns(0)
 {
-  
-  if(!w || !h) {
-    printf("error: cannot save png because the given width and height are invalid: %d x %d\n", w, h);
-    return false;
+}
+
+template<class T>
+inline bool Meshlets::build(std::vector<T>& verts, std::vector<uint32_t>& indices, int maxVertices, int maxTriangles) {
+  std::vector<vec3> pos(verts.size());
+  for (size_t i = 0; i < verts.size(); ++i) {
+    pos[i] = verts[i].pos;
   }
-  
-  if(!channels || channels > 4) {
-    printf("error: cannot save png because the number of color channels is invalid: %d\n", channels);
+  return build(pos, indices, maxVertices, maxTriangles);
+}
+
+inline bool Meshlets::build(std::vector<vec3>& positions, std::vector<uint32_t>& input, int maxVertices, int maxTriangles) {
+
+  if (maxVertices < 3 || maxVertices > 255 || maxTriangles < 1) {
+    printf("Error: invalid meshlet limits, vertices: %d (3-255), triangles: %d\n", maxVertices, maxTriangles);
     return false;
   }
-  
-  if(!pixels) {
-    printf("error: cannot save png because we got an invalid pixels array: %p\n", pixels);
+
+  if (0 != (input.size() % 3)) {
+    printf("Error: the number of indices is not a multiple of 3: %d\n", (int)input.size());
     return false;
   }
-  
-  if(!filepath.size()) {
-    printf("error: cannot save png because the given filepath is invalid.\n");
-    return false;
+
+  uint64_t start_time = rx_hrtime();
+  size_t num_tris = input.size() / 3;
+  size_t num_verts = positions.size();
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    if (input[i] >= num_verts) {
+      printf("Error: index out of range: %u, vertices: %d\n", input[i], (int)num_verts);
+      return false;
+    }
   }
-  
-  png_structp png_ptr; 
-  png_infop info_ptr;
-  
-  FILE* fp = fopen(filepath.c_str(), "wb");
-  if(!fp) {
-    printf("error: canont save png because we cannot open the filepath: %s\n", filepath.c_str());
-    fp = NULL;
-    return false;
+
+  meshlets.clear();
+  indices.clear();
+  vertices.clear();
+  indices.reserve(input.size());
+
+  /* Triangles per vertex. */
+  adj_offsets.assign(num_verts + 1, 0);
+  for (size_t i = 0; i < input.size(); ++i) {
+    adj_offsets[input[i] + 1]++;
+  }
+  for (size_t i = 0; i < num_verts; ++i) {
+    adj_offsets[i + 1] += adj_offsets[i];
+  }
+  live.assign(adj_offsets.begin(), adj_offsets.end() - 1);
+  adj_tris.resize(input.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    adj_tris[live[input[i]]++] = uint32_t(i / 3);
+  }
+  for (size_t i = 0; i < num_verts; ++i) {
+    live[i] = adj_offsets[i + 1] - adj_offsets[i];
+  }
+
+  local.assign(num_verts, 0xFF);
+  std::vector<uint8_t> used(num_tris, 0);
+  size_t next_free = 0;                                                         /* all triangles before this one are in a meshlet */
+  uint32_t last = 0xFFFFFFFF;                                                   /* the triangle we added last */
+
+  Meshlet m = Meshlet();
+
+  for (size_t n = 0; n < num_tris; ++n) {
+
+    /* 
+       Find the neighbour that adds the least vertices; on a tie the one 
+       whose vertices have the least free triangles left so we don't leave
+       small islands behind. We first look around the last triangle and 
+       then around all the vertices of the meshlet.
+    */
+    uint32_t best = 0xFFFFFFFF;
+    uint32_t best_new = 4;
+    uint32_t best_live = 0xFFFFFFFF;
+
+    for (int pass = 0; pass < 2 && best == 0xFFFFFFFF && last != 0xFFFFFFFF; ++pass) {
+      uint32_t nv = (0 == pass) ? 3 : m.num_vertices;
+      for (uint32_t k = 0; k < nv; ++k) {
+        uint32_t v = (0 == pass) ? input[last * 3 + k] : vertices[m.first_vertex + k];
+        for (uint32_t j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+          uint32_t t = adj_tris[j];
+          if (used[t]) {
+            continue;
+          }
+          const uint32_t* tri = &input[t * 3];
+          uint32_t num_new = (local[tri[0]] == 0xFF) + (local[tri[1]] == 0xFF) + (local[tri[2]] == 0xFF);
+          uint32_t num_live = live[tri[0]] + live[tri[1]] + live[tri[2]];
+          if (num_new < best_new || (num_new == best_new && num_live < best_live)) {
+            best = t;
+            best_new = num_new;
+            best_live = num_live;
+          }
+        }
+      }
+    }
+
+    if (best == 0xFFFFFFFF) {
+      while (used[next_free]) {
+        ++next_free;
+      }
+      best = uint32_t(next_free);
+    }
+
+    const uint32_t* tri = &input[best * 3];
+    uint32_t num_new = (local[tri[0]] == 0xFF) + (local[tri[1]] == 0xFF) + (local[tri[2]] == 0xFF);
+    if (m.num_vertices + num_new > uint32_t(maxVertices) || m.num_triangles + 1 > uint32_t(maxTriangles)) {
+      addMeshlet(positions, m);
+      m = Meshlet();
+      m.first_index = uint32_t(indices.size());
+      m.first_vertex = uint32_t(vertices.size());
+    }
+
+    for (int k = 0; k < 3; ++k) {
+      uint32_t v = tri[k];
+      if (local[v] == 0xFF) {
+        local[v] = uint8_t(m.num_vertices++);
+        vertices.push_back(v);
+      }
+      indices.push_back(v);
+      live[v]--;
+    }
+
+    used[best] = 1;
+    m.num_triangles++;
+    last = best;
   }
-  
-  png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-  if(png_ptr == NULL) {
-    printf("error: cannot save png because we cannot create a png write struct.\n");
-    fclose(fp);
-    fp = NULL;
-    return false;
+
+  if (m.num_triangles > 0) {
+    addMeshlet(positions, m);
   }
-  
-  info_ptr = png_create_info_struct(png_ptr);
-  if(info_ptr == NULL) {
-    printf("error: cannot save png brecause we cannot create a png info struct.\n");
-    fclose(fp);
-    fp = NULL;
-    return false;
+
+  build_time_ns = rx_hrtime() - start_time;
+
+  return true;
+}
+
+inline void Meshlets::addMeshlet(std::vector<vec3>& positions, Meshlet& m) {
+
+  const uint32_t* verts = &vertices[m.first_vertex];
+
+  for (uint32_t i = 0; i < m.num_vertices; ++i) {
+    local[verts[i]] = 0xFF;
   }
-  
-  if(setjmp(png_jmpbuf(png_ptr))) {
-    printf("error: cannot save png because we cannot set the jump pointer.\n");
-    png_destroy_write_struct(&png_ptr, &info_ptr);
-    fclose(fp);
-    fp = NULL;
-    return false;
+
+  /* Bounding sphere (Ritter): start with the two points that are far apart and grow the sphere. */
+  vec3 a = positions[verts[0]];
+  vec3 b = a;
+  float dmax = -1.0f;
+  for (uint32_t i = 0; i < m.num_vertices; ++i) {
+    float d = dot(positions[verts[i]] - positions[verts[0]], positions[verts[i]] - positions[verts[0]]);
+    if (d > dmax) { dmax = d; a = positions[verts[i]]; } 
   }
-  
-  png_uint_32 color_type;
-  switch(channels) {
-    case 1: {
-      color_type = PNG_COLOR_TYPE_GRAY; 
-      break;
+  dmax = -1.0f;
+  for (uint32_t i = 0; i < m.num_vertices; ++i) {
+    float d = dot(positions[verts[i]] - a, positions[verts[i]] - a);
+    if (d > dmax) { dmax = d; b = positions[verts[i]]; } 
+  }
+
+  vec3 center = (a + b) * 0.5f;
+  float radius = length(b - a) * 0.5f;
+  for (uint32_t i = 0; i < m.num_vertices; ++i) {
+    const vec3& p = positions[verts[i]];
+    float d = length(p - center);
+    if (d > radius) {
+      float r = (radius + d) * 0.5f;
+      center = center + (p - center) * ((r - radius) / d);
+      radius = r;
     }
-    case 3: {
-      color_type = PNG_COLOR_TYPE_RGB;
-      break;
+  }
+  m.center = center;
+  m.radius = radius;
+
+  /* Normal cone: the apex is moved back along the axis until it's behind all triangles. */
+  const uint32_t* tris = &indices[m.first_index];
+  vec3 axis(0.0f, 0.0f, 0.0f);
+  for (uint32_t i = 0; i < m.num_triangles; ++i) {
+    vec3 n = cross(positions[tris[i * 3 + 1]] - positions[tris[i * 3]], positions[tris[i * 3 + 2]] - positions[tris[i * 3]]);
+    float len = length(n);
+    if (len > 0.0f) {
+      axis += n / len;
     }
-    case 4: {
-      color_type = PNG_COLOR_TYPE_RGB_ALPHA;
-      break;
+  }
+
+  m.cone_apex = center;
+  m.cone_axis = vec3(0.0f, 0.0f, 0.0f);
+  m.cone_cutoff = 1.0f;
+
+  float min_dp = -1.0f;
+  float axis_len = length(axis);
+  if (axis_len > 0.0f) {
+    axis = axis / axis_len;
+    min_dp = 1.0f;
+    for (uint32_t i = 0; i < m.num_triangles; ++i) {
+      vec3 n = cross(positions[tris[i * 3 + 1]] - positions[tris[i * 3]], positions[tris[i * 3 + 2]] - positions[tris[i * 3]]);
+      float len = length(n);
+      if (len > 0.0f) {
+        min_dp = LOWEST(min_dp, dot(n / len, axis));
+      }
     }
-    default: {
-      printf("error: cannot save png because we cannot detect the color type based on the number of channels.\n");
-      fclose(fp);
-      fp = NULL;
-      return false;
+  }
+
+  /* When the triangles face too many directions the cone would never cull. */
+  if (min_dp > 0.1f) {
+
+    float max_t = 0.0f;
+    for (uint32_t i = 0; i < m.num_triangles; ++i) {
+      const vec3& p0 = positions[tris[i * 3]];
+      vec3 n = cross(positions[tris[i * 3 + 1]] - p0, positions[tris[i * 3 + 2]] - p0);
+      float len = length(n);
+      if (len > 0.0f) {
+        n = n / len;
+        max_t = HEIGHEST(max_t, dot(center - p0, n) / dot(axis, n));
+      }
     }
-  };
-  
-  png_set_IHDR(png_ptr, 
-               info_ptr, 
-               w, 
-               h, 
-               8, 
-               color_type, 
-               PNG_INTERLACE_NONE, 
-               PNG_COMPRESSION_TYPE_DEFAULT, 
-               PNG_FILTER_TYPE_DEFAULT);
-  
-  //  unsigned char* p = (h * w * channels);
-  //  int stride = -(w * channels);
-  png_bytep* row_ptrs = new png_bytep[h];
-  if(flip) {
-    for(size_t j = 0; j < h; ++j) {
-      row_ptrs[h-(j+1)] = pixels + (j * (w * channels));
+
+    m.cone_apex = center - axis * max_t;
+    m.cone_axis = axis;
+    m.cone_cutoff = sqrtf(1.0f - min_dp * min_dp);                              /* sin of the cone angle: the view directions that see the back of all triangles */
+  }
+
+  meshlets.push_back(m);
+}
+
+inline size_t Meshlets::cull(const mat4& mvp, const vec3& eye, std::vector<MeshletDraw>& draws) {
+
+  uint64_t start_time = rx_hrtime();
+  const float* m = mvp.m;
+  float planes[6][4];
+
+  /* Frustum planes from the rows of the matrix (Gribb, Hartmann). */
+  for (int i = 0; i < 3; ++i) {
+    for (int k = 0; k < 4; ++k) {
+      planes[i * 2 + 0][k] = m[k * 4 + 3] + m[k * 4 + i];
+      planes[i * 2 + 1][k] = m[k * 4 + 3] - m[k * 4 + i];
     }
   }
-  else {
-    for(size_t j = 0; j < h; ++j) {
-      row_ptrs[j] = pixels + (j * (w * channels));
+  for (int i = 0; i < 6; ++i) {
+    float len = sqrtf(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+    if (len > 0.0f) {
+      for (int k = 0; k < 4; ++k) {
+        planes[i][k] /= len;
+      }
     }
   }
-   
-  png_init_io(png_ptr, fp);
-  png_set_rows(png_ptr, info_ptr, row_ptrs);
-  png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-  
-  png_destroy_write_struct(&png_ptr, &info_ptr);
-  
-  delete[] row_ptrs;
-  row_ptrs = NULL;
 
-  fclose(fp);
-  
-  return true;
-}
+  draws.clear();
+  num_visible = 0;
+  num_frustum_culled = 0;
+  num_backface_culled = 0;
 
-/*
+  for (size_t i = 0; i < meshlets.size(); ++i) {
 
-  @param std::string filepath      - The file to laod
-  @param unsigned char** pix       - A reference to the buffer that will be set to the 
-                                     memory we allocate OR that we will reallocate (if needed).
-                                     We will only reallocate when the *allocated parameter is
-                                     passed. 
-  @param int& width                - Will be set to the width of the image.
-  @param int& height               - Will be set to the height of the image
-  @param int& nchannels            - Will be set to the number of color channels in the image
-  @param int* allocated (NULL)     - Can be NULL, if not it must be set to the number of bytes in *pix.
-                                     When the number of allocated bytes is less then what we need, we will
-                                     reallocate the buffer.   
-  @param int flags                 - This allows you to tell the loader, to convert a e.g. RGB
-                                     png into a RGBA, wich may be handy if you need to upload
-                                     the pixels to the GPU.  
+    const Meshlet& ml = meshlets[i];
 
-  @return int                      - The number of bytes of the image buffer (doesn't have to be the same 
-                                     as the number of bytes that was previously allocated!).
-                                   - on error we return a negative value.
+    bool outside = false;
+    for (int k = 0; k < 6 && !outside; ++k) {
+      outside = (planes[k][0] * ml.center.x + planes[k][1] * ml.center.y + planes[k][2] * ml.center.z + planes[k][3]) < -ml.radius;
+    }
+    if (outside) {
+      num_frustum_culled++;
+      continue;
+    }
 
- */  
-extern int rx_load_png(std::string filepath, 
-                        unsigned char** pixels,
-                        int& width,
-                        int& height,
-                        int& nchannels, 
-                        int* allocated,
-                        int flags)
-{
-  png_structp png_ptr;
-  png_infop info_ptr; 
-  unsigned char* tmp = NULL;
+    if (ml.cone_cutoff < 1.0f) {
+      vec3 dir = ml.cone_apex - eye;
+      if (dot(dir, ml.cone_axis) >= ml.cone_cutoff * length(dir)) {
+        num_backface_culled++;
+        continue;
+      }
+    }
 
-  FILE* fp = fopen(filepath.c_str(), "rb");
-  if(!fp) {
-    printf("Error: cannot load the png file: %s\n", filepath.c_str());
-    fp = NULL;
-    return -1;
+    num_visible++;
+
+    if (draws.size() && draws.back().first_index + draws.back().count == ml.first_index) {
+      draws.back().count += ml.num_triangles * 3;
+      continue;
+    }
+
+    MeshletDraw d;
+    d.count = ml.num_triangles * 3;
+    d.instance_count = 1;
+    d.first_index = ml.first_index;
+    d.base_vertex = 0;
+    d.base_instance = 0;
+    draws.push_back(d);
   }
-  
-  unsigned char sig[8];
-  size_t r = 0;
-  r = fread(sig, 1, 8, fp);
-  if(r != 8) {
-    printf("Error: invalid png signature (not enough bytes read) in: %s.\n", filepath.c_str());
-    fclose(fp);
-    fp = NULL;
-    return  -2;
+
+  cull_time_ns = rx_hrtime() - start_time;
+
+  return draws.size();
+}
+
+inline void Meshlets::print() {
+
+  size_t num_verts = 0;
+  size_t num_tris = 0;
+  for (size_t i = 0; i < meshlets.size(); ++i) {
+    num_verts += meshlets[i].num_vertices;
+    num_tris += meshlets[i].num_triangles;
   }
-  
-  if(!png_check_sig(sig, 8)) {
-    printf("Error: invalid png signature (wrong siganture) in: %s.\n", filepath.c_str());
-    fclose(fp);
-    fp = NULL;
-    return -3;
+
+  printf("meshlets.num_meshlets: %d\n", (int)meshlets.size());
+  printf("meshlets.avg_vertices: %.2f\n", meshlets.size() ? double(num_verts) / meshlets.size() : 0.0);
+  printf("meshlets.avg_triangles: %.2f\n", meshlets.size() ? double(num_tris) / meshlets.size() : 0.0);
+  printf("meshlets.build_time: %.2f ms\n", double(build_time_ns) / 1e6);
+  printf("meshlets.visible: %d\n", (int)num_visible);
+  printf("meshlets.frustum_culled: %d\n", (int)num_frustum_culled);
+  printf("meshlets.backface_culled: %d\n", (int)num_backface_culled);
+  printf("meshlets.cull_time: %.3f ms\n", double(cull_time_ns) / 1e6);
+}
+
+/*
+  OBJCache
+  --------
+
+  Parsing the same .obj files at every launch is slow. OBJCache stores the 
+  indexed mesh (see OBJ::createIndices()), with the triangles and vertices
+  reordered by MeshOptimizer, in a binary file next to the .obj
+  file (`mesh.obj` is cached in `mesh.obj.cache`). The cache is keyed by 
+  the modification time and size of the .obj file; when one of them changes,
+  or when the cache version changed, the cache is rebuilt automatically. 
+
+  Loading a cache memory maps the file; the members point directly into the 
+  mapped data so there is no parsing and nothing is copied. Every section 
+  is 16 byte aligned so you can hand the pointers to glBufferData(). The 
+  pointers stay valid until close() is called or the OBJCache is destroyed.
+
+  When you ask for more than one level of detail, MeshSimplifier creates a
+  chain of LODs that share the vertices. `indices` holds the indices of all
+  levels; `lods[i].first_index` and `lods[i].num_indices` give the range of 
+  each level, lods[0] is the full mesh. 
+
+  Layouts:
+  - OBJ_CACHE_LAYOUT_PLANAR: separate `positions`, `normals`, `tex_coords` 
+    and `tangents` arrays.
+  - OBJ_CACHE_LAYOUT_INTERLEAVED: one `vertices` array with VertexPTTN data.
+
+  ````c++
+  OBJCache cache;
+  if (cache.load(rx_to_data_path("mesh.obj"), OBJ_CACHE_LAYOUT_INTERLEAVED)) {
+    glBufferData(GL_ARRAY_BUFFER, cache.num_vertices * sizeof(VertexPTTN), cache.vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, cache.num_indices * sizeof(uint32_t), cache.indices, GL_STATIC_DRAW);
   }
-    
-  png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-  if(!png_ptr) {
-    printf("Error: cannot create png read struct: %s\n", filepath.c_str());
-    fclose(fp);
-    fp = NULL;
-    return -4;
+
+  // with 4 levels of detail:
+  if (cache.load(rx_to_data_path("mesh.obj"), OBJ_CACHE_LAYOUT_INTERLEAVED, 4)) {
+    ...
+    const OBJCacheLOD& lod = cache.lods[level];
+    glDrawElements(GL_TRIANGLES, lod.num_indices, GL_UNSIGNED_INT, (GLvoid*)(lod.first_index * sizeof(uint32_t)));
   }
-  
-  info_ptr = png_create_info_struct(png_ptr);
-  if(!info_ptr) {
-    png_destroy_read_struct(&png_ptr, NULL, NULL);
-    printf("Error: cannot create png info struct for: %s\n", filepath.c_str());
-    fclose(fp);
-    fp = NULL;
-    return -5;
+  ````
+ */
+
+#define OBJ_CACHE_VERSION 3
+#define OBJ_CACHE_LAYOUT_PLANAR 1        /* separate arrays per attribute */
+#define OBJ_CACHE_LAYOUT_INTERLEAVED 2   /* one array with VertexPTTN vertices */
+#define OBJ_CACHE_FLAG_NORMALS 0x0001
+#define OBJ_CACHE_FLAG_TEXCOORDS 0x0002
+#define OBJ_CACHE_FLAG_TANGENTS 0x0004
+
+struct OBJCacheHeader {
+  char magic[4];                                                               /* "RXMC" */
+  uint32_t version;                                                            /* OBJ_CACHE_VERSION */
+  uint64_t source_mtime;                                                       /* rx_get_file_mtime() of the .obj file */
+  uint64_t source_size;                                                        /* rx_get_file_size() of the .obj file */
+  uint32_t layout;                                                             /* OBJ_CACHE_LAYOUT_{PLANAR, INTERLEAVED} */
+  uint32_t flags;                                                              /* OBJ_CACHE_FLAG_* */
+  uint32_t num_vertices;
+  uint32_t num_indices;
+  uint64_t offset_positions;                                                   /* byte offsets from the start of the file; 0 when not used */
+  uint64_t offset_normals;
+  uint64_t offset_tex_coords;
+  uint64_t offset_tangents;
+  uint64_t offset_vertices;
+  uint64_t offset_indices;
+  uint64_t offset_lods;
+  uint32_t num_lods;                                                           /* number of OBJCacheLOD entries, at least 1 */
+  uint32_t requested_lods;                                                     /* number of levels asked for when the cache was created, see OBJCache::load() */
+};
+
+struct OBJCacheLOD {
+  uint32_t first_index;                                                        /* first index of this level in OBJCache::indices */
+  uint32_t num_indices;                                                        /* number of indices of this level */
+  float error;                                                                 /* relative error, see MeshSimplifier */
+  uint32_t reserved;
+};
+
+class OBJCache {
+ public:
+  OBJCache();
+  ~OBJCache();
+  bool load(std::string filepath, int layout = OBJ_CACHE_LAYOUT_PLANAR, int numLods = 1); /* maps the cache for the given .obj file; (re)builds the cache when it's missing or stale */
+  bool open(std::string cachepath);                                            /* maps a cache file as is, without checking the source */
+  void close();                                                                /* unmaps the cache; all pointers become invalid */
+  static bool save(std::string cachepath, OBJ& obj, int layout, uint64_t source_mtime, uint64_t source_size, int numLods = 1);  /* writes the indexed mesh of the given obj, with numLods levels of detail */
+  static std::string getCachePath(std::string filepath);                       /* returns the path of the cache for the given .obj file */
+  bool hasNormals();
+  bool hasTexCoords();
+  bool hasTangents();
+
+ public:
+  const OBJCacheHeader* header;                                                /* the header of the mapped file */
+  const vec3* positions;                                                       /* OBJ_CACHE_LAYOUT_PLANAR */
+  const vec3* normals;                                                         /* OBJ_CACHE_LAYOUT_PLANAR */
+  const vec2* tex_coords;                                                      /* OBJ_CACHE_LAYOUT_PLANAR */
+  const vec4* tangents;                                                        /* OBJ_CACHE_LAYOUT_PLANAR */
+  const VertexPTTN* vertices;                                                  /* OBJ_CACHE_LAYOUT_INTERLEAVED */
+  const uint32_t* indices;                                                     /* triangle indices of all levels of detail */
+  const OBJCacheLOD* lods;                                                     /* the levels of detail, lods[0] is the full mesh */
+  uint32_t num_vertices;
+  uint32_t num_indices;
+  uint32_t num_lods;
+
+ private:
+  const char* data;                                                            /* the mapped data */
+  size_t nbytes;                                                               /* size of the mapped data */
+}; // OBJCache
+
+inline OBJCache::OBJCache()
+  :header(NULL)
+  ,positions(NULL)
+  ,normals(NULL)
+  ,tex_coords(NULL)
+  ,tangents(NULL)
+  ,vertices(NULL)
+  ,indices(NULL)
+  ,lods(NULL)
+  ,num_vertices(0)
+  ,num_indices(0)
+  ,num_lods(0)
+  ,data(NULL)
+  ,nbytes(0)
+{
+}
+
+inline OBJCache::~OBJCache() {
+  close();
+}
+
+inline std::string OBJCache::getCachePath(std::string filepath) {
+  return filepath + ".cache";
+}
+
+inline bool OBJCache::hasNormals() {
+  return header && (header->flags & OBJ_CACHE_FLAG_NORMALS);
+}
+
+inline bool OBJCache::hasTexCoords() {
+  return header && (header->flags & OBJ_CACHE_FLAG_TEXCOORDS);
+}
+
+inline bool OBJCache::hasTangents() {
+  return header && (header->flags & OBJ_CACHE_FLAG_TANGENTS);
+}
+
+inline void OBJCache::close() {
+  rx_unmap_file(data, nbytes);
+  data = NULL;
+  nbytes = 0;
+  header = NULL;
+  positions = NULL;
+  normals = NULL;
+  tex_coords = NULL;
+  tangents = NULL;
+  vertices = NULL;
+  indices = NULL;
+  lods = NULL;
+  num_vertices = 0;
+  num_indices = 0;
+  num_lods = 0;
+}
+
+inline bool OBJCache::load(std::string filepath, int layout, int numLods) {
+
+  std::string cachepath = getCachePath(filepath);
+  bool has_source = rx_file_exists(filepath);
+  uint64_t mtime = rx_get_file_mtime(filepath);
+  uint64_t size = rx_get_file_size(filepath);
+
+  if (open(cachepath)) {
+
+    bool is_same_request = (header->layout == (uint32_t)layout && header->requested_lods == (uint32_t)numLods);
+
+    /* Without the source we can't recreate the cache, so it must match exactly what is asked for. */
+    if (false == has_source) {
+      if (is_same_request) {
+        return true;
+      }
+      printf("Error: the obj cache has a different layout or number of lods and the .obj file is missing: %s\n", cachepath.c_str());
+      close();
+      return false;
+    }
+
+    if (is_same_request
+        && header->source_mtime == mtime
+        && header->source_size == size)
+      {
+        return true;
+      }
+
+    close();
   }
-  
-#if !defined(_WIN32)
-#if 1
-  if(setjmp(png_jmpbuf(png_ptr))) {
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    fclose(fp);
-    fp = NULL;
-    return -6;
+
+  if (false == has_source) {
+    printf("Error: cannot find the .obj file or cache for: %s\n", filepath.c_str());
+    return false;
   }
-#endif
-#endif
 
-  
-  // @TODO - add option to rescale to 8bit color info or 16bit
-  // @TODO - add option to strip the alpha (not recommended in the example)
-  png_init_io(png_ptr, fp);
-  png_set_sig_bytes(png_ptr, 8);
-  png_read_info(png_ptr, info_ptr);
-  
-  uint32_t stride = 0;
-  uint32_t num_bytes = 0;
-  uint32_t bit_depth = png_get_bit_depth(png_ptr, info_ptr);
-  uint32_t color_type = png_get_color_type(png_ptr, info_ptr);
-  width = png_get_image_width(png_ptr, info_ptr);
-  height = png_get_image_height(png_ptr, info_ptr);
-  nchannels = png_get_channels(png_ptr, info_ptr);
+  OBJ obj;
+  if (false == obj.load(filepath)) {
+    return false;
+  }
 
-  if(width == 0 || height == 0) {
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    fclose(fp);
-    fp = NULL;
-    return -7;
+  if (false == save(cachepath, obj, layout, mtime, size, numLods)) {
+    return false;
   }
-  
-  /* @TODO - add option to allow input colors/gray values to be not converted */
 
-  switch(color_type) {
-    case PNG_COLOR_TYPE_PALETTE: {
-      png_set_palette_to_rgb(png_ptr);
-      nchannels = 3;
-      break;
-    }
-    case PNG_COLOR_TYPE_GRAY: {
-      if(bit_depth < 8) {
-        png_set_expand_gray_1_2_4_to_8(png_ptr);
-        bit_depth = 8;
-      }
-      break;
-    }
-    default: {
-      /*printf("Warning: unsupported color type: %d.\n", color_type);*/
-      break;
-    }
-  };
+  return open(cachepath);
+}
 
-  /* When transparency is set convert it to a full alpha channel */
-  if(png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
-    png_set_tRNS_to_alpha(png_ptr);
-    nchannels += 1;
+inline bool OBJCache::open(std::string cachepath) {
+
+  close();
+
+  if (false == rx_file_exists(cachepath)) {
+    return false;
   }
 
-  /* When flag is set to load as RGBA, we need to the info struct */
-  if ((flags & RX_FLAG_LOAD_AS_RGBA) == RX_FLAG_LOAD_AS_RGBA) {
-    if (color_type == PNG_COLOR_TYPE_RGB ||
-        color_type == PNG_COLOR_TYPE_GRAY || 
-        color_type == PNG_COLOR_TYPE_PALETTE)
+  if (false == rx_map_file(cachepath, &data, nbytes)) {
+    printf("Error: cannot map the obj cache: %s\n", cachepath.c_str());
+    return false;
+  }
+
+  const OBJCacheHeader* hdr = (const OBJCacheHeader*)data;
+  if (nbytes < sizeof(OBJCacheHeader)
+      || 0 != memcmp(hdr->magic, "RXMC", 4)
+      || OBJ_CACHE_VERSION != hdr->version)
     {
-      png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+      close();
+      return false;
     }
 
-    if(color_type == PNG_COLOR_TYPE_GRAY ||
-       color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+  /* Counts that can't fit in the file are corrupt; this also keeps the section sizes below from overflowing. */
+  if (hdr->num_vertices > nbytes / sizeof(vec2)
+      || hdr->num_indices > nbytes / sizeof(uint32_t)
+      || hdr->num_lods > nbytes / sizeof(OBJCacheLOD))
     {
-      png_set_gray_to_rgb(png_ptr);
+      printf("Error: the obj cache is corrupt: %s\n", cachepath.c_str());
+      close();
+      return false;
     }
 
-    png_read_update_info(png_ptr, info_ptr);
+  /* Make sure that all sections are inside the file, written so that offset + size can't wrap. */
+  uint64_t nv = hdr->num_vertices;
+  uint64_t sections[7][2] = {
+    { hdr->offset_positions, nv * sizeof(vec3) },
+    { hdr->offset_normals, nv * sizeof(vec3) },
+    { hdr->offset_tex_coords, nv * sizeof(vec2) },
+    { hdr->offset_tangents, nv * sizeof(vec4) },
+    { hdr->offset_vertices, nv * sizeof(VertexPTTN) },
+    { hdr->offset_indices, uint64_t(hdr->num_indices) * sizeof(uint32_t) },
+    { hdr->offset_lods, uint64_t(hdr->num_lods) * sizeof(OBJCacheLOD) }
+  };
 
-    nchannels = 4;
+  for (int i = 0; i < 7; ++i) {
+    if (sections[i][0] != 0 && (sections[i][1] > nbytes || sections[i][0] > nbytes - sections[i][1])) {
+      printf("Error: the obj cache is corrupt: %s\n", cachepath.c_str());
+      close();
+      return false;
+    }
   }
 
-  stride = png_get_rowbytes(png_ptr, info_ptr);
-  num_bytes = stride * height; 
-
-  /* Reallocate when a buffer size is given */
-  unsigned char* pixbuf = NULL;
-  if (NULL != allocated) {
-    if (0 == *allocated) {
-      /* not allocated yet */
-      *pixels = (unsigned char*)malloc(num_bytes);
-      if (*pixels) {
-        *allocated = num_bytes;
-        pixbuf = *pixels;
-      }
-      else {
-        printf("Error: cannot allocate buffer for png image, %d bytes.\n", num_bytes);
-      }
+  header = hdr;
+  num_vertices = hdr->num_vertices;
+  num_indices = hdr->num_indices;
+  positions = hdr->offset_positions ? (const vec3*)(data + hdr->offset_positions) : NULL;
+  normals = hdr->offset_normals ? (const vec3*)(data + hdr->offset_normals) : NULL;
+  tex_coords = hdr->offset_tex_coords ? (const vec2*)(data + hdr->offset_tex_coords) : NULL;
+  tangents = hdr->offset_tangents ? (const vec4*)(data + hdr->offset_tangents) : NULL;
+  vertices = hdr->offset_vertices ? (const VertexPTTN*)(data + hdr->offset_vertices) : NULL;
+  indices = hdr->offset_indices ? (const uint32_t*)(data + hdr->offset_indices) : NULL;
+  lods = hdr->offset_lods ? (const OBJCacheLOD*)(data + hdr->offset_lods) : NULL;
+  num_lods = lods ? hdr->num_lods : 0;
+
+  for (uint32_t i = 0; i < num_lods; ++i) {
+    if (uint64_t(lods[i].first_index) + lods[i].num_indices > num_indices) {
+      printf("Error: the obj cache has an invalid lod: %s\n", cachepath.c_str());
+      close();
+      return false;
     }
-    else if (num_bytes > *allocated) {
-      /* already allocated, try to reallocate if necessary */
-      tmp = (unsigned char*)realloc(*pixels, num_bytes);
-      if (NULL == tmp) {
-        printf("Error: cannot reallocate the pixel buffer for the jpg.");
-      }
-      else {
-        *pixels = tmp;
-        *allocated = num_bytes;
-        pixbuf = *pixels;
-      }
+  }
+
+  return true;
+}
+
+/* We write into a temporary file first so a reader never maps a half written cache. */
+inline bool OBJCache::save(std::string cachepath, OBJ& obj, int layout, uint64_t source_mtime, uint64_t source_size, int numLods) {
+
+  if (layout != OBJ_CACHE_LAYOUT_PLANAR && layout != OBJ_CACHE_LAYOUT_INTERLEAVED) {
+    printf("Error: invalid obj cache layout: %d\n", layout);
+    return false;
+  }
+
+  std::vector<VertexPTTN> verts;
+  std::vector<uint32_t> dx;
+  if (false == obj.copy(verts, dx)) {
+    printf("Error: cannot create the obj cache, failed to copy the vertices.\n");
+    return false;
+  }
+
+  MeshOptimizer opt;
+  opt.optimize(verts, dx);
+
+  /* The levels of detail share the vertices; we only reorder their triangles for the vertex cache. */
+  std::vector<MeshLOD> lod_data;
+  MeshSimplifier simp;
+  simp.createLODs(verts, dx, lod_data, HEIGHEST(numLods, 1));
+
+  std::vector<OBJCacheLOD> lods(lod_data.size());
+  size_t num_indices = 0;
+  for (size_t i = 0; i < lod_data.size(); ++i) {
+    if (i > 0) {
+      opt.optimizeVertexCache(lod_data[i].indices, verts.size());
     }
-    else {
-      pixbuf = *pixels;
+    lods[i].first_index = num_indices;
+    lods[i].num_indices = lod_data[i].indices.size();
+    lods[i].error = lod_data[i].error;
+    lods[i].reserved = 0;
+    num_indices += lod_data[i].indices.size();
+  }
+
+  size_t nv = verts.size();
+  OBJCacheHeader hdr;
+  memset(&hdr, 0x00, sizeof(hdr));
+  memcpy(hdr.magic, "RXMC", 4);
+  hdr.version = OBJ_CACHE_VERSION;
+  hdr.source_mtime = source_mtime;
+  hdr.source_size = source_size;
+  hdr.layout = layout;
+  hdr.flags = (obj.has_normals ? OBJ_CACHE_FLAG_NORMALS : 0)
+    | (obj.has_texcoords ? OBJ_CACHE_FLAG_TEXCOORDS : 0)
+    | (obj.has_tangents ? OBJ_CACHE_FLAG_TANGENTS : 0);
+  hdr.num_vertices = nv;
+  hdr.num_indices = num_indices;
+  hdr.num_lods = lods.size();
+  hdr.requested_lods = numLods;
+
+  /* Layout the sections, 16 byte aligned. */
+  uint64_t offset = (sizeof(OBJCacheHeader) + 15) & ~15;
+  if (layout == OBJ_CACHE_LAYOUT_PLANAR) {
+    hdr.offset_positions = offset;
+    offset = (offset + nv * sizeof(vec3) + 15) & ~15;
+    hdr.offset_normals = offset;
+    offset = (offset + nv * sizeof(vec3) + 15) & ~15;
+    hdr.offset_tex_coords = offset;
+    offset = (offset + nv * sizeof(vec2) + 15) & ~15;
+    hdr.offset_tangents = offset;
+    offset = (offset + nv * sizeof(vec4) + 15) & ~15;
+  }
+  else {
+    hdr.offset_vertices = offset;
+    offset = (offset + nv * sizeof(VertexPTTN) + 15) & ~15;
+  }
+  hdr.offset_indices = offset;
+  offset = (offset + num_indices * sizeof(uint32_t) + 15) & ~15;
+  hdr.offset_lods = offset;
+  offset += lods.size() * sizeof(OBJCacheLOD);
+
+  std::vector<char> buf(offset, 0);
+  memcpy(&buf[0], &hdr, sizeof(hdr));
+
+  if (layout == OBJ_CACHE_LAYOUT_PLANAR) {
+    vec3* pos = (vec3*)&buf[hdr.offset_positions];
+    vec3* norm = (vec3*)&buf[hdr.offset_normals];
+    vec2* tex = (vec2*)&buf[hdr.offset_tex_coords];
+    vec4* tan = (vec4*)&buf[hdr.offset_tangents];
+    for (size_t i = 0; i < nv; ++i) {
+      pos[i] = verts[i].pos;
+      norm[i] = verts[i].norm;
+      tex[i] = verts[i].tex;
+      tan[i] = verts[i].tan;
     }
   }
+  else if (nv) {
+    memcpy(&buf[hdr.offset_vertices], &verts[0], nv * sizeof(VertexPTTN));
+  }
+
+  for (size_t i = 0; i < lods.size(); ++i) {
+    if (lods[i].num_indices) {
+      memcpy(&buf[hdr.offset_indices + lods[i].first_index * sizeof(uint32_t)], &lod_data[i].indices[0], lods[i].num_indices * sizeof(uint32_t));
+    }
+  }
+
+  if (lods.size()) {
+    memcpy(&buf[hdr.offset_lods], &lods[0], lods.size() * sizeof(OBJCacheLOD));
+  }
+
+  std::string tmppath = cachepath + ".tmp";
+  FILE* fp = fopen(tmppath.c_str(), "wb");
+  if (NULL == fp) {
+    printf("Error: cannot write the obj cache: %s\n", tmppath.c_str());
+    return false;
+  }
+
+  size_t nwritten = fwrite(&buf[0], 1, buf.size(), fp);
+  fclose(fp);
+
+  if (nwritten != buf.size()) {
+    printf("Error: failed to write the obj cache: %s\n", tmppath.c_str());
+    remove(tmppath.c_str());
+    return false;
+  }
+
+#if defined(_WIN32)
+  remove(cachepath.c_str());
+#endif
+
+  if (0 != rename(tmppath.c_str(), cachepath.c_str())) {
+    printf("Error: cannot rename the obj cache: %s\n", cachepath.c_str());
+    remove(tmppath.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+/*
+  Tube
+  ----
+
+  Generates an indexed tube or ribbon mesh along a Spline<vec3>. We
+  evaluate the catmull rom segments directly (instead of calling 
+  Spline::at() per ring) and use parallel transport to compute the
+  frames so the tube doesn't twist. All vertices are written into 
+  the preallocated `vertices` buffer; the buffers only reallocate
+  when the number of points, sides or the segments change.
+
+  When you move a couple of control points you can call update() with
+  the range of points that changed. We only regenerate the rings that
+  are influenced by these points and stop as soon as the transported 
+  frames match the previous ones again. The range of vertices that 
+  was written is stored in `dirty_start` and `dirty_end` so you can 
+  use glBufferSubData() to upload only that part.
+
+  ````c++
+  Spline<vec3> spline;  
+  Tube tube;
+  tube.type = TUBE_TYPE_TUBE;
+  tube.radius = 5.0f;
+  tube.create(spline);
+  
+  // after changing spline[4]
+  tube.update(spline, 4, 4);
+  ````
+ */
+
+#define TUBE_TYPE_TUBE 1     /* generates a closed tube around the spline */
+#define TUBE_TYPE_RIBBON 2   /* generates a flat ribbon, facing the transported normal */
+
+class Tube {
+ public:
+  Tube();
+  bool create(Spline<vec3>& spline);                                      /* (re)generates all vertices and, when the topology changed, the indices */
+  bool update(Spline<vec3>& spline, size_t first, size_t last);           /* regenerates only the rings that are influenced by the control points [first, last] */
+  size_t getNumRings();                                                   /* returns the number of rings for the last created spline */
+
+ private:
+  bool setup(size_t npoints);                                             /* allocates the buffers and creates the indices when necessary */
+  void evaluate(Spline<vec3>& spline, size_t ring, vec3& pos, vec3& tan); /* evaluate the position and tangent of the given ring */
+  void transport(size_t ring);                                            /* calculate the frame for the given ring from the previous one */
+  void writeRing(size_t ring);                                            /* write the vertices for the given ring */
+
+ public:
+  int type;                                                               /* TUBE_TYPE_TUBE or TUBE_TYPE_RIBBON */
+  int sides;                                                              /* number of sides around the tube; not used for ribbons */
+  int segments;                                                           /* number of rings we generate per spline segment */
+  float radius;                                                           /* radius of the tube or half the width of the ribbon */
+  std::vector<VertexPTN> vertices;                                        /* the generated vertices */
+  std::vector<uint32_t> indices;                                          /* triangle indices into `vertices` */
+  size_t dirty_start;                                                     /* first vertex that was written by the last create()/update() */
+  size_t dirty_end;                                                       /* one past the last vertex that was written by the last create()/update() */
+
+ private:
+  std::vector<vec3> positions;                                            /* position of each ring */
+  std::vector<vec3> tangents;                                             /* frame per ring: tangent */
+  std::vector<vec3> normals;                                              /* frame per ring: transported normal */
+  std::vector<vec3> binormals;                                            /* frame per ring: binormal */
+  size_t num_points;                                                      /* number of spline points used for the current topology */
+  int created_type;                                                       /* type used for the current topology */
+  int created_sides;                                                      /* sides used for the current topology */
+  int created_segments;                                                   /* segments used for the current topology */
+}; // Tube
+
+inline Tube::Tube()
+  :type(TUBE_TYPE_TUBE)
+  ,sides(8)
+  ,segments(8)
+  ,radius(1.0f)
+  ,dirty_start(0)
+  ,dirty_end(0)
+  ,num_points(0)
+  ,created_type(0)
+  ,created_sides(0)
+  ,created_segments(0)
+{
+}
+
+inline size_t Tube::getNumRings() {
+  return positions.size();
+}
+
+inline bool Tube::setup(size_t npoints) {
+
+  if (npoints < 4) {
+    printf("Error: cannot create a tube; we need at least 4 spline points.\n");
+    return false;
+  }
+
+  if (sides < 3 || segments < 1) {
+    printf("Error: cannot create a tube; invalid sides (%d) or segments (%d).\n", sides, segments);
+    return false;
+  }
+
+  if (npoints == num_points
+      && type == created_type
+      && sides == created_sides
+      && segments == created_segments)
+    {
+      return true;
+    }
+
+  size_t nrings = (npoints - 1) * segments + 1;
+  size_t nsides = (type == TUBE_TYPE_RIBBON) ? 1 : sides;
+  size_t stride = nsides + 1;
+
+  positions.resize(nrings);
+  tangents.resize(nrings);
+  normals.resize(nrings);
+  binormals.resize(nrings);
+  vertices.resize(nrings * stride);
+  indices.resize((nrings - 1) * nsides * 6);
+
+  uint32_t* dx = &indices[0];
+  for (size_t r = 0; r < nrings - 1; ++r) {
+    for (size_t j = 0; j < nsides; ++j) {
+      uint32_t a = r * stride + j;
+      uint32_t b = a + stride;
+      dx[0] = a;
+      dx[1] = b;
+      dx[2] = a + 1;
+      dx[3] = a + 1;
+      dx[4] = b;
+      dx[5] = b + 1;
+      dx += 6;
+    }
+  }
+
+  num_points = npoints;
+  created_type = type;
+  created_sides = sides;
+  created_segments = segments;
+
+  return true;
+}
+
+/* Same catmull rom as Spline<T>::at(), but we also calculate the derivative. */
+inline void Tube::evaluate(Spline<vec3>& spline, size_t ring, vec3& pos, vec3& tan) {
+
+  int n = spline.points.size();
+  int b = ring / segments;
+  float t = float(ring % segments) / segments;
+
+  if (b >= n - 1) {
+    b = n - 2;
+    t = 1.0f;
+  }
+
+  int a = LOWEST(HEIGHEST(b - 1, 0), n - 1);
+  int c = b + 1;
+  int d = LOWEST(c + 1, n - 1);
+
+  const vec3& p0 = spline.points[a];
+  const vec3& p1 = spline.points[b];
+  const vec3& p2 = spline.points[c];
+  const vec3& p3 = spline.points[d];
+
+  vec3 c1 = -p0 + p2;
+  vec3 c2 = 2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3;
+  vec3 c3 = -p0 + 3.0f * p1 - 3.0f * p2 + p3;
+
+  pos = 0.5f * ((2.0f * p1) + c1 * t + c2 * (t * t) + c3 * (t * t * t));
+  tan = 0.5f * (c1 + c2 * (2.0f * t) + c3 * (3.0f * t * t));
+}
+
+/* Projects the previous normal onto the plane of the new tangent; a cheap approximation of the rotation minimizing frame. */
+inline void Tube::transport(size_t ring) {
+
+  vec3& t = tangents[ring];
+
+  if (0 == ring) {
+    vec3 up = (fabsf(t.x) > fabsf(t.z)) ? vec3(-t.y, t.x, 0.0f) : vec3(0.0f, -t.z, t.y);
+    normals[0] = normalized(up);
+    binormals[0] = cross(t, normals[0]);
+    return;
+  }
+
+  vec3 n = normals[ring - 1];
+  n = n - t * dot(n, t);
+
+  float len = length(n);
+  if (len < 1e-6f) {
+    n = binormals[ring - 1];
+    n = n - t * dot(n, t);
+    len = length(n);
+  }
+
+  normals[ring] = n / len;
+  binormals[ring] = cross(t, normals[ring]);
+}
+
+inline void Tube::writeRing(size_t ring) {
+
+  float v = float(ring) / float(positions.size() - 1);
+  const vec3& p = positions[ring];
+  const vec3& n = normals[ring];
+  const vec3& b = binormals[ring];
+
+  if (created_type == TUBE_TYPE_RIBBON) {
+    VertexPTN* dst = &vertices[ring * 2];
+    dst[0].set(p - b * radius, vec2(0.0f, v), n);
+    dst[1].set(p + b * radius, vec2(1.0f, v), n);
+    return;
+  }
+
+  float step = TWO_PI / created_sides;
+  VertexPTN* dst = &vertices[ring * (created_sides + 1)];
+
+  for (int j = 0; j <= created_sides; ++j) {
+    float ca = cosf(step * j);
+    float sa = sinf(step * j);
+    vec3 dir = n * ca + b * sa;
+    dst[j].set(p + dir * radius, vec2(float(j) / created_sides, v), dir);
+  }
+}
+
+inline bool Tube::create(Spline<vec3>& spline) {
+
+  if (false == setup(spline.points.size())) {
+    return false;
+  }
+
+  size_t nrings = positions.size();
+
+  for (size_t r = 0; r < nrings; ++r) {
+    vec3 tan;
+    evaluate(spline, r, positions[r], tan);
+    float len = length(tan);
+    tangents[r] = (len > 1e-6f) ? tan / len : ((r > 0) ? tangents[r - 1] : vec3(1.0f, 0.0f, 0.0f));
+    transport(r);
+    writeRing(r);
+  }
+
+  dirty_start = 0;
+  dirty_end = vertices.size();
+
+  return true;
+}
+
+inline bool Tube::update(Spline<vec3>& spline, size_t first, size_t last) {
+
+  if (spline.points.size() != num_points
+      || type != created_type
+      || sides != created_sides
+      || segments != created_segments)
+    {
+      return create(spline);
+    }
+
+  if (first > last || first >= num_points) {
+    printf("Error: invalid tube update range: %d - %d.\n", int(first), int(last));
+    return false;
+  }
+
+  /* Point `i` is used by the curve segments [i - 2, i + 1]. */
+  size_t nrings = positions.size();
+  size_t stride = vertices.size() / nrings;
+  size_t ring_start = (first > 2) ? (first - 2) * segments : 0;
+  size_t ring_end = LOWEST((last + 2) * segments + 1, nrings);
+
+  for (size_t r = ring_start; r < ring_end; ++r) {
+    vec3 tan;
+    evaluate(spline, r, positions[r], tan);
+    float len = length(tan);
+    tangents[r] = (len > 1e-6f) ? tan / len : ((r > 0) ? tangents[r - 1] : vec3(1.0f, 0.0f, 0.0f));
+    transport(r);
+    writeRing(r);
+  }
+
+  /* The frames after the changed range are only rotated when the transported normal changed. */
+  size_t r = ring_end;
+  for (; r < nrings; ++r) {
+    vec3 prev = normals[r];
+    transport(r);
+    vec3 diff = normals[r] - prev;
+    if (dot(diff, diff) < 1e-12f) {
+      break;
+    }
+    writeRing(r);
+  }
+
+  dirty_start = ring_start * stride;
+  dirty_end = r * stride;
+
+  return true;
+}
+
+/*
+  Painter
+  --------
+  
+  The Painter class is a simple wrapper that mimics intermediate 
+  mode of openGL draw calls. This Painter class is not meant to be
+  used in super optimized applications as using this approach is 
+  is just not the correct one for optimized draw calls. Though this
+  class is probably quite fast as we will use vbo's. Goal of is class
+  is to provide a simple way to draw lines, rects, circles etc.. when 
+  you just want to quickly draw something.
+
+  Contexts
+  --------
+  The painter is build around the concept of contexts, where a 
+  context takes care of drawing particular vertex data. PainterContextPC
+  draws shapes with a color and PainterContextPT draws textures. The PC
+  context stores VertexPackedPC vertices: a 2D position and a RGBA8 
+  color, 12 bytes instead of the 28 of a VertexPC. The color is packed 
+  once in color(), rgba() or hex() and copied into every vertex as one
+  uint32_t.
+
+  Instancing
+  ----------
+  When you draw a lot of rects or circles, call instanced(). Every shape
+  is then stored as one PainterInstance of 20 bytes (position, size and 
+  a packed color) instead of 6 (rect) or resolution + 2 (circle) vertices
+  of 28 bytes. The vertex shader expands a static unit mesh per shape kind 
+  and every kind is drawn with one glDrawArraysInstanced(). The instanced
+  shapes are drawn after the other shapes, grouped per kind, so they don't 
+  keep their order relative to shapes of another kind.
+
+  ````c++
+  painter.instanced();
+  for (int i = 0; i < 100000; ++i) {
+    painter.circle(x[i], y[i], 2.0f);
+  }
+  painter.noinstanced();
+  ````
+
+  SDF shapes
+  ----------
+  After sdf(), rects and circles are drawn as one quad per shape and the
+  fragment shader computes the signed distance to a rounded box to get 
+  an antialiased edge. A circle is a box with a corner radius of half its
+  size, so circles are round at any radius without more vertices. With 
+  nofill() you get a ring / outline of lineWidth(). roundedRect() always 
+  uses this path. The shapes are stored as PainterSDFInstance (28 bytes)
+  and drawn with one instanced draw call after the other instanced shapes.
+
+  ````c++
+  painter.sdf();
+  painter.fill();
+  painter.circle(400, 300, 250);
+  painter.roundedRect(10, 10, 200, 50, 8);
+  painter.nofill();
+  painter.lineWidth(3);
+  painter.circle(400, 300, 270);
+  painter.nosdf();
+  ````
+
+  Polylines
+  ---------
+  GL_LINES and GL_LINE_STRIP are limited to 1 pixel in a core profile. 
+  After polyline(), line() and begin()/vertex()/end() with GL_LINES, 
+  GL_LINE_STRIP or GL_LINE_LOOP store the center line as 
+  PainterPolylinePoint (position, width and color: 16 bytes per point). 
+  The vertex shader expands every segment into a quad, one instance per
+  segment, with the six vertices selected by gl_VertexID. The instance 
+  reads four consecutive points (previous, start, end, next), so the 
+  joins can be computed without a geometry shader. The width and color
+  of the points are taken from lineWidth() and color() when you call
+  vertex(), so they can change per point.
+
+  Miter joins compute the same miter vertex for both segments of a join,
+  so segments don't overlap; the length of the miter is limited to 4 
+  times the half width. Round joins draw every segment as a capsule and
+  compute the distance to the segment in the fragment shader; the 
+  capsules overlap at the joins which is visible with transparent colors.
+  Every join type is drawn with one draw call, miter first, so polylines
+  of different join types don't keep their order.
+
+  ````c++
+  painter.polyline();
+  painter.lineJoin(PAINTER_JOIN_ROUND);
+  painter.begin(GL_LINE_STRIP);
+  for (int i = 0; i < n; ++i) {
+    painter.lineWidth(1.0f + i * 0.1f);
+    painter.vertex(x[i], y[i]);
+  }
+  painter.end();
+  painter.nopolyline();
+  ````
+
+  Layers
+  ------
+  Everything you draw is recorded again every frame after clear(). For 
+  things that rarely change use a layer: select it with layer(name), draw 
+  into it and go back with nolayer(). A layer keeps its shapes until you 
+  call clearLayer() and has its own buffer that is only uploaded again 
+  after something was added to it. Layers are drawn in the same draw() 
+  call, sorted on their order; layers with an order below 0 are drawn 
+  before the shapes that are not in a layer, the others after them.
+
+  ````c++
+  // once (after init())
+  painter.layer("grid");
+  painter.layerOrder("grid", -1);
+  for (int i = 0; i < 100; ++i) {
+    painter.line(i * 10, 0, i * 10, 1000);
+  }
+  painter.nolayer();
+
+  // every frame
+  painter.clear();
+  painter.circle(mouse_x, mouse_y, 10);
+  painter.draw();
+  ````
+
+  Recorders
+  ---------
+  The Painter itself can only be used from one thread. To build shapes on
+  multiple threads, get a PainterRecorder per thread or per job with 
+  recorder() on the main thread, fill them on the worker threads and call
+  draw() on the main thread once they're done. Every recorder has its own
+  vertices, indices and commands; in draw() they are copied after the
+  other PC shapes into the same buffer, in the order the recorders were 
+  handed out. Recorders draw only rects, circles, lines and begin()/end()
+  batches, without layers or instancing.
+
+  ````c++
+  // main thread
+  painter.clear();
+  for (int i = 0; i < num_widgets; ++i) {
+    widgets[i].rec = painter.recorder();
+  }
+
+  // worker threads
+  widgets[i].rec->color(1, 0, 0, 1);
+  widgets[i].rec->rect(x, y, w, h);
+
+  // main thread, after joining
+  painter.draw();
+  ````
+
+  TODO
+  ----
+  At this point the API might change...
+
+ */
+
+#define PAINTER_CONTEXT_TYPE_PC 1   /* a context that can draw position + colors */
+#define PAINTER_CONTEXT_TYPE_PT 2   /* a context that can draw position + texcoords (not yet implemented) */
+#define PAINTER_CONTEXT_TYPE_POLYLINE 3 /* vertex() adds polyline points, see Painter::polyline() */
+
+#define PAINTER_STATE_NONE 0x0000        /* default state; no-fill */
+#define PAINTER_STATE_FILL 0x0001        /* draw everything filled */
+#define PAINTER_STATE_INSTANCED 0x0002   /* rects and circles are drawn with instancing, see PainterContextInstanced */
+#define PAINTER_STATE_SDF 0x0004         /* rects and circles are drawn as antialiased quads, see Painter::sdf() */
+#define PAINTER_STATE_POLYLINE 0x0008    /* lines are drawn as thick antialiased polylines, see Painter::polyline() */
+#define PAINTER_STATE_CULL 0x0010        /* shapes outside the viewport or cull rect and tiny shapes are not added, see Painter::cull() */
+
+#define PAINTER_JOIN_MITER 0             /* polyline joins; every join type is drawn with one draw call */
+#define PAINTER_JOIN_ROUND 1
+#define PAINTER_JOIN_COUNT 2
+
+#define PAINTER_SHAPE_RECT_FILL 0        /* instanced shape kinds; every kind is drawn with one glDrawArraysInstanced() */
+#define PAINTER_SHAPE_RECT_OUTLINE 1
+#define PAINTER_SHAPE_CIRCLE_FILL 2
+#define PAINTER_SHAPE_CIRCLE_OUTLINE 3
+#define PAINTER_SHAPE_COUNT 4
+
+// -----------------------------------------------------
+
+static const char* PAINTER_VERTEX_PC_VS  = ""
+  "#version 330\n"
+  ""
+  "layout( std140 ) uniform Shared { "
+  "  mat4 u_pm; " 
+  "};"
+  ""
+  "layout( location = 0 ) in vec4 a_pos; " 
+  "layout( location = 1 ) in vec4 a_col; "
+  "out vec4 v_col;"
+  ""
+  "void main() {"
+  "  gl_Position = u_pm * a_pos; " 
+  "  v_col = a_col; "
+  "}"
+  "";
+
+static const char* PAINTER_VERTEX_PC_FS = ""
+  "#version 330\n"
+  "in vec4 v_col; " 
+  "layout (location = 0) out vec4 fragcolor; " 
+  ""
+  "void main() {"
+  " fragcolor = v_col; " 
+  "}"
+  "";
+
+// -----------------------------------------------------
+
+static const char* PAINTER_VERTEX_PT_VS = ""
+  "#version 330\n"
+  ""
+  "layout( std140 ) uniform Shared { "
+  "  mat4 u_pm; "
+  "};"
+  ""
+  "layout( location = 0 ) in vec4 a_pos; " 
+  "layout( location = 1 ) in vec3 a_tex; "        /* u, v and the layer of a texture array */
+  "out vec3 v_tex;"
+  ""
+  "void main() {"
+  "   gl_Position = u_pm * a_pos; "
+  "   v_tex = a_tex; " 
+  "}"
+  "";
+
+static const char* PAINTER_VERTEX_PT_SAMPLER2D_FS = ""
+  "#version 330\n"
+  "uniform sampler2D u_tex; "
+  "in vec3 v_tex; " 
+  "layout( location = 0 ) out vec4 fragcolor; " 
+  ""
+  "void main() {"
+  "  fragcolor = texture(u_tex, v_tex.xy);"
+  "}"
+  "";
+
+static const char* PAINTER_VERTEX_PT_SAMPLER2DARRAY_FS = ""
+  "#version 330\n"
+  "uniform sampler2DArray u_tex; "
+  "in vec3 v_tex; " 
+  "layout( location = 0 ) out vec4 fragcolor; " 
+  ""
+  "void main() {"
+  "  fragcolor = texture(u_tex, v_tex);"
+  "}"
+  "";
+
+// -----------------------------------------------------
+
+static const char* PAINTER_INSTANCED_VS = ""
+  "#version 330\n"
+  ""
+  "layout( std140 ) uniform Shared { "
+  "  mat4 u_pm; "
+  "};"
+  ""
+  "layout( location = 0 ) in vec2 a_pos; "          /* unit mesh */
+  "layout( location = 1 ) in vec4 a_rect; "         /* per instance: x, y, w, h */
+  "layout( location = 2 ) in vec4 a_col; "          /* per instance: packed RGBA8 */
+  "out vec4 v_col;"
+  ""
+  "void main() {"
+  "  gl_Position = u_pm * vec4(a_rect.xy + a_pos * a_rect.zw, 0.0, 1.0); "
+  "  v_col = a_col; "
+  "}"
+  "";
+
+static const char* PAINTER_SDF_VS = ""
+  "#version 330\n"
+  ""
+  "layout( std140 ) uniform Shared { "
+  "  mat4 u_pm; "
+  "};"
+  ""
+  "layout( location = 0 ) in vec2 a_pos; "          /* unit quad */
+  "layout( location = 1 ) in vec4 a_rect; "         /* per instance: x, y, w, h */
+  "layout( location = 2 ) in vec2 a_shape; "        /* per instance: corner radius, stroke width (0 = filled) */
+  "layout( location = 3 ) in vec4 a_col; "          /* per instance: packed RGBA8 */
+  "out vec2 v_pos; "
+  "out vec2 v_half; "
+  "out vec2 v_shape; "
+  "out vec4 v_col; "
+  ""
+  "void main() {"
+  "  float margin = 1.0 + a_shape.y * 0.5; "       /* room for the antialiased edge and the outer half of the stroke */
+  "  vec2 half_size = a_rect.zw * 0.5; "
+  "  vec2 p = a_rect.xy - margin + a_pos * (a_rect.zw + 2.0 * margin); "
+  "  v_pos = p - (a_rect.xy + half_size); "
+  "  v_half = half_size; "
+  "  v_shape = a_shape; "
+  "  v_col = a_col; "
+  "  gl_Position = u_pm * vec4(p, 0.0, 1.0); "
+  "}"
+  "";
+
+static const char* PAINTER_SDF_FS = ""
+  "#version 330\n"
+  "in vec2 v_pos; "
+  "in vec2 v_half; "
+  "in vec2 v_shape; "
+  "in vec4 v_col; "
+  "layout( location = 0 ) out vec4 fragcolor; "
+  ""
+  "void main() {"
+  "  vec2 q = abs(v_pos) - v_half + v_shape.x; "
+  "  float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - v_shape.x; "  /* distance to the rounded box */
+  "  if (v_shape.y > 0.0) { "
+  "    d = abs(d) - v_shape.y * 0.5; "                                         /* outline centered on the edge */
+  "  } "
+  "  float alpha = clamp(0.5 - d / max(fwidth(d), 1e-4), 0.0, 1.0); "
+  "  if (alpha <= 0.0) { "
+  "    discard; "
+  "  } "
+  "  fragcolor = vec4(v_col.rgb, v_col.a * alpha); "
+  "}"
+  "";
+
+static const char* PAINTER_POLYLINE_VS = ""
+  "#version 330\n"
+  ""
+  "layout( std140 ) uniform Shared { "
+  "  mat4 u_pm; "
+  "};"
+  ""
+  "uniform int u_round; "
+  "layout( location = 0 ) in vec3 a_prev; "         /* per instance: x, y, width; a width < 0 marks a padding point */
+  "layout( location = 1 ) in vec3 a_start; "
+  "layout( location = 2 ) in vec4 a_start_col; "
+  "layout( location = 3 ) in vec3 a_end; "
+  "layout( location = 4 ) in vec4 a_end_col; "
+  "layout( location = 5 ) in vec3 a_next; "
+  "out vec2 v_pos; "
+  "out vec4 v_col; "
+  "out float v_dist; "
+  "out float v_half; "
+  "flat out vec4 v_seg; "
+  "flat out vec2 v_widths; "
+  "flat out vec4 v_start_col; "
+  "flat out vec4 v_end_col; "
+  ""
+  "void main() {"
+  "  if (a_start.z < 0.0 || a_end.z < 0.0) { "    /* the gap between two polylines */
+  "    gl_Position = vec4(2.0, 2.0, 2.0, 1.0); "
+  "    return; "
+  "  } "
+  "  int end = (gl_VertexID == 2 || gl_VertexID >= 4) ? 1 : 0; "
+  "  float side = (gl_VertexID == 1 || gl_VertexID == 2 || gl_VertexID == 4) ? 1.0 : -1.0; "
+  "  vec2 seg = a_end.xy - a_start.xy; "
+  "  float len = length(seg); "
+  "  vec2 d = (len > 1e-6) ? seg / len : vec2(1.0, 0.0); "
+  "  vec2 n = vec2(-d.y, d.x); "
+  "  vec2 p = (end == 0) ? a_start.xy : a_end.xy; "
+  "  float half_width = 0.5 * ((end == 0) ? a_start.z : a_end.z); "
+  "  float ext = half_width + 1.0; "                 /* one unit extra for the antialiased edge */
+  "  vec2 offset; "
+  "  if (u_round == 1) { "
+  "    offset = n * side * ext + d * ((end == 0) ? -ext : ext); "
+  "  } "
+  "  else { "
+  "    vec2 od = (end == 0) ? (a_start.xy - a_prev.xy) : (a_next.xy - a_end.xy); "
+  "    vec2 m = n; "
+  "    float ml = 1.0; "
+  "    if (len > 1e-6 && length(od) > 1e-6) { "
+  "      vec2 t = normalize(od) + d; "
+  "      if (length(t) > 1e-6) { "
+  "        t = normalize(t); "
+  "        m = vec2(-t.y, t.x); "
+  "        ml = min(1.0 / max(dot(m, n), 1e-3), 4.0); "
+  "      } "
+  "    } "
+  "    offset = m * ml * side * ext; "
+  "  } "
+  "  v_pos = p + offset; "
+  "  v_col = (end == 0) ? a_start_col : a_end_col; "
+  "  v_dist = side * ext; "
+  "  v_half = half_width; "
+  "  v_seg = vec4(a_start.xy, a_end.xy); "
+  "  v_widths = vec2(a_start.z, a_end.z); "
+  "  v_start_col = a_start_col; "
+  "  v_end_col = a_end_col; "
+  "  gl_Position = u_pm * vec4(v_pos, 0.0, 1.0); "
+  "}"
+  "";
+
+static const char* PAINTER_POLYLINE_FS = ""
+  "#version 330\n"
+  "uniform int u_round; "
+  "in vec2 v_pos; "
+  "in vec4 v_col; "
+  "in float v_dist; "
+  "in float v_half; "
+  "flat in vec4 v_seg; "
+  "flat in vec2 v_widths; "
+  "flat in vec4 v_start_col; "
+  "flat in vec4 v_end_col; "
+  "layout( location = 0 ) out vec4 fragcolor; "
+  ""
+  "void main() {"
+  "  float alpha; "
+  "  vec4 col; "
+  "  if (u_round == 1) { "                           /* distance to the segment: a capsule */
+  "    vec2 pa = v_pos - v_seg.xy; "
+  "    vec2 ba = v_seg.zw - v_seg.xy; "
+  "    float t = clamp(dot(pa, ba) / max(dot(ba, ba), 1e-6), 0.0, 1.0); "
+  "    alpha = clamp(0.5 * mix(v_widths.x, v_widths.y, t) - length(pa - ba * t) + 0.5, 0.0, 1.0); "
+  "    col = mix(v_start_col, v_end_col, t); "
+  "  } "
+  "  else { "
+  "    alpha = clamp(v_half - abs(v_dist) + 0.5, 0.0, 1.0); "
+  "    col = v_col; "
+  "  } "
+  "  if (alpha <= 0.0) { "
+  "    discard; "
+  "  } "
+  "  fragcolor = vec4(col.rgb, col.a * alpha); "
+  "}"
+  "";
+
+// -----------------------------------------------------
+
+class PainterCommand {
+ public:
+  GLenum type;  /* PainterContextPC: GL_TRIANGLES, GL_LINES or GL_POINTS; PainterContextPT: the texture target */
+  int offset;   /* PainterContextPC: first index; PainterContextPT: first vertex */
+  int count;
+  GLuint tex; /* the texture, in case we need to draw a texture */
+};
+
+// -----------------------------------------------------
+
+class Painter;
+
+class PainterRecorder {
+
+ public:
+  PainterRecorder(Painter& painter);                              /* records PC shapes on any thread, see Painter::recorder() */
+  void clear();                                                   /* removes the shapes but keeps the allocated memory */
+  void color(float r = 1.0, float g = 1.0, float b = 1.0, float a = 1.0);
+  void fill();
+  void nofill();
+  void rect(float x, float y, float w, float h);
+  void circle(float x, float y, float radius);                    /* uses the circle resolution of the painter, don't change it while recording */
+  void line(float x0, float y0, float x1, float y1);
+  void begin(GLenum type);
+  void vertex(float x, float y);
+  void end();
+
+ public:
+  Painter& painter;                                               /* only used to read the circle resolution */
+  std::vector<VertexPackedPC> vertices;                           /* the vertices of this recorder */
+  std::vector<uint32_t> indices;                                  /* indices into `vertices`, rebased when they are stitched */
+  std::vector<PainterCommand> commands;                           /* merged commands; offsets are relative to `indices` */
+  size_t num_commands;                                            /* number of added commands */
+  size_t first_vertex;                                            /* begin()/end(): first vertex of the current batch */
+  GLenum command_type;                                            /* begin()/end(): the primitive type */
+  uint32_t col;                                                   /* the packed draw color, initialized from the painter */
+  int state;                                                      /* PAINTER_STATE_FILL, initialized from the painter */
+};
+
+// -----------------------------------------------------
+
+class PainterContextPC {
+
+public:
+  PainterContextPC(Painter& painter);                             /* a PainterContext is used to render specific vertex data. This context renders only colors */
+  void init();                                                    /* must be called to initialize this context. */
+  void shutdown();                                                /* must be called to cleanup. */
+  void clear();                                                   /* clear all vertices */
+  size_t getUploadSize();                                         /* number of bytes update() writes into the stream buffer */
+  void update();                                                  /* writes the vertices and indices into `buffer` */
+  void draw();                                                    /* draws the buffers and commands to screen */
+  void rect(float x, float y, float w, float h);                  /* create a rectangular shape */
+  void circle(float x, float y, float radius);                    /* create a circle */
+  void line(float x0, float y0, float x1, float y1);              /* create a line */
+  void command(GLenum cmd, std::vector<VertexPackedPC>& vertices);/* adds a command (Painter calls this when using begin()/end() */
+
+private:
+  void addCommand(GLenum type, size_t first, size_t num);         /* converts the vertices [first, first + num) of the given type into an indexed list and merges it with the previous command when possible */
+
+public:
+  Painter& painter;                                               /* reference to the main Painter object */
+  StreamBuffer* buffer;                                           /* update() writes into this buffer: Painter::stream or the buffer of a PainterLayer */
+  PainterContextPC* shared;                                       /* owns the programs and vaos: this context for the Painter, the Painter's context for a layer */
+  std::vector<PainterCommand> commands;                           /* the merged draw calls: one per run of commands with the same primitive class */
+  std::vector<VertexPackedPC> vertices;                           /* the vertices, copied into the stream buffer every frame */
+  std::vector<uint32_t> indices;                                  /* triangle, line and point lists into `vertices` */
+  std::vector<PainterRecorder*> recorders;                        /* stitched after our own commands in update(), in this order */
+  std::vector<PainterCommand> draws;                              /* `commands` followed by the commands of the recorders, set in update() */
+  size_t num_commands;                                            /* number of added commands; the number of draw calls without merging */
+  size_t num_vertices;                                            /* number of vertices of this frame, including the recorders */
+  size_t num_indices;                                             /* number of indices of this frame, including the recorders */
+  size_t vertex_offset;                                           /* byte offset of the vertices of this frame in the stream buffer */
+  size_t index_offset;                                            /* byte offset of the indices of this frame in the stream buffer */
+  GLuint vao;                                                     /* the vao */
+  GLuint vert;                                                    /* our vertex shader, see PAINTER_VERTEX_PC_VS */
+  GLuint frag;                                                    /* our fragment shader, see PAINTER_VERTEX_PC_FS */
+  GLuint prog;                                                    /* the shader program, used to render our vbo */
+};
+
+// -----------------------------------------------------
+
+class PainterContextPT {
+
+ public:
+  PainterContextPT(Painter& painter);                             /* a PainterContextPT is used to render textures */
+  void init();                                                    /* must be called to initialize this context. */
+  void shutdown();                                                /* must be called to cleanup. */
+  void clear();                                                   /* clear all vertices */
+  size_t getUploadSize();                                         /* number of bytes update() writes into the stream buffer */
+  void update();                                                  /* writes the VertexPT data into `buffer` */
+  void draw();                                                    /* draws the texture */
+  void texture(GLuint tex, float x, float y, float w, float h);   /* add anther texture that should be drawn */
+  void texture(const TextureRegion& region, float x, float y, float w, float h); /* draw an image of a TextureAtlas or TextureArray */
+
+ private:
+  void addQuad(GLenum target, GLuint tex, float layer, float u0, float v0, float u1, float v1, float x, float y, float w, float h);
+  void sortCommands();                                            /* groups all quads per texture, see Painter::sortTextures() */
+
+ public:
+  Painter& painter;                                               /* reference to the main Painter object */
+  StreamBuffer* buffer;                                           /* update() writes into this buffer: Painter::stream or the buffer of a PainterLayer */
+  PainterContextPT* shared;                                       /* owns the programs and vaos: this context for the Painter, the Painter's context for a layer */
+  std::vector<PainterCommand> commands;                           /* the commands/texture draw calls. the type field contains the texture target: GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY. following textures with the same id are merged */
+  std::vector<VertexPT3> vertices;                                /* the vertices we draw; the third texcoord is the layer of a texture array */
+  std::vector<VertexPT3> sorted_vertices;                         /* scratch buffer for sortCommands() */
+  size_t num_commands;                                            /* number of added textures; the number of draw calls without merging */
+  size_t vertex_offset;                                           /* byte offset of the vertices of this frame in the stream buffer */
+  GLuint vao;                                                     /* our vao, that contains the vertex info */
+  GLuint vert;                                                    /* vertex shader for vertexpt data */  
+  GLuint frag;                                                    /* fragment shader for the vertexpt data */
+  GLuint prog;                                                    /* the shader program that draws the texture */
+  GLuint frag_array;                                              /* fragment shader for GL_TEXTURE_2D_ARRAY */
+  GLuint prog_array;                                              /* the shader program that draws the layers of a texture array */
+};
+
+// -----------------------------------------------------
+
+struct PainterInstance {                                          /* one instanced rect or circle, 20 bytes */
+  float rect[4];                                                  /* rect: x, y, w, h; circle: center x, center y, radius, radius */
+  uint32_t color;                                                 /* RGBA8, r in the lowest byte */
+};
+
+struct PainterSDFInstance {                                       /* one SDF rect, rounded rect or circle, 28 bytes */
+  float rect[4];                                                  /* bounds: x, y, w, h */
+  float radius;                                                   /* corner radius, half the size for a circle */
+  float stroke;                                                   /* outline width, 0 when filled */
+  uint32_t color;                                                 /* RGBA8, r in the lowest byte */
+};
+
+class PainterContextInstanced {
+
+ public:
+  PainterContextInstanced(Painter& painter);                      /* draws rects and circles with instancing, see Painter::instanced() */
+  void init();                                                    /* must be called to initialize this context. */
+  void shutdown();                                                /* must be called to cleanup. */
+  void clear();                                                   /* clear all instances */
+  size_t getUploadSize();                                         /* number of bytes update() writes into the stream buffer */
+  void update();                                                  /* writes the instances into `buffer` */
+  void draw();                                                    /* updates the shared unit meshes when the circle resolution changed; one glDrawArraysInstanced() per shape kind */
+  void rect(float x, float y, float w, float h);                  /* adds a rect instance, filled or outlined depending on the painter state */
+  void circle(float x, float y, float radius);                    /* adds a circle instance */
+  void sdfRect(float x, float y, float w, float h, float radius); /* adds a (rounded) SDF rect, filled or outlined depending on the painter state */
+  void sdfCircle(float x, float y, float radius);                 /* adds a SDF circle or ring */
+
+ private:
+  void createMeshes();                                            /* creates the unit meshes for all shape kinds */
+
+ public:
+  Painter& painter;                                               /* reference to the main Painter object */
+  StreamBuffer* buffer;                                           /* update() writes into this buffer: Painter::stream or the buffer of a PainterLayer */
+  PainterContextInstanced* shared;                                /* owns the programs and vaos: this context for the Painter, the Painter's context for a layer */
+  std::vector<PainterInstance> instances[PAINTER_SHAPE_COUNT];    /* the instances per shape kind */
+  size_t instance_offsets[PAINTER_SHAPE_COUNT];                   /* byte offset of the instances of each kind in the stream buffer */
+  std::vector<PainterSDFInstance> sdf_instances;                  /* the SDF shapes, see Painter::sdf() */
+  size_t sdf_offset;                                              /* byte offset of the SDF instances in the stream buffer */
+  GLenum mesh_types[PAINTER_SHAPE_COUNT];                         /* primitive type of the unit mesh of each kind */
+  GLint mesh_offsets[PAINTER_SHAPE_COUNT];                        /* first vertex of the unit mesh of each kind in `mesh_vbo` */
+  GLsizei mesh_counts[PAINTER_SHAPE_COUNT];                       /* number of vertices of the unit mesh of each kind */
+  int mesh_resolution;                                            /* circle resolution of the unit meshes */
+  GLuint vao;                                                     /* the vao */
+  GLuint mesh_vbo;                                                /* the unit meshes (vec2) */
+  GLuint vert;                                                    /* our vertex shader, see PAINTER_INSTANCED_VS */
+  GLuint frag;                                                    /* our fragment shader, see PAINTER_VERTEX_PC_FS */
+  GLuint prog;                                                    /* the shader program */
+  GLuint sdf_vao;                                                 /* the vao for the SDF shapes; uses the unit quad of `mesh_vbo` */
+  GLuint sdf_vert;                                                /* see PAINTER_SDF_VS */
+  GLuint sdf_frag;                                                /* see PAINTER_SDF_FS */
+  GLuint sdf_prog;
+};
+
+// -----------------------------------------------------
+
+struct PainterPolylinePoint {                                     /* one point of the center line of a polyline, 16 bytes */
+  float pos[2];
+  float width;                                                    /* line width at this point; < 0 for the padding points around a polyline */
+  uint32_t color;                                                 /* RGBA8, r in the lowest byte */
+};
+
+class PainterContextPolyline {
+
+ public:
+  PainterContextPolyline(Painter& painter);                       /* draws thick antialiased polylines, see Painter::polyline() */
+  void init();                                                    /* must be called to initialize this context. */
+  void shutdown();                                                /* must be called to cleanup. */
+  void clear();                                                   /* clear all points */
+  size_t getUploadSize();                                         /* number of bytes update() writes into the stream buffer */
+  void update();                                                  /* writes the points into `buffer` */
+  void draw();                                                    /* one glDrawArraysInstanced() per join type */
+  void line(float x0, float y0, float x1, float y1);              /* adds a polyline of two points with the current width and color */
+  void polyline(const PainterPolylinePoint* points, size_t num, bool closed); /* adds a polyline; closed connects the last point with the first */
+
+ public:
+  Painter& painter;                                               /* reference to the main Painter object */
+  StreamBuffer* buffer;                                           /* update() writes into this buffer: Painter::stream or the buffer of a PainterLayer */
+  PainterContextPolyline* shared;                                 /* owns the programs and vaos: this context for the Painter, the Painter's context for a layer */
+  std::vector<PainterPolylinePoint> points[PAINTER_JOIN_COUNT];   /* all polylines per join type, each one with a padding point before and after it */
+  size_t point_offsets[PAINTER_JOIN_COUNT];                       /* byte offset of the points of each join type in the stream buffer */
+  size_t num_polylines;                                           /* number of added polylines */
+  GLuint vao;                                                     /* only per instance attributes */
+  GLuint vert;                                                    /* see PAINTER_POLYLINE_VS */
+  GLuint frag;                                                    /* see PAINTER_POLYLINE_FS */
+  GLuint prog;
+  GLint u_round;                                                  /* location of the join type uniform */
+};
+
+// -----------------------------------------------------
+
+class PainterLayer {
+
+ public:
+  PainterLayer(Painter& painter, std::string name);               /* a named set of contexts with their own buffer, see Painter::layer() */
+  void init();                                                    /* creates the buffer of this layer; the programs and vaos of the Painter are shared */
+  void shutdown();                                                /* must be called to cleanup. */
+  void clear();                                                   /* removes all shapes from this layer */
+  void update();                                                  /* uploads the shapes when the layer is dirty */
+  void draw();                                                    /* draws the layer when it's visible */
+
+ public:
+  std::string name;                                               /* the name, see Painter::layer() */
+  int order;                                                      /* draw order; lower first, < 0 is drawn before the shapes that are not in a layer */
+  bool is_dirty;                                                  /* true when shapes were added or removed since the last upload */
+  bool is_visible;                                                /* see Painter::showLayer() and Painter::hideLayer() */
+  size_t num_uploads;                                             /* number of times the layer was uploaded */
+  StreamBuffer buffer;                                            /* holds the vertices, indices and instances of this layer */
+  PainterContextPC context_pc;
+  PainterContextPT context_pt;
+  PainterContextInstanced context_instanced;
+  PainterContextPolyline context_polyline;
+};
+
+// -----------------------------------------------------
+
+// Shared GL data
+struct PainterShared {
+  mat4 pm;
+};
+
+// -----------------------------------------------------
+
+class Painter {
+
+ public:
+  Painter();
+  void init();                                                                      /* must be called to initialize some GL objects we need. */
+  void shutdown();                                                                  /* must be called to cleanup the Painter .*/
+  void clear();                                                                     /* clear all vertices */
+  void draw();                                                                      /* draw all the added lines, circles, textures etc.. */
+  void rect(float x, float y, float w, float h);                                    /* draw a rectangle */
+  void circle(float x, float y, float radius);                                      /* draw a circle, see resolution() to change the resolution of the circle */
+  void line(float x0, float y0, float x1, float y1);                                /* draw a single line, see begin()/end() if you want to draw line strips */
+  void texture(GLuint tex, float x, float y, float w, float h);                     /* draw a texture, at the time of writing only GL_TEXTURE_2D is supported */
+  void texture(const TextureRegion& region, float x, float y, float w, float h);    /* draw an image from a TextureAtlas or TextureArray */
+
+  void begin(GLenum type);                                                          /* begin a batch of vertices, just like the old days  */
+  void vertex(float x, float y);                                                    /* add a vertex to the current batch */
+  void end();                                                                       /* end the current batch; this will flush the added vertices into the correct context */
+
+  void color(float r = 1.0, float g = 1.0, float b = 1.0, float a = 1.0);           /* set the color of lines, circles, rectangles */
+  void rgba(int r = 255, int g = 255, int b = 255, int a = 255);                    /* set the color of lines, circles, rectangles, etc.. using RGB values in range [0,255] */
+  void hex(std::string hexstr);                                                     /* set the color of lines, circles, rectangles, etc.. using a HEX string, e.g. `484A47` for rgb, or 484A47FF for rgba. */
+  void fill();                                                                      /* enable fill mode */
+  void nofill();                                                                    /* disable fill mode */
+  void instanced();                                                                 /* draw rects and circles with instancing, see PainterContextInstanced */
+  void noinstanced();                                                               /* draw rects and circles as vertices (default) */
+  void sdf();                                                                       /* draw rects and circles as antialiased quads using a signed distance field */
+  void nosdf();                                                                     /* draw rects and circles as vertices or instances again (default) */
+  void roundedRect(float x, float y, float w, float h, float radius);               /* draw a rounded rectangle, always drawn with the SDF path */
+  void lineWidth(float w);                                                          /* set the outline width of SDF shapes and the width of polylines */
+  void polyline();                                                                  /* draw lines as thick antialiased polylines, see PainterContextPolyline */
+  void nopolyline();                                                                /* draw lines with GL_LINES again (default) */
+  void polyline(const vec2* points, size_t num, bool closed = false);               /* add a polyline with the current color and width, always drawn as thick line */
+  void lineJoin(int join);                                                          /* PAINTER_JOIN_MITER or PAINTER_JOIN_ROUND */
+  PainterRecorder* recorder();                                                      /* returns a cleared recorder that can be filled on another thread; call on the main thread */
+  void sortTextures(bool flag);                                                     /* when true, all textures are grouped per texture (atlas page) before drawing; textures don't keep their order then */
+  void cull();                                                                      /* don't add shapes that are outside the viewport (see resize()) and cull rect, or smaller than the cull size */
+  void nocull();                                                                    /* add all shapes again (default) */
+  void cullRect(float x, float y, float w, float h);                                /* only keep shapes that overlap this rect (and the viewport); shapes are not clipped */
+  void nocullRect();                                                                /* cull against the viewport only (default) */
+  void cullSize(float size);                                                        /* shapes whose width and height are smaller than this are rejected, e.g. 1 pixel; 0 disables (default) */
+  bool isCulled(float x0, float y0, float x1, float y1, float margin);              /* true when culling is enabled and the bounds (plus margin for outlines) are culled or rejected; updates the stats */
+  void setDirty();                                                                  /* marks the active layer, or the shapes without layer, as changed so draw() writes them into the buffer again */
+
+  void layer(std::string name);                                                     /* draw into the given layer, it's created when it doesn't exist yet; also works before init() or without GL context */
+  void nolayer();                                                                   /* draw the next shapes without layer again; they are removed by clear() */
+  void clearLayer(std::string name);                                                /* remove all shapes from the given layer */
+  void layerOrder(std::string name, int order);                                     /* set the draw order of a layer, lower first */
+  void showLayer(std::string name);                                                 /* draw the layer (default) */
+  void hideLayer(std::string name);                                                 /* don't draw the layer, but keep its shapes */
+  PainterLayer* getLayer(std::string name);                                         /* returns the layer or NULL when it doesn't exist */
+  void resize(int w, int h);                                                        /* whenever your viewport changes, call this so we can recalculate the projection matrix */
+  void resolution(int n);                                                           /* set the circle resolution */
+  uint32_t packColor();                                                             /* returns the current color as RGBA8, see packed_col */
+  void print();                                                                     /* prints the number of draw calls before and after merging */
+
+  int width();                                                                      /* returns the last set/calculated viewport width */
+  int height();                                                                     /* returns the last set/calculated viewport height */
+
+ public:
+  PainterContextPC context_pc;                                                      /* context used to draw VertexPackedPC vertices (color) */
+  PainterContextPT context_pt;                                                      /* context used to draw VertexPT vertices (textures) */
+  PainterContextInstanced context_instanced;                                        /* context used to draw instanced rects and circles */
+  PainterContextPolyline context_polyline;                                          /* context used to draw thick lines */
+  std::vector<PainterLayer*> layers;                                                /* the layers, sorted on order */
+  std::vector<PainterRecorder*> recorder_pool;                                      /* all recorders we created; reused every frame so their memory stays allocated */
+  size_t num_recorders;                                                             /* number of recorders handed out since the last clear() */
+  PainterLayer* active_layer;                                                       /* the layer we draw into, NULL when we don't use a layer */
+  PainterContextPC* active_pc;                                                      /* the PC context of the active layer or context_pc */
+  PainterContextPT* active_pt;                                                      /* the PT context of the active layer or context_pt */
+  PainterContextInstanced* active_instanced;                                        /* the instanced context of the active layer or context_instanced */
+  PainterContextPolyline* active_polyline;                                          /* the polyline context of the active layer or context_polyline */
+  int circle_resolution;                                                            /* the last set circle resolution */
+  float line_width;                                                                 /* outline width of SDF shapes and width of polylines, see lineWidth() */
+  int line_join;                                                                    /* PAINTER_JOIN_MITER or PAINTER_JOIN_ROUND, see lineJoin() */
+  bool sort_textures;                                                               /* see sortTextures() */
+  bool has_cull_rect;                                                               /* true when cullRect() is set */
+  float cull_rect[4];                                                               /* x, y, w, h, see cullRect() */
+  float cull_size;                                                                  /* see cullSize() */
+  size_t num_culled;                                                                /* shapes outside the viewport or cull rect since the last clear() */
+  size_t num_rejected;                                                              /* shapes smaller than `cull_size` since the last clear() */
+  vec4 col;                                                                         /* the color we use to draw with */
+  uint32_t packed_col;                                                              /* `col` as RGBA8, set by color(), rgba() and hex() */
+  int state;                                                                        /* keeps state of the painter; e.g. fill/nofill */
+  GLuint ubo;                                                                       /* shared uniform buffer object with matrice(s) */
+  StreamBuffer stream;                                                              /* the vertices, indices and instances of all contexts are streamed through this buffer */
+  bool needs_update;                                                                /* true when the shapes without layer changed since they were written into `stream` */
+  bool is_streamed;                                                                 /* true when `stream` holds the current shapes without layer */
+  PainterShared ubo_data;                                                           /* the actual data for our ubo */
+  std::vector<vec2> circle_data;                                                    /* pre-calculated sin/cos values for our circle; just a tiny bit of optimization */
+  int win_w;                                                                        /* the last calculated or set viewport width */
+  int win_h;                                                                        /* the last calculated or set viewport height */
+
+  /* begin() - end() handling */
+  GLenum command_type;                                                              /* when begin() is called we store the command type. the next call to vertex defines what PainterContext we will use; for now only default is used */
+  int context_type;                                                                 /* when begin()/end() is used, a call to one of the overloaded vertex() function will define what context will be used. in end() we add the added vertices to the correct context */
+  std::vector<VertexPackedPC> vertices_pc;                                          /* VertexPackedPC vertices for our PC context */ 
+  std::vector<PainterPolylinePoint> polyline_points;                                /* points for our polyline context */
+};
+
+/*
+  PainterRasterizer
+  -----------------
+
+  Renders what a Painter recorded on the CPU into a RGBA8 buffer, for 
+  headless machines without a GL context or for tests. Recording shapes 
+  doesn't use GL, so a Painter that is never init()-ed can be used with 
+  this class; layers work too, they only create their buffer when the 
+  Painter is initialized. draw() reads the same data as Painter::draw(): 
+  the indexed commands of PainterContextPC (including the recorders), the instances, 
+  SDF shapes, polylines and textures, in the same order, and blends them
+  with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA. Painter coordinates are used
+  as pixels; the first row of `pixels` is the top of the image.
+
+  Every shape is first turned into primitives: triangles with edge 
+  functions (rects, fans, lines and points of 1 pixel wide, textures) or 
+  shapes that are evaluated per pixel (SDF shapes and polyline segments, 
+  which are drawn as capsules for both join types). The primitives are 
+  binned into tiles of PAINTER_RASTER_TILE_SIZE pixels and the tiles are 
+  rasterized in parallel with rx_parallel_for(); every tile handles its
+  primitives in order so the result doesn't depend on the number of 
+  threads. With SSE2, the edge functions are evaluated for 4 pixels at 
+  once. Textures must be added with addTexture() because we can't read 
+  GL textures; texture arrays aren't supported.
+
+  ````c++
+  Painter painter;             // no init(), no GL context needed
+  PainterRasterizer raster;
+  raster.init(1024, 768);
+
+  painter.fill();
+  painter.circle(100, 100, 50);
+
+  raster.clear(0, 0, 0, 1);
+  raster.draw(painter);
+  raster.save("overlay.png"); // needs ROXLU_USE_PNG
+  raster.print();             // shapes per second
+  raster.benchmark(painter);  // the same, but the fastest and average of 10 draws
+  ````
+ */
+
+#define PAINTER_RASTER_TILE_SIZE 64
+#define PAINTER_RASTER_TRIANGLE 0   /* primitive types of PainterRasterPrim */
+#define PAINTER_RASTER_SDF 1
+#define PAINTER_RASTER_CAPSULE 2
+
+struct PainterRasterTexture {                                                       /* CPU copy of a texture, see PainterRasterizer::addTexture() */
+  int width;
+  int height;
+  std::vector<unsigned char> pixels;                                                /* RGBA8 */
+};
+
+struct PainterRasterPrim {
+  int type;                                                                         /* PAINTER_RASTER_TRIANGLE, PAINTER_RASTER_SDF or PAINTER_RASTER_CAPSULE */
+  int bbox[4];                                                                      /* x0, y0, x1, y1 in pixels, clipped; x1 and y1 are exclusive */
+  PainterRasterTexture* texture;                                                    /* textured triangles, NULL otherwise */
+  bool is_flat;                                                                     /* all vertices have the same color */
+  bool include[3];                                                                  /* top-left rule: pixels exactly on this edge are inside */
+  float edges[9];                                                                   /* triangle: A, B, C per edge; inside when A * x + B * y + C >= 0 */
+  float inv_area;                                                                   /* triangle: 1 / (sum of the edge functions) */
+  float col[12];                                                                    /* triangle: rgba per vertex; sdf: col[0-3]; capsule: start and end color */
+  float uv[6];                                                                      /* triangle: texcoords per vertex */
+  float shape[6];                                                                   /* sdf: center x, y, half w, h, radius, stroke; capsule: ax, ay, bx, by, start width, end width */
+};
+
+class PainterRasterizer {
+ public:
+  PainterRasterizer();
+  bool init(int w, int h, int numThreads = 0);                                      /* numThreads is passed to rx_parallel_for(), 0 = one per core */
+  void shutdown();
+  void clear(float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 1.0f);       /* fills the buffer with a color */
+  void addTexture(GLuint tex, int w, int h, unsigned char* rgba);                   /* copies the pixels that are used when the painter draws `tex` */
+  void draw(Painter& painter);                                                      /* rasterizes everything the painter would draw in Painter::draw() */
+  void print();                                                                     /* prints the number of shapes and primitives, the timings and shapes per second of the last draw() */
+  void benchmark(Painter& painter, int numRuns = 10);                               /* draws numRuns times and prints the fastest and average timings; the pixels end up the same as after one draw() */
+#if defined(ROXLU_USE_PNG)
+  bool save(std::string filepath);                                                  /* saves the buffer using rx_save_png() */
+#endif
+
+ private:
+  void addContexts(PainterContextPC& pc, PainterContextPolyline& polyline, PainterContextInstanced& instanced, PainterContextPT& pt);
+  void addIndexed(const std::vector<VertexPackedPC>& vertices, const std::vector<uint32_t>& indices, const std::vector<PainterCommand>& commands);
+  void addTriangle(const float* p0, const float* p1, const float* p2, const float* c0, const float* c1, const float* c2, const float* uv, PainterRasterTexture* texture);
+  void addQuad(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, const float* col);
+  void addLine(float x0, float y0, float x1, float y1, const float* col);         /* a line of 1 pixel wide, like GL_LINES */
+  void addSDF(const PainterSDFInstance& inst);
+  void addCapsule(const PainterPolylinePoint& a, const PainterPolylinePoint& b);
+  bool clip(PainterRasterPrim& prim, float minX, float minY, float maxX, float maxY);
+  void rasterizeTile(int tile);
+  void rasterizeTriangle(const PainterRasterPrim& prim, int x0, int y0, int x1, int y1);
+  void rasterizeShape(const PainterRasterPrim& prim, int x0, int y0, int x1, int y1);
+  static void rasterizeJob(int dx, void* user);
+
+ public:
+  int width;
+  int height;
+  int num_threads;
+  int tiles_x;
+  int tiles_y;
+  std::vector<unsigned char> pixels;                                                /* RGBA8, the first row is the top */
+  std::vector<PainterRasterPrim> prims;                                             /* the primitives of the last draw() */
+  std::vector<std::vector<uint32_t> > bins;                                         /* per tile the indices into `prims` */
+  std::map<GLuint, PainterRasterTexture> textures;
+  size_t num_shapes;                                                                /* number of shapes in the last draw() */
+  uint64_t setup_time;                                                              /* ns spent on creating and binning primitives */
+  uint64_t raster_time;                                                             /* ns spent on rasterizing the tiles */
+};
+
+#  endif // ROXLU_USE_OPENGL_MATH_H
+#endif // defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_MATH)
+
+// ------------------------------------------------------------------------------------
+//                              R O X L U _ U S E _ O P E N G L 
+//                              R O X L U _ U S E _ P N G 
+// ------------------------------------------------------------------------------------
+
+#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_PNG)
+#  ifndef ROXLU_USE_OPENGL_PNG_H
+#  define ROXLU_USE_OPENGL_PNG_H
+
+extern GLuint rx_create_texture(std::string filepath, int internalFormat = -1, int format = -1, int type = -1);
+extern bool rx_create_png_screenshot(std::string filepath); 
+
+#  endif // ROXLU_USE_OPENGL_PNG_H
+#endif // defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_PNG)
+
+
+// ------------------------------------------------------------------------------------
+//                              R O X L U _ U S E _ O P E N G L 
+//                              R O X L U _ U S E _ J P G
+// ------------------------------------------------------------------------------------
+
+#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_JPG)
+#  ifndef ROXLU_USE_OPENGL_JPG_H
+#  define ROXLU_USE_OPENGL_JPG_H
+
+extern bool rx_create_jpg_screenshot(std::string filepath, int quality = 80); 
+
+#  endif // ROXLU_USE_OPENGL_JPG_H
+#endif // defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_JPG)
+
+
+// ------------------------------------------------------------------------------------
+//                              R O X L U _ U S E _ A U D I O 
+// ------------------------------------------------------------------------------------
+
+#if defined(ROXLU_USE_AUDIO)
+#  ifndef ROXLU_USE_AUDIO_H
+#  define ROXLU_USE_AUDIO_H
+#  include <sndfile.h>
+#  include <cubeb/cubeb.h>
+#  if defined(__APPLE__) or defined(__linux)
+#    include <pthread.h>
+#  endif
+
+/*
+
+  AudioPlayer
+  -----------
+  
+  The audio player uses libsndfile and libcubeb (Firefox' audio output layer) to 
+  load and playback audio files. At this moment we only support audio files with 
+  a samplerate of 44100, 2 channels. 
+
+  On Mac you must link with:
+  --------------------------
+  - cubeb (https://github.com/kinetiknz/cubeb)
+  - pthreads
+  - AudioUnit framework
+  - CoreAudio framework
+  - AudioToolbox framework
+
+  On Linux you must link with (depending how you compiled libsndfile):
+  -------------------------------------------------------------------
+  -lz
+  -lpthread
+  -logg
+  -lvorbis
+  -lvorbisenc
+  -lFLAC
+  -ldl
+  -lasound
+
+
+  High level description:
+  -----------------------
+  AudioPlayer:         interface that is supposed to use to add audio files and play them
+  AudioFile:           holds a buffer (data) with float (2-channel) audio
+  AudioPlaybackState:  a user can play the same audio file multiple times; this object keeps 
+                       track of the current read position in the AudioFile.data member
+
+  ````c++
+  AudioPlayer player;
+
+  player.add(0, "boing.wav");
+  player.add(1, "bleep.wav");
+  player.add(2, "zweeep.wav");
+
+  AudioPlaybackState* state = player.play(0);
+  if(state) {
+     state->volume(0.5);
+  }
+  ````                       
+
+*/
+
+class AudioPlayer;
+
+long audioplayer_data_cb(cubeb_stream* stm, void* user, void* buffer, long nframes);      /* The callback that gets called by cubeb that whenever it wants some more audio data */
+void audioplayer_state_cb(cubeb_stream* stm, void* user, cubeb_state state);              /* Is called whenever a stream starts or stops */
+
+/* ----------------------------------- */
+
+class AudioFile {                                                                         /* An AudioFile will hold the raw loaded audio data */
+ public:
+  AudioFile();
+  bool load(std::string filepath);                                                        /* Loads the given audio filepath usign libsnd file */
+
+ public:
+  SNDFILE* sf;                                                                            /* Handle to the sound file */
+  SF_INFO info;                                                                           /* Contains information about the loaded sound file. See libsndfile documentation for more info */
+  std::vector<float> data;                                                                /* The raw audio data */
+};
+
+/* ----------------------------------- */
+
+class AudioPlaybackState {                                                                /* Everytime you call AudioPlayer::play() we create a new AudioPlaybackState instance that keeps track of the read position for this sample */
+ public: 
+  AudioPlaybackState(int name, AudioFile* file);                                          /* C'tor; pass the name of the audio file and a pointer to the actual AudioFile itself that contains the audio data */
+  ~AudioPlaybackState();
+  void volume(float level) ;                                                              /* Set the volume: 0 - off, 1.0 full */
+
+ public:
+  AudioFile* file;                                                                        /* Pointer to the audio file */
+  size_t read_pos;                                                                        /* The current read position in the file->data member. */
+  float volume_level;                                                                     /* Each playstate keeps track of it's own volume */
+  int name;                                                                               /* The name of the audio file that we play (a redundant, easy helper) */
+};
+
+/* ----------------------------------- */
+
+class AudioPlayer {                                                                       /* The AudioPlayer manages all the audio files and states. */
+ public:
+  AudioPlayer();                                                                          /* C'tor, creates the necessary cubeb context and stream. */
+  ~AudioPlayer();                                                                         /* D'tor, cleans up all allocated members. */
+  bool add(int name, std::string filepath);                                               /* Add a new audio file for the given name and filepath. Note that we use libsndfile to load the audio files. */
+  AudioPlaybackState* play(int name, float volume = 1.0);                                 /* Playback the given audio name. We return the state object on which you can set the volume. On error we return NULL. */
+  void lock();                                                                            /* Locks a mutex; used to sync access to the play_states member. */
+  void unlock();                                                                          /* Unlocks a mutex; "" "" "" */
+
+ public:
+  cubeb* cube_ctx;                                                                        /* The cubeb state */
+  cubeb_stream* cube_stream;                                                              /* The cubeb_stream to playback the audio samples. We only have one stream. */
+  std::map<int, AudioFile*> files;                                                        /* The added files */
+  std::vector<AudioPlaybackState*> play_states;                                           /* The playback states; each state keeps track of what frames to play and the volume */
+
+#if defined(__APPLE__) or defined(__linux) 
+  pthread_mutex_t mutex;                                                                  /* Used to lock the mutex to protect the play_states member. */
+#endif  
+};
+
+#  endif // ROXLU_USE_AUDIO_H
+#endif // defined(ROXLU_USE_AUDIO)
+
+
+// ------------------------------------------------------------------------------------
+//                              R O X L U _ U S E _ L O G
+// ------------------------------------------------------------------------------------
+#if defined(ROXLU_USE_LOG)
+#  ifndef ROXLU_USE_LOG_H
+#  define ROXLU_USE_LOG_H
+
+#define RX_LOG_LEVEL_ALL 4
+#define RX_LOG_LEVEL_ERROR  1
+#define RX_LOG_LEVEL_WARNING 2
+#define RX_LOG_LEVEL_VERBOSE 3
+
+#if defined(_MSC_VER)
+#  define RX_VERBOSE(fmt, ...) { rx_verbose(__LINE__, __FUNCSIG__, fmt, ##__VA_ARGS__); } 
+#  define RX_WARNING(fmt, ...) { rx_warning(__LINE__, __FUNCSIG__, fmt, ##__VA_ARGS__); } 
+#  define RX_ERROR(fmt, ...) { rx_error(__LINE__, __FUNCSIG__, fmt, ##__VA_ARGS__); } 
+#else                                                                             
+#  define RX_VERBOSE(fmt, ...) { rx_verbose(__LINE__, __PRETTY_FUNCTION__, fmt, ##__VA_ARGS__); } 
+#  define RX_WARNING(fmt, ...) { rx_warning(__LINE__, __PRETTY_FUNCTION__, fmt, ##__VA_ARGS__); } 
+#  define RX_ERROR(fmt, ...) { rx_error(__LINE__, __PRETTY_FUNCTION__, fmt, ##__VA_ARGS__); } 
+#endif
+
+/* --------------------------------------------------------------------------------- */
+
+int rx_log_init(std::string path = "");
+void rx_log_disable_stdout();
+void rx_log_enable_stdout();
+void rx_log_set_level(int level);
+void rx_verbose(int line, const char* function, const char* fmt, ...);
+void rx_warning(int line, const char* function, const char* fmt, ...);
+void rx_error(int line, const char* function, const char* fmt, ...);
+
+/* --------------------------------------------------------------------------------- */
+
+class Log {
+ public:
+  Log();
+  ~Log();
+  int open(std::string filepath);
+  void log(int level, int line, const char* function, const char* fmt, va_list args);
+
+ public:
+  bool write_to_stdout;
+  int level;                   /* what level we should log. */
+
+ private:
+  std::string filepath;        /* filepath where we save the log file. */
+  std::ofstream ofs;           /* the output file stream */
+};
+
+/* --------------------------------------------------------------------------------- */
+
+extern Log rx_log;
+
+#  endif // ROXLU_USE_LOG_H
+#endif // defined(ROXLU_USE_LOG) 
+
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//                          I M P L E M E N T A T I O N
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+// ====================================================================================
+//                              T I N Y L I B 
+// ====================================================================================
+
+#if defined(ROXLU_IMPLEMENTATION)
+
+#if defined(_WIN32) 
+extern std::string rx_get_exe_path() {
+  char buffer[MAX_PATH];
+
+  // Try to get the executable path with a buffer of MAX_PATH characters.
+  DWORD result = ::GetModuleFileNameA(nullptr, buffer, static_cast<DWORD>(MAX_PATH));
+  if(result == 0) {
+    return "";
+  }
+
+  std::string::size_type pos = std::string(buffer).find_last_of( "\\/" );
+
+  return std::string(buffer).substr(0, pos) +"\\";
+}
+#elif defined(__APPLE__) 
+extern std::string rx_get_exe_path() {
+  char buffer[1024];
+  uint32_t usize = sizeof(buffer);;
+
+  int result;
+  char* path;
+  char* fullpath;
+
+  result = _NSGetExecutablePath(buffer, &usize);
+  if (result) {
+    return "";
+  }
+
+  path = (char*)malloc(2 * PATH_MAX);
+  fullpath = realpath(buffer, path);
+
+  if (fullpath == NULL) {
+    free(path);
+    return "";
+  }
+  strncpy(buffer, fullpath, usize);
+
+  const char* dn = dirname(buffer);
+  usize = strlen(dn);
+  std::string ret(dn, usize) ;
+  ret.push_back('/');
+
+  free(path);
+  return ret;
+}
+#elif defined(__linux) 
+extern std::string rx_get_exe_path() {
+  char buffer[MAX_PATH];
+  size_t size = MAX_PATH;
+  ssize_t n = readlink("/proc/self/exe", buffer, size - 1);
+  if (n <= 0) {
+    return "";
+  }
+  buffer[n] = '\0';
+
+
+  const char* dn = dirname(buffer);
+  size = strlen(dn);
+  std::string ret(dn, size) ;
+  ret.push_back('/');
+  return ret;
+}
+#endif // rx_get_exe_path() / win32
+
+extern bool rx_file_exists(std::string filepath) {
+
+#if defined(_WIN32)
+  char* lptr = (char*)filepath.c_str();
+  DWORD dwattrib = GetFileAttributes(lptr);
+  return (dwattrib != INVALID_FILE_ATTRIBUTES && !(dwattrib & FILE_ATTRIBUTE_DIRECTORY));
+
+#elif defined(__APPLE__)
+  int res = access(filepath.c_str(), R_OK);
+  if(res < 0) {
+    return false;
+  }
+#else
+  struct stat buffer;   
+  return (stat(filepath.c_str(), &buffer) == 0);
+#endif
+
+  return true;
+}
+
+#if defined(WIN32) 
+extern bool rx_is_dir(std::string filepath) {
+  DWORD type = GetFileAttributesA(filepath.c_str());
+  if (type & FILE_ATTRIBUTE_DIRECTORY) {
+    return true; 
+  }
+  if (type & INVALID_FILE_ATTRIBUTES) {
+    return false; 
+  }
+  return false;
+}
+#else
+extern bool rx_is_dir(std::string filepath) {
+  struct stat st;
+  int result = stat(filepath.c_str(), &st);
+
+  if(result < 0) {
+    if(errno == EACCES) {
+      printf("EACCESS: no permission for: %s", filepath.c_str());
+    }
+    else if(errno == EFAULT) {
+      printf("EFAULT: bad address, for: %s", filepath.c_str());
+    }
+    else if(errno == ELOOP) {
+      printf("ELOOP: too many links, for: %s", filepath.c_str());
+    }
+    else if(errno == ENAMETOOLONG) {
+      printf("ENAMETOOLONG: for: %s", filepath.c_str());
+    }
+    else if(errno == ENOENT) {
+      // we expect this when the dir doesn't exist
+      return false;
+    }
+    else if(errno == ENOMEM) {
+      printf("ENOMEM: for: %s", filepath.c_str());
+    }
+    else if(errno == ENOTDIR) {
+      printf("ENOTDIR: for: %s", filepath.c_str());
+    }
+    else if(errno == EOVERFLOW) {
+      printf("EOVERFLOW: for: %s", filepath.c_str());
+    }
+
+    return false;
+  }
+
+#if defined(__APPLE__) or defined(__linux__)
+  return S_ISDIR(st.st_mode);
+#else 
+  return result == 0;
+#endif  
+}
+#endif // !defined(WIN32) for rx_is_dir()
+
+extern std::string rx_to_data_path(const std::string filename) {
+
+  std::string data_path = rx_get_data_path();
+  if (0 != data_path.size()) {
+    return data_path + filename;
+  }
+
+  data_path = rx_get_exe_path();
+
+#if defined(__APPLE__)
+  if(rx_is_dir(data_path +"data")) {
+    data_path += "data/" +filename;
+  }
+  else if(rx_is_dir(data_path +"../MacOS")) {
+    /* When we're part of an .app bundle, the Resources dir is our data dir. */
+    data_path += "../Resources/" +filename;
+  }
+  else {
+    data_path += filename;
+  }
+#elif defined(__linux)
+  data_path += "data/" +filename;
+#else 
+  data_path += "data\\" +filename;
+#endif  
+
+  return data_path;
+}
+
+std::string rx_data_path = "";
+
+extern void rx_set_data_path(const std::string path) {
+  rx_data_path = path;
+}
+
+extern std::string rx_get_data_path() {
+  
+  return rx_data_path;
+}
+
+/* See http://stackoverflow.com/questions/4021479/getting-file-modification-time-on-unix-using-utime-in-c */
+/* returns the unix epoc time stamp in nano seconds */
+extern uint64_t rx_get_file_mtime(std::string filepath) {
+#if defined(_WIN32)
+  struct _stat statbuf;
+  if (_stat(filepath.c_str(), &statbuf) == -1) {
+    return 0;
+  }
+  return statbuf.st_mtime * 1e6;
+#else  
+  struct stat statbuf;
+  if (stat(filepath.c_str(), &statbuf) == -1) {
+    return 0;
+  }
+  return statbuf.st_mtime * 1e6;
+#endif
+}
+
+extern uint64_t rx_get_file_size(std::string filepath) {
+#if defined(_WIN32)
+  struct _stat64 statbuf;
+  if (_stat64(filepath.c_str(), &statbuf) == -1) {
+    return 0;
+  }
+  return statbuf.st_size;
+#else  
+  struct stat statbuf;
+  if (stat(filepath.c_str(), &statbuf) == -1) {
+    return 0;
+  }
+  return statbuf.st_size;
+#endif
+}
+
+extern std::string rx_string_replace(std::string str, std::string from, std::string to) {
+  size_t start_pos = str.find(from);
+  if(start_pos == std::string::npos) {
+    return str;
+  }
+  str.replace(start_pos, from.length(), to);
+  return str;
+}
+
+extern std::string rx_string_replace(std::string str, char from, char to) {
+  std::replace(str.begin(), str.end(), from, to);
+  return str;
+}
+
+extern std::string rx_strip_filename(std::string path) {
+  std::string directory;
+  path = rx_string_replace(path, '\\', '/');
+  path = rx_string_replace(path, "//", "/");
+  const size_t last_slash_idx = path.rfind('/');
+
+  if(std::string::npos != last_slash_idx) {
+    directory = path.substr(0, last_slash_idx + 1);
+  }
+
+#if defined(_WIN32)
+  directory = rx_string_replace(directory, '/', '\\');
+#endif
+
+  return directory;
+}
+
+extern std::string rx_strip_file_ext(std::string path) {
+  std::string ext = "." +rx_get_file_ext(path);
+  std::string result = rx_string_replace(path, ext, "");
+  return result;
+}
+
+extern std::string rx_strip_dir(std::string path) {
+  std::string filename;;
+  path = rx_string_replace(path, '\\', '/');
+  path = rx_string_replace(path, "//", "/");
+
+  const size_t last_slash_idx = path.rfind('/');
+  if(last_slash_idx == std::string::npos) {
+    return path;
+  }
+
+  if(std::string::npos != last_slash_idx) {
+    filename = path.substr(last_slash_idx + 1, path.size());
+  }
+
+  return filename;
+}
+
+extern bool rx_create_dir(std::string path) {
+#ifdef _WIN32
+  if(_mkdir(path.c_str()) != 0) {
+    if(errno == ENOENT) { 
+      printf("Cannot create directory: %s (ENOENT)\n", path.c_str());
+      return false;
+    }
+    else if(errno == EEXIST) {
+      printf("Cannot create directory: %s (EEXIST)\n", path.c_str());
+    }
+  }
+  return true;
+
+#else
+  if(mkdir(path.c_str(), 0777) != 0) {
+    return false;
+  }
+  return true;
+#endif
+}
+
+extern std::string rx_get_file_ext(std::string filepath) {
+  size_t pos = filepath.rfind(".");
+  std::string result = "";
+
+  if(pos == std::string::npos) {
+    return result;
+  }
+
+  std::string ext = filepath.substr(pos + 1, (filepath.size() - pos));
+  return ext;
+} // rx_get_file_ext()
+
+extern bool rx_create_path(std::string path) {
+
+#ifdef _WIN32
+  std::string drive;
+  for(int i = 0; i < path.size()-1; ++i) {
+    if(path[i] == ':' && path[i + 1] == '\\') {
+      break;
+    }
+    drive.push_back(path[i]);
+  }
+  path = path.substr(drive.size() + 2);
+  drive = drive + ":";
+#endif
+
+  std::vector<std::string> dirs;
+  while(path.length() > 0) {
+
+     
+#ifdef _WIN32
+    int index = path.find('\\'); // win 
+#else
+    int index = path.find('/'); // posix
+#endif
+    std::string dir = (index == -1 ) ? path : path.substr(0, index);
+
+    if(dir.length() > 0) {
+      dirs.push_back(dir);
+    }
+    if(index + 1 >= path.length() || index == -1) {
+      break;
+    }
+    path = path.substr(index + 1);
+  }
+    
+  struct stat s;
+  std::string dir_path;
+
+#ifdef _WIN32
+  dir_path = drive;
+#endif
+
+  for(unsigned int i = 0; i < dirs.size(); i++) {
+
+#ifdef _WIN32
+    dir_path += "\\";
+#else
+    dir_path += "/";
+#endif
+
+#if !defined(_WIN32)
+    dir_path += dirs[i];
+    if(stat(dir_path.c_str(), &s) != 0) {
+      if(!rx_create_dir(dir_path.c_str())) {
+        printf("ERROR: cannot create directory: %s\n", dir_path.c_str());
+        return false;
+      }
+    }
+#endif
+  }
+
+#if defined(_WIN32)
+   printf("WARNING: We have not yet implemented rx_create_path() on windows.\n");
+#endif
+
+  return true;
+} // rx_create_path()
+
+/* using * for ext will return all images */
+extern std::vector<std::string> rx_get_files(std::string path, std::string ext) { 
+  std::vector<std::string> result;
+#if !defined(_WIN32)
+  DIR* dir;
+  struct dirent* ent;
+  if((dir = opendir(path.c_str())) != NULL) {
+    while((ent = readdir(dir)) != NULL) {
+      if(ent->d_type == DT_REG) {
+        std::string file_path = path +"/" +ent->d_name;
+
+        if(ext != "*" && ext.size()) {
+          std::string file_ext = rx_get_file_ext(file_path);
+          if(file_ext != ext) {
+            continue;
+          }
+        }
+
+        result.push_back(file_path);
+      }
+    }
+    closedir(dir);
+  }
+#else
+
+  char search_path[MAX_PATH] = { 0 };
+  WIN32_FIND_DATA ffd;
+  DWORD err;
+  HANDLE handle;
+
+  if (ext.size()) {
+    sprintf(search_path, "%s\\*", path.c_str());
+  }
+  else {
+    sprintf(search_path, "%s\\*.%s", path.c_str(), ext.c_str());
+  }
+
+  handle = FindFirstFile(search_path, &ffd);
+  if (INVALID_HANDLE_VALUE == handle) {
+    err = GetLastError();
+    printf("error: cannot get directory listing, error code: %u\n", err);
+  }
+  else {
+    do {
+      if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+        continue;
+      }
+      std::string file_path = path +"/" +ffd.cFileName;
+      result.push_back(file_path);
+    } while (FindNextFile(handle, &ffd) != 0);
+  }
+  CloseHandle(handle);
+
+#endif
+  return result;
+} // rx_get_files()
+
+extern std::string rx_norm_path(std::string path) {
+#if defined(_WIN32)
+  std::string from = "/";
+  std::string to = "\\";
+  size_t start_pos = 0;
+  while((start_pos = path.find(from, start_pos)) != std::string::npos) {
+    path.replace(start_pos, from.length(), to);
+    start_pos += to.length();
+  }
+  return path;
+#else
+  return path;
+#endif
+} // rx_norm_path()
+
+
+extern int rx_to_int(const std::string& v) {
+  int r = 0;
+  std::stringstream ss(v);
+  ss >> r;
+  return r;
+}
+
+extern float rx_to_float(const std::string& v) {
+  float r = 0.0f;
+  std::stringstream ss(v);
+  ss >> r;
+  return r;
+}
+
+extern std::string rx_int_to_string(const int& v) {
+  std::stringstream ss;
+  ss << v;
+  return ss.str();
+}
+
+extern std::string rx_float_to_string(const float& v) {
+  std::stringstream ss;
+  ss << v;
+  return ss.str();
+}
+
+extern std::vector<std::string> rx_split(std::string str, char delim) {
+  std::string line;
+  std::stringstream ss(str);
+  std::vector<std::string> result;
+  while(std::getline(ss, line, delim)) {
+    result.push_back(line);
+  }
+  return result;
+}
+
+extern std::string rx_to_lower(std::string str) {
+  std::string result;
+  result.resize(str.size());
+  std::transform(str.begin(), str.end(), result.begin(), ::tolower);
+  return result;
+}
+
+extern uint64_t rx_hrtime() {
+#if defined(__APPLE__) 
+  mach_timebase_info_data_t info;
+  if(mach_timebase_info(&info) != KERN_SUCCESS) {
+    abort();
+  }
+  return mach_absolute_time() * info.numer / info.denom;
+
+#elif defined(__linux)
+  static clock_t fast_clock_id = -1;
+  struct timespec t;
+  clock_t clock_id;
+
+  if(fast_clock_id == -1) {
+    if(clock_getres(CLOCK_MONOTONIC_COARSE, &t) == 0 && t.tv_nsec <= 1 * 1000 * 1000LLU) {
+      fast_clock_id = CLOCK_MONOTONIC_COARSE;
+    }
+    else {
+      fast_clock_id = CLOCK_MONOTONIC;
+    }
+  }
+
+  clock_id =  CLOCK_MONOTONIC;
+  if(clock_gettime(clock_id, &t)) {
+    return 0; 
+  }
+
+  return t.tv_sec * (uint64_t)1e9 +t.tv_nsec;
+
+#elif defined(_WIN32)
+  LARGE_INTEGER timer_freq;
+  LARGE_INTEGER timer_time;
+  QueryPerformanceCounter(&timer_time);
+  QueryPerformanceFrequency(&timer_freq);
+  static double freq = (double)timer_freq.QuadPart/(double)1000000000;
+  return (uint64_t)((double)timer_time.QuadPart / freq);
+#endif
+};
+
+extern float rx_millis() {
+  static uint64_t start = rx_hrtime();
+  int64_t d = (rx_hrtime() - start);
+  return d / 1000000000.0;
+}
+
+extern std::string rx_read_file(std::string filepath) {
+  std::ifstream ifs(filepath.c_str(), std::ios::in);
+  if(!ifs.is_open()) {
+    return "";
+  }
+  std::string str((std::istreambuf_iterator<char>(ifs)) , std::istreambuf_iterator<char>());
+  return str;
+}
+
+/* Memory maps the complete file read-only. An empty file is mapped as data = NULL, nbytes = 0. */
+extern bool rx_map_file(std::string filepath, const char** data, size_t& nbytes) {
+
+  *data = NULL;
+  nbytes = 0;
+
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (INVALID_HANDLE_VALUE == file) {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  if (0 == size.QuadPart) {
+    CloseHandle(file);
+    return true;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (NULL == mapping) {
+    return false;
+  }
+
+  /* The view keeps a reference to the mapping. */
+  void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (NULL == ptr) {
+    return false;
+  }
+
+  *data = (const char*)ptr;
+  nbytes = (size_t)size.QuadPart;
+#else
+  int fd = open(filepath.c_str(), O_RDONLY);
+  if (-1 == fd) {
+    return false;
+  }
+
+  struct stat statbuf;
+  if (-1 == fstat(fd, &statbuf)) {
+    close(fd);
+    return false;
+  }
+
+  if (0 == statbuf.st_size) {
+    close(fd);
+    return true;
+  }
+
+  void* ptr = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MAP_FAILED == ptr) {
+    return false;
+  }
+
+#  if defined(MADV_SEQUENTIAL)
+  madvise(ptr, statbuf.st_size, MADV_SEQUENTIAL);
+#  endif
+
+  *data = (const char*)ptr;
+  nbytes = (size_t)statbuf.st_size;
+#endif
+
+  return true;
+}
+
+extern void rx_unmap_file(const char* data, size_t nbytes) {
+
+  if (NULL == data) {
+    return;
+  }
+
+#if defined(_WIN32)
+  UnmapViewOfFile(data);
+#else
+  munmap((void*)data, nbytes);
+#endif
+}
+
+extern std::string rx_strftime(const std::string fmt) {
+  time_t t;
+  struct tm* info;
+  char buf[4096]; // must be enough..
+  time(&t);
+  info = localtime(&t);
+  strftime(buf, 4096, fmt.c_str(), info);
+  std::string result(buf);
+  return result;
+}
+
+extern std::string rx_get_time_string() {
+  double millis = double(rx_hrtime()) / 1000000000.0;
+  uint64_t intpart = (millis - (int)millis) * 1000;
+  std::string millis_str;
+  std::stringstream ss; 
+  ss << intpart;
+  ss >> millis_str;
+  return rx_strftime("%Y.%m.%d_%H.%M.%S_") +millis_str;
+}
+
+extern std::string rx_get_date_string() {
+  return rx_strftime("%Y.%m.%d");
+}
+
+extern int rx_get_year() {
+  return rx_to_int(rx_strftime("%Y"));
+}
+
+extern int rx_get_month() {
+  return rx_to_int(rx_strftime("%m"));
+}
+
+extern int rx_get_day() {
+  return rx_to_int(rx_strftime("%d"));
+}
+
+extern int rx_get_hour() {
+  return rx_to_int(rx_strftime("%H"));
+}
+
+extern int rx_get_minute() {
+  return rx_to_int(rx_strftime("%M"));
+}
+
+#if defined(ROXLU_USE_THREADS)
+
+extern int rx_get_num_cores() {
+  int n = (int)std::thread::hardware_concurrency();
+  return (n > 0) ? n : 1;
+}
+
+struct rx_parallel_for_state {
+  void (*job)(int dx, void* user);
+  void* user;
+  int njobs;
+  std::atomic<int> next;
+};
+
+static void rx_parallel_for_worker(rx_parallel_for_state* state) {
+  int dx;
+  while ((dx = state->next.fetch_add(1)) < state->njobs) {
+    state->job(dx, state->user);
+  }
+}
+
+/* 
+   Calls job(dx, user) for dx in [0, njobs) using `nthreads` threads (0 = one 
+   per core). Jobs are handed out dynamically; the calling thread also works.
+   Returns when all jobs are done.
+*/
+extern void rx_parallel_for(int njobs, void (*job)(int dx, void* user), void* user, int nthreads) {
+
+  if (nthreads <= 0) {
+    nthreads = rx_get_num_cores();
+  }
+
+  nthreads = LOWEST(nthreads, njobs);
+
+  if (nthreads <= 1) {
+    for (int i = 0; i < njobs; ++i) {
+      job(i, user);
+    }
+    return;
+  }
+
+  rx_parallel_for_state state;
+  state.job = job;
+  state.user = user;
+  state.njobs = njobs;
+  state.next = 0;
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < nthreads; ++i) {
+    threads.push_back(std::thread(rx_parallel_for_worker, &state));
+  }
+
+  rx_parallel_for_worker(&state);
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+}
+
+#else
+
+/* Without ROXLU_USE_THREADS the jobs run serially on the calling thread. */
+extern int rx_get_num_cores() {
+  return 1;
+}
+
+extern void rx_parallel_for(int njobs, void (*job)(int dx, void* user), void* user, int /* nthreads */) {
+  for (int i = 0; i < njobs; ++i) {
+    job(i, user);
+  }
+}
+
+#endif
+
+#undef get16bits
+#if (defined(__GNUC__) && defined(__i386__)) || defined(__WATCOMC__) \
+|| defined(_MSC_VER) || defined (__BORLANDC__) || defined (__TURBOC__)
+#define get16bits(d) (*((const uint16_t *) (d)))
+#endif
+
+#if !defined (get16bits)
+#define get16bits(d) ((((uint32_t)(((const uint8_t *)(d))[1])) << 8)\
++(uint32_t)(((const uint8_t *)(d))[0]) )
+#endif
+
+extern uint32_t rx_string_id(const std::string& v) {
+  const char* data = v.c_str();
+  int len = v.size();
+  uint32_t hash = len, tmp;
+  int rem;
+  
+  if (len <= 0 || data == NULL) {
+    return 0;
+  }
+  
+  rem = len & 3;
+  len >>= 2;
+  
+  /* Main loop */
+  for (;len > 0; len--) {
+    hash  += get16bits (data);
+    tmp    = (get16bits (data+2) << 11) ^ hash;
+    hash   = (hash << 16) ^ tmp;
+    data  += 2*sizeof (uint16_t);
+    hash  += hash >> 11;
+  }
+  
+  /* Handle end cases */
+  switch (rem) {
+    case 3: hash += get16bits (data);
+      hash ^= hash << 16;
+      hash ^= data[sizeof (uint16_t)] << 18;
+      hash += hash >> 11;
+      break;
+    case 2: hash += get16bits (data);
+      hash ^= hash << 11;
+      hash += hash >> 17;
+      break;
+    case 1: hash += *data;
+      hash ^= hash << 10;
+      hash += hash >> 1;
+  }
+  
+  /* Force "avalanching" of final 127 bits */
+  hash ^= hash << 3;
+  hash += hash >> 5;
+  hash ^= hash << 4;
+  hash += hash >> 17;
+  hash ^= hash << 25;
+  hash += hash >> 6;
+  
+  return hash;
+}
+
+#endif // defined(ROXLU_IMPLEMENTATION)
+
+// ====================================================================================
+//                              R O X L U _ U S E _ M A T H
+// ====================================================================================
+#if defined(ROXLU_USE_CURL) && defined(ROXLU_IMPLEMENTATION) 
+
+size_t rx_curl_write_string_data(void* ptr, size_t size, size_t nmemb, void* str) {
+  std::string* s = static_cast<std::string*>(str);
+  std::copy((char*)ptr, (char*)ptr + (size * nmemb), std::back_inserter(*s));
+  return size * nmemb;
+}
+
+size_t rx_curl_write_file_data(void* ptr, size_t size, size_t nmemb, void* fpptr) {
+  FILE* fp = static_cast<FILE*>(fpptr);
+  size_t written = fwrite(ptr, size, nmemb, fp);
+  return written;
+}
+
+bool rx_fetch_url(std::string url, std::string& result) {
+  
+  CURL* curl = NULL;
+  CURLcode res;
+
+  curl = curl_easy_init();
+  if(!curl) {
+    printf("Error: cannot intialize curl.\n");
+    return false;
+  }
+
+  res = curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  RX_CHECK_CURLCODE(res, "Cannot set url");
+
+  res = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  RX_CHECK_CURLCODE(res, "Cannot set follow location");
+
+  res = curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result);
+  RX_CHECK_CURLCODE(res, "Cannot set write data");
+  
+  res = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, rx_curl_write_string_data);
+  RX_CHECK_CURLCODE(res, "Cannot set write function");
+
+  res = curl_easy_perform(curl);
+  RX_CHECK_CURLCODE(res, "Cannot easy perform");
+
+  curl_easy_cleanup(curl);
+  curl = NULL;
+  
+  return true;
+}
+
+bool rx_download_file(std::string url, std::string filepath) {
+
+  FILE* fp = NULL;
+  CURL* curl = NULL;
+  CURLcode res;
+
+  fp = fopen(filepath.c_str(), "wb");
+  if(!fp) {
+    printf("Error: cannot open file: %s\n", filepath.c_str());
+    return false;
+  }
+  
+  curl = curl_easy_init();
+  if(!curl) {
+    printf("Error: cannot initialize cur.\n");
+    return false;
+  }
+
+#if !defined(NDEBUG)  
+  res = curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+  RX_CHECK_CURLCODE(res, "Cannot set verbose");
+#endif
+
+  res = curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+  RX_CHECK_CURLCODE(res, "Cannot disable SSL_VERIFYPEER");
+
+  res = curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+  RX_CHECK_CURLCODE(res, "Cannot disable SSL_VERIFYPEER");
+
+  res = curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  RX_CHECK_CURLCODE(res, "Cannot set url");
+
+  res = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  RX_CHECK_CURLCODE(res, "Cannot set follow location");
+
+  res = curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
+  RX_CHECK_CURLCODE(res, "Cannot set write data");
+  
+  res = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, rx_curl_write_file_data);
+  RX_CHECK_CURLCODE(res, "Cannot set write function");
+
+  res = curl_easy_perform(curl);
+  RX_CHECK_CURLCODE(res, "Cannot easy perform");
+
+  curl_easy_cleanup(curl);
+  curl = NULL;
+
+  fclose(fp);
+  fp = NULL;
+
+  return true;
+}
+
+#endif
+
+// ====================================================================================
+//                              R O X L U _ U S E _ M A T H
+// ====================================================================================
+#if defined(ROXLU_USE_MATH) && defined(ROXLU_IMPLEMENTATION) 
+
+extern float rx_random(float max) {
+  return max * rand() / (RAND_MAX + 1.0f);
+}
+
+extern float rx_random(float x, float y) {
+  float high = 0;
+  float low = 0;
+  float result = 0;
+        
+  high = std::max<float>(x,y);
+  low = std::min<float>(x,y);
+  result = low + ((high-low) * rand()/(RAND_MAX + 1.0));
+  return result;
+}
+
+extern bool rx_is_power_of_two(int n) {
+  if (0 == n) {
+    return false;
+  }
+  return (n & (n - 1)) == 0;
+}
+
+extern float rx_map(float val, float inmin, float inmax, float outmin, float outmax, bool clamp) {
+
+  float out = (val - inmin) / (inmax - inmin) * (outmax - outmin) + outmin;
+  
+  if (true == clamp) {
+    if (outmin < outmax) {
+      if (out > outmax) {
+        out = outmax;
+      }
+      else if (out < outmin) {
+        out = outmin;
+      }
+    }
+    else {
+      if (out < outmax) {
+        out = outmax;
+      }
+      else if (out > outmin) {
+        out = outmin;
+      }
+    }
+  }
+
+  return out;
+}
+
+// all in range 0 - 1 
+extern void rx_rgb_to_hsv(float r, float g, float b, float& h, float& s, float& v) {
+  float K = 0.f;
+
+  if(g < b) {
+    std::swap(g, b);
+    K = -1.f;
+  }
+
+  if(r < g) {
+    std::swap(r, g);
+    K = -2.f / 6.f - K;
+  }
+
+  float chroma = r - std::min<float>(g, b);
+  h = fabs(K + (g - b) / (6.f * chroma + 1e-20f));
+  s = chroma / (r + 1e-20f);
+  v = r;
+}
+
+extern void rx_rgb_to_hsv(vec3 rgb, vec3& hsv) {
+  rx_rgb_to_hsv(rgb.x, rgb.y, rgb.z, hsv.x, hsv.y, hsv.z);
+}
+
+extern void rx_rgb_to_hsv(vec3 rgb, float* hsv) {
+  rx_rgb_to_hsv(rgb.x, rgb.y, rgb.z, hsv[0], hsv[1], hsv[2]);
+}
+
+extern void rx_rgb_to_hsv(float* rgb, float* hsv) {
+  rx_rgb_to_hsv(rgb[0], rgb[1], rgb[2], hsv[0], hsv[1], hsv[2]);
+}
+
+extern void rx_hsv_to_rgb(float h, float s, float v, float& r, float& g, float& b) {
+  float tmp_r = CLAMP((-1.0f + fabs(6.0f * h - 3.0f)), 0,1);
+  float tmp_g = CLAMP(( 2.0f - fabs(6.0f * h - 2.0f)), 0,1);      
+  float tmp_b = CLAMP(( 2.0f - fabs(6.0f * h - 4.0f)), 0,1);  
+  float p = 1.0f - s;  
+  r = v * (p + tmp_r * s);  
+  g = v * (p + tmp_g * s);    
+  b = v * (p + tmp_b * s);        
+}
+
+extern void rx_hsv_to_rgb(vec3 hsv, vec3& rgb) {
+  rx_hsv_to_rgb(hsv.x, hsv.y, hsv.z, rgb.x, rgb.y, rgb.z);
+}
+
+extern void rx_hsv_to_rgb(vec3 hsv, float* rgb) {
+  rx_hsv_to_rgb(hsv.x, hsv.y, hsv.z, rgb[0], rgb[1], rgb[2]);
+}
+
+extern void rx_hsv_to_rgb(float* hsv, float* rgb) {
+  rx_hsv_to_rgb(hsv[0], hsv[1], hsv[2], rgb[0], rgb[1], rgb[2]);
+}
+
+
+SegmentIntersector::SegmentIntersector()
+  :skip_connected(false)
+  ,num_tests(0)
+  ,min_x(0.0f)
+  ,min_y(0.0f)
+  ,inv_cell_size(1.0f)
+  ,grid_w(0)
+  ,grid_h(0)
+{
+}
+
+void SegmentIntersector::clear() {
+  segments.clear();
+}
+
+void SegmentIntersector::add(const vec3& p0, const vec3& p1) {
+  segments.push_back(p0);
+  segments.push_back(p1);
+}
+
+void SegmentIntersector::add(float x0, float y0, float x1, float y1) {
+  segments.push_back(vec3(x0, y0, 0.0f));
+  segments.push_back(vec3(x1, y1, 0.0f));
+}
+
+size_t SegmentIntersector::size() {
+  return segments.size() / 2;
+}
+
+/* 
+   We walk over all the rows the segment spans and calculate the horizontal
+   range of the segment within each row. Both ranges are grown by a tiny
+   epsilon so that segments that cross exactly on a cell border end up in 
+   both cells.
+*/
+void SegmentIntersector::rasterize(int segment, bool fill) {
+
+  const float eps = 1e-4f;
+  const vec3& p0 = segments[segment * 2 + 0];
+  const vec3& p1 = segments[segment * 2 + 1];
+
+  float x0 = (p0.x - min_x) * inv_cell_size;
+  float y0 = (p0.y - min_y) * inv_cell_size;
+  float x1 = (p1.x - min_x) * inv_cell_size;
+  float y1 = (p1.y - min_y) * inv_cell_size;
+
+  if (y0 > y1) {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+
+  float dy = y1 - y0;
+  float dxdy = (dy > 1e-12f) ? (x1 - x0) / dy : 0.0f;
+  int row_start = CLAMP(int(floorf(y0 - eps)), 0, grid_h - 1);
+  int row_end = CLAMP(int(floorf(y1 + eps)), 0, grid_h - 1);
+
+  for (int row = row_start; row <= row_end; ++row) {
+
+    float ya = HEIGHEST(float(row), y0);
+    float yb = LOWEST(float(row + 1), y1);
+    float xa = x0;
+    float xb = x1;
+
+    if (dy > 1e-12f) {
+      xa = x0 + (ya - y0) * dxdy;
+      xb = x0 + (yb - y0) * dxdy;
+    }
+
+    if (xa > xb) {
+      std::swap(xa, xb);
+    }
+
+    int col_start = CLAMP(int(floorf(xa - eps)), 0, grid_w - 1);
+    int col_end = CLAMP(int(floorf(xb + eps)), 0, grid_w - 1);
+    int* cells = &cell_offsets[row * grid_w];
+
+    if (false == fill) {
+      for (int col = col_start; col <= col_end; ++col) {
+        cells[col]++;
+      }
+    }
+    else {
+      for (int col = col_start; col <= col_end; ++col) {
+        cell_items[cells[col]++] = segment;
+      }
+    }
+  }
+}
+
+static bool segment_intersection_sort(const SegmentIntersection& a, const SegmentIntersection& b) {
+  return (a.a != b.a) ? (a.a < b.a) : (a.b < b.b);
+}
+
+static bool segment_intersection_equal(const SegmentIntersection& a, const SegmentIntersection& b) {
+  return a.a == b.a && a.b == b.b;
+}
+
+size_t SegmentIntersector::intersect(std::vector<SegmentIntersection>& result) {
+
+  result.clear();
+  num_tests = 0;
+
+  int nsegments = segments.size() / 2;
+  if (nsegments < 2) {
+    return 0;
+  }
+
+  /* Bounds and average segment extent determine the cell size. */
+  float max_x = segments[0].x;
+  float max_y = segments[0].y;
+  float extent = 0.0f;
+  min_x = max_x;
+  min_y = max_y;
+
+  for (size_t i = 0; i < segments.size(); i += 2) {
+    const vec3& a = segments[i];
+    const vec3& b = segments[i + 1];
+    min_x = LOWEST(min_x, LOWEST(a.x, b.x));
+    min_y = LOWEST(min_y, LOWEST(a.y, b.y));
+    max_x = HEIGHEST(max_x, HEIGHEST(a.x, b.x));
+    max_y = HEIGHEST(max_y, HEIGHEST(a.y, b.y));
+    extent += HEIGHEST(fabsf(b.x - a.x), fabsf(b.y - a.y));
+  }
+
+  float w = HEIGHEST(max_x - min_x, 1e-6f);
+  float h = HEIGHEST(max_y - min_y, 1e-6f);
+  float cell_size = HEIGHEST(extent / nsegments, sqrtf((w * h) / nsegments));
+  cell_size = HEIGHEST(cell_size, HEIGHEST(w, h) / 2048.0f);
+
+  inv_cell_size = 1.0f / cell_size;
+  grid_w = CLAMP(int(w * inv_cell_size) + 1, 1, 2048);
+  grid_h = CLAMP(int(h * inv_cell_size) + 1, 1, 2048);
+
+  /* Count, prefix sum and fill: a CSR layout of segments per cell. */
+  size_t ncells = size_t(grid_w) * size_t(grid_h);
+  cell_offsets.assign(ncells + 1, 0);
+
+  for (int i = 0; i < nsegments; ++i) {
+    rasterize(i, false);
+  }
+
+  int total = 0;
+  for (size_t i = 0; i < ncells; ++i) {
+    int count = cell_offsets[i];
+    cell_offsets[i] = total;
+    total += count;
+  }
+  cell_offsets[ncells] = total;
+  cell_items.resize(total);
+
+  for (int i = 0; i < nsegments; ++i) {
+    rasterize(i, true);
+  }
+
+  /* Filling advanced every offset to the start of the next cell; shift back. */
+  for (size_t i = ncells; i > 0; --i) {
+    cell_offsets[i] = cell_offsets[i - 1];
+  }
+  cell_offsets[0] = 0;
+
+  /* Test all pairs per cell. */
+  vec3 point;
+  SegmentIntersection hit;
+
+  for (size_t c = 0; c < ncells; ++c) {
+
+    int start = cell_offsets[c];
+    int end = cell_offsets[c + 1];
+
+    for (int i = start; i < end; ++i) {
+
+      int sa = cell_items[i];
+      const vec3& a0 = segments[sa * 2 + 0];
+      const vec3& a1 = segments[sa * 2 + 1];
+
+      for (int j = i + 1; j < end; ++j) {
+
+        int sb = cell_items[j];
+        const vec3& b0 = segments[sb * 2 + 0];
+        const vec3& b1 = segments[sb * 2 + 1];
+
+        if (LOWEST(a0.x, a1.x) > HEIGHEST(b0.x, b1.x)
+            || LOWEST(b0.x, b1.x) > HEIGHEST(a0.x, a1.x)
+            || LOWEST(a0.y, a1.y) > HEIGHEST(b0.y, b1.y)
+            || LOWEST(b0.y, b1.y) > HEIGHEST(a0.y, a1.y))
+          {
+            continue;
+          }
+
+        if (skip_connected
+            && ((a0.x == b0.x && a0.y == b0.y) || (a0.x == b1.x && a0.y == b1.y)
+                || (a1.x == b0.x && a1.y == b0.y) || (a1.x == b1.x && a1.y == b1.y)))
+          {
+            continue;
+          }
+
+        num_tests++;
+
+        if (::intersect(a0, a1, b0, b1, point)) {
+          hit.point.set(point.x, point.y, 0.0f);
+          hit.a = LOWEST(sa, sb);
+          hit.b = HEIGHEST(sa, sb);
+          result.push_back(hit);
+        }
+      }
+    }
+  }
+
+  /* Pairs that share more than one cell are found multiple times. */
+  std::sort(result.begin(), result.end(), segment_intersection_sort);
+  result.erase(std::unique(result.begin(), result.end(), segment_intersection_equal), result.end());
+
+  return result.size();
+}
+
+
+#endif // defined(ROXLU_USE_MATH) && defined(ROXLU_IMPLEMENTATON) 
+
+// ====================================================================================
+//                              R O X L U _ U S E _ J P G
+// ====================================================================================
+
+#if defined(ROXLU_USE_JPG) && defined(ROXLU_IMPLEMENTATION)
+
+static void rx_load_jpg_error_handler(j_common_ptr cinfo) {
+  printf("Error occured while loading the jpeg (rx_load_jpg). This error is triggered by libjpeg. \n");
+  struct rx_jpeg_error_mgr* jerr = (struct rx_jpeg_error_mgr*)cinfo->err;
+  longjmp(jerr->setjmp_buffer, 1);
+}
+
+/*
+
+  @param std::string filepath      - The file to laod
+  @param unsigned char** pix       - A reference to the buffer that will be set to the 
+                                     memory we allocate OR that we will reallocate (if needed).
+                                     We will only reallocate when the *allocated parameter is
+                                     passed. 
+  @param int& width                - Will be set to the width of the image.
+  @param int& height               - Will be set to the height of the image
+  @param int& nchannels            - Will be set to the number of color channels in the image
+  @param int* allocated (NULL)     - Can be NULL, if not it must be set to the number of bytes in *pix.
+                                     When the number of allocated bytes is less then what we need, we will
+                                     reallocate the buffer.   
+  @return int                      - The number of bytes of the image buffer (doesn't have to be the same 
+                                     as the number of bytes that was previously allocated!).
+                                   - on error we return a negative value.
+
+ */
+int rx_load_jpg(std::string filepath, unsigned char** pix, int& width, int& height, int& nchannels, int* allocated) {
+  
+  struct rx_jpeg_error_mgr jerr;
+  struct jpeg_decompress_struct cinfo;
+  FILE* fp = NULL;
+  JSAMPARRAY buffer;
+  int stride = 0;
+  int num_bytes = 0;
+  unsigned char* pixels = NULL;
+  unsigned char* tmp = NULL;
+  
+  if( (fp = fopen(filepath.c_str(), "rb")) == NULL ) {
+    printf("Error: cannot load %s (rx_load_jpg)\n", filepath.c_str());
+    return -1;
+  }
+
+  memset(&jerr, 0x00, sizeof(jerr));
+  cinfo.err = jpeg_std_error(&jerr.pub);
+
+  /* Set the error handler, otherwise libjpg calls exit(). */
+  jerr.pub.error_exit = rx_load_jpg_error_handler;
+  if (setjmp(jerr.setjmp_buffer)) { /* When an error occurs we jump to this part. */
+    if (NULL != fp) {
+      fclose(fp);
+      fp = NULL;
+    }
+    
+    jpeg_destroy_decompress(&cinfo);
+    return -1;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, fp);
+  jpeg_read_header(&cinfo, TRUE);
+  jpeg_start_decompress(&cinfo);
+
+  stride = cinfo.output_width * cinfo.output_components;
+  nchannels = cinfo.output_components;
+  width = cinfo.output_width;
+  height = cinfo.output_height;
+  num_bytes = width * height * nchannels;
+
+  /* Reallocate when a buffer size is given */
+  if (NULL != allocated) {
+    if (0 == *allocated) {
+      /* not allocated yet */
+      pixels = (unsigned char*)malloc(num_bytes);
+      if (pixels) {
+        *allocated = num_bytes;
+      }
+      else {
+        printf("Error: cannot allocate a buffer for the jpg. (rx_load_jpg)\n");
+      }
+    }
+    else if (num_bytes > *allocated) {
+      /* already allocated, try to reallocate if necessary */
+      tmp = (unsigned char*)realloc(*pix, num_bytes);
+      if (NULL == tmp) {
+        printf("Error: cannot reallocate the pixel buffer for the jpg. (rx_load_jpg)\n");
+        pixels = NULL;
+      }
+      else {
+        pixels = tmp;
+        *allocated = num_bytes;
+      }
+    }
+    else {
+      pixels = *pix;
+    }
+  }
+  else {
+    pixels = (unsigned char*)malloc(num_bytes);
+  }
+
+  if(!pixels) {
+    printf("Error: cannot allocate pixel buffer for jpg.(rx_load_jpg) \n");
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    fclose(fp);
+    return -1;
+  }
+
+  size_t dest_row = 0;
+  buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr) &cinfo, JPOOL_IMAGE, stride, 1);
+  while(cinfo.output_scanline < cinfo.output_height) {
+    jpeg_read_scanlines(&cinfo, buffer, 1);
+    memcpy(pixels + (dest_row * stride), buffer[0], stride);
+    dest_row++;
+  }
+
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  fclose(fp);
+  *pix = pixels;
+  return num_bytes;
+}
+
+bool rx_save_jpg(std::string filepath, unsigned char* pix, int width, int height, int nchannels, int quality, bool flip, J_COLOR_SPACE colorSpace, J_DCT_METHOD dctMethod) {
+
+  if(!pix) {
+    printf("Error: cannot save jpg, invalid pixels.\n");
+    return false;
+  }
+
+  if(width <= 0 || height <= 0) {
+    printf("Error: cannot save jpg, invalid size: %d x %d\n", width, height);
+    return false;
+  }
+
+  if(quality < 0) {
+    quality = 0;
+  }
+  else if(quality > 100) {
+    quality = 100;
+  }
+
+  FILE* fp = fopen(filepath.c_str(), "wb");
+  if(!fp) {
+    printf("Cannot open the file: `%s`", filepath.c_str());
+    fp = NULL;
+    return false;
+  }
+
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  JSAMPROW row_pointer[1];
+
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+  
+  jpeg_stdio_dest(&cinfo, fp);
+
+  // compression parameters
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = nchannels;
+  cinfo.in_color_space = colorSpace;
+
+  jpeg_set_defaults(&cinfo); // after setting the default we can set our custom settings
+
+  cinfo.dct_method = dctMethod;
+
+  jpeg_set_quality(&cinfo, quality, TRUE /* limit to jpeg baseline values */);
+
+  jpeg_start_compress(&cinfo, TRUE /* write complete data stream */); 
+
+  int stride = width * nchannels;
+
+  if(flip) {
+    while(cinfo.next_scanline < cinfo.image_height) {
+      row_pointer[0] = &pix[ (cinfo.image_height - 1 - cinfo.next_scanline) * stride];
+      jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    }
+  }
+  else {
+    while(cinfo.next_scanline < cinfo.image_height) {
+      row_pointer[0] = &pix[cinfo.next_scanline * stride];
+      jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    }
+  }
+
+  jpeg_finish_compress(&cinfo);
+
+  fclose(fp);
+  fp = NULL;
+
+  jpeg_destroy_compress(&cinfo);
+  return true;
+}
+
+#endif // defined(ROXLU_USE_JPG) && defined(ROXLU_IMPLEMENTATON) 
+
+
+// ====================================================================================
+//                              R O X L U _ U S E _ P N G
+// ====================================================================================
+
+#if defined(ROXLU_USE_PNG) && defined(ROXLU_IMPLEMENTATION)
+
+extern bool rx_save_png(std::string filepath, 
+                        unsigned char* pixels, 
+                        int w, 
+                        int h, 
+                        int channels = 3, 
+                        bool flip = false) 
+{
+  
+  if(!w || !h) {
+    printf("error: cannot save png because the given width and height are invalid: %d x %d\n", w, h);
+    return false;
+  }
+  
+  if(!channels || channels > 4) {
+    printf("error: cannot save png because the number of color channels is invalid: %d\n", channels);
+    return false;
+  }
+  
+  if(!pixels) {
+    printf("error: cannot save png because we got an invalid pixels array: %p\n", pixels);
+    return false;
+  }
+  
+  if(!filepath.size()) {
+    printf("error: cannot save png because the given filepath is invalid.\n");
+    return false;
+  }
+  
+  png_structp png_ptr; 
+  png_infop info_ptr;
+  
+  FILE* fp = fopen(filepath.c_str(), "wb");
+  if(!fp) {
+    printf("error: canont save png because we cannot open the filepath: %s\n", filepath.c_str());
+    fp = NULL;
+    return false;
+  }
+  
+  png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if(png_ptr == NULL) {
+    printf("error: cannot save png because we cannot create a png write struct.\n");
+    fclose(fp);
+    fp = NULL;
+    return false;
+  }
+  
+  info_ptr = png_create_info_struct(png_ptr);
+  if(info_ptr == NULL) {
+    printf("error: cannot save png brecause we cannot create a png info struct.\n");
+    fclose(fp);
+    fp = NULL;
+    return false;
+  }
+  
+  if(setjmp(png_jmpbuf(png_ptr))) {
+    printf("error: cannot save png because we cannot set the jump pointer.\n");
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    fclose(fp);
+    fp = NULL;
+    return false;
+  }
+  
+  png_uint_32 color_type;
+  switch(channels) {
+    case 1: {
+      color_type = PNG_COLOR_TYPE_GRAY; 
+      break;
+    }
+    case 3: {
+      color_type = PNG_COLOR_TYPE_RGB;
+      break;
+    }
+    case 4: {
+      color_type = PNG_COLOR_TYPE_RGB_ALPHA;
+      break;
+    }
+    default: {
+      printf("error: cannot save png because we cannot detect the color type based on the number of channels.\n");
+      fclose(fp);
+      fp = NULL;
+      return false;
+    }
+  };
+  
+  png_set_IHDR(png_ptr, 
+               info_ptr, 
+               w, 
+               h, 
+               8, 
+               color_type, 
+               PNG_INTERLACE_NONE, 
+               PNG_COMPRESSION_TYPE_DEFAULT, 
+               PNG_FILTER_TYPE_DEFAULT);
+  
+  //  unsigned char* p = (h * w * channels);
+  //  int stride = -(w * channels);
+  png_bytep* row_ptrs = new png_bytep[h];
+  if(flip) {
+    for(size_t j = 0; j < h; ++j) {
+      row_ptrs[h-(j+1)] = pixels + (j * (w * channels));
+    }
+  }
+  else {
+    for(size_t j = 0; j < h; ++j) {
+      row_ptrs[j] = pixels + (j * (w * channels));
+    }
+  }
+   
+  png_init_io(png_ptr, fp);
+  png_set_rows(png_ptr, info_ptr, row_ptrs);
+  png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+  
+  png_destroy_write_struct(&png_ptr, &info_ptr);
+  
+  delete[] row_ptrs;
+  row_ptrs = NULL;
+
+  fclose(fp);
+  
+  return true;
+}
+
+/*
+
+  @param std::string filepath      - The file to laod
+  @param unsigned char** pix       - A reference to the buffer that will be set to the 
+                                     memory we allocate OR that we will reallocate (if needed).
+                                     We will only reallocate when the *allocated parameter is
+                                     passed. 
+  @param int& width                - Will be set to the width of the image.
+  @param int& height               - Will be set to the height of the image
+  @param int& nchannels            - Will be set to the number of color channels in the image
+  @param int* allocated (NULL)     - Can be NULL, if not it must be set to the number of bytes in *pix.
+                                     When the number of allocated bytes is less then what we need, we will
+                                     reallocate the buffer.   
+  @param int flags                 - This allows you to tell the loader, to convert a e.g. RGB
+                                     png into a RGBA, wich may be handy if you need to upload
+                                     the pixels to the GPU.  
+
+  @return int                      - The number of bytes of the image buffer (doesn't have to be the same 
+                                     as the number of bytes that was previously allocated!).
+                                   - on error we return a negative value.
+
+ */  
+extern int rx_load_png(std::string filepath, 
+                        unsigned char** pixels,
+                        int& width,
+                        int& height,
+                        int& nchannels, 
+                        int* allocated,
+                        int flags)
+{
+  png_structp png_ptr;
+  png_infop info_ptr; 
+  unsigned char* tmp = NULL;
+
+  FILE* fp = fopen(filepath.c_str(), "rb");
+  if(!fp) {
+    printf("Error: cannot load the png file: %s\n", filepath.c_str());
+    fp = NULL;
+    return -1;
+  }
+  
+  unsigned char sig[8];
+  size_t r = 0;
+  r = fread(sig, 1, 8, fp);
+  if(r != 8) {
+    printf("Error: invalid png signature (not enough bytes read) in: %s.\n", filepath.c_str());
+    fclose(fp);
+    fp = NULL;
+    return  -2;
+  }
+  
+  if(!png_check_sig(sig, 8)) {
+    printf("Error: invalid png signature (wrong siganture) in: %s.\n", filepath.c_str());
+    fclose(fp);
+    fp = NULL;
+    return -3;
+  }
+    
+  png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if(!png_ptr) {
+    printf("Error: cannot create png read struct: %s\n", filepath.c_str());
+    fclose(fp);
+    fp = NULL;
+    return -4;
+  }
+  
+  info_ptr = png_create_info_struct(png_ptr);
+  if(!info_ptr) {
+    png_destroy_read_struct(&png_ptr, NULL, NULL);
+    printf("Error: cannot create png info struct for: %s\n", filepath.c_str());
+    fclose(fp);
+    fp = NULL;
+    return -5;
+  }
+  
+#if !defined(_WIN32)
+#if 1
+  if(setjmp(png_jmpbuf(png_ptr))) {
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    fclose(fp);
+    fp = NULL;
+    return -6;
+  }
+#endif
+#endif
+
+  
+  // @TODO - add option to rescale to 8bit color info or 16bit
+  // @TODO - add option to strip the alpha (not recommended in the example)
+  png_init_io(png_ptr, fp);
+  png_set_sig_bytes(png_ptr, 8);
+  png_read_info(png_ptr, info_ptr);
+  
+  uint32_t stride = 0;
+  uint32_t num_bytes = 0;
+  uint32_t bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+  uint32_t color_type = png_get_color_type(png_ptr, info_ptr);
+  width = png_get_image_width(png_ptr, info_ptr);
+  height = png_get_image_height(png_ptr, info_ptr);
+  nchannels = png_get_channels(png_ptr, info_ptr);
+
+  if(width == 0 || height == 0) {
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    fclose(fp);
+    fp = NULL;
+    return -7;
+  }
+  
+  /* @TODO - add option to allow input colors/gray values to be not converted */
+
+  switch(color_type) {
+    case PNG_COLOR_TYPE_PALETTE: {
+      png_set_palette_to_rgb(png_ptr);
+      nchannels = 3;
+      break;
+    }
+    case PNG_COLOR_TYPE_GRAY: {
+      if(bit_depth < 8) {
+        png_set_expand_gray_1_2_4_to_8(png_ptr);
+        bit_depth = 8;
+      }
+      break;
+    }
+    default: {
+      /*printf("Warning: unsupported color type: %d.\n", color_type);*/
+      break;
+    }
+  };
+
+  /* When transparency is set convert it to a full alpha channel */
+  if(png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+    png_set_tRNS_to_alpha(png_ptr);
+    nchannels += 1;
+  }
+
+  /* When flag is set to load as RGBA, we need to the info struct */
+  if ((flags & RX_FLAG_LOAD_AS_RGBA) == RX_FLAG_LOAD_AS_RGBA) {
+    if (color_type == PNG_COLOR_TYPE_RGB ||
+        color_type == PNG_COLOR_TYPE_GRAY || 
+        color_type == PNG_COLOR_TYPE_PALETTE)
+    {
+      png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+    }
+
+    if(color_type == PNG_COLOR_TYPE_GRAY ||
+       color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+    {
+      png_set_gray_to_rgb(png_ptr);
+    }
+
+    png_read_update_info(png_ptr, info_ptr);
+
+    nchannels = 4;
+  }
+
+  stride = png_get_rowbytes(png_ptr, info_ptr);
+  num_bytes = stride * height; 
+
+  /* Reallocate when a buffer size is given */
+  unsigned char* pixbuf = NULL;
+  if (NULL != allocated) {
+    if (0 == *allocated) {
+      /* not allocated yet */
+      *pixels = (unsigned char*)malloc(num_bytes);
+      if (*pixels) {
+        *allocated = num_bytes;
+        pixbuf = *pixels;
+      }
+      else {
+        printf("Error: cannot allocate buffer for png image, %d bytes.\n", num_bytes);
+      }
+    }
+    else if (num_bytes > *allocated) {
+      /* already allocated, try to reallocate if necessary */
+      tmp = (unsigned char*)realloc(*pixels, num_bytes);
+      if (NULL == tmp) {
+        printf("Error: cannot reallocate the pixel buffer for the jpg.");
+      }
+      else {
+        *pixels = tmp;
+        *allocated = num_bytes;
+        pixbuf = *pixels;
+      }
+    }
+    else {
+      pixbuf = *pixels;
+    }
+  }
+  else {
+    pixbuf = (unsigned char*)malloc(num_bytes); 
+  }
+  
+  if(!pixbuf) {
+    printf("Error: image is to big: %s\n", filepath.c_str());
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    fclose(fp);
+    fp = NULL;
+    return -8;
+  }
+
+   /* set the outgoing pixel buffer. */
+  *pixels = pixbuf;
+  
+  png_bytep* row_ptrs = (png_bytep*)malloc(sizeof(png_bytep) * height); 
+  if(!row_ptrs) {
+    printf("Error: image is to big: %s\n", filepath.c_str());
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    fclose(fp);
+    fp = NULL;
+    
+    /* free allocations */
+    free(*pixels);
+    *pixels = NULL;
+    if (NULL != allocated) {
+      *allocated = 0;
+    }
+
+    return -9;
+  }
+
+  /*
+    Some code on github iterate over the number of passes (see interlace
+    above, but this doesn't seem to be necessary.
+  */
+  for(size_t i = 0; i < height; ++i) {
+    row_ptrs[i] = (png_bytep)(*pixels) +(i * stride);
+  }
+
+
+  png_read_image(png_ptr, row_ptrs);
+  png_read_end(png_ptr, info_ptr);
+
+  free(row_ptrs);
+  row_ptrs = NULL;
+  png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+  fclose(fp);
+
+  return num_bytes;
+}
+
+#endif //  defined(ROXLU_USE_PNG) && defined(ROXLU_IMPLEMENATION)
+
+// ====================================================================================
+//                              R O X L U _ U S E _ O P E N G L 
+// ====================================================================================
+
+#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_IMPLEMENTATION)
+
+extern void rx_print_shader_link_info(GLuint shader) {
+  GLint status = 0;
+  GLint count = 0;
+  GLchar* error = NULL;
+  GLsizei nchars = 0;
+  glGetProgramiv(shader, GL_LINK_STATUS, &status);
+  if(!status) {
+    glGetProgramiv(shader, GL_INFO_LOG_LENGTH, &count);
+    if(count > 0) {
+      error = new GLchar[count];
+      glGetProgramInfoLog(shader, 2048, &nchars, error);
+      printf("------\n");
+      printf("%s\n", error);
+      printf("------\n");
+      delete[] error;
+      error = NULL;
+      assert(0);
+    }
+  }
+}
+
+extern void rx_print_shader_compile_info(GLuint shader) {
+  GLint status = 0;
+  GLint count = 0;
+  GLchar* error = NULL;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  if(!status) {
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &count);
+    if(count > 0) {
+      error = new GLchar[count];
+      glGetShaderInfoLog(shader, count, NULL, error);
+      printf("------\n");
+      printf("%s\n", error);
+      printf("------\n");
+      delete[] error;
+      error = NULL;
+      assert(0);
+    }
+  }
+}
+  
+extern GLuint rx_create_program(GLuint vert, GLuint frag, bool link) {
+  GLuint prog = glCreateProgram();
+  glAttachShader(prog, vert);
+  glAttachShader(prog, frag);
+
+  if(link) {
+    glLinkProgram(prog);
+    rx_print_shader_link_info(prog);
+  }
+  return prog;
+}
+  
+extern GLuint rx_create_shader(GLenum type, const char* src) {
+  GLuint s = glCreateShader(type);
+  glShaderSource(s, 1, &src,  NULL);
+  glCompileShader(s);
+  rx_print_shader_compile_info(s);
+  return s;
+}
+
+
+extern GLuint rx_create_shader_from_file(GLenum type, std::string filepath) {
+
+  std::string source = rx_read_file(filepath);
+  if(!source.size()) {
+    printf("Error: cannot open the shader source: %s\n", filepath.c_str());
+    return -1;
+  }
+  
+  return rx_create_shader(type, source.c_str());
+}
+
+extern GLuint rx_create_program_with_attribs(GLuint vert, 
+                                             GLuint frag, 
+                                             int nattribs, 
+                                             const char** attribs) 
+{
+  GLuint prog = rx_create_program(vert, frag);
+  
+  if(attribs) {
+    for(int i = 0; i < nattribs; ++i) {
+      glBindAttribLocation(prog, i, attribs[i]);
+    }
+  }
+
+  glLinkProgram(prog);
+  rx_print_shader_link_info(prog);
+
+  return prog;
+}
+
+extern GLint rx_get_uniform_location(GLuint prog, std::string name) {
+#if !defined(NDEBUG)
+  GLint loc = glGetUniformLocation(prog, name.c_str());
+  if(loc < 0) {
+    printf("Error: cannot find the uniform: %s\n", name.c_str());
+  }
+#else
+  GLint loc = glGetUniformLocation(prog, name.c_str());
+#endif
+  
+  return loc;
+}
+
+extern void rx_uniform_1i(GLuint prog, std::string name, GLint v) {
+  glUniform1i(rx_get_uniform_location(prog, name), v);
+}
+
+extern void rx_uniform_1f(GLuint prog, std::string name, GLfloat v) {
+  glUniform1f(rx_get_uniform_location(prog, name), v);
+}
+
+extern void rx_uniform_mat4fv(GLuint prog, 
+                              std::string name, 
+                              GLsizei count, 
+                              GLboolean transpose, 
+                              const GLfloat* value) 
+{
+  glUniformMatrix4fv(rx_get_uniform_location(prog, name), count, transpose, value);
+}
+
+Program::~Program() {
+  for(std::vector<Shader*>::iterator it = created_shaders.begin(); it != created_shaders.end(); ++it) {
+    delete *it;
+  }
+  shaders.clear();
+  created_shaders.clear();
+}
+
+Program& Program::add(Shader* s) {
+
+  if(id < 0) {
+    id = glCreateProgram();
+  }
+
+  s->compile();
+
+  if(s->id < 0) {
+    printf("Error: a shader is not compiled yet!\n");
+    ::exit(EXIT_FAILURE);
+  }
+
+  glAttachShader(id, s->id);
+  
+  shaders.push_back(s);
+  return *this;
+}
+
+Program& Program::create(GLenum type, 
+                         std::string filepath, 
+                         std::string extraSource) 
+{
+  Shader* s = new Shader();
+  s->load(type, filepath, extraSource);
+  created_shaders.push_back(s);
+  return add(s);
+}
+
+Program& Program::link(int nattribs, 
+                       const char** atts, 
+                       int nfrags, 
+                       const char** fraglocs) 
+{
+
+  if(id < 0) {
+    printf("Error: first add a shader before linking.\n");
+    ::exit(EXIT_FAILURE);
+  }
+
+  if(nattribs) {
+    attribs.clear();
+    
+    for(int i = 0; i < nattribs; ++i) {
+      glBindAttribLocation(id, i, atts[i]);
+      attribs.push_back(atts[i]);
+    }
+  }
+
+  if(nfrags) {
+    frags.clear();
+    for(int i = 0; i < nfrags; ++i) {
+      glBindFragDataLocation(id, i, fraglocs[i]);
+      frags.push_back(fraglocs[i]);
+    }
+  }
+  
+  glLinkProgram(id);
+  rx_print_shader_link_info(id);
+
+  return *this;
+}
+
+Program& Program::recompile() {
+
+  if(id < 0) {
+    printf("Error: cannot recompile the program because we've not been created yet.\n");
+    ::exit(EXIT_FAILURE);
+  }
+
+  for(size_t i = 0; i < shaders.size(); ++i) {
+    shaders[i]->reload();
+    shaders[i]->compile();
+  }
+
+  for(size_t i = 0; i < attribs.size(); ++i) {
+    glBindAttribLocation(id, i, attribs[i].c_str());
+  }
+
+  for(size_t i = 0; i < frags.size(); ++i) {
+    glBindFragDataLocation(id, i, frags[i].c_str());
+  }
+
+  glLinkProgram(id);
+  rx_print_shader_link_info(id); 
+
+  return *this;
+}
+
+Shader& Shader::load(GLenum t, 
+                     std::string fp, 
+                     std::string extraSource)
+{
+
+  file_source = rx_read_file(fp);
+
+  if(!file_source.size()) {
+    printf("Error: cannot get contents for shader file: %s\n", fp.c_str());
+    ::exit(EXIT_FAILURE);
+  }
+
+  extra_source = extraSource;
+  filepath = fp;
+  type = t;
+  return *this;
+}
+
+Shader& Shader::compile() {
+
+  if(id < 0) {
+    id = glCreateShader(type);
+  }
+  
+  if(!file_source.size()) {
+    printf("Error: The source of the shader is empty, cannot compile.\n");
+    ::exit(EXIT_FAILURE);
+  }
+
+  std::string combined_source = extra_source +"\n" +file_source;
+  const char* src = combined_source.c_str();
+
+  glShaderSource(id, 1, &src, NULL);
+  glCompileShader(id);
+  rx_print_shader_compile_info(id);
+  return *this;
+}
+
+Shader& Shader::reload() {
+  return load(type, filepath, extra_source);
+}
+
+// -----------------------------------------------------
+
+StreamBuffer::StreamBuffer()
+  :id(0)
+  ,region_size(0)
+  ,num_regions(0)
+  ,region(0)
+  ,used(0)
+  ,is_persistent(false)
+  ,ptr(NULL)
+  ,num_waits(0)
+{
+}
+
+bool StreamBuffer::init(size_t nbytes, int numRegions, bool usePersistent) {
+
+  if (0 != id) {
+    printf("Error: the stream buffer is already initialized.\n");
+    return false;
+  }
+
+  if (0 == nbytes || numRegions < 1) {
+    printf("Error: invalid stream buffer size: %d, regions: %d\n", (int)nbytes, numRegions);
+    return false;
+  }
+
+  is_persistent = false;
+
+#if defined(GL_MAP_PERSISTENT_BIT)
+  if (usePersistent) {
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    is_persistent = (major > 4 || (major == 4 && minor >= 4));
+
+    GLint num_ext = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_ext);
+    for (GLint i = 0; i < num_ext && !is_persistent; ++i) {
+      const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+      is_persistent = (NULL != ext && 0 == strcmp(ext, "GL_ARB_buffer_storage"));
+    }
+  }
+#endif
+
+  num_regions = (is_persistent) ? numRegions : 1;
+  fences.assign(num_regions, (GLsync)0);
+
+  return create(nbytes);
+}
+
+bool StreamBuffer::create(size_t regionSize) {
+
+  if (0 != id) {
+    if (is_persistent) {
+      glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+      glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    glDeleteBuffers(1, &id);
+    id = 0;
+  }
+
+  for (size_t i = 0; i < fences.size(); ++i) {
+    if (fences[i]) {
+      glDeleteSync(fences[i]);
+      fences[i] = 0;
+    }
+  }
+
+  region_size = regionSize;
+  region = 0;
+  used = 0;
+  ptr = NULL;
+
+  glGenBuffers(1, &id);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+
+#if defined(GL_MAP_PERSISTENT_BIT)
+  if (is_persistent) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_WRITE_BUFFER, region_size * num_regions, NULL, flags);
+    ptr = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, region_size * num_regions, flags);
+    if (NULL == ptr) {
+      printf("Error: cannot map the persistent stream buffer.\n");
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  glBufferData(GL_COPY_WRITE_BUFFER, region_size, NULL, GL_STREAM_DRAW);
+
+  return true;
+}
+
+void StreamBuffer::shutdown() {
+
+  if (0 == id) {
+    return;
+  }
+
+  if (is_persistent) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+  }
+
+  for (size_t i = 0; i < fences.size(); ++i) {
+    if (fences[i]) {
+      glDeleteSync(fences[i]);
+    }
+  }
+
+  glDeleteBuffers(1, &id);
+
+  id = 0;
+  ptr = NULL;
+  fences.clear();
+}
+
+bool StreamBuffer::begin(size_t nbytes) {
+
+  if (0 == id) {
+    printf("Error: the stream buffer is not initialized.\n");
+    return false;
+  }
+
+  if (nbytes > region_size) {
+    if (false == create(HEIGHEST(nbytes, region_size * 2))) {
+      return false;
+    }
+  }
+
+  used = 0;
+
+  if (is_persistent) {
+
+    region = (region + 1) % num_regions;
+
+    GLsync sync = fences[region];
+    if (sync) {
+      GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+      if (GL_TIMEOUT_EXPIRED == result) {
+        num_waits++;
+        do {
+          result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);  /* 1 second */
+        } while (GL_TIMEOUT_EXPIRED == result);
+      }
+      glDeleteSync(sync);
+      fences[region] = 0;
+    }
+
+    return true;
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+  ptr = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, region_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (NULL == ptr) {
+    printf("Error: cannot map the stream buffer.\n");
+    return false;
+  }
+
+  return true;
+}
+
+void* StreamBuffer::alloc(size_t nbytes, size_t alignment, size_t& offset) {
+
+  if (NULL == ptr) {
+    return NULL;
+  }
+
+  size_t base = region * region_size;
+  size_t start = base + used;
+
+  if (alignment > 1) {
+    start = ((start + alignment - 1) / alignment) * alignment;
+  }
+
+  if (start + nbytes > base + region_size) {
+    printf("Error: stream buffer allocation of %d bytes doesn't fit, pass the correct size to begin().\n", (int)nbytes);
+    return NULL;
+  }
+
+  used = (start + nbytes) - base;
+  offset = start;
+
+  return (is_persistent) ? (ptr + start) : (ptr + (start - base));
+}
+
+void StreamBuffer::end() {
+
+  if (is_persistent || NULL == ptr) {
+    return;
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+  glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+  ptr = NULL;
+}
+
+void StreamBuffer::fence() {
+
+  if (!is_persistent) {
+    return;
+  }
+
+  if (fences[region]) {
+    glDeleteSync(fences[region]);
+  }
+
+  fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// -----------------------------------------------------
+
+TextureRegion::TextureRegion()
+  :target(GL_TEXTURE_2D)
+  ,tex(0)
+  ,page(0)
+  ,layer(0)
+  ,x(0)
+  ,y(0)
+  ,width(0)
+  ,height(0)
+  ,u0(0.0f)
+  ,v0(0.0f)
+  ,u1(1.0f)
+  ,v1(1.0f)
+{
+}
+
+// -----------------------------------------------------
+
+TextureAtlas::TextureAtlas()
+  :page_width(0)
+  ,page_height(0)
+  ,padding(0)
+{
+}
+
+bool TextureAtlas::init(int pageWidth, int pageHeight, int pad) {
+
+  if (pages.size()) {
+    printf("Error: the texture atlas is already initialized.\n");
+    return false;
+  }
+
+  if (pageWidth <= 0 || pageHeight <= 0 || pad < 0) {
+    printf("Error: invalid texture atlas page size: %d x %d, padding: %d\n", pageWidth, pageHeight, pad);
+    return false;
+  }
+
+  page_width = pageWidth;
+  page_height = pageHeight;
+  padding = pad;
+
+  return addPage();
+}
+
+void TextureAtlas::shutdown() {
+
+  if (pages.size()) {
+    glDeleteTextures(pages.size(), &pages[0]);
+  }
+
+  pages.clear();
+  skylines.clear();
+  used.clear();
+}
+
+bool TextureAtlas::addPage() {
+
+  GLuint tex = 0;
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, page_width, page_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  TextureAtlasNode node;
+  node.x = 0;
+  node.y = 0;
+  node.width = page_width;
+
+  pages.push_back(tex);
+  skylines.push_back(std::vector<TextureAtlasNode>(1, node));
+  used.push_back(0);
+
+  return true;
+}
+
+bool TextureAtlas::add(int w, int h, unsigned char* pixels, TextureRegion& region) {
+
+  if (0 == pages.size()) {
+    printf("Error: cannot add to the texture atlas, not initialized.\n");
+    return false;
+  }
+
+  if (NULL == pixels || w <= 0 || h <= 0) {
+    printf("Error: cannot add an invalid image to the texture atlas.\n");
+    return false;
+  }
+
+  int pw = w + 2 * padding;
+  int ph = h + 2 * padding;
+
+  if (pw > page_width || ph > page_height) {
+    printf("Error: the image (%d x %d) is too large for the texture atlas pages (%d x %d).\n", w, h, page_width, page_height);
+    return false;
+  }
+
+  /* Try the existing pages first, the newest one is the emptiest. */
+  int page = -1;
+  int node = -1;
+  int x = 0;
+  int y = 0;
+
+  for (int i = int(pages.size()) - 1; i >= 0; --i) {
+    node = findPosition(i, pw, ph, x, y);
+    if (node >= 0) {
+      page = i;
+      break;
+    }
+  }
+
+  if (page < 0) {
+    addPage();
+    page = int(pages.size()) - 1;
+    node = findPosition(page, pw, ph, x, y);
+  }
+
+  addNode(page, node, x, y, pw, ph);
+  used[page] += pw * ph;
+
+  /* Copy the image with a border that repeats the edge pixels. */
+  padded.resize(pw * ph * 4);
+  for (int j = 0; j < ph; ++j) {
+    int sy = CLAMP(j - padding, 0, h - 1);
+    for (int i = 0; i < pw; ++i) {
+      int sx = CLAMP(i - padding, 0, w - 1);
+      memcpy(&padded[(j * pw + i) * 4], pixels + (sy * w + sx) * 4, 4);
+    }
+  }
+
+  glBindTexture(GL_TEXTURE_2D, pages[page]);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, pw, ph, GL_RGBA, GL_UNSIGNED_BYTE, &padded[0]);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  region.target = GL_TEXTURE_2D;
+  region.tex = pages[page];
+  region.page = page;
+  region.layer = 0;
+  region.x = x + padding;
+  region.y = y + padding;
+  region.width = w;
+  region.height = h;
+  region.u0 = float(region.x) / page_width;
+  region.v0 = float(region.y) / page_height;
+  region.u1 = float(region.x + w) / page_width;
+  region.v1 = float(region.y + h) / page_height;
+
+  return true;
+}
+
+/* 
+   A rect that starts at a node covers that node and maybe some of the next 
+   ones; it has to be placed on top of the highest of them. We pick the 
+   position with the lowest top and when that's equal, the narrowest node 
+   so we waste less space.
+*/
+int TextureAtlas::findPosition(int page, int w, int h, int& x, int& y) {
+
+  std::vector<TextureAtlasNode>& skyline = skylines[page];
+  int best_node = -1;
+  int best_top = INT_MAX;
+  int best_width = INT_MAX;
+
+  for (size_t i = 0; i < skyline.size(); ++i) {
+
+    int nx = skyline[i].x;
+    if (nx + w > page_width) {
+      break;
+    }
+
+    int ny = 0;
+    int remaining = w;
+    for (size_t j = i; remaining > 0; ++j) {
+      ny = HEIGHEST(ny, skyline[j].y);
+      remaining -= skyline[j].width;
+    }
+
+    if (ny + h > page_height) {
+      continue;
+    }
+
+    if (ny + h < best_top || (ny + h == best_top && skyline[i].width < best_width)) {
+      best_node = int(i);
+      best_top = ny + h;
+      best_width = skyline[i].width;
+      x = nx;
+      y = ny;
+    }
+  }
+
+  return best_node;
+}
+
+void TextureAtlas::addNode(int page, int node, int x, int y, int w, int h) {
+
+  std::vector<TextureAtlasNode>& skyline = skylines[page];
+
+  TextureAtlasNode n;
+  n.x = x;
+  n.y = y + h;
+  n.width = w;
+  skyline.insert(skyline.begin() + node, n);
+
+  /* Shrink or remove the nodes that are now below the new node. */
+  size_t i = node + 1;
+  while (i < skyline.size()) {
+    int end = n.x + n.width;
+    if (skyline[i].x >= end) {
+      break;
+    }
+    int shrink = end - skyline[i].x;
+    if (shrink >= skyline[i].width) {
+      skyline.erase(skyline.begin() + i);
+      continue;
+    }
+    skyline[i].x += shrink;
+    skyline[i].width -= shrink;
+    break;
+  }
+
+  /* Merge neighbours at the same height. */
+  for (i = 0; i + 1 < skyline.size(); ) {
+    if (skyline[i].y == skyline[i + 1].y) {
+      skyline[i].width += skyline[i + 1].width;
+      skyline.erase(skyline.begin() + i + 1);
+    }
+    else {
+      ++i;
+    }
+  }
+}
+
+void TextureAtlas::print() {
+  printf("texture_atlas.pages: %d\n", (int)pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    printf("texture_atlas.page.%d: used: %.02f%%, skyline nodes: %d\n",
+           (int)i, 100.0f * float(used[i]) / (page_width * page_height), (int)skylines[i].size());
+  }
+}
+
+// -----------------------------------------------------
+
+TextureArray::TextureArray()
+  :tex(0)
+  ,width(0)
+  ,height(0)
+  ,num_layers(0)
+  ,layer(0)
+{
+}
+
+bool TextureArray::init(int w, int h, int numLayers) {
+
+  if (0 != tex) {
+    printf("Error: the texture array is already initialized.\n");
+    return false;
+  }
+
+  if (w <= 0 || h <= 0 || numLayers <= 0) {
+    printf("Error: invalid texture array size: %d x %d x %d\n", w, h, numLayers);
+    return false;
+  }
+
+  width = w;
+  height = h;
+  num_layers = numLayers;
+  layer = 0;
+
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, num_layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  return true;
+}
+
+void TextureArray::shutdown() {
+
+  if (0 != tex) {
+    glDeleteTextures(1, &tex);
+  }
+
+  tex = 0;
+  layer = 0;
+}
+
+bool TextureArray::add(unsigned char* pixels, TextureRegion& region) {
+
+  if (0 == tex) {
+    printf("Error: cannot add to the texture array, not initialized.\n");
+    return false;
+  }
+
+  if (layer >= num_layers) {
+    printf("Error: cannot add to the texture array, all %d layers are used.\n", num_layers);
+    return false;
+  }
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  region.target = GL_TEXTURE_2D_ARRAY;
+  region.tex = tex;
+  region.page = 0;
+  region.layer = layer;
+  region.x = 0;
+  region.y = 0;
+  region.width = width;
+  region.height = height;
+  region.u0 = 0.0f;
+  region.v0 = 0.0f;
+  region.u1 = 1.0f;
+  region.v1 = 1.0f;
+
+  layer++;
+
+  return true;
+}
+
+#endif //  defined(ROXLU_USE_OPENGL) && defined(ROXLU_IMPLEMENTATION)
+
+// ====================================================================================
+//                              R O X L U _ U S E _ O P E N G L 
+//                              R O X L U _ U S E _ M A T H
+// ====================================================================================
+#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_MATH) && defined(ROXLU_IMPLEMENTATION)
+
+/* Packs a [0, 1] color into RGBA8 with r in the lowest byte, see VertexPackedPC. */
+static uint32_t painter_pack_color(float r, float g, float b, float a) {
+  uint32_t ur = uint32_t(CLAMP(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+  uint32_t ug = uint32_t(CLAMP(g, 0.0f, 1.0f) * 255.0f + 0.5f);
+  uint32_t ub = uint32_t(CLAMP(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+  uint32_t ua = uint32_t(CLAMP(a, 0.0f, 1.0f) * 255.0f + 0.5f);
+  return ur | (ug << 8) | (ub << 16) | (ua << 24);
+}
+
+// -----------------------------------------------------
+
+PainterContextPT::PainterContextPT(Painter& painter)
+  :painter(painter)
+  ,buffer(&painter.stream)
+  ,shared(this)
+  ,num_commands(0)
+  ,vertex_offset(0)
+  ,vao(0)
+  ,vert(0)
+  ,frag(0)
+  ,prog(0)
+  ,frag_array(0)
+  ,prog_array(0)
+{
+}
+
+void PainterContextPT::init() {
+  vert = rx_create_shader(GL_VERTEX_SHADER, PAINTER_VERTEX_PT_VS);
+  frag = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_VERTEX_PT_SAMPLER2D_FS);
+  frag_array = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_VERTEX_PT_SAMPLER2DARRAY_FS);
+  prog = rx_create_program(vert, frag);
+  prog_array = rx_create_program(vert, frag_array);
+  glLinkProgram(prog);
+  glLinkProgram(prog_array);
+
+  glGenVertexArrays(1, &vao);
+
+  // bind ubo to binding 0
+  GLuint progs[] = { prog, prog_array };
+  for (int i = 0; i < 2; ++i) {
+    glUseProgram(progs[i]);
+    GLint block_dx = glGetUniformBlockIndex(progs[i], "Shared");
+    glUniformBlockBinding(progs[i], block_dx, 0);
+    glUniform1i(glGetUniformLocation(progs[i], "u_tex"), 0);
+  }
+}
+
+void PainterContextPT::shutdown() {
+
+  if (0 == vao) {
+    return;
+  }
+
+  glDeleteShader(vert);
+  glDeleteShader(frag);
+  glDeleteShader(frag_array);
+  glDeleteProgram(prog);
+  glDeleteProgram(prog_array);
+  glDeleteVertexArrays(1, &vao);
+}
+
+void PainterContextPT::texture(GLuint tex, float x, float y, float w, float h) {
+  addQuad(GL_TEXTURE_2D, tex, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, x, y, w, h);
+}
+
+void PainterContextPT::texture(const TextureRegion& region, float x, float y, float w, float h) {
+  addQuad(region.target, region.tex, float(region.layer), region.u0, region.v0, region.u1, region.v1, x, y, w, h);
+}
+
+void PainterContextPT::addQuad(GLenum target, GLuint tex, float layer, 
+                               float u0, float v0, float u1, float v1, 
+                               float x, float y, float w, float h) 
+{
+  num_commands++;
+
+  if (commands.size() && commands.back().tex == tex && commands.back().type == target) {
+    commands.back().count += 6;
+  }
+  else {
+    PainterCommand cmd;
+    cmd.type = target;
+    cmd.count = 6;
+    cmd.offset = vertices.size();
+    cmd.tex = tex;
+    commands.push_back(cmd);
+  }
+  
+  VertexPT3 a(vec3(x,     y + h, 0.0), vec3(u0, v1, layer)); // bottom left
+  VertexPT3 b(vec3(x + w, y + h, 0.0), vec3(u1, v1, layer)); // bottom right
+  VertexPT3 c(vec3(x + w,     y, 0.0), vec3(u1, v0, layer)); // top right
+  VertexPT3 d(vec3(x,         y, 0.0), vec3(u0, v0, layer)); // top left
+
+  vertices.push_back(a);
+  vertices.push_back(b);
+  vertices.push_back(c);
+  vertices.push_back(a);
+  vertices.push_back(c);
+  vertices.push_back(d);
+}
+
+static bool painter_command_sort(const PainterCommand& a, const PainterCommand& b) {
+  return (a.type != b.type) ? (a.type < b.type) : (a.tex < b.tex);
+}
+
+/* 
+   Reorders the vertices so every texture (e.g. atlas page) is one range and 
+   one draw call. The sort is stable so the textures keep their order on 
+   the same page.
+*/
+void PainterContextPT::sortCommands() {
+
+  std::stable_sort(commands.begin(), commands.end(), painter_command_sort);
+
+  sorted_vertices.resize(vertices.size());
+
+  size_t dx = 0;
+  size_t merged = 0;
+
+  for (size_t i = 0; i < commands.size(); ++i) {
+
+    PainterCommand cmd = commands[i];
+    std::copy(vertices.begin() + cmd.offset, vertices.begin() + cmd.offset + cmd.count, sorted_vertices.begin() + dx);
+    cmd.offset = dx;
+    dx += cmd.count;
+
+    if (merged > 0 && commands[merged - 1].tex == cmd.tex && commands[merged - 1].type == cmd.type) {
+      commands[merged - 1].count += cmd.count;
+    }
+    else {
+      commands[merged++] = cmd;
+    }
+  }
+
+  commands.resize(merged);
+  vertices.swap(sorted_vertices);
+}
+
+void PainterContextPT::clear() {
+  vertices.clear();
+  commands.clear();
+  num_commands = 0;
+}
+
+size_t PainterContextPT::getUploadSize() {
+  return (vertices.size()) ? (vertices.size() + 1) * sizeof(VertexPT3) : 0;
+}
+
+void PainterContextPT::update() {
+
+  if(vertices.size() == 0) {
+    return;
+  }
+
+  if (painter.sort_textures && commands.size() > 1) {
+    sortCommands();
+  }
+
+  void* dst = buffer->alloc(vertices.size() * sizeof(VertexPT3), sizeof(VertexPT3), vertex_offset);
+  if (NULL == dst) {
+    return;
+  }
+
+  memcpy(dst, vertices[0].ptr(), vertices.size() * sizeof(VertexPT3));
+}
+
+void PainterContextPT::draw() {
+
+  if(vertices.size() == 0) {
+    return;
+  }
+
+  glDisable(GL_DEPTH_TEST);
+  glBindVertexArray(shared->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer->id);
+  rx_vertex_attrib_pointers<VertexPT3>(); // pos, tex
+
+  glActiveTexture(GL_TEXTURE0);
+
+  GLint first = GLint(vertex_offset / sizeof(VertexPT3));
+  GLenum target = GL_NONE;
+
+  for(std::vector<PainterCommand>::iterator it = commands.begin(); it != commands.end(); ++it) {
+    PainterCommand& cmd = *it;
+    if (cmd.type != target) {
+      target = cmd.type;
+      glUseProgram((GL_TEXTURE_2D_ARRAY == target) ? shared->prog_array : shared->prog);
+    }
+    glBindTexture(cmd.type, cmd.tex);
+    glDrawArrays(GL_TRIANGLES, first + cmd.offset, cmd.count);
+  }
+}
+
+// -----------------------------------------------------
+
+PainterContextPC::PainterContextPC(Painter& painter) 
+  :painter(painter)
+  ,buffer(&painter.stream)
+  ,shared(this)
+  ,num_commands(0)
+  ,num_vertices(0)
+  ,num_indices(0)
+  ,vertex_offset(0)
+  ,index_offset(0)
+  ,vao(0)
+  ,vert(0)
+  ,frag(0)
+  ,prog(0)
+{
+}
+
+void PainterContextPC::init() {
+  
+  vert = rx_create_shader(GL_VERTEX_SHADER, PAINTER_VERTEX_PC_VS);
+  frag = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_VERTEX_PC_FS);
+  prog = rx_create_program(vert, frag);
+  glLinkProgram(prog);
+
+  glGenVertexArrays(1, &vao);
+
+  // bind ubo to binding 0
+  glUseProgram(prog);
+  GLint block_dx = glGetUniformBlockIndex(prog, "Shared");
+  glUniformBlockBinding(prog, block_dx, 0);
+}
+
+void PainterContextPC::shutdown() {
+  
+  if (0 == vao) {
+    return;
+  }
+
+  glDeleteVertexArrays(1, &vao);
+  glDeleteShader(vert);
+  glDeleteShader(frag);
+  glDeleteProgram(prog);
+}
+
+void PainterContextPC::rect(float x, float y, float w, float h) {
+
+  VertexPackedPC a(x, y + h, painter.packed_col); // bottom left
+  VertexPackedPC b(x + w, y + h, painter.packed_col); // bottom right
+  VertexPackedPC c(x + w, y, painter.packed_col); // top right
+  VertexPackedPC d(x, y, painter.packed_col); // top left
+
+  size_t first = vertices.size();
+
+  vertices.push_back(a);
+  vertices.push_back(b);
+  vertices.push_back(c);
+  vertices.push_back(d);
+
+  if(painter.state & PAINTER_STATE_FILL) {
+    addCommand(GL_TRIANGLE_FAN, first, 4); // (a, b, c), (a, c, d)
+  }
+  else {
+    addCommand(GL_LINE_LOOP, first, 4);
+  }
+}
+
+void PainterContextPC::clear() {
+  vertices.clear();
+  indices.clear();
+  commands.clear();
+  recorders.clear();
+  draws.clear();
+  num_commands = 0;
+  num_vertices = 0;
+  num_indices = 0;
+}
+
+void PainterContextPC::circle(float x, float y, float radius) {
+  
+  size_t first = vertices.size();
+  GLenum type = GL_LINE_STRIP;
+
+  if(painter.state & PAINTER_STATE_FILL) {
+    type = GL_TRIANGLE_FAN;
+    vertices.push_back(VertexPackedPC(x, y, painter.packed_col));
+  }
+
+  for(std::vector<vec2>::iterator it = painter.circle_data.begin(); it != painter.circle_data.end(); ++it) {
+    vec2& v= *it;
+    vertices.push_back(VertexPackedPC(x + v.x * radius, y + v.y * radius, painter.packed_col));
+  }
+
+  addCommand(type, first, vertices.size() - first);
+}
+
+void PainterContextPC::line(float x0, float y0, float x1, float y1) {
+  
+  size_t first = vertices.size();
+
+  VertexPackedPC a(x0, y0, painter.packed_col);
+  VertexPackedPC b(x1, y1, painter.packed_col);
+  vertices.push_back(a);
+  vertices.push_back(b);
+
+  addCommand(GL_LINES, first, 2);
+}
+
+void PainterContextPC::command(GLenum type, std::vector<VertexPackedPC>& v) {
+  
+  size_t first = vertices.size();
+  
+  std::copy(v.begin(), v.end(), std::back_inserter(vertices));
+
+  addCommand(type, first, v.size());
+}
+
+/* 
+   Fans, strips and loops can't be concatenated into one draw, so we convert 
+   every command into an indexed triangle, line or point list. Following
+   commands of the same primitive class then become one draw call; the 
+   order in which things are drawn stays the same. Returns false for an
+   unsupported type.
+*/
+static bool painter_add_command(GLenum type, size_t first, size_t num, 
+                                std::vector<uint32_t>& indices, 
+                                std::vector<PainterCommand>& commands) 
+{
+
+  GLenum list_type = GL_NONE;
+  uint32_t v = uint32_t(first);
+  uint32_t n = uint32_t(num);
+
+  switch (type) {
+
+    case GL_TRIANGLES: {
+      list_type = GL_TRIANGLES;
+      for (uint32_t i = 0; i + 2 < n; i += 3) {
+        indices.push_back(v + i);
+        indices.push_back(v + i + 1);
+        indices.push_back(v + i + 2);
+      }
+      break;
+    }
+    case GL_TRIANGLE_FAN: {
+      list_type = GL_TRIANGLES;
+      for (uint32_t i = 1; i + 1 < n; ++i) {
+        indices.push_back(v);
+        indices.push_back(v + i);
+        indices.push_back(v + i + 1);
+      }
+      break;
+    }
+    case GL_TRIANGLE_STRIP: {
+      list_type = GL_TRIANGLES;
+      for (uint32_t i = 0; i + 2 < n; ++i) {
+        indices.push_back(v + i + (i & 1));          /* every odd triangle swaps its first two vertices to keep the winding */
+        indices.push_back(v + i + 1 - (i & 1));
+        indices.push_back(v + i + 2);
+      }
+      break;
+    }
+    case GL_LINES: {
+      list_type = GL_LINES;
+      for (uint32_t i = 0; i + 1 < n; i += 2) {
+        indices.push_back(v + i);
+        indices.push_back(v + i + 1);
+      }
+      break;
+    }
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP: {
+      list_type = GL_LINES;
+      for (uint32_t i = 0; i + 1 < n; ++i) {
+        indices.push_back(v + i);
+        indices.push_back(v + i + 1);
+      }
+      if (type == GL_LINE_LOOP && n > 2) {
+        indices.push_back(v + n - 1);
+        indices.push_back(v);
+      }
+      break;
+    }
+    case GL_POINTS: {
+      list_type = GL_POINTS;
+      for (uint32_t i = 0; i < n; ++i) {
+        indices.push_back(v + i);
+      }
+      break;
+    }
+    default: {
+      printf("Error: unsupported painter command type: %d\n", type);
+      return false;
+    }
+  }
+
+  int count = int(indices.size());
+  if (commands.size()) {
+    count -= commands.back().offset + commands.back().count;
+  }
+
+  if (0 == count) {
+    return true;
+  }
+
+  if (commands.size() && commands.back().type == list_type) {
+    commands.back().count += count;
+    return true;
+  }
+
+  PainterCommand cmd;
+  cmd.type = list_type;
+  cmd.offset = int(indices.size()) - count;
+  cmd.count = count;
+  cmd.tex = 0;
+  commands.push_back(cmd);
+
+  return true;
+}
+
+void PainterContextPC::addCommand(GLenum type, size_t first, size_t num) {
+  if (painter_add_command(type, first, num, indices, commands)) {
+    num_commands++;
+  }
+}
+
+size_t PainterContextPC::getUploadSize() {
+
+  num_vertices = vertices.size();
+  num_indices = indices.size();
+
+  for (size_t i = 0; i < recorders.size(); ++i) {
+    num_vertices += recorders[i]->vertices.size();
+    num_indices += recorders[i]->indices.size();
+  }
+
+  if (num_indices == 0) {
+    return 0;
+  }
+
+  return (num_vertices + 1) * sizeof(VertexPackedPC) + (num_indices + 1) * sizeof(uint32_t);
+}
+
+/*
+  Our own vertices and indices are copied first, followed by those of the 
+  recorders in the order they were handed out. The indices of a recorder 
+  start at 0, so they are rebased on the number of vertices before it and
+  its commands on the number of indices before it. Following commands of 
+  the same type are merged like in addCommand().
+*/
+void PainterContextPC::update() {
+
+  draws.clear();
+
+  if(getUploadSize() == 0) {
+    return;
+  }
+
+  StreamBuffer& stream = *buffer;
+  char* dst_vertices = (char*)stream.alloc(num_vertices * sizeof(VertexPackedPC), sizeof(VertexPackedPC), vertex_offset);
+  uint32_t* dst_indices = (uint32_t*)stream.alloc(num_indices * sizeof(uint32_t), sizeof(uint32_t), index_offset);
+  if (NULL == dst_vertices || NULL == dst_indices) {
+    return;
+  }
+
+  if (vertices.size()) {
+    memcpy(dst_vertices, vertices[0].ptr(), vertices.size() * sizeof(VertexPackedPC));
+  }
+  if (indices.size()) {
+    memcpy(dst_indices, &indices[0], indices.size() * sizeof(uint32_t));
+  }
+
+  draws = commands;
+
+  uint32_t base_vertex = vertices.size();
+  int base_index = int(indices.size());
+
+  for (size_t i = 0; i < recorders.size(); ++i) {
+
+    PainterRecorder* rec = recorders[i];
+    if (0 == rec->indices.size()) {
+      continue;
+    }
+
+    memcpy(dst_vertices + base_vertex * sizeof(VertexPackedPC), rec->vertices[0].ptr(), rec->vertices.size() * sizeof(VertexPackedPC));
+
+    uint32_t* dst = dst_indices + base_index;
+    for (size_t j = 0; j < rec->indices.size(); ++j) {
+      dst[j] = rec->indices[j] + base_vertex;
+    }
+
+    for (size_t j = 0; j < rec->commands.size(); ++j) {
+      PainterCommand cmd = rec->commands[j];
+      cmd.offset += base_index;
+      if (draws.size() && draws.back().type == cmd.type) {
+        draws.back().count += cmd.count;
+      }
+      else {
+        draws.push_back(cmd);
+      }
+    }
+
+    base_vertex += rec->vertices.size();
+    base_index += int(rec->indices.size());
+  }
+}
+
+void PainterContextPC::draw() {
+  
+  if(draws.size() == 0) {
+    return;
+  }
+
+  /* The vao is shared with the layers, so we point it to our buffer every draw. */
+  glUseProgram(shared->prog);
+  glBindVertexArray(shared->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer->id);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->id);
+  rx_vertex_attrib_pointers<VertexPackedPC>(); // pos, col
+
+  GLint base_vertex = GLint(vertex_offset / sizeof(VertexPackedPC));
+
+  for(std::vector<PainterCommand>::iterator it = draws.begin(); it != draws.end(); ++it) {
+    PainterCommand& cmd = *it;
+    glDrawElementsBaseVertex(cmd.type, cmd.count, GL_UNSIGNED_INT, (GLvoid*)(index_offset + cmd.offset * sizeof(uint32_t)), base_vertex);
+  }
+}
+
+// -----------------------------------------------------
+
+PainterRecorder::PainterRecorder(Painter& painter)
+  :painter(painter)
+  ,num_commands(0)
+  ,first_vertex(0)
+  ,command_type(GL_TRIANGLES)
+  ,col(0xFFFFFFFF)
+  ,state(PAINTER_STATE_NONE)
+{
+}
+
+void PainterRecorder::clear() {
+  vertices.clear();
+  indices.clear();
+  commands.clear();
+  num_commands = 0;
+}
+
+void PainterRecorder::color(float r, float g, float b, float a) {
+  col = painter_pack_color(r, g, b, a);
+}
+
+void PainterRecorder::fill() {
+  state |= PAINTER_STATE_FILL;
+}
+
+void PainterRecorder::nofill() {
+  state &= ~PAINTER_STATE_FILL;
+}
+
+void PainterRecorder::rect(float x, float y, float w, float h) {
+
+  size_t first = vertices.size();
+
+  vertices.push_back(VertexPackedPC(x, y + h, col)); // bottom left
+  vertices.push_back(VertexPackedPC(x + w, y + h, col)); // bottom right
+  vertices.push_back(VertexPackedPC(x + w, y, col)); // top right
+  vertices.push_back(VertexPackedPC(x, y, col)); // top left
+
+  if (painter_add_command((state & PAINTER_STATE_FILL) ? GL_TRIANGLE_FAN : GL_LINE_LOOP, first, 4, indices, commands)) {
+    num_commands++;
+  }
+}
+
+void PainterRecorder::circle(float x, float y, float radius) {
+
+  size_t first = vertices.size();
+  GLenum type = GL_LINE_STRIP;
+
+  if (state & PAINTER_STATE_FILL) {
+    type = GL_TRIANGLE_FAN;
+    vertices.push_back(VertexPackedPC(x, y, col));
+  }
+
+  const std::vector<vec2>& circle_data = painter.circle_data;
+  for (size_t i = 0; i < circle_data.size(); ++i) {
+    vertices.push_back(VertexPackedPC(x + circle_data[i].x * radius, y + circle_data[i].y * radius, col));
+  }
+
+  if (painter_add_command(type, first, vertices.size() - first, indices, commands)) {
+    num_commands++;
+  }
+}
+
+void PainterRecorder::line(float x0, float y0, float x1, float y1) {
+
+  size_t first = vertices.size();
+
+  vertices.push_back(VertexPackedPC(x0, y0, col));
+  vertices.push_back(VertexPackedPC(x1, y1, col));
+
+  if (painter_add_command(GL_LINES, first, 2, indices, commands)) {
+    num_commands++;
+  }
+}
+
+void PainterRecorder::begin(GLenum type) {
+  command_type = type;
+  first_vertex = vertices.size();
+}
+
+void PainterRecorder::vertex(float x, float y) {
+  vertices.push_back(VertexPackedPC(x, y, col));
+}
+
+void PainterRecorder::end() {
+  if (painter_add_command(command_type, first_vertex, vertices.size() - first_vertex, indices, commands)) {
+    num_commands++;
+  }
+}
+
+// -----------------------------------------------------
+
+PainterContextInstanced::PainterContextInstanced(Painter& painter)
+  :painter(painter)
+  ,buffer(&painter.stream)
+  ,shared(this)
+  ,sdf_offset(0)
+  ,mesh_resolution(0)
+  ,vao(0)
+  ,mesh_vbo(0)
+  ,vert(0)
+  ,frag(0)
+  ,prog(0)
+  ,sdf_vao(0)
+  ,sdf_vert(0)
+  ,sdf_frag(0)
+  ,sdf_prog(0)
+{
+  for (int i = 0; i < PAINTER_SHAPE_COUNT; ++i) {
+    instance_offsets[i] = 0;
+    mesh_types[i] = GL_TRIANGLES;
+    mesh_offsets[i] = 0;
+    mesh_counts[i] = 0;
+  }
+}
+
+void PainterContextInstanced::init() {
+
+  vert = rx_create_shader(GL_VERTEX_SHADER, PAINTER_INSTANCED_VS);
+  frag = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_VERTEX_PC_FS);
+  prog = rx_create_program(vert, frag);
+  glLinkProgram(prog);
+
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+
+  glGenBuffers(1, &mesh_vbo);
+
+  glBindBuffer(GL_ARRAY_BUFFER, mesh_vbo);
+  glEnableVertexAttribArray(0); // unit mesh
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2), (GLvoid*)0);
+
+  glEnableVertexAttribArray(1); // x, y, w, h
+  glEnableVertexAttribArray(2); // col
+  glVertexAttribDivisor(1, 1);
+  glVertexAttribDivisor(2, 1);
+
+  createMeshes();
+
+  /* SDF shapes: unit quad + x, y, w, h + radius, stroke + col */
+  sdf_vert = rx_create_shader(GL_VERTEX_SHADER, PAINTER_SDF_VS);
+  sdf_frag = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_SDF_FS);
+  sdf_prog = rx_create_program(sdf_vert, sdf_frag);
+  glLinkProgram(sdf_prog);
+
+  glGenVertexArrays(1, &sdf_vao);
+  glBindVertexArray(sdf_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, mesh_vbo);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2), (GLvoid*)0);
+
+  for (GLuint i = 1; i <= 3; ++i) {
+    glEnableVertexAttribArray(i);
+    glVertexAttribDivisor(i, 1);
+  }
+
+  // bind ubo to binding 0
+  GLuint progs[] = { prog, sdf_prog };
+  for (int i = 0; i < 2; ++i) {
+    glUseProgram(progs[i]);
+    GLint block_dx = glGetUniformBlockIndex(progs[i], "Shared");
+    glUniformBlockBinding(progs[i], block_dx, 0);
+  }
+}
+
+void PainterContextInstanced::shutdown() {
+
+  if (0 == vao) {
+    return;
+  }
+
+  glDeleteVertexArrays(1, &vao);
+  glDeleteVertexArrays(1, &sdf_vao);
+  glDeleteBuffers(1, &mesh_vbo);
+  glDeleteShader(vert);
+  glDeleteShader(frag);
+  glDeleteShader(sdf_vert);
+  glDeleteShader(sdf_frag);
+  glDeleteProgram(prog);
+  glDeleteProgram(sdf_prog);
+}
+
+void PainterContextInstanced::createMeshes() {
+
+  std::vector<vec2> verts;
+
+  /* Rects span [0, 1] and are scaled by w/h; same corners as PainterContextPC::rect(). */
+  mesh_types[PAINTER_SHAPE_RECT_FILL] = GL_TRIANGLES;
+  mesh_offsets[PAINTER_SHAPE_RECT_FILL] = verts.size();
+  verts.push_back(vec2(0.0f, 1.0f));
+  verts.push_back(vec2(1.0f, 1.0f));
+  verts.push_back(vec2(1.0f, 0.0f));
+  verts.push_back(vec2(0.0f, 1.0f));
+  verts.push_back(vec2(1.0f, 0.0f));
+  verts.push_back(vec2(0.0f, 0.0f));
+
+  mesh_types[PAINTER_SHAPE_RECT_OUTLINE] = GL_LINE_LOOP;
+  mesh_offsets[PAINTER_SHAPE_RECT_OUTLINE] = verts.size();
+  verts.push_back(vec2(0.0f, 1.0f));
+  verts.push_back(vec2(1.0f, 1.0f));
+  verts.push_back(vec2(1.0f, 0.0f));
+  verts.push_back(vec2(0.0f, 0.0f));
+
+  /* Circles have radius 1 around the origin and are scaled by the radius. */
+  mesh_types[PAINTER_SHAPE_CIRCLE_FILL] = GL_TRIANGLE_FAN;
+  mesh_offsets[PAINTER_SHAPE_CIRCLE_FILL] = verts.size();
+  verts.push_back(vec2(0.0f, 0.0f));
+  std::copy(painter.circle_data.begin(), painter.circle_data.end(), std::back_inserter(verts));
+
+  mesh_types[PAINTER_SHAPE_CIRCLE_OUTLINE] = GL_LINE_STRIP;
+  mesh_offsets[PAINTER_SHAPE_CIRCLE_OUTLINE] = verts.size();
+  std::copy(painter.circle_data.begin(), painter.circle_data.end(), std::back_inserter(verts));
+
+  for (int i = 0; i < PAINTER_SHAPE_COUNT; ++i) {
+    GLint end = (i + 1 < PAINTER_SHAPE_COUNT) ? mesh_offsets[i + 1] : GLint(verts.size());
+    mesh_counts[i] = end - mesh_offsets[i];
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, mesh_vbo);
+  glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(vec2), verts[0].ptr(), GL_STATIC_DRAW);
+
+  mesh_resolution = painter.circle_resolution;
+}
+
+void PainterContextInstanced::clear() {
+  for (int i = 0; i < PAINTER_SHAPE_COUNT; ++i) {
+    instances[i].clear();
+  }
+  sdf_instances.clear();
+}
+
+void PainterContextInstanced::rect(float x, float y, float w, float h) {
+
+  PainterInstance inst;
+  inst.rect[0] = x;
+  inst.rect[1] = y;
+  inst.rect[2] = w;
+  inst.rect[3] = h;
+  inst.color = painter.packed_col;
+
+  instances[(painter.state & PAINTER_STATE_FILL) ? PAINTER_SHAPE_RECT_FILL : PAINTER_SHAPE_RECT_OUTLINE].push_back(inst);
+}
+
+void PainterContextInstanced::circle(float x, float y, float radius) {
+
+  PainterInstance inst;
+  inst.rect[0] = x;
+  inst.rect[1] = y;
+  inst.rect[2] = radius;
+  inst.rect[3] = radius;
+  inst.color = painter.packed_col;
+
+  instances[(painter.state & PAINTER_STATE_FILL) ? PAINTER_SHAPE_CIRCLE_FILL : PAINTER_SHAPE_CIRCLE_OUTLINE].push_back(inst);
+}
+
+void PainterContextInstanced::sdfRect(float x, float y, float w, float h, float radius) {
+
+  /* Negative sizes are allowed for the other paths, so we normalize them here. */
+  if (w < 0.0f) {
+    x += w;
+    w = -w;
+  }
+  if (h < 0.0f) {
+    y += h;
+    h = -h;
+  }
+
+  PainterSDFInstance inst;
+  inst.rect[0] = x;
+  inst.rect[1] = y;
+  inst.rect[2] = w;
+  inst.rect[3] = h;
+  inst.radius = CLAMP(radius, 0.0f, 0.5f * LOWEST(w, h));
+  inst.stroke = (painter.state & PAINTER_STATE_FILL) ? 0.0f : HEIGHEST(painter.line_width, 0.0f);
+  inst.color = painter.packed_col;
+
+  sdf_instances.push_back(inst);
+}
+
+void PainterContextInstanced::sdfCircle(float x, float y, float radius) {
+  radius = fabsf(radius);
+  sdfRect(x - radius, y - radius, 2.0f * radius, 2.0f * radius, radius);
+}
+
+size_t PainterContextInstanced::getUploadSize() {
+  size_t needed = 0;
+  for (int i = 0; i < PAINTER_SHAPE_COUNT; ++i) {
+    needed += (instances[i].size()) ? (instances[i].size() * sizeof(PainterInstance) + sizeof(float)) : 0;
+  }
+  needed += (sdf_instances.size()) ? (sdf_instances.size() * sizeof(PainterSDFInstance) + sizeof(float)) : 0;
+  return needed;
+}
+
+void PainterContextInstanced::update() {
+
+  /* Every kind gets its own range in the stream buffer; draw() points the instance attributes to it. */
+  for (int i = 0; i < PAINTER_SHAPE_COUNT; ++i) {
+    if (0 == instances[i].size()) {
+      continue;
+    }
+    size_t nbytes = instances[i].size() * sizeof(PainterInstance);
+    void* dst = buffer->alloc(nbytes, sizeof(float), instance_offsets[i]);
+    if (NULL == dst) {
+      return;
+    }
+    memcpy(dst, &instances[i][0], nbytes);
+  }
+
+  if (sdf_instances.size()) {
+    size_t nbytes = sdf_instances.size() * sizeof(PainterSDFInstance);
+    void* dst = buffer->alloc(nbytes, sizeof(float), sdf_offset);
+    if (NULL == dst) {
+      return;
+    }
+    memcpy(dst, &sdf_instances[0], nbytes);
+  }
+}
+
+void PainterContextInstanced::draw() {
+
+  PainterContextInstanced& gl = *shared;
+  if (gl.mesh_resolution != painter.circle_resolution) {
+    gl.createMeshes();
+  }
+
+  glUseProgram(gl.prog);
+  glBindVertexArray(gl.vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer->id);
+
+  for (int i = 0; i < PAINTER_SHAPE_COUNT; ++i) {
+
+    if (0 == instances[i].size()) {
+      continue;
+    }
+
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PainterInstance), (GLvoid*)(instance_offsets[i] + offsetof(PainterInstance, rect)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PainterInstance), (GLvoid*)(instance_offsets[i] + offsetof(PainterInstance, color)));
+    glDrawArraysInstanced(gl.mesh_types[i], gl.mesh_offsets[i], gl.mesh_counts[i], instances[i].size());
+  }
+
+  if (sdf_instances.size()) {
+    glUseProgram(gl.sdf_prog);
+    glBindVertexArray(gl.sdf_vao);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PainterSDFInstance), (GLvoid*)(sdf_offset + offsetof(PainterSDFInstance, rect)));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(PainterSDFInstance), (GLvoid*)(sdf_offset + offsetof(PainterSDFInstance, radius)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PainterSDFInstance), (GLvoid*)(sdf_offset + offsetof(PainterSDFInstance, color)));
+    glDrawArraysInstanced(GL_TRIANGLES, gl.mesh_offsets[PAINTER_SHAPE_RECT_FILL], gl.mesh_counts[PAINTER_SHAPE_RECT_FILL], sdf_instances.size());
+  }
+}
+
+// -----------------------------------------------------
+
+PainterContextPolyline::PainterContextPolyline(Painter& painter)
+  :painter(painter)
+  ,buffer(&painter.stream)
+  ,shared(this)
+  ,num_polylines(0)
+  ,vao(0)
+  ,vert(0)
+  ,frag(0)
+  ,prog(0)
+  ,u_round(-1)
+{
+  for (int i = 0; i < PAINTER_JOIN_COUNT; ++i) {
+    point_offsets[i] = 0;
+  }
+}
+
+void PainterContextPolyline::init() {
+
+  vert = rx_create_shader(GL_VERTEX_SHADER, PAINTER_POLYLINE_VS);
+  frag = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_POLYLINE_FS);
+  prog = rx_create_program(vert, frag);
+  glLinkProgram(prog);
+
+  /* All attributes are per instance; the vertices of the quad are selected with gl_VertexID. */
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+  for (GLuint i = 0; i < 6; ++i) {
+    glEnableVertexAttribArray(i);
+    glVertexAttribDivisor(i, 1);
+  }
+
+  // bind ubo to binding 0
+  glUseProgram(prog);
+  GLint block_dx = glGetUniformBlockIndex(prog, "Shared");
+  glUniformBlockBinding(prog, block_dx, 0);
+  u_round = glGetUniformLocation(prog, "u_round");
+}
+
+void PainterContextPolyline::shutdown() {
+
+  if (0 == vao) {
+    return;
+  }
+
+  glDeleteVertexArrays(1, &vao);
+  glDeleteShader(vert);
+  glDeleteShader(frag);
+  glDeleteProgram(prog);
+}
+
+void PainterContextPolyline::clear() {
+  for (int i = 0; i < PAINTER_JOIN_COUNT; ++i) {
+    points[i].clear();
+  }
+  num_polylines = 0;
+}
+
+void PainterContextPolyline::line(float x0, float y0, float x1, float y1) {
+
+  PainterPolylinePoint pts[2];
+  pts[0].pos[0] = x0;
+  pts[0].pos[1] = y0;
+  pts[1].pos[0] = x1;
+  pts[1].pos[1] = y1;
+  pts[0].width = pts[1].width = painter.line_width;
+  pts[0].color = pts[1].color = painter.packed_col;
+
+  polyline(pts, 2, false);
+}
+
+/*
+  An instance draws the segment between its 2nd and 3rd point and uses the 
+  1st and 4th for the joins. We add a padding point before and after every
+  polyline so the first and last segment have neighbours; for an open 
+  polyline they're on the end points (butt caps), for a closed one they're
+  the neighbours across the closing segment. The padding points have a 
+  negative width so the segments between two polylines are skipped.
+*/
+void PainterContextPolyline::polyline(const PainterPolylinePoint* pts, size_t num, bool closed) {
+
+  if (NULL == pts || num < 2) {
+    return;
+  }
+
+  std::vector<PainterPolylinePoint>& dest = points[(painter.line_join == PAINTER_JOIN_ROUND) ? PAINTER_JOIN_ROUND : PAINTER_JOIN_MITER];
+  PainterPolylinePoint pad = closed ? pts[num - 1] : pts[0];
+  pad.width = -1.0f;
+
+  dest.reserve(dest.size() + num + 3);
+  dest.push_back(pad);
+  dest.insert(dest.end(), pts, pts + num);
+
+  if (closed) {
+    dest.push_back(pts[0]);
+    pad = pts[1];
+  }
+  else {
+    pad = pts[num - 1];
+  }
+
+  pad.width = -1.0f;
+  dest.push_back(pad);
+
+  num_polylines++;
+}
+
+size_t PainterContextPolyline::getUploadSize() {
+  size_t needed = 0;
+  for (int i = 0; i < PAINTER_JOIN_COUNT; ++i) {
+    needed += (points[i].size()) ? (points[i].size() * sizeof(PainterPolylinePoint) + sizeof(float)) : 0;
+  }
+  return needed;
+}
+
+void PainterContextPolyline::update() {
+
+  for (int i = 0; i < PAINTER_JOIN_COUNT; ++i) {
+    if (0 == points[i].size()) {
+      continue;
+    }
+    size_t nbytes = points[i].size() * sizeof(PainterPolylinePoint);
+    void* dst = buffer->alloc(nbytes, sizeof(float), point_offsets[i]);
+    if (NULL == dst) {
+      return;
+    }
+    memcpy(dst, &points[i][0], nbytes);
+  }
+}
+
+void PainterContextPolyline::draw() {
+
+  if (0 == num_polylines) {
+    return;
+  }
+
+  glUseProgram(shared->prog);
+  glBindVertexArray(shared->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer->id);
+
+  GLsizei stride = sizeof(PainterPolylinePoint);
+
+  for (int i = 0; i < PAINTER_JOIN_COUNT; ++i) {
+
+    if (points[i].size() < 4) {
+      continue;
+    }
+
+    /* Instance j reads the points j, j + 1, j + 2 and j + 3. */
+    size_t offset = point_offsets[i];
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(offset));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(offset + stride));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid*)(offset + stride + offsetof(PainterPolylinePoint, color)));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(offset + 2 * stride));
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid*)(offset + 2 * stride + offsetof(PainterPolylinePoint, color)));
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(offset + 3 * stride));
+
+    glUniform1i(shared->u_round, (i == PAINTER_JOIN_ROUND) ? 1 : 0);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, points[i].size() - 3);
+  }
+}
+
+// -----------------------------------------------------
+
+PainterLayer::PainterLayer(Painter& painter, std::string name)
+  :name(name)
+  ,order(0)
+  ,is_dirty(false)
+  ,is_visible(true)
+  ,num_uploads(0)
+  ,context_pc(painter)
+  ,context_pt(painter)
+  ,context_instanced(painter)
+  ,context_polyline(painter)
+{
+  context_pc.buffer = &buffer;
+  context_pt.buffer = &buffer;
+  context_instanced.buffer = &buffer;
+  context_polyline.buffer = &buffer;
+
+  /* The programs and vaos are created once, by the contexts of the Painter. */
+  context_pc.shared = &painter.context_pc;
+  context_pt.shared = &painter.context_pt;
+  context_instanced.shared = &painter.context_instanced;
+  context_polyline.shared = &painter.context_polyline;
+}
+
+void PainterLayer::init() {
+
+  /* One region without persistent mapping: the data stays in the buffer until the layer changes. */
+  buffer.init(4096, 1, false);
+}
+
+void PainterLayer::shutdown() {
+  buffer.shutdown();
+}
+
+void PainterLayer::clear() {
+
+  context_pc.clear();
+  context_pt.clear();
+  context_instanced.clear();
+  context_polyline.clear();
+
+  is_dirty = true;
+}
+
+void PainterLayer::update() {
+
+  if (!is_dirty) {
+    return;
+  }
+
+  is_dirty = false;
+
+  size_t needed = context_pc.getUploadSize() + context_polyline.getUploadSize() + context_instanced.getUploadSize() + context_pt.getUploadSize();
+  if (0 == needed || false == buffer.begin(needed)) {
+    return;
+  }
+
+  context_pc.update();
+  context_polyline.update();
+  context_instanced.update();
+  context_pt.update();
+
+  buffer.end();
+  num_uploads++;
+}
+
+void PainterLayer::draw() {
+
+  if (!is_visible) {
+    return;
+  }
+
+  context_pc.draw();
+  context_polyline.draw();
+  context_instanced.draw();
+  context_pt.draw();
+}
+
+// -----------------------------------------------------
+
+Painter::Painter() 
+  :context_pc(*this)
+  ,context_pt(*this)
+  ,context_instanced(*this)
+  ,context_polyline(*this)
+  ,num_recorders(0)
+  ,active_layer(NULL)
+  ,active_pc(&context_pc)
+  ,active_pt(&context_pt)
+  ,active_instanced(&context_instanced)
+  ,active_polyline(&context_polyline)
+  ,circle_resolution(8)
+  ,line_width(1.0f)
+  ,line_join(PAINTER_JOIN_MITER)
+  ,sort_textures(false)
+  ,has_cull_rect(false)
+  ,cull_size(0.0f)
+  ,num_culled(0)
+  ,num_rejected(0)
+  ,state(PAINTER_STATE_NONE)
+  ,ubo(0)
+  ,needs_update(false)
+  ,is_streamed(false)
+  ,win_w(0)
+  ,win_h(0)
+  ,command_type(GL_NONE)
+  ,context_type(0)
+{
+
+  col[0] = 1.0f;
+  col[1] = 0.0f;
+  col[2] = 0.0f;
+  col[3] = 1.0f;
+  packed_col = packColor();
+
+  cull_rect[0] = 0.0f;
+  cull_rect[1] = 0.0f;
+  cull_rect[2] = 0.0f;
+  cull_rect[3] = 0.0f;
+
+  resolution(circle_resolution);
+}
+
+void Painter::init() {
+
+  context_pc.init();
+  context_pt.init();
+  context_instanced.init();
+  context_polyline.init();
+
+  stream.init();
+  needs_update = true;
+
+  /* Layers that were created before init(), see layer(). */
+  for (size_t i = 0; i < layers.size(); ++i) {
+    if (0 == layers[i]->buffer.id) {
+      layers[i]->init();
+      layers[i]->is_dirty = true;
+    }
+  }
+  
+  glGenBuffers(1, &ubo);
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(PainterShared), NULL, GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  resize(viewport[2], viewport[3]);
+}
+
+void Painter::shutdown() {
+
+  context_pc.shutdown();
+  context_pt.shutdown();
+  context_instanced.shutdown();
+  context_polyline.shutdown();
+
+  stream.shutdown();
+
+  for (size_t i = 0; i < layers.size(); ++i) {
+    layers[i]->shutdown();
+    delete layers[i];
+  }
+  layers.clear();
+  nolayer();
+
+  for (size_t i = 0; i < recorder_pool.size(); ++i) {
+    delete recorder_pool[i];
+  }
+  recorder_pool.clear();
+  num_recorders = 0;
+  is_streamed = false;
+  
+  glDeleteBuffers(1, &ubo);
+}
+
+void Painter::clear() {
+  context_pc.clear();
+  context_pt.clear();
+  context_instanced.clear();
+  context_polyline.clear();
+  num_recorders = 0;
+  num_culled = 0;
+  num_rejected = 0;
+  needs_update = true;
+}
+
+/*
+  The recorders are handed out in order and stitched in that same order, 
+  so the result doesn't depend on which thread finishes first. A recorder 
+  is cleared when it's handed out again after the next clear(), which
+  keeps its memory allocated, so after a couple of frames recording 
+  doesn't allocate anymore.
+*/
+PainterRecorder* Painter::recorder() {
+
+  if (num_recorders == recorder_pool.size()) {
+    recorder_pool.push_back(new PainterRecorder(*this));
+  }
+
+  PainterRecorder* rec = recorder_pool[num_recorders++];
+  rec->clear();
+  rec->col = packed_col;
+  rec->state = state & PAINTER_STATE_FILL;
+
+  context_pc.recorders.push_back(rec);
+
+  return rec;
+}
+
+void Painter::resolution(int n) {
+  
+  float a = TWO_PI / float(n);
+  circle_resolution = n;
+  circle_data.clear();
+  for(int i = 0; i <= n; ++i) {
+    circle_data.push_back(vec2(cosf(a * i), sinf(a * i)));
+  }
+}
+
+void Painter::rect(float x, float y, float w, float h) {
+  if (isCulled(x, y, x + w, y + h, (state & PAINTER_STATE_FILL) ? 0.0f : (state & PAINTER_STATE_SDF) ? 0.5f * line_width : 0.5f)) {
+    return;
+  }
+  if (state & PAINTER_STATE_SDF) {
+    active_instanced->sdfRect(x, y, w, h, 0.0f);
+  }
+  else if (state & PAINTER_STATE_INSTANCED) {
+    active_instanced->rect(x, y, w, h);
+  }
+  else {
+    active_pc->rect(x, y, w, h);
+  }
+  setDirty();
+}
+
+void Painter::circle(float x, float y, float radius) {
+  if (isCulled(x - radius, y - radius, x + radius, y + radius, (state & PAINTER_STATE_FILL) ? 0.0f : (state & PAINTER_STATE_SDF) ? 0.5f * line_width : 0.5f)) {
+    return;
+  }
+  if (state & PAINTER_STATE_SDF) {
+    active_instanced->sdfCircle(x, y, radius);
+  }
+  else if (state & PAINTER_STATE_INSTANCED) {
+    active_instanced->circle(x, y, radius);
+  }
+  else {
+    active_pc->circle(x, y, radius);
+  }
+  setDirty();
+}
+
+void Painter::roundedRect(float x, float y, float w, float h, float radius) {
+  if (isCulled(x, y, x + w, y + h, (state & PAINTER_STATE_FILL) ? 0.0f : 0.5f * line_width)) {
+    return;
+  }
+  active_instanced->sdfRect(x, y, w, h, radius);
+  setDirty();
+}
+
+void Painter::line(float x0, float y0, float x1, float y1) {
+  if (isCulled(x0, y0, x1, y1, (state & PAINTER_STATE_POLYLINE) ? 0.5f * line_width : 0.5f)) {
+    return;
+  }
+  if (state & PAINTER_STATE_POLYLINE) {
+    active_polyline->line(x0, y0, x1, y1);
+  }
+  else {
+    active_pc->line(x0, y0, x1, y1);
+  }
+  setDirty();
+}
+
+void Painter::texture(GLuint tex, float x, float y, float w, float h) {
+  if (isCulled(x, y, x + w, y + h, 0.0f)) {
+    return;
+  }
+  active_pt->texture(tex, x, y, w, h);
+  setDirty();
+}
+
+void Painter::texture(const TextureRegion& region, float x, float y, float w, float h) {
+  if (isCulled(x, y, x + w, y + h, 0.0f)) {
+    return;
+  }
+  active_pt->texture(region, x, y, w, h);
+  setDirty();
+}
+
+void Painter::sortTextures(bool flag) {
+
+  sort_textures = flag;
+
+  /* The textures are sorted when they're written into the buffer. */
+  needs_update = true;
+  for (size_t i = 0; i < layers.size(); ++i) {
+    layers[i]->is_dirty = true;
+  }
+}
+
+void Painter::color(float r, float g, float b, float a) {
+
+  col[0] = r;
+  col[1] = g;
+  col[2] = b;
+  col[3] = a;
+  packed_col = packColor();
+}
+
+void Painter::rgba(int r, int g, int b, int a) {
+  float inv = 1.0f / 255.0f;
+  col[0] = r * inv;
+  col[1] = g * inv;
+  col[2] = b * inv;
+  col[3] = a * inv;
+  packed_col = uint32_t(CLAMP(r, 0, 255)) | (uint32_t(CLAMP(g, 0, 255)) << 8) | (uint32_t(CLAMP(b, 0, 255)) << 16) | (uint32_t(CLAMP(a, 0, 255)) << 24);
+}
+
+/* Convert hex string to color, e.g. hex("FF00CCFF") or hex("FFCC00"). */
+void Painter::hex(std::string str) {
+
+  unsigned int h;
+  std::stringstream ss;
+  ss << std::hex << str;
+  ss >> h;
+
+  if (str.size() == 6) {
+    int r = (h >> 16) & 0xFF;
+    int g = (h >> 8) & 0xFF;
+    int b = (h) & 0xFF;
+    rgba(r, g, b);
+  }
+  else if (str.size() == 8) {
+    int r = (h >> 24) & 0xFF;
+    int g = (h >> 16) & 0xFF;
+    int b = (h >> 8) & 0xFF;
+    int a = (h) & 0xFF;
+    rgba(r, g, b, a);
+  }
   else {
-    pixbuf = (unsigned char*)malloc(num_bytes); 
-  }
-  
-  if(!pixbuf) {
-    printf("Error: image is to big: %s\n", filepath.c_str());
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    fclose(fp);
-    fp = NULL;
-    return -8;
+    printf("error: invalid hex str.\n");
   }
+}
 
-   /* set the outgoing pixel buffer. */
-  *pixels = pixbuf;
-  
-  png_bytep* row_ptrs = (png_bytep*)malloc(sizeof(png_bytep) * height); 
-  if(!row_ptrs) {
-    printf("Error: image is to big: %s\n", filepath.c_str());
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    fclose(fp);
-    fp = NULL;
-    
-    /* free allocations */
-    free(*pixels);
-    *pixels = NULL;
-    if (NULL != allocated) {
-      *allocated = 0;
+void Painter::draw() {
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  /* 
+     When the shapes without layer changed they're written into the next region 
+     of the stream buffer, otherwise we draw the region we wrote last time again. 
+     Recorders are filled outside the Painter, so we always write them.
+  */
+  if (needs_update || num_recorders > 0) {
+    size_t needed = context_pc.getUploadSize() + context_polyline.getUploadSize() + context_instanced.getUploadSize() + context_pt.getUploadSize();
+    is_streamed = (needed > 0 && stream.begin(needed));
+    needs_update = (needed > 0 && false == is_streamed);
+    if (is_streamed) {
+      context_pc.update();
+      context_polyline.update();
+      context_instanced.update();
+      context_pt.update();
+      stream.end();
     }
+  }
 
-    return -9;
+  for (size_t i = 0; i < layers.size(); ++i) {
+    layers[i]->update();
   }
 
-  /*
-    Some code on github iterate over the number of passes (see interlace
-    above, but this doesn't seem to be necessary.
-  */
-  for(size_t i = 0; i < height; ++i) {
-    row_ptrs[i] = (png_bytep)(*pixels) +(i * stride);
+  size_t dx = 0;
+  for (; dx < layers.size() && layers[dx]->order < 0; ++dx) {
+    layers[dx]->draw();
   }
 
+  if (is_streamed) {
+    context_pc.draw();
+    context_polyline.draw();
+    context_instanced.draw();
+    context_pt.draw();
+  }
 
-  png_read_image(png_ptr, row_ptrs);
-  png_read_end(png_ptr, info_ptr);
+  for (; dx < layers.size(); ++dx) {
+    layers[dx]->draw();
+  }
 
-  free(row_ptrs);
-  row_ptrs = NULL;
-  png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-  fclose(fp);
+  if (is_streamed) {
+    stream.fence();
+  }
+}
 
-  return num_bytes;
+void Painter::resize(int w, int h) {
+
+  ubo_data.pm.ortho(0, w, h, 0, 0.0f, 100.0f);
+
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PainterShared), ubo_data.pm.ptr());
+
+  win_w = w;
+  win_h = h;
 }
 
-#endif //  defined(ROXLU_USE_PNG) && defined(ROXLU_IMPLEMENATION)
+void Painter::fill() {
+  state |= PAINTER_STATE_FILL;
+}
 
-// ====================================================================================
-//                              R O X L U _ U S E _ O P E N G L 
-// ====================================================================================
+void Painter::nofill() {
+  state &= ~PAINTER_STATE_FILL;
+}
 
-#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_IMPLEMENTATION)
+void Painter::instanced() {
+  state |= PAINTER_STATE_INSTANCED;
+}
 
-extern void rx_print_shader_link_info(GLuint shader) {
-  GLint status = 0;
-  GLint count = 0;
-  GLchar* error = NULL;
-  GLsizei nchars = 0;
-  glGetProgramiv(shader, GL_LINK_STATUS, &status);
-  if(!status) {
-    glGetProgramiv(shader, GL_INFO_LOG_LENGTH, &count);
-    if(count > 0) {
-      error = new GLchar[count];
-      glGetProgramInfoLog(shader, 2048, &nchars, error);
-      printf("------\n");
-      printf("%s\n", error);
-      printf("------\n");
-      delete[] error;
-      error = NULL;
-      assert(0);
-    }
-  }
+void Painter::noinstanced() {
+  state &= ~PAINTER_STATE_INSTANCED;
 }
 
-extern void rx_print_shader_compile_info(GLuint shader) {
-  GLint status = 0;
-  GLint count = 0;
-  GLchar* error = NULL;
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-  if(!status) {
-    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &count);
-    if(count > 0) {
-      error = new GLchar[count];
-      glGetShaderInfoLog(shader, count, NULL, error);
-      printf("------\n");
-      printf("%s\n", error);
-      printf("------\n");
-      delete[] error;
-      error = NULL;
-      assert(0);
+void Painter::sdf() {
+  state |= PAINTER_STATE_SDF;
+}
+
+void Painter::nosdf() {
+  state &= ~PAINTER_STATE_SDF;
+}
+
+void Painter::lineWidth(float w) {
+  line_width = w;
+}
+
+void Painter::polyline() {
+  state |= PAINTER_STATE_POLYLINE;
+}
+
+void Painter::nopolyline() {
+  state &= ~PAINTER_STATE_POLYLINE;
+}
+
+void Painter::lineJoin(int join) {
+  line_join = join;
+}
+
+void Painter::polyline(const vec2* pts, size_t num, bool closed) {
+
+  if (num && (state & PAINTER_STATE_CULL)) {
+    vec2 bmin = pts[0];
+    vec2 bmax = pts[0];
+    for (size_t i = 1; i < num; ++i) {
+      bmin.x = LOWEST(bmin.x, pts[i].x);
+      bmin.y = LOWEST(bmin.y, pts[i].y);
+      bmax.x = HEIGHEST(bmax.x, pts[i].x);
+      bmax.y = HEIGHEST(bmax.y, pts[i].y);
+    }
+    if (isCulled(bmin.x, bmin.y, bmax.x, bmax.y, 0.5f * line_width)) {
+      return;
     }
   }
-}
-  
-extern GLuint rx_create_program(GLuint vert, GLuint frag, bool link) {
-  GLuint prog = glCreateProgram();
-  glAttachShader(prog, vert);
-  glAttachShader(prog, frag);
 
-  if(link) {
-    glLinkProgram(prog);
-    rx_print_shader_link_info(prog);
+  polyline_points.resize(num);
+
+  for (size_t i = 0; i < num; ++i) {
+    PainterPolylinePoint& pt = polyline_points[i];
+    pt.pos[0] = pts[i].x;
+    pt.pos[1] = pts[i].y;
+    pt.width = line_width;
+    pt.color = packed_col;
   }
-  return prog;
+
+  active_polyline->polyline(polyline_points.empty() ? NULL : &polyline_points[0], num, closed);
+  polyline_points.clear();
+
+  setDirty();
 }
-  
-extern GLuint rx_create_shader(GLenum type, const char* src) {
-  GLuint s = glCreateShader(type);
-  glShaderSource(s, 1, &src,  NULL);
-  glCompileShader(s);
-  rx_print_shader_compile_info(s);
-  return s;
+
+void Painter::cull() {
+  state |= PAINTER_STATE_CULL;
 }
 
+void Painter::nocull() {
+  state &= ~PAINTER_STATE_CULL;
+}
 
-extern GLuint rx_create_shader_from_file(GLenum type, std::string filepath) {
+void Painter::cullRect(float x, float y, float w, float h) {
+  cull_rect[0] = LOWEST(x, x + w);
+  cull_rect[1] = LOWEST(y, y + h);
+  cull_rect[2] = fabsf(w);
+  cull_rect[3] = fabsf(h);
+  has_cull_rect = true;
+}
 
-  std::string source = rx_read_file(filepath);
-  if(!source.size()) {
-    printf("Error: cannot open the shader source: %s\n", filepath.c_str());
-    return -1;
+void Painter::nocullRect() {
+  has_cull_rect = false;
+}
+
+void Painter::cullSize(float size) {
+  cull_size = size;
+}
+
+void Painter::setDirty() {
+  if (active_layer) {
+    active_layer->is_dirty = true;
+  }
+  else {
+    needs_update = true;
   }
-  
-  return rx_create_shader(type, source.c_str());
 }
 
-extern GLuint rx_create_program_with_attribs(GLuint vert, 
-                                             GLuint frag, 
-                                             int nattribs, 
-                                             const char** attribs) 
-{
-  GLuint prog = rx_create_program(vert, frag);
-  
-  if(attribs) {
-    for(int i = 0; i < nattribs; ++i) {
-      glBindAttribLocation(prog, i, attribs[i]);
+/*
+  Shapes are culled when they're recorded, so the coordinates are the 
+  pixels of the viewport. A shape that is smaller than `cull_size` in 
+  both directions is rejected; this is off by default because it drops
+  tiny shapes, with a size of 1 a shape covers at most one pixel center. 
+  The margin is half the width of outlines and lines; we keep one extra 
+  pixel for the antialiased edges of SDF shapes and polylines. Note that
+  shapes in a layer stay culled when the viewport changes later on.
+*/
+bool Painter::isCulled(float x0, float y0, float x1, float y1, float margin) {
+
+  if (0 == (state & PAINTER_STATE_CULL)) {
+    return false;
+  }
+
+  float minx = LOWEST(x0, x1) - margin;
+  float miny = LOWEST(y0, y1) - margin;
+  float maxx = HEIGHEST(x0, x1) + margin;
+  float maxy = HEIGHEST(y0, y1) + margin;
+
+  if ((maxx - minx) < cull_size && (maxy - miny) < cull_size) {
+    num_rejected++;
+    return true;
+  }
+
+  bool has_bounds = false;
+  float bounds[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+  if (win_w > 0 && win_h > 0) {
+    bounds[2] = float(win_w);
+    bounds[3] = float(win_h);
+    has_bounds = true;
+  }
+
+  if (has_cull_rect) {
+    if (has_bounds) {
+      bounds[0] = HEIGHEST(bounds[0], cull_rect[0]);
+      bounds[1] = HEIGHEST(bounds[1], cull_rect[1]);
+      bounds[2] = LOWEST(bounds[2], cull_rect[0] + cull_rect[2]);
+      bounds[3] = LOWEST(bounds[3], cull_rect[1] + cull_rect[3]);
+    }
+    else {
+      bounds[0] = cull_rect[0];
+      bounds[1] = cull_rect[1];
+      bounds[2] = cull_rect[0] + cull_rect[2];
+      bounds[3] = cull_rect[1] + cull_rect[3];
     }
+    has_bounds = true;
   }
 
-  glLinkProgram(prog);
-  rx_print_shader_link_info(prog);
+  if (has_bounds 
+      && (maxx + 1.0f < bounds[0] || maxy + 1.0f < bounds[1] 
+          || minx - 1.0f > bounds[2] || miny - 1.0f > bounds[3]))
+    {
+      num_culled++;
+      return true;
+    }
 
-  return prog;
+  return false;
 }
 
-extern GLint rx_get_uniform_location(GLuint prog, std::string name) {
-#if !defined(NDEBUG)
-  GLint loc = glGetUniformLocation(prog, name.c_str());
-  if(loc < 0) {
-    printf("Error: cannot find the uniform: %s\n", name.c_str());
-  }
-#else
-  GLint loc = glGetUniformLocation(prog, name.c_str());
-#endif
-  
-  return loc;
+/* The current color as RGBA8, r in the lowest byte (the byte order of GL_UNSIGNED_BYTE attributes). */
+uint32_t Painter::packColor() {
+  return painter_pack_color(col[0], col[1], col[2], col[3]);
 }
 
-extern void rx_uniform_1i(GLuint prog, std::string name, GLint v) {
-  glUniform1i(rx_get_uniform_location(prog, name), v);
+void Painter::begin(GLenum type) {
+  command_type = type;
 }
 
-extern void rx_uniform_1f(GLuint prog, std::string name, GLfloat v) {
-  glUniform1f(rx_get_uniform_location(prog, name), v);
+void Painter::vertex(float x, float y) {
+
+  if ((state & PAINTER_STATE_POLYLINE) 
+      && (GL_LINES == command_type || GL_LINE_STRIP == command_type || GL_LINE_LOOP == command_type)) 
+    {
+      PainterPolylinePoint pt;
+      pt.pos[0] = x;
+      pt.pos[1] = y;
+      pt.width = line_width;
+      pt.color = packed_col;
+      context_type = PAINTER_CONTEXT_TYPE_POLYLINE;
+      polyline_points.push_back(pt);
+      return;
+    }
+
+  context_type = PAINTER_CONTEXT_TYPE_PC;
+  vertices_pc.push_back(VertexPackedPC(x, y, packed_col));
 }
 
-extern void rx_uniform_mat4fv(GLuint prog, 
-                              std::string name, 
-                              GLsizei count, 
-                              GLboolean transpose, 
-                              const GLfloat* value) 
-{
-  glUniformMatrix4fv(rx_get_uniform_location(prog, name), count, transpose, value);
+void Painter::end() {
+
+  /* The whole batch is culled or kept, using the bounds of its vertices. */
+  if (state & PAINTER_STATE_CULL) {
+
+    float bmin[2] = { 0.0f, 0.0f };
+    float bmax[2] = { 0.0f, 0.0f };
+    float margin = 0.5f;
+    size_t num = 0;
+
+    if (context_type == PAINTER_CONTEXT_TYPE_PC && vertices_pc.size()) {
+      num = vertices_pc.size();
+      bmin[0] = bmax[0] = vertices_pc[0].pos[0];
+      bmin[1] = bmax[1] = vertices_pc[0].pos[1];
+      for (size_t i = 1; i < num; ++i) {
+        bmin[0] = LOWEST(bmin[0], vertices_pc[i].pos[0]);
+        bmin[1] = LOWEST(bmin[1], vertices_pc[i].pos[1]);
+        bmax[0] = HEIGHEST(bmax[0], vertices_pc[i].pos[0]);
+        bmax[1] = HEIGHEST(bmax[1], vertices_pc[i].pos[1]);
+      }
+      if (GL_TRIANGLES == command_type || GL_TRIANGLE_STRIP == command_type || GL_TRIANGLE_FAN == command_type) {
+        margin = 0.0f;
+      }
+    }
+    else if (context_type == PAINTER_CONTEXT_TYPE_POLYLINE && polyline_points.size()) {
+      num = polyline_points.size();
+      bmin[0] = bmax[0] = polyline_points[0].pos[0];
+      bmin[1] = bmax[1] = polyline_points[0].pos[1];
+      for (size_t i = 1; i < num; ++i) {
+        bmin[0] = LOWEST(bmin[0], polyline_points[i].pos[0]);
+        bmin[1] = LOWEST(bmin[1], polyline_points[i].pos[1]);
+        bmax[0] = HEIGHEST(bmax[0], polyline_points[i].pos[0]);
+        bmax[1] = HEIGHEST(bmax[1], polyline_points[i].pos[1]);
+      }
+      margin = 0.5f * line_width;
+    }
+
+    if (num && isCulled(bmin[0], bmin[1], bmax[0], bmax[1], margin)) {
+      vertices_pc.clear();
+      polyline_points.clear();
+      context_type = 0;
+      return;
+    }
+  }
+
+  if(context_type == PAINTER_CONTEXT_TYPE_PC) {
+    active_pc->command(command_type, vertices_pc);
+    vertices_pc.clear();
+    setDirty();
+  }
+  else if (context_type == PAINTER_CONTEXT_TYPE_POLYLINE) {
+    if (GL_LINES == command_type) {
+      for (size_t i = 0; i + 1 < polyline_points.size(); i += 2) {
+        active_polyline->polyline(&polyline_points[i], 2, false);
+      }
+    }
+    else if (polyline_points.size()) {
+      active_polyline->polyline(&polyline_points[0], polyline_points.size(), GL_LINE_LOOP == command_type);
+    }
+    polyline_points.clear();
+    setDirty();
+  }
+
+  context_type = 0;
 }
 
-Program::~Program() {
-  for(std::vector<Shader*>::iterator it = created_shaders.begin(); it != created_shaders.end(); ++it) {
-    delete *it;
+void Painter::layer(std::string name) {
+
+  PainterLayer* l = getLayer(name);
+
+  if (NULL == l) {
+    l = new PainterLayer(*this, name);
+    if (0 != ubo) {
+      l->init();                                                  /* without init() there is no GL context, e.g. for the PainterRasterizer; init() creates the buffer then */
+    }
+    layers.push_back(l);
+    layerOrder(name, 0);
   }
-  shaders.clear();
-  created_shaders.clear();
+
+  active_layer = l;
+  active_pc = &l->context_pc;
+  active_pt = &l->context_pt;
+  active_instanced = &l->context_instanced;
+  active_polyline = &l->context_polyline;
 }
 
-Program& Program::add(Shader* s) {
+void Painter::nolayer() {
+  active_layer = NULL;
+  active_pc = &context_pc;
+  active_pt = &context_pt;
+  active_instanced = &context_instanced;
+  active_polyline = &context_polyline;
+}
 
-  if(id < 0) {
-    id = glCreateProgram();
+void Painter::clearLayer(std::string name) {
+  PainterLayer* l = getLayer(name);
+  if (NULL == l) {
+    printf("Error: cannot clear layer: %s, not found.\n", name.c_str());
+    return;
   }
+  l->clear();
+}
 
-  s->compile();
+void Painter::layerOrder(std::string name, int order) {
 
-  if(s->id < 0) {
-    printf("Error: a shader is not compiled yet!\n");
-    ::exit(EXIT_FAILURE);
+  PainterLayer* l = getLayer(name);
+  if (NULL == l) {
+    printf("Error: cannot set the order of layer: %s, not found.\n", name.c_str());
+    return;
   }
 
-  glAttachShader(id, s->id);
-  
-  shaders.push_back(s);
-  return *this;
-}
+  l->order = order;
 
-Program& Program::create(GLenum type, 
-                         std::string filepath, 
-                         std::string extraSource) 
-{
-  Shader* s = new Shader();
-  s->load(type, filepath, extraSource);
-  created_shaders.push_back(s);
-  return add(s);
+  /* Keep the layers sorted; layers with the same order keep the order in which they were created. */
+  std::vector<PainterLayer*>::iterator it = std::find(layers.begin(), layers.end(), l);
+  layers.erase(it);
+  it = layers.begin();
+  while (it != layers.end() && (*it)->order <= order) {
+    ++it;
+  }
+  layers.insert(it, l);
 }
 
-Program& Program::link(int nattribs, 
-                       const char** atts, 
-                       int nfrags, 
-                       const char** fraglocs) 
-{
-
-  if(id < 0) {
-    printf("Error: first add a shader before linking.\n");
-    ::exit(EXIT_FAILURE);
+void Painter::showLayer(std::string name) {
+  PainterLayer* l = getLayer(name);
+  if (NULL != l) {
+    l->is_visible = true;
   }
+}
 
-  if(nattribs) {
-    attribs.clear();
-    
-    for(int i = 0; i < nattribs; ++i) {
-      glBindAttribLocation(id, i, atts[i]);
-      attribs.push_back(atts[i]);
-    }
+void Painter::hideLayer(std::string name) {
+  PainterLayer* l = getLayer(name);
+  if (NULL != l) {
+    l->is_visible = false;
   }
+}
 
-  if(nfrags) {
-    frags.clear();
-    for(int i = 0; i < nfrags; ++i) {
-      glBindFragDataLocation(id, i, fraglocs[i]);
-      frags.push_back(fraglocs[i]);
+PainterLayer* Painter::getLayer(std::string name) {
+  for (size_t i = 0; i < layers.size(); ++i) {
+    if (layers[i]->name == name) {
+      return layers[i];
     }
   }
-  
-  glLinkProgram(id);
-  rx_print_shader_link_info(id);
-
-  return *this;
+  return NULL;
 }
 
-Program& Program::recompile() {
+void Painter::print() {
 
-  if(id < 0) {
-    printf("Error: cannot recompile the program because we've not been created yet.\n");
-    ::exit(EXIT_FAILURE);
+  size_t num_instanced = 0;
+  size_t num_instanced_draws = 0;
+  for (int i = 0; i < PAINTER_SHAPE_COUNT; ++i) {
+    num_instanced += context_instanced.instances[i].size();
+    num_instanced_draws += (context_instanced.instances[i].size() > 0) ? 1 : 0;
   }
 
-  for(size_t i = 0; i < shaders.size(); ++i) {
-    shaders[i]->reload();
-    shaders[i]->compile();
+  size_t num_recorded = 0;
+  for (size_t i = 0; i < num_recorders; ++i) {
+    num_recorded += recorder_pool[i]->num_commands;
   }
 
-  for(size_t i = 0; i < attribs.size(); ++i) {
-    glBindAttribLocation(id, i, attribs[i].c_str());
-  }
+  printf("painter.pc.commands: %d\n", (int)context_pc.num_commands);
+  printf("painter.pc.draws: %d\n", (int)context_pc.draws.size());
+  printf("painter.recorders: %d, commands: %d\n", (int)num_recorders, (int)num_recorded);
+  printf("painter.pt.commands: %d\n", (int)context_pt.num_commands);
+  printf("painter.pt.draws: %d\n", (int)context_pt.commands.size());
+  printf("painter.instanced.shapes: %d\n", (int)num_instanced);
+  printf("painter.instanced.draws: %d\n", (int)num_instanced_draws);
+  printf("painter.sdf.shapes: %d\n", (int)context_instanced.sdf_instances.size());
+  printf("painter.polyline.lines: %d, points: %d\n", (int)context_polyline.num_polylines, 
+         (int)(context_polyline.points[PAINTER_JOIN_MITER].size() + context_polyline.points[PAINTER_JOIN_ROUND].size()));
+  printf("painter.culled: %d, rejected: %d\n", (int)num_culled, (int)num_rejected);
 
-  for(size_t i = 0; i < frags.size(); ++i) {
-    glBindFragDataLocation(id, i, frags[i].c_str());
+  for (size_t i = 0; i < layers.size(); ++i) {
+    PainterLayer* l = layers[i];
+    printf("painter.layer.%s: order: %d, visible: %d, commands: %d, draws: %d, uploads: %d\n", 
+           l->name.c_str(), l->order, (int)l->is_visible,
+           (int)(l->context_pc.num_commands + l->context_pt.num_commands),
+           (int)(l->context_pc.draws.size() + l->context_pt.commands.size()),
+           (int)l->num_uploads);
   }
+}
 
-  glLinkProgram(id);
-  rx_print_shader_link_info(id); 
+int Painter::width() {
+  return win_w;
+}
 
-  return *this;
+int Painter::height() {
+  return win_h;
 }
 
-Shader& Shader::load(GLenum t, 
-                     std::string fp, 
-                     std::string extraSource)
-{
+// -----------------------------------------------------
 
-  file_source = rx_read_file(fp);
+static void painter_raster_unpack(uint32_t col, float* out) {
+  out[0] = float(col & 0xFF) / 255.0f;
+  out[1] = float((col >> 8) & 0xFF) / 255.0f;
+  out[2] = float((col >> 16) & 0xFF) / 255.0f;
+  out[3] = float((col >> 24) & 0xFF) / 255.0f;
+}
 
-  if(!file_source.size()) {
-    printf("Error: cannot get contents for shader file: %s\n", fp.c_str());
-    ::exit(EXIT_FAILURE);
+/* GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA for all four channels, like Painter::draw(). */
+static inline void painter_raster_blend(unsigned char* dst, const float* src, float coverage) {
+
+  float a = src[3] * coverage;
+  if (a <= 0.0f) {
+    return;
   }
 
-  extra_source = extraSource;
-  filepath = fp;
-  type = t;
-  return *this;
+  float ia = 1.0f - a;
+  dst[0] = (unsigned char)(CLAMP(src[0] * a * 255.0f + dst[0] * ia, 0.0f, 255.0f) + 0.5f);
+  dst[1] = (unsigned char)(CLAMP(src[1] * a * 255.0f + dst[1] * ia, 0.0f, 255.0f) + 0.5f);
+  dst[2] = (unsigned char)(CLAMP(src[2] * a * 255.0f + dst[2] * ia, 0.0f, 255.0f) + 0.5f);
+  dst[3] = (unsigned char)(CLAMP(a * a * 255.0f + dst[3] * ia, 0.0f, 255.0f) + 0.5f);
 }
 
-Shader& Shader::compile() {
+/* Bilinear sample with clamp to edge; v = 0 is the first row of the texture. */
+static void painter_raster_sample(const PainterRasterTexture& tex, float u, float v, float* out) {
 
-  if(id < 0) {
-    id = glCreateShader(type);
-  }
-  
-  if(!file_source.size()) {
-    printf("Error: The source of the shader is empty, cannot compile.\n");
-    ::exit(EXIT_FAILURE);
-  }
+  float fx = u * tex.width - 0.5f;
+  float fy = v * tex.height - 0.5f;
+  float flx = floorf(fx);
+  float fly = floorf(fy);
+  float ax = fx - flx;
+  float ay = fy - fly;
+  int ix = int(CLAMP(flx, -1.0f, float(tex.width)));
+  int iy = int(CLAMP(fly, -1.0f, float(tex.height)));
+  int x0 = CLAMP(ix, 0, tex.width - 1);
+  int x1 = CLAMP(ix + 1, 0, tex.width - 1);
+  int y0 = CLAMP(iy, 0, tex.height - 1);
+  int y1 = CLAMP(iy + 1, 0, tex.height - 1);
 
-  std::string combined_source = extra_source +"\n" +file_source;
-  const char* src = combined_source.c_str();
+  const unsigned char* p00 = &tex.pixels[(y0 * tex.width + x0) * 4];
+  const unsigned char* p10 = &tex.pixels[(y0 * tex.width + x1) * 4];
+  const unsigned char* p01 = &tex.pixels[(y1 * tex.width + x0) * 4];
+  const unsigned char* p11 = &tex.pixels[(y1 * tex.width + x1) * 4];
 
-  glShaderSource(id, 1, &src, NULL);
-  glCompileShader(id);
-  rx_print_shader_compile_info(id);
-  return *this;
+  for (int i = 0; i < 4; ++i) {
+    float top = p00[i] + (p10[i] - p00[i]) * ax;
+    float bottom = p01[i] + (p11[i] - p01[i]) * ax;
+    out[i] = (top + (bottom - top) * ay) / 255.0f;
+  }
 }
 
-Shader& Shader::reload() {
-  return load(type, filepath, extra_source);
-}
+/* w0, w1 and w2 are the edge functions of the pixel; they sum up to the area. */
+static inline void painter_raster_shade(const PainterRasterPrim& prim, float w0, float w1, float w2, unsigned char* dst) {
 
-#endif //  defined(ROXLU_USE_OPENGL) && defined(ROXLU_IMPLEMENTATION)
+  float col[4];
 
-// ====================================================================================
-//                              R O X L U _ U S E _ O P E N G L 
-//                              R O X L U _ U S E _ M A T H
-// ====================================================================================
-#if defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_MATH) && defined(ROXLU_IMPLEMENTATION)
+  if (prim.texture) {
+    float u = (prim.uv[0] * w0 + prim.uv[2] * w1 + prim.uv[4] * w2) * prim.inv_area;
+    float v = (prim.uv[1] * w0 + prim.uv[3] * w1 + prim.uv[5] * w2) * prim.inv_area;
+    painter_raster_sample(*prim.texture, u, v, col);
+  }
+  else if (prim.is_flat) {
+    painter_raster_blend(dst, prim.col, 1.0f);
+    return;
+  }
+  else {
+    for (int i = 0; i < 4; ++i) {
+      col[i] = (prim.col[i] * w0 + prim.col[4 + i] * w1 + prim.col[8 + i] * w2) * prim.inv_area;
+    }
+  }
 
-PainterContextPT::PainterContextPT(Painter& painter)
-  :painter(painter)
-  ,allocated(0)
-  ,needs_update(false)
-  ,vao(0)
-  ,vbo(0)
-  ,vert(0)
-  ,frag(0)
-  ,prog(0)
+  painter_raster_blend(dst, col, 1.0f);
+}
+
+PainterRasterizer::PainterRasterizer()
+  :width(0)
+  ,height(0)
+  ,num_threads(0)
+  ,tiles_x(0)
+  ,tiles_y(0)
+  ,num_shapes(0)
+  ,setup_time(0)
+  ,raster_time(0)
 {
 }
 
-void PainterContextPT::init() {
-  vert = rx_create_shader(GL_VERTEX_SHADER, PAINTER_VERTEX_PT_VS);
-  frag = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_VERTEX_PT_SAMPLER2D_FS);
-  prog = rx_create_program(vert, frag);
-  glLinkProgram(prog);
+bool PainterRasterizer::init(int w, int h, int numThreads) {
 
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
+  if (w <= 0 || h <= 0) {
+    printf("Error: cannot initialize the PainterRasterizer with a size of %d x %d.\n", w, h);
+    return false;
+  }
 
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  
-  glEnableVertexAttribArray(0); // pos
-  glEnableVertexAttribArray(1); // tex
-  
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPT), (GLvoid*) 0); // pos
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(VertexPT), (GLvoid*) 12); // tex
+  width = w;
+  height = h;
+  num_threads = numThreads;
+  tiles_x = (w + PAINTER_RASTER_TILE_SIZE - 1) / PAINTER_RASTER_TILE_SIZE;
+  tiles_y = (h + PAINTER_RASTER_TILE_SIZE - 1) / PAINTER_RASTER_TILE_SIZE;
 
-  // bind ubo to binding 0
-  glUseProgram(prog);
-  GLint block_dx = glGetUniformBlockIndex(prog, "Shared");
-  glUniformBlockBinding(prog, block_dx, 0);
-  glUniform1i(glGetUniformLocation(prog, "u_tex"), 0);
+  pixels.assign(size_t(w) * size_t(h) * 4, 0);
+  bins.clear();
+  bins.resize(tiles_x * tiles_y);
+
+  return true;
 }
 
-void PainterContextPT::shutdown() {
+void PainterRasterizer::shutdown() {
+  width = 0;
+  height = 0;
+  tiles_x = 0;
+  tiles_y = 0;
+  pixels.clear();
+  prims.clear();
+  bins.clear();
+  textures.clear();
+}
 
-  if (0 == vao) {
-    return;
-  }
+void PainterRasterizer::clear(float r, float g, float b, float a) {
 
-  glDeleteShader(vert);
-  glDeleteShader(frag);
-  glDeleteProgram(prog);
-  glDeleteVertexArrays(1, &vao);
-  glDeleteBuffers(1, &vbo);
+  unsigned char col[4];
+  col[0] = (unsigned char)(CLAMP(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+  col[1] = (unsigned char)(CLAMP(g, 0.0f, 1.0f) * 255.0f + 0.5f);
+  col[2] = (unsigned char)(CLAMP(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+  col[3] = (unsigned char)(CLAMP(a, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    memcpy(&pixels[i], col, 4);
+  }
 }
 
-void PainterContextPT::texture(GLuint tex, float x, float y, float w, float h) {
-  
-  PainterCommand cmd;
-  cmd.type = GL_TEXTURE_2D;
-  cmd.count = 6;
-  cmd.offset = vertices.size();
-  cmd.tex = tex;
-  commands.push_back(cmd);
-  
-  VertexPT a(vec3(x,     y + h, 0.0), vec2(0.0, 1.0)); // bottom left
-  VertexPT b(vec3(x + w, y + h, 0.0), vec2(1.0, 1.0)); // bottom right
-  VertexPT c(vec3(x + w,     y, 0.0), vec2(1.0, 0.0)); // top right
-  VertexPT d(vec3(x,         y, 0.0), vec2(0.0, 0.0)); // top left
+void PainterRasterizer::addTexture(GLuint tex, int w, int h, unsigned char* rgba) {
 
-  vertices.push_back(a);
-  vertices.push_back(b);
-  vertices.push_back(c);
-  vertices.push_back(a);
-  vertices.push_back(c);
-  vertices.push_back(d);
+  if (NULL == rgba || w <= 0 || h <= 0) {
+    printf("Error: cannot add texture %d to the PainterRasterizer, invalid pixels or size.\n", (int)tex);
+    return;
+  }
 
-  needs_update = true;
+  PainterRasterTexture& t = textures[tex];
+  t.width = w;
+  t.height = h;
+  t.pixels.assign(rgba, rgba + size_t(w) * size_t(h) * 4);
 }
 
-void PainterContextPT::clear() {
-  vertices.clear();
-  commands.clear();
-}
+void PainterRasterizer::draw(Painter& painter) {
 
-void PainterContextPT::update() {
-  if(!needs_update) {
+  if (0 == pixels.size()) {
+    printf("Error: cannot draw, the PainterRasterizer is not initialized.\n");
     return;
   }
 
-  size_t needed = sizeof(VertexPT) * vertices.size();
-  if(needed == 0) {
-    return;
+  uint64_t start_time = rx_hrtime();
+
+  prims.clear();
+  num_shapes = 0;
+  for (size_t i = 0; i < bins.size(); ++i) {
+    bins[i].clear();
+  }
+
+  /* Same order as Painter::draw(). */
+  std::vector<PainterLayer*>& layers = painter.layers;
+  size_t dx = 0;
+  for (; dx < layers.size() && layers[dx]->order < 0; ++dx) {
+    if (layers[dx]->is_visible) {
+      addContexts(layers[dx]->context_pc, layers[dx]->context_polyline, layers[dx]->context_instanced, layers[dx]->context_pt);
+    }
   }
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  addContexts(painter.context_pc, painter.context_polyline, painter.context_instanced, painter.context_pt);
 
-  if(needed > allocated) {
-    allocated = needed;
-    glBufferData(GL_ARRAY_BUFFER, needed, vertices[0].ptr(), GL_STREAM_DRAW);
+  for (; dx < layers.size(); ++dx) {
+    if (layers[dx]->is_visible) {
+      addContexts(layers[dx]->context_pc, layers[dx]->context_polyline, layers[dx]->context_instanced, layers[dx]->context_pt);
+    }
   }
-  else {
-    glBufferSubData(GL_ARRAY_BUFFER, 0, needed, vertices[0].ptr());
+
+  /* Bin the primitives; triangles skip the tiles that are completely outside one of their edges. */
+  const float ts = float(PAINTER_RASTER_TILE_SIZE);
+  for (size_t i = 0; i < prims.size(); ++i) {
+
+    const PainterRasterPrim& prim = prims[i];
+    int tx0 = prim.bbox[0] / PAINTER_RASTER_TILE_SIZE;
+    int ty0 = prim.bbox[1] / PAINTER_RASTER_TILE_SIZE;
+    int tx1 = (prim.bbox[2] - 1) / PAINTER_RASTER_TILE_SIZE;
+    int ty1 = (prim.bbox[3] - 1) / PAINTER_RASTER_TILE_SIZE;
+    bool is_large = (PAINTER_RASTER_TRIANGLE == prim.type && (tx0 != tx1 || ty0 != ty1));
+
+    for (int ty = ty0; ty <= ty1; ++ty) {
+      for (int tx = tx0; tx <= tx1; ++tx) {
+
+        if (is_large) {
+          float minx = tx * ts + 0.5f;
+          float miny = ty * ts + 0.5f;
+          float maxx = minx + ts - 1.0f;
+          float maxy = miny + ts - 1.0f;
+          bool is_outside = false;
+          for (int k = 0; k < 3 && !is_outside; ++k) {
+            const float* e = prim.edges + k * 3;
+            is_outside = (e[0] * ((e[0] > 0.0f) ? maxx : minx) + e[1] * ((e[1] > 0.0f) ? maxy : miny) + e[2]) < 0.0f;
+          }
+          if (is_outside) {
+            continue;
+          }
+        }
+
+        bins[ty * tiles_x + tx].push_back(i);
+      }
+    }
   }
 
-  needs_update = false;
+  uint64_t binned_time = rx_hrtime();
+  setup_time = binned_time - start_time;
+
+  rx_parallel_for(tiles_x * tiles_y, rasterizeJob, this, num_threads);
+
+  raster_time = rx_hrtime() - binned_time;
 }
 
-void PainterContextPT::draw() {
+void PainterRasterizer::addContexts(PainterContextPC& pc, PainterContextPolyline& polyline, PainterContextInstanced& instanced, PainterContextPT& pt) {
 
-  if(vertices.size() == 0) {
-    return;
-  }
+  float col[4];
 
-  glDisable(GL_DEPTH_TEST);
-  glUseProgram(prog);
-  glBindVertexArray(vao);
+  /* Colored vertices and the recorders, which are stitched after our own commands. */
+  addIndexed(pc.vertices, pc.indices, pc.commands);
+  num_shapes += pc.num_commands;
 
-  glActiveTexture(GL_TEXTURE0);
+  for (size_t i = 0; i < pc.recorders.size(); ++i) {
+    addIndexed(pc.recorders[i]->vertices, pc.recorders[i]->indices, pc.recorders[i]->commands);
+    num_shapes += pc.recorders[i]->num_commands;
+  }
 
-  for(std::vector<PainterCommand>::iterator it = commands.begin(); it != commands.end(); ++it) {
-    PainterCommand& cmd = *it;
-    glBindTexture(cmd.type, cmd.tex);
-    glDrawArrays(GL_TRIANGLES, cmd.offset, cmd.count);
+  /* Polylines; the padding points separate the polylines. */
+  for (int j = 0; j < PAINTER_JOIN_COUNT; ++j) {
+    std::vector<PainterPolylinePoint>& pts = polyline.points[j];
+    for (size_t i = 0; i + 1 < pts.size(); ++i) {
+      if (pts[i].width >= 0.0f && pts[i + 1].width >= 0.0f) {
+        addCapsule(pts[i], pts[i + 1]);
+      }
+    }
   }
-}
+  num_shapes += polyline.num_polylines;
 
-// -----------------------------------------------------
+  /* Instances, expanded into the same meshes as PainterContextInstanced::createMeshes(). */
+  const std::vector<vec2>& circle = instanced.painter.circle_data;
 
-PainterContextPC::PainterContextPC(Painter& painter) 
-  :painter(painter)
-  ,allocated(0)
-  ,needs_update(true)
-  ,vao(0)
-  ,vbo(0)
-  ,vert(0)
-  ,frag(0)
-  ,prog(0)
-{
-}
+  for (int j = 0; j < PAINTER_SHAPE_COUNT; ++j) {
 
-void PainterContextPC::init() {
-  
-  vert = rx_create_shader(GL_VERTEX_SHADER, PAINTER_VERTEX_PC_VS);
-  frag = rx_create_shader(GL_FRAGMENT_SHADER, PAINTER_VERTEX_PC_FS);
-  prog = rx_create_program(vert, frag);
-  glLinkProgram(prog);
+    std::vector<PainterInstance>& insts = instanced.instances[j];
+    num_shapes += insts.size();
 
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
+    for (size_t i = 0; i < insts.size(); ++i) {
 
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  
-  glEnableVertexAttribArray(0); // pos
-  glEnableVertexAttribArray(1); // col
-  
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPC), (GLvoid*) 0); // pos
-  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(VertexPC), (GLvoid*) 12); // col
+      const float* r = insts[i].rect;
+      painter_raster_unpack(insts[i].color, col);
 
-  // bind ubo to binding 0
-  glUseProgram(prog);
-  GLint block_dx = glGetUniformBlockIndex(prog, "Shared");
-  glUniformBlockBinding(prog, block_dx, 0);
-}
+      if (PAINTER_SHAPE_RECT_FILL == j) {
+        addQuad(r[0], r[1] + r[3], r[0] + r[2], r[1] + r[3], r[0] + r[2], r[1], r[0], r[1], col);
+      }
+      else if (PAINTER_SHAPE_RECT_OUTLINE == j) {
+        addLine(r[0], r[1] + r[3], r[0] + r[2], r[1] + r[3], col);
+        addLine(r[0] + r[2], r[1] + r[3], r[0] + r[2], r[1], col);
+        addLine(r[0] + r[2], r[1], r[0], r[1], col);
+        addLine(r[0], r[1], r[0], r[1] + r[3], col);
+      }
+      else {
+        for (size_t k = 0; k + 1 < circle.size(); ++k) {
+          float x0 = r[0] + circle[k].x * r[2];
+          float y0 = r[1] + circle[k].y * r[3];
+          float x1 = r[0] + circle[k + 1].x * r[2];
+          float y1 = r[1] + circle[k + 1].y * r[3];
+          if (PAINTER_SHAPE_CIRCLE_FILL == j) {
+            float p0[2] = { r[0], r[1] };
+            float p1[2] = { x0, y0 };
+            float p2[2] = { x1, y1 };
+            addTriangle(p0, p1, p2, col, col, col, NULL, NULL);
+          }
+          else {
+            addLine(x0, y0, x1, y1, col);
+          }
+        }
+      }
+    }
+  }
 
-void PainterContextPC::shutdown() {
-  
-  if (0 == vao) {
-    return;
+  for (size_t i = 0; i < instanced.sdf_instances.size(); ++i) {
+    addSDF(instanced.sdf_instances[i]);
   }
+  num_shapes += instanced.sdf_instances.size();
 
-  glDeleteVertexArrays(1, &vao);
-  glDeleteBuffers(1, &vbo);
-  glDeleteShader(vert);
-  glDeleteShader(frag);
-  glDeleteProgram(prog);
+  /* Textures */
+  const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+  for (size_t i = 0; i < pt.commands.size(); ++i) {
+
+    PainterCommand& cmd = pt.commands[i];
+    if (GL_TEXTURE_2D != cmd.type) {
+      continue;
+    }
+
+    std::map<GLuint, PainterRasterTexture>::iterator it = textures.find(cmd.tex);
+    if (it == textures.end()) {
+      printf("Error: texture %d is not added to the PainterRasterizer, see addTexture().\n", (int)cmd.tex);
+      continue;
+    }
+
+    for (int k = cmd.offset; k + 2 < cmd.offset + cmd.count; k += 3) {
+      VertexPT3* v = &pt.vertices[k];
+      float uv[6] = { v[0].tex.x, v[0].tex.y, v[1].tex.x, v[1].tex.y, v[2].tex.x, v[2].tex.y };
+      addTriangle(v[0].pos.ptr(), v[1].pos.ptr(), v[2].pos.ptr(), white, white, white, uv, &it->second);
+    }
+  }
+  num_shapes += pt.num_commands;
 }
 
-void PainterContextPC::rect(float x, float y, float w, float h) {
+void PainterRasterizer::addIndexed(const std::vector<VertexPackedPC>& vertices, const std::vector<uint32_t>& indices, const std::vector<PainterCommand>& commands) {
 
-  VertexPC a(vec3(x,     y + h, 0.0), painter.col); // bottom left
-  VertexPC b(vec3(x + w, y + h, 0.0), painter.col); // bottom right
-  VertexPC c(vec3(x + w,     y, 0.0), painter.col); // top right
-  VertexPC d(vec3(x,         y, 0.0), painter.col); // top left
+  float c0[4];
+  float c1[4];
+  float c2[4];
 
-  PainterCommand cmd;
-  cmd.offset = vertices.size();
+  for (size_t i = 0; i < commands.size(); ++i) {
 
-  if(painter.state & PAINTER_STATE_FILL) {
+    const PainterCommand& cmd = commands[i];
+    const uint32_t* idx = &indices[cmd.offset];
 
-    cmd.type = GL_TRIANGLES;
+    if (GL_TRIANGLES == cmd.type) {
+      for (int k = 0; k + 2 < cmd.count; k += 3) {
+        const VertexPackedPC& a = vertices[idx[k + 0]];
+        const VertexPackedPC& b = vertices[idx[k + 1]];
+        const VertexPackedPC& c = vertices[idx[k + 2]];
+        painter_raster_unpack(a.col, c0);
+        painter_raster_unpack(b.col, c1);
+        painter_raster_unpack(c.col, c2);
+        addTriangle(a.pos, b.pos, c.pos, c0, c1, c2, NULL, NULL);
+      }
+    }
+    else if (GL_LINES == cmd.type) {
+      for (int k = 0; k + 1 < cmd.count; k += 2) {
+        const VertexPackedPC& a = vertices[idx[k + 0]];
+        const VertexPackedPC& b = vertices[idx[k + 1]];
+        painter_raster_unpack(a.col, c0);
+        addLine(a.pos[0], a.pos[1], b.pos[0], b.pos[1], c0);
+      }
+    }
+    else if (GL_POINTS == cmd.type) {
+      for (int k = 0; k < cmd.count; ++k) {
+        const VertexPackedPC& a = vertices[idx[k]];
+        painter_raster_unpack(a.col, c0);
+        addQuad(a.pos[0] - 0.5f, a.pos[1] + 0.5f, a.pos[0] + 0.5f, a.pos[1] + 0.5f, 
+                a.pos[0] + 0.5f, a.pos[1] - 0.5f, a.pos[0] - 0.5f, a.pos[1] - 0.5f, c0);
+      }
+    }
+  }
+}
 
-    vertices.push_back(a);
-    vertices.push_back(b);
-    vertices.push_back(c);
-    vertices.push_back(a);
-    vertices.push_back(c);
-    vertices.push_back(d);
+void PainterRasterizer::addTriangle(const float* p0, const float* p1, const float* p2, 
+                                    const float* c0, const float* c1, const float* c2, 
+                                    const float* uv, PainterRasterTexture* texture)
+{
+  PainterRasterPrim prim;
+  const float x[3] = { p0[0], p1[0], p2[0] };
+  const float y[3] = { p0[1], p1[1], p2[1] };
+
+  /* Edge k lies opposite of vertex k, so its edge function is the weight of that vertex. */
+  for (int k = 0; k < 3; ++k) {
+    int j = (k + 1) % 3;
+    int i = (k + 2) % 3;
+    float* e = prim.edges + k * 3;
+    e[0] = y[j] - y[i];
+    e[1] = x[i] - x[j];
+    e[2] = -(e[0] * x[j] + e[1] * y[j]);
+  }
+
+  float area = prim.edges[0] * x[0] + prim.edges[1] * y[0] + prim.edges[2];
+  if (fabsf(area) < 1e-6f) {
+    return;
   }
-  else {
 
-    cmd.type = GL_LINE_LOOP;
-    vertices.push_back(a);
-    vertices.push_back(b);
-    vertices.push_back(c);
-    vertices.push_back(d);
+  /* Both windings are drawn; make the inside positive. */
+  if (area < 0.0f) {
+    for (int k = 0; k < 9; ++k) {
+      prim.edges[k] = -prim.edges[k];
+    }
+    area = -area;
   }
 
-  cmd.count = vertices.size() - cmd.offset;
-  commands.push_back(cmd);
-  needs_update = true;
-}
+  if (false == clip(prim, LOWEST(x[0], LOWEST(x[1], x[2])), LOWEST(y[0], LOWEST(y[1], y[2])),
+                    HEIGHEST(x[0], HEIGHEST(x[1], x[2])), HEIGHEST(y[0], HEIGHEST(y[1], y[2]))))
+  {
+    return;
+  }
 
-void PainterContextPC::clear() {
-  vertices.clear();
-  commands.clear();
-}
+  /* Pixels on an edge that is shared by two triangles belong to exactly one of them. */
+  for (int k = 0; k < 3; ++k) {
+    float a = prim.edges[k * 3 + 0];
+    float b = prim.edges[k * 3 + 1];
+    prim.include[k] = (a > 0.0f || (a == 0.0f && b > 0.0f));
+  }
 
-void PainterContextPC::circle(float x, float y, float radius) {
-  
-  PainterCommand cmd;
-  cmd.offset = vertices.size();
+  prim.type = PAINTER_RASTER_TRIANGLE;
+  prim.texture = texture;
+  prim.inv_area = 1.0f / area;
+  memcpy(prim.col + 0, c0, sizeof(float) * 4);
+  memcpy(prim.col + 4, c1, sizeof(float) * 4);
+  memcpy(prim.col + 8, c2, sizeof(float) * 4);
+  prim.is_flat = (0 == memcmp(c0, c1, sizeof(float) * 4) && 0 == memcmp(c0, c2, sizeof(float) * 4));
 
-  if(painter.state & PAINTER_STATE_FILL) {
-    cmd.type = GL_TRIANGLE_FAN;
-    vertices.push_back(VertexPC(vec3(x, y, 0), painter.col));
+  if (uv) {
+    memcpy(prim.uv, uv, sizeof(prim.uv));
   }
   else {
-    cmd.type = GL_LINE_STRIP;
+    memset(prim.uv, 0, sizeof(prim.uv));
   }
 
-  cmd.offset = vertices.size();
+  prims.push_back(prim);
+}
 
-  for(std::vector<vec2>::iterator it = painter.circle_data.begin(); it != painter.circle_data.end(); ++it) {
-    vec2& v= *it;
-    vertices.push_back(VertexPC(vec3(x + v.x * radius, y + v.y * radius, 0), painter.col));
-  }
+void PainterRasterizer::addQuad(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, const float* col) {
 
-  cmd.count = vertices.size() - cmd.offset;
+  float p0[2] = { x0, y0 };
+  float p1[2] = { x1, y1 };
+  float p2[2] = { x2, y2 };
+  float p3[2] = { x3, y3 };
 
-  commands.push_back(cmd);
-  needs_update = true;
+  addTriangle(p0, p1, p2, col, col, col, NULL, NULL);
+  addTriangle(p0, p2, p3, col, col, col, NULL, NULL);
 }
 
-void PainterContextPC::line(float x0, float y0, float x1, float y1) {
-  
-  PainterCommand cmd;
-  cmd.type = GL_LINES;
-  cmd.offset = vertices.size();
-  cmd.count = 2;
-  commands.push_back(cmd);
+void PainterRasterizer::addLine(float x0, float y0, float x1, float y1, const float* col) {
 
-  VertexPC a(vec3(x0, y0, 0), painter.col);
-  VertexPC b(vec3(x1, y1, 0), painter.col);
-  vertices.push_back(a);
-  vertices.push_back(b);
+  float dx = x1 - x0;
+  float dy = y1 - y0;
+  float len = sqrtf(dx * dx + dy * dy);
+  if (len < 1e-6f) {
+    return;
+  }
 
-  needs_update = true;
+  float nx = -0.5f * dy / len;
+  float ny = 0.5f * dx / len;
+  addQuad(x0 + nx, y0 + ny, x1 + nx, y1 + ny, x1 - nx, y1 - ny, x0 - nx, y0 - ny, col);
 }
 
-void PainterContextPC::command(GLenum type, std::vector<VertexPC>& v) {
-  
-  PainterCommand command;
-  command.type = type;
-  command.offset = vertices.size();
-  command.count = v.size();
-  
-  std::copy(v.begin(), v.end(), std::back_inserter(vertices));
+void PainterRasterizer::addSDF(const PainterSDFInstance& inst) {
 
-  commands.push_back(command);
+  PainterRasterPrim prim;
+  float hw = 0.5f * inst.rect[2];
+  float hh = 0.5f * inst.rect[3];
+  float cx = inst.rect[0] + hw;
+  float cy = inst.rect[1] + hh;
+  float margin = 0.5f * inst.stroke + 1.0f;
 
-  needs_update = true;
+  if (false == clip(prim, cx - hw - margin, cy - hh - margin, cx + hw + margin, cy + hh + margin)) {
+    return;
+  }
+
+  prim.type = PAINTER_RASTER_SDF;
+  prim.texture = NULL;
+  prim.shape[0] = cx;
+  prim.shape[1] = cy;
+  prim.shape[2] = hw;
+  prim.shape[3] = hh;
+  prim.shape[4] = inst.radius;
+  prim.shape[5] = inst.stroke;
+  painter_raster_unpack(inst.color, prim.col);
+
+  prims.push_back(prim);
 }
 
-void PainterContextPC::update() {
+void PainterRasterizer::addCapsule(const PainterPolylinePoint& a, const PainterPolylinePoint& b) {
 
-  if(!needs_update) {
-    return;
-  }
+  PainterRasterPrim prim;
+  float margin = 0.5f * HEIGHEST(a.width, b.width) + 1.0f;
 
-  size_t needed = sizeof(VertexPC) * vertices.size();
-  if(needed == 0) {
+  if (false == clip(prim, LOWEST(a.pos[0], b.pos[0]) - margin, LOWEST(a.pos[1], b.pos[1]) - margin, 
+                    HEIGHEST(a.pos[0], b.pos[0]) + margin, HEIGHEST(a.pos[1], b.pos[1]) + margin))
+  {
     return;
   }
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  prim.type = PAINTER_RASTER_CAPSULE;
+  prim.texture = NULL;
+  prim.shape[0] = a.pos[0];
+  prim.shape[1] = a.pos[1];
+  prim.shape[2] = b.pos[0];
+  prim.shape[3] = b.pos[1];
+  prim.shape[4] = a.width;
+  prim.shape[5] = b.width;
+  painter_raster_unpack(a.color, prim.col + 0);
+  painter_raster_unpack(b.color, prim.col + 4);
 
-  if(needed > allocated) {
-    allocated = needed;
-    glBufferData(GL_ARRAY_BUFFER, needed, vertices[0].ptr(), GL_STREAM_DRAW);
-  }
-  else {
-    glBufferSubData(GL_ARRAY_BUFFER, 0, needed, vertices[0].ptr());
+  prims.push_back(prim);
+}
+
+/* Sets the pixel bounds of the primitive; returns false when it's outside the buffer (or NaN). */
+bool PainterRasterizer::clip(PainterRasterPrim& prim, float minX, float minY, float maxX, float maxY) {
+
+  if (!(maxX > 0.0f && maxY > 0.0f && minX < float(width) && minY < float(height))) {
+    return false;
   }
 
-  needs_update = false;
+  prim.bbox[0] = int(floorf(HEIGHEST(minX, 0.0f)));
+  prim.bbox[1] = int(floorf(HEIGHEST(minY, 0.0f)));
+  prim.bbox[2] = int(ceilf(LOWEST(maxX, float(width))));
+  prim.bbox[3] = int(ceilf(LOWEST(maxY, float(height))));
+
+  return (prim.bbox[0] < prim.bbox[2] && prim.bbox[1] < prim.bbox[3]);
 }
 
-void PainterContextPC::draw() {
-  
-  if(vertices.size() == 0) {
+void PainterRasterizer::rasterizeJob(int dx, void* user) {
+  PainterRasterizer* raster = static_cast<PainterRasterizer*>(user);
+  raster->rasterizeTile(dx);
+}
+
+void PainterRasterizer::rasterizeTile(int tile) {
+
+  std::vector<uint32_t>& bin = bins[tile];
+  if (0 == bin.size()) {
     return;
   }
 
-  glUseProgram(prog);
-  glBindVertexArray(vao);
+  int x0 = (tile % tiles_x) * PAINTER_RASTER_TILE_SIZE;
+  int y0 = (tile / tiles_x) * PAINTER_RASTER_TILE_SIZE;
+  int x1 = LOWEST(x0 + PAINTER_RASTER_TILE_SIZE, width);
+  int y1 = LOWEST(y0 + PAINTER_RASTER_TILE_SIZE, height);
 
-  for(std::vector<PainterCommand>::iterator it = commands.begin(); it != commands.end(); ++it) {
-    PainterCommand& cmd = *it;
-    glDrawArrays(cmd.type, cmd.offset, cmd.count);
+  for (size_t i = 0; i < bin.size(); ++i) {
+
+    const PainterRasterPrim& prim = prims[bin[i]];
+    int bx0 = HEIGHEST(x0, prim.bbox[0]);
+    int by0 = HEIGHEST(y0, prim.bbox[1]);
+    int bx1 = LOWEST(x1, prim.bbox[2]);
+    int by1 = LOWEST(y1, prim.bbox[3]);
+
+    if (PAINTER_RASTER_TRIANGLE == prim.type) {
+      rasterizeTriangle(prim, bx0, by0, bx1, by1);
+    }
+    else {
+      rasterizeShape(prim, bx0, by0, bx1, by1);
+    }
   }
 }
 
-// -----------------------------------------------------
+/* Tests the pixel centers against the three edge functions. */
+void PainterRasterizer::rasterizeTriangle(const PainterRasterPrim& prim, int x0, int y0, int x1, int y1) {
 
-Painter::Painter() 
-  :context_pc(*this)
-  ,context_pt(*this)
-  ,circle_resolution(8)
-  ,state(PAINTER_STATE_NONE)
-  ,ubo(0)
-  ,win_w(0)
-  ,win_h(0)
-  ,command_type(GL_NONE)
-  ,context_type(0)
-{
+  const float* e = prim.edges;
 
-  col[0] = 1.0f;
-  col[1] = 0.0f;
-  col[2] = 0.0f;
-  col[3] = 1.0f;
+#if defined(ROXLU_SSE2)
 
-  resolution(circle_resolution);
-}
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  const __m128 a0 = _mm_set1_ps(e[0]);
+  const __m128 a1 = _mm_set1_ps(e[3]);
+  const __m128 a2 = _mm_set1_ps(e[6]);
+  float w[12];
 
-void Painter::init() {
+  for (int y = y0; y < y1; ++y) {
 
-  context_pc.init();
-  context_pt.init();
-  
-  glGenBuffers(1, &ubo);
-  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(PainterShared), NULL, GL_DYNAMIC_DRAW);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+    float py = float(y) + 0.5f;
+    __m128 r0 = _mm_set1_ps(e[1] * py + e[2]);
+    __m128 r1 = _mm_set1_ps(e[4] * py + e[5]);
+    __m128 r2 = _mm_set1_ps(e[7] * py + e[8]);
+    unsigned char* row = &pixels[size_t(y) * width * 4];
 
-  GLint viewport[4];
-  glGetIntegerv(GL_VIEWPORT, viewport);
-  resize(viewport[2], viewport[3]);
-}
+    for (int x = x0; x < x1; x += 4) {
 
-void Painter::shutdown() {
+      __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), offset);
+      __m128 w0 = _mm_add_ps(_mm_mul_ps(a0, px), r0);
+      __m128 w1 = _mm_add_ps(_mm_mul_ps(a1, px), r1);
+      __m128 w2 = _mm_add_ps(_mm_mul_ps(a2, px), r2);
+      __m128 m0 = (prim.include[0]) ? _mm_cmpge_ps(w0, zero) : _mm_cmpgt_ps(w0, zero);
+      __m128 m1 = (prim.include[1]) ? _mm_cmpge_ps(w1, zero) : _mm_cmpgt_ps(w1, zero);
+      __m128 m2 = (prim.include[2]) ? _mm_cmpge_ps(w2, zero) : _mm_cmpgt_ps(w2, zero);
 
-  context_pc.shutdown();
-  context_pt.shutdown();
-  
-  glDeleteBuffers(1, &ubo);
-}
+      int mask = _mm_movemask_ps(_mm_and_ps(m0, _mm_and_ps(m1, m2)));
+      if (x1 - x < 4) {
+        mask &= (1 << (x1 - x)) - 1;
+      }
+      if (0 == mask) {
+        continue;
+      }
 
-void Painter::clear() {
-  context_pc.clear();
-  context_pt.clear();
-}
+      _mm_storeu_ps(w + 0, w0);
+      _mm_storeu_ps(w + 4, w1);
+      _mm_storeu_ps(w + 8, w2);
 
-void Painter::resolution(int n) {
-  
-  float a = TWO_PI / float(n);
-  for(int i = 0; i <= n; ++i) {
-    circle_data.push_back(vec2(cosf(a * i), sinf(a * i)));
+      for (int i = 0; i < 4; ++i) {
+        if (mask & (1 << i)) {
+          painter_raster_shade(prim, w[i], w[4 + i], w[8 + i], row + (x + i) * 4);
+        }
+      }
+    }
   }
-}
 
-void Painter::rect(float x, float y, float w, float h) {
-  context_pc.rect(x, y, w, h);
-}
+#else
 
-void Painter::circle(float x, float y, float radius) {
-  context_pc.circle(x, y, radius);
-}
+  for (int y = y0; y < y1; ++y) {
 
-void Painter::line(float x0, float y0, float x1, float y1) {
-  context_pc.line(x0, y0, x1, y1);
-}
+    float py = float(y) + 0.5f;
+    float r0 = e[1] * py + e[2];
+    float r1 = e[4] * py + e[5];
+    float r2 = e[7] * py + e[8];
+    unsigned char* row = &pixels[size_t(y) * width * 4];
 
-void Painter::texture(GLuint tex, float x, float y, float w, float h) {
-  context_pt.texture(tex, x, y, w, h);
-}
+    for (int x = x0; x < x1; ++x) {
 
-void Painter::color(float r, float g, float b, float a) {
+      float px = float(x) + 0.5f;
+      float w0 = e[0] * px + r0;
+      float w1 = e[3] * px + r1;
+      float w2 = e[6] * px + r2;
 
-  col[0] = r;
-  col[1] = g;
-  col[2] = b;
-  col[3] = a;
-}
+      if ((prim.include[0] ? w0 >= 0.0f : w0 > 0.0f)
+          && (prim.include[1] ? w1 >= 0.0f : w1 > 0.0f)
+          && (prim.include[2] ? w2 >= 0.0f : w2 > 0.0f))
+      {
+        painter_raster_shade(prim, w0, w1, w2, row + x * 4);
+      }
+    }
+  }
 
-void Painter::rgba(int r, int g, int b, int a) {
-  float inv = 1.0f / 255.0f;
-  col[0] = r * inv;
-  col[1] = g * inv;
-  col[2] = b * inv;
-  col[3] = a * inv;
+#endif
 }
 
-/* Convert hex string to color, e.g. hex("FF00CCFF") or hex("FFCC00"). */
-void Painter::hex(std::string str) {
+/* SDF shapes and capsules, with the same coverage as PAINTER_SDF_FS and PAINTER_POLYLINE_FS. */
+void PainterRasterizer::rasterizeShape(const PainterRasterPrim& prim, int x0, int y0, int x1, int y1) {
 
-  unsigned int h;
-  std::stringstream ss;
-  ss << std::hex << str;
-  ss >> h;
+  const float* s = prim.shape;
+  float col[4];
 
-  if (str.size() == 6) {
-    int r = (h >> 16) & 0xFF;
-    int g = (h >> 8) & 0xFF;
-    int b = (h) & 0xFF;
-    rgba(r, g, b);
-  }
-  else if (str.size() == 8) {
-    int r = (h >> 24) & 0xFF;
-    int g = (h >> 16) & 0xFF;
-    int b = (h >> 8) & 0xFF;
-    int a = (h) & 0xFF;
-    rgba(r, g, b, a);
-  }
-  else {
-    printf("error: invalid hex str.\n");
-  }
-}
+  for (int y = y0; y < y1; ++y) {
 
-void Painter::draw() {
+    float py = float(y) + 0.5f;
+    unsigned char* row = &pixels[size_t(y) * width * 4];
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    for (int x = x0; x < x1; ++x) {
 
-  context_pc.update();
-  context_pc.draw();
+      float px = float(x) + 0.5f;
+      float alpha = 0.0f;
 
-  context_pt.update();
-  context_pt.draw();
+      if (PAINTER_RASTER_SDF == prim.type) {
+        float qx = fabsf(px - s[0]) - s[2] + s[4];
+        float qy = fabsf(py - s[1]) - s[3] + s[4];
+        float ox = HEIGHEST(qx, 0.0f);
+        float oy = HEIGHEST(qy, 0.0f);
+        float d = sqrtf(ox * ox + oy * oy) + LOWEST(HEIGHEST(qx, qy), 0.0f) - s[4];
+        if (s[5] > 0.0f) {
+          d = fabsf(d) - s[5] * 0.5f;
+        }
+        alpha = CLAMP(0.5f - d, 0.0f, 1.0f);
+        if (alpha > 0.0f) {
+          painter_raster_blend(row + x * 4, prim.col, alpha);
+        }
+      }
+      else {
+        float abx = s[2] - s[0];
+        float aby = s[3] - s[1];
+        float len2 = abx * abx + aby * aby;
+        float t = (len2 > 0.0f) ? CLAMP(((px - s[0]) * abx + (py - s[1]) * aby) / len2, 0.0f, 1.0f) : 0.0f;
+        float dx = px - (s[0] + t * abx);
+        float dy = py - (s[1] + t * aby);
+        float half = 0.5f * (s[4] + t * (s[5] - s[4]));
+        alpha = CLAMP(half - sqrtf(dx * dx + dy * dy) + 0.5f, 0.0f, 1.0f);
+        if (alpha > 0.0f) {
+          for (int i = 0; i < 4; ++i) {
+            col[i] = prim.col[i] + t * (prim.col[4 + i] - prim.col[i]);
+          }
+          painter_raster_blend(row + x * 4, col, alpha);
+        }
+      }
+    }
+  }
 }
 
-void Painter::resize(int w, int h) {
-
-  ubo_data.pm.ortho(0, w, h, 0, 0.0f, 100.0f);
+void PainterRasterizer::print() {
 
-  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PainterShared), ubo_data.pm.ptr());
+  double setup_ms = double(setup_time) / 1e6;
+  double raster_ms = double(raster_time) / 1e6;
+  double total_ms = setup_ms + raster_ms;
 
-  win_w = w;
-  win_h = h;
+  printf("painter.raster.size: %d x %d, tiles: %d x %d\n", width, height, tiles_x, tiles_y);
+  printf("painter.raster.shapes: %d, prims: %d\n", (int)num_shapes, (int)prims.size());
+  printf("painter.raster.setup: %.3f ms, raster: %.3f ms, shapes/sec: %.0f\n", 
+         setup_ms, raster_ms, (total_ms > 0.0) ? (double(num_shapes) * 1000.0 / total_ms) : 0.0);
 }
 
-void Painter::fill() {
-  state |= PAINTER_STATE_FILL;
-}
+/* Every run starts from the pixels we had before the benchmark, so the shapes aren't blended on top of each other. */
+void PainterRasterizer::benchmark(Painter& painter, int numRuns) {
 
-void Painter::nofill() {
-  state &= ~PAINTER_STATE_FILL;
-}
+  if (0 == pixels.size() || numRuns < 1) {
+    printf("Error: cannot benchmark, the PainterRasterizer is not initialized or numRuns < 1: %d\n", numRuns);
+    return;
+  }
 
-void Painter::begin(GLenum type) {
-  command_type = type;
-}
+  std::vector<unsigned char> background = pixels;
+  uint64_t best_setup = 0;
+  uint64_t best_raster = 0;
+  uint64_t sum_setup = 0;
+  uint64_t sum_raster = 0;
 
-void Painter::vertex(float x, float y) {
-  context_type = PAINTER_CONTEXT_TYPE_PC;
-  vertices_pc.push_back(VertexPC(vec3(x, y, 0), col));
-}
+  for (int i = 0; i < numRuns; ++i) {
 
-void Painter::end() {
+    memcpy(&pixels[0], &background[0], pixels.size());
+    draw(painter);
 
-  if(context_type == PAINTER_CONTEXT_TYPE_PC) {
-    context_pc.command(command_type, vertices_pc);
-    vertices_pc.clear();
+    if (0 == i || setup_time + raster_time < best_setup + best_raster) {
+      best_setup = setup_time;
+      best_raster = raster_time;
+    }
+
+    sum_setup += setup_time;
+    sum_raster += raster_time;
   }
-}
 
-int Painter::width() {
-  return win_w;
+  double best_ms = double(best_setup + best_raster) / 1e6;
+  double avg_ms = double(sum_setup + sum_raster) / (1e6 * numRuns);
+
+  printf("painter.raster.benchmark.runs: %d, threads: %d\n", numRuns, (num_threads > 0) ? num_threads : rx_get_num_cores());
+  printf("painter.raster.benchmark.shapes: %d, prims: %d\n", (int)num_shapes, (int)prims.size());
+  printf("painter.raster.benchmark.fastest: setup: %.3f ms, raster: %.3f ms, shapes/sec: %.0f\n",
+         double(best_setup) / 1e6, double(best_raster) / 1e6, (best_ms > 0.0) ? (double(num_shapes) * 1000.0 / best_ms) : 0.0);
+  printf("painter.raster.benchmark.average: setup: %.3f ms, raster: %.3f ms, shapes/sec: %.0f\n",
+         double(sum_setup) / (1e6 * numRuns), double(sum_raster) / (1e6 * numRuns), (avg_ms > 0.0) ? (double(num_shapes) * 1000.0 / avg_ms) : 0.0);
 }
 
-int Painter::height() {
-  return win_h;
+#if defined(ROXLU_USE_PNG)
+bool PainterRasterizer::save(std::string filepath) {
+
+  if (0 == pixels.size()) {
+    printf("Error: cannot save, the PainterRasterizer is not initialized.\n");
+    return false;
+  }
+
+  return rx_save_png(filepath, &pixels[0], width, height, 4, false);
 }
+#endif
 
 #endif // defined(ROXLU_USE_OPENGL) && defined(ROXLU_USE_MATH) && defined(ROXLU_IMPLEMENTATION)
 
@@ -5519,15 +13283,14 @@ namespace roxlu {
     :needs_update(false)
     ,win_w(0)
     ,win_h(0)
-    ,vbo(0)
-    ,vao(0)
-    ,tex(0)
-    ,bytes_allocated(0)
     ,line_height(0)
     ,scale_w(0)
     ,scale_h(0)
     ,pages(0)
     ,base(0)
+    ,vao(0)
+    ,vertex_offset(0)
+    ,tex(0)
     {
       col[0] = col[1] = col[2] = col[3] = 1.0f;
     }
@@ -5553,19 +13316,9 @@ namespace roxlu {
     }
 
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    glEnableVertexAttribArray(0);  // pos
-    glEnableVertexAttribArray(1);  // tex
-    glEnableVertexAttribArray(2);  // fg_color
 
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CharacterVertex), (GLvoid*)0); // pos
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CharacterVertex), (GLvoid*)8); // tex
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CharacterVertex), (GLvoid*)16); // fg_color
-
-    return true;
+    /* Room for about 80 characters per region; begin() grows the buffer for longer texts. */
+    return stream.init(16 * 1024);
   }
 
   void Font::setupTexture(int w, int h, unsigned char* pix) {
@@ -5601,6 +13354,7 @@ namespace roxlu {
 
   void Font::clear() {
     vertices.clear();
+    needs_update = true;
   }
 
   void Font::write(float x, float y, std::string str, int align) {
@@ -5675,38 +13429,47 @@ namespace roxlu {
       return;
     }
 
-    updateVertices();
+    if(!updateVertices()) {
+      return;
+    }
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_RECTANGLE, tex);
 
     glUseProgram(prog);
     glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    glDrawArrays(GL_TRIANGLES, vertex_offset / sizeof(CharacterVertex), vertices.size());
+
+    stream.fence();
   }
 
-  void Font::updateVertices() {
+  bool Font::updateVertices() {
 
     if(!needs_update) {
-      return;
+      return true;
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
     size_t needed = sizeof(CharacterVertex) * vertices.size();
-    if(!needed) {
-      return;
+    if(!stream.begin(needed + sizeof(CharacterVertex))) {
+      return false;
     }
 
-    if(needed > bytes_allocated) {
-      glBufferData(GL_ARRAY_BUFFER, needed, &vertices[0].x, GL_DYNAMIC_DRAW);
-      bytes_allocated = needed;
-    }
-    else {
-      glBufferSubData(GL_ARRAY_BUFFER, 0, needed, &vertices[0].x);
+    void* dst = stream.alloc(needed, sizeof(CharacterVertex), vertex_offset);
+    if(NULL == dst) {
+      stream.end();
+      return false;
     }
 
+    memcpy(dst, &vertices[0].x, needed);
+    stream.end();
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.id);
+    rx_vertex_attrib_pointers<CharacterVertex>(); // pos, tex, fg_color
+
     needs_update = false;
+
+    return true;
   }
 
   bool Font::getChar(unsigned int code, Character& result) {